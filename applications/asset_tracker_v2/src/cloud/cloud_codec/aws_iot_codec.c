@@ -13,8 +13,10 @@
 #include <stdlib.h>
 
 #include "cJSON.h"
+#include <json_writer.h>
 #include "json_helpers.h"
 #include "json_common.h"
+#include "cbor_common.h"
 #include "json_protocol_names.h"
 
 #include <logging/log.h>
@@ -101,337 +103,330 @@ exit:
 	return err;
 }
 
-int cloud_codec_encode_config(struct cloud_codec_data *output,
-			      struct cloud_data_cfg *data)
+/* Data buffers passed to the encoding functions through json_common_encode(). */
+struct data_buffers {
+	struct cloud_data_gps *gps_buf;
+	struct cloud_data_sensors *sensor_buf;
+	struct cloud_data_modem_static *modem_stat_buf;
+	struct cloud_data_modem_dynamic *modem_dyn_buf;
+	struct cloud_data_ui *ui_buf;
+	struct cloud_data_accelerometer *accel_buf;
+	struct cloud_data_battery *bat_buf;
+	size_t gps_buf_count;
+	size_t sensor_buf_count;
+	size_t modem_dyn_buf_count;
+	size_t ui_buf_count;
+	size_t accel_buf_count;
+	size_t bat_buf_count;
+};
+
+static void encoded_output_print(const char *prefix, struct cloud_codec_data *output)
 {
-	int err;
-	char *buffer;
-
-	cJSON *root_obj = cJSON_CreateObject();
-	cJSON *state_obj = cJSON_CreateObject();
-	cJSON *rep_obj = cJSON_CreateObject();
-
-	if (root_obj == NULL || state_obj == NULL || rep_obj == NULL) {
-		cJSON_Delete(root_obj);
-		cJSON_Delete(state_obj);
-		cJSON_Delete(rep_obj);
-		return -ENOMEM;
+	if (IS_ENABLED(CONFIG_CLOUD_CODEC_LOG_LEVEL_DBG)) {
+		printk("%s%s\n", prefix, output->buf);
 	}
+}
 
-	err = json_common_config_add(rep_obj, data, DATA_CONFIG);
+static int config_encode(struct json_writer *writer, void *user_data)
+{
+	int err;
+	struct cloud_data_cfg *data = user_data;
 
-	json_add_obj(state_obj, OBJECT_REPORTED, rep_obj);
-	json_add_obj(root_obj, OBJECT_STATE, state_obj);
+	json_writer_object_start(writer, NULL);
+	json_writer_object_start(writer, OBJECT_STATE);
+	json_writer_object_start(writer, OBJECT_REPORTED);
 
+	err = json_common_config_add(writer, data, DATA_CONFIG);
 	if (err) {
-		goto exit;
+		return err;
 	}
 
-	buffer = cJSON_PrintUnformatted(root_obj);
-	if (buffer == NULL) {
-		LOG_ERR("Failed to allocate memory for JSON string");
+	json_writer_object_end(writer);
+	json_writer_object_end(writer);
+	json_writer_object_end(writer);
 
-		err = -ENOMEM;
-		goto exit;
-	}
+	return json_writer_error(writer);
+}
 
-	if (IS_ENABLED(CONFIG_CLOUD_CODEC_LOG_LEVEL_DBG)) {
-		json_print_obj("Encoded message:\n", root_obj);
+int cloud_codec_encode_config(struct cloud_codec_data *output,
+			      struct cloud_data_cfg *data)
+{
+	int err;
+
+	err = json_common_encode(output, config_encode, data);
+	if (err) {
+		return err;
 	}
 
-	output->buf = buffer;
-	output->len = strlen(buffer);
+	encoded_output_print("Encoded message:\n", output);
 
-exit:
-	cJSON_Delete(root_obj);
-	return err;
+	return 0;
 }
 
-int cloud_codec_encode_data(struct cloud_codec_data *output,
-			    struct cloud_data_gps *gps_buf,
-			    struct cloud_data_sensors *sensor_buf,
-			    struct cloud_data_modem_static *modem_stat_buf,
-			    struct cloud_data_modem_dynamic *modem_dyn_buf,
-			    struct cloud_data_ui *ui_buf,
-			    struct cloud_data_accelerometer *accel_buf,
-			    struct cloud_data_battery *bat_buf)
+static int data_encode(struct json_writer *writer, void *user_data)
 {
 	int err;
-	char *buffer;
 	bool object_added = false;
+	struct data_buffers *buffers = user_data;
 
-	cJSON *root_obj = cJSON_CreateObject();
-	cJSON *state_obj = cJSON_CreateObject();
-	cJSON *rep_obj = cJSON_CreateObject();
-
-	if (root_obj == NULL || state_obj == NULL || rep_obj == NULL) {
-		cJSON_Delete(root_obj);
-		cJSON_Delete(state_obj);
-		cJSON_Delete(rep_obj);
-		return -ENOMEM;
-	}
+	json_writer_object_start(writer, NULL);
+	json_writer_object_start(writer, OBJECT_STATE);
+	json_writer_object_start(writer, OBJECT_REPORTED);
 
-	err = json_common_ui_data_add(rep_obj, ui_buf,
-				      JSON_COMMON_ADD_DATA_TO_OBJECT,
-				      DATA_BUTTON,
-				      NULL);
+	err = json_common_ui_data_add(writer, buffers->ui_buf, DATA_BUTTON);
 	if (err == 0) {
 		object_added = true;
 	} else if (err != -ENODATA) {
-		goto add_object;
+		return err;
 	}
 
-	err = json_common_modem_static_data_add(rep_obj, modem_stat_buf,
-						JSON_COMMON_ADD_DATA_TO_OBJECT,
-						DATA_MODEM_STATIC,
-						NULL);
+	err = json_common_modem_static_data_add(writer, buffers->modem_stat_buf,
+						DATA_MODEM_STATIC);
 	if (err == 0) {
 		object_added = true;
 	} else if (err != -ENODATA) {
-		goto add_object;
+		return err;
 	}
 
-	err = json_common_modem_dynamic_data_add(rep_obj, modem_dyn_buf,
-						 JSON_COMMON_ADD_DATA_TO_OBJECT,
-						 DATA_MODEM_DYNAMIC,
-						 NULL);
+	err = json_common_modem_dynamic_data_add(writer, buffers->modem_dyn_buf,
+						 DATA_MODEM_DYNAMIC);
 	if (err == 0) {
 		object_added = true;
 	} else if (err != -ENODATA) {
-		goto add_object;
+		return err;
 	}
 
-	err = json_common_gps_data_add(rep_obj, gps_buf,
-				       JSON_COMMON_ADD_DATA_TO_OBJECT,
-				       DATA_GPS,
-				       NULL);
+	err = json_common_gps_data_add(writer, buffers->gps_buf, DATA_GPS);
 	if (err == 0) {
 		object_added = true;
 	} else if (err != -ENODATA) {
-		goto add_object;
+		return err;
 	}
 
-	err = json_common_sensor_data_add(rep_obj, sensor_buf,
-					  JSON_COMMON_ADD_DATA_TO_OBJECT,
-					  DATA_ENVIRONMENTALS,
-					  NULL);
+	err = json_common_sensor_data_add(writer, buffers->sensor_buf, DATA_ENVIRONMENTALS);
 	if (err == 0) {
 		object_added = true;
 	} else if (err != -ENODATA) {
-		goto add_object;
+		return err;
 	}
 
-	err = json_common_accel_data_add(rep_obj, accel_buf,
-					 JSON_COMMON_ADD_DATA_TO_OBJECT,
-					 DATA_MOVEMENT,
-					 NULL);
+	err = json_common_accel_data_add(writer, buffers->accel_buf, DATA_MOVEMENT);
 	if (err == 0) {
 		object_added = true;
 	} else if (err != -ENODATA) {
-		goto add_object;
+		return err;
 	}
 
-	err = json_common_battery_data_add(rep_obj, bat_buf,
-					   JSON_COMMON_ADD_DATA_TO_OBJECT,
-					   DATA_BATTERY,
-					   NULL);
+	err = json_common_battery_data_add(writer, buffers->bat_buf, DATA_BATTERY);
 	if (err == 0) {
 		object_added = true;
 	} else if (err != -ENODATA) {
-		goto add_object;
-	}
-
-add_object:
-
-	json_add_obj(state_obj, OBJECT_REPORTED, rep_obj);
-	json_add_obj(root_obj, OBJECT_STATE, state_obj);
-
-	/* Check error code after all objects has been added to the root object.
-	 * This way, we only need to clear the root_object upon an error.
-	 */
-	if ((err != 0) && (err != -ENODATA)) {
-		goto exit;
+		return err;
 	}
 
 	if (!object_added) {
-		err = -ENODATA;
 		LOG_DBG("No data to encode, JSON string empty...");
-		goto exit;
-	} else {
-		/* At this point err can be either 0 or -ENODATA. Explicitly set err to 0 if
-		 * objects has been added to the rootj object.
-		 */
-		err = 0;
+		return -ENODATA;
 	}
 
-	buffer = cJSON_PrintUnformatted(root_obj);
-	if (buffer == NULL) {
-		LOG_ERR("Failed to allocate memory for JSON string");
+	json_writer_object_end(writer);
+	json_writer_object_end(writer);
+	json_writer_object_end(writer);
 
-		err = -ENOMEM;
-		goto exit;
-	}
+	return json_writer_error(writer);
+}
 
-	if (IS_ENABLED(CONFIG_CLOUD_CODEC_LOG_LEVEL_DBG)) {
-		json_print_obj("Encoded message:\n", root_obj);
+int cloud_codec_encode_data(struct cloud_codec_data *output,
+			    struct cloud_data_gps *gps_buf,
+			    struct cloud_data_sensors *sensor_buf,
+			    struct cloud_data_modem_static *modem_stat_buf,
+			    struct cloud_data_modem_dynamic *modem_dyn_buf,
+			    struct cloud_data_ui *ui_buf,
+			    struct cloud_data_accelerometer *accel_buf,
+			    struct cloud_data_battery *bat_buf)
+{
+	int err;
+	struct data_buffers buffers = {
+		.gps_buf = gps_buf,
+		.sensor_buf = sensor_buf,
+		.modem_stat_buf = modem_stat_buf,
+		.modem_dyn_buf = modem_dyn_buf,
+		.ui_buf = ui_buf,
+		.accel_buf = accel_buf,
+		.bat_buf = bat_buf,
+	};
+
+	err = json_common_encode(output, data_encode, &buffers);
+	if (err) {
+		return err;
 	}
 
-	output->buf = buffer;
-	output->len = strlen(buffer);
+	encoded_output_print("Encoded message:\n", output);
 
-exit:
-	cJSON_Delete(root_obj);
-	return err;
+	return 0;
 }
 
-int cloud_codec_encode_ui_data(struct cloud_codec_data *output,
-			       struct cloud_data_ui *ui_buf)
+static int ui_data_encode(struct json_writer *writer, void *user_data)
 {
 	int err;
-	char *buffer;
-
-	cJSON *root_obj = cJSON_CreateObject();
+	struct cloud_data_ui *ui_buf = user_data;
 
-	if (root_obj == NULL) {
-		cJSON_Delete(root_obj);
-		return -ENOMEM;
-	}
+	json_writer_object_start(writer, NULL);
 
-	err = json_common_ui_data_add(root_obj, ui_buf,
-				      JSON_COMMON_ADD_DATA_TO_OBJECT,
-				      DATA_BUTTON,
-				      NULL);
+	err = json_common_ui_data_add(writer, ui_buf, DATA_BUTTON);
 	if (err) {
-		goto exit;
+		return err;
 	}
 
-	buffer = cJSON_PrintUnformatted(root_obj);
-	if (buffer == NULL) {
-		LOG_ERR("Failed to allocate memory for JSON string");
+	json_writer_object_end(writer);
 
-		err = -ENOMEM;
-		goto exit;
+	return json_writer_error(writer);
+}
+
+int cloud_codec_encode_ui_data(struct cloud_codec_data *output,
+			       struct cloud_data_ui *ui_buf)
+{
+	int err;
+
+	if (IS_ENABLED(CONFIG_CLOUD_CODEC_CBOR)) {
+		return cbor_common_ui_data_encode(output, ui_buf);
 	}
 
-	if (IS_ENABLED(CONFIG_CLOUD_CODEC_LOG_LEVEL_DBG)) {
-		json_print_obj("Encoded message:\n", root_obj);
+	err = json_common_encode(output, ui_data_encode, ui_buf);
+	if (err) {
+		return err;
 	}
 
-	output->buf = buffer;
-	output->len = strlen(buffer);
+	encoded_output_print("Encoded message:\n", output);
 
-exit:
-	cJSON_Delete(root_obj);
-	return err;
+	return 0;
 }
 
-int cloud_codec_encode_batch_data(
-				struct cloud_codec_data *output,
-				struct cloud_data_gps *gps_buf,
-				struct cloud_data_sensors *sensor_buf,
-				struct cloud_data_modem_dynamic *modem_dyn_buf,
-				struct cloud_data_ui *ui_buf,
-				struct cloud_data_accelerometer *accel_buf,
-				struct cloud_data_battery *bat_buf,
-				size_t gps_buf_count,
-				size_t sensor_buf_count,
-				size_t modem_dyn_buf_count,
-				size_t ui_buf_count,
-				size_t accel_buf_count,
-				size_t bat_buf_count)
+static int batch_data_encode(struct json_writer *writer, void *user_data)
 {
 	int err;
-	char *buffer;
 	bool object_added = false;
+	struct data_buffers *buffers = user_data;
 
-	cJSON *root_obj = cJSON_CreateObject();
+	json_writer_object_start(writer, NULL);
 
-	if (root_obj == NULL) {
-		cJSON_Delete(root_obj);
-		return -ENOMEM;
-	}
-
-	err = json_common_batch_data_add(root_obj, JSON_COMMON_MODEM_DYNAMIC,
-					 modem_dyn_buf, modem_dyn_buf_count,
+	err = json_common_batch_data_add(writer, JSON_COMMON_MODEM_DYNAMIC,
+					 buffers->modem_dyn_buf, buffers->modem_dyn_buf_count,
 					 DATA_MODEM_DYNAMIC);
 	if (err == 0) {
 		object_added = true;
 	} else if (err != -ENODATA) {
-		goto exit;
+		return err;
 	}
 
-	err = json_common_batch_data_add(root_obj, JSON_COMMON_GPS,
-					 gps_buf, gps_buf_count,
+	err = json_common_batch_data_add(writer, JSON_COMMON_GPS,
+					 buffers->gps_buf, buffers->gps_buf_count,
 					 DATA_GPS);
 	if (err == 0) {
 		object_added = true;
 	} else if (err != -ENODATA) {
-		goto exit;
+		return err;
 	}
 
-	err = json_common_batch_data_add(root_obj, JSON_COMMON_SENSOR,
-					 sensor_buf, sensor_buf_count,
+	err = json_common_batch_data_add(writer, JSON_COMMON_SENSOR,
+					 buffers->sensor_buf, buffers->sensor_buf_count,
 					 DATA_ENVIRONMENTALS);
 	if (err == 0) {
 		object_added = true;
 	} else if (err != -ENODATA) {
-		goto exit;
+		return err;
 	}
 
-	err = json_common_batch_data_add(root_obj, JSON_COMMON_UI,
-					 ui_buf, ui_buf_count,
+	err = json_common_batch_data_add(writer, JSON_COMMON_UI,
+					 buffers->ui_buf, buffers->ui_buf_count,
 					 DATA_BUTTON);
 	if (err == 0) {
 		object_added = true;
 	} else if (err != -ENODATA) {
-		goto exit;
+		return err;
 	}
 
-	err = json_common_batch_data_add(root_obj, JSON_COMMON_BATTERY,
-					 bat_buf, bat_buf_count,
+	err = json_common_batch_data_add(writer, JSON_COMMON_BATTERY,
+					 buffers->bat_buf, buffers->bat_buf_count,
 					 DATA_BATTERY);
 	if (err == 0) {
 		object_added = true;
 	} else if (err != -ENODATA) {
-		goto exit;
+		return err;
 	}
 
-	err = json_common_batch_data_add(root_obj, JSON_COMMON_ACCELEROMETER,
-					 accel_buf, accel_buf_count,
+	err = json_common_batch_data_add(writer, JSON_COMMON_ACCELEROMETER,
+					 buffers->accel_buf, buffers->accel_buf_count,
 					 DATA_MOVEMENT);
 	if (err == 0) {
 		object_added = true;
 	} else if (err != -ENODATA) {
-		goto exit;
+		return err;
 	}
 
 	if (!object_added) {
-		err = -ENODATA;
 		LOG_DBG("No data to encode, JSON string empty...");
-		goto exit;
-	} else {
-		/* At this point err can be either 0 or -ENODATA. Explicitly set err to 0 if
-		 * objects has been added to the rootj object.
-		 */
-		err = 0;
+		return -ENODATA;
 	}
 
-	buffer = cJSON_PrintUnformatted(root_obj);
-	if (buffer == NULL) {
-		LOG_ERR("Failed to allocate memory for JSON string");
+	json_writer_object_end(writer);
 
-		err = -ENOMEM;
-		goto exit;
-	}
+	return json_writer_error(writer);
+}
 
-	if (IS_ENABLED(CONFIG_CLOUD_CODEC_LOG_LEVEL_DBG)) {
-		json_print_obj("Encoded batch message:\n", root_obj);
+int cloud_codec_encode_batch_data(
+				struct cloud_codec_data *output,
+				struct cloud_data_gps *gps_buf,
+				struct cloud_data_sensors *sensor_buf,
+				struct cloud_data_modem_dynamic *modem_dyn_buf,
+				struct cloud_data_ui *ui_buf,
+				struct cloud_data_accelerometer *accel_buf,
+				struct cloud_data_battery *bat_buf,
+				size_t gps_buf_count,
+				size_t sensor_buf_count,
+				size_t modem_dyn_buf_count,
+				size_t ui_buf_count,
+				size_t accel_buf_count,
+				size_t bat_buf_count)
+{
+	int err;
+	struct data_buffers buffers = {
+		.gps_buf = gps_buf,
+		.sensor_buf = sensor_buf,
+		.modem_dyn_buf = modem_dyn_buf,
+		.ui_buf = ui_buf,
+		.accel_buf = accel_buf,
+		.bat_buf = bat_buf,
+		.gps_buf_count = gps_buf_count,
+		.sensor_buf_count = sensor_buf_count,
+		.modem_dyn_buf_count = modem_dyn_buf_count,
+		.ui_buf_count = ui_buf_count,
+		.accel_buf_count = accel_buf_count,
+		.bat_buf_count = bat_buf_count,
+	};
+
+	if (IS_ENABLED(CONFIG_CLOUD_CODEC_CBOR_BATCH_DELTA)) {
+		return cbor_common_batch_data_delta_encode(output, gps_buf, sensor_buf,
+							   modem_dyn_buf, ui_buf, accel_buf,
+							   bat_buf, gps_buf_count,
+							   sensor_buf_count, modem_dyn_buf_count,
+							   ui_buf_count, accel_buf_count,
+							   bat_buf_count);
+	}
+
+	if (IS_ENABLED(CONFIG_CLOUD_CODEC_CBOR)) {
+		return cbor_common_batch_data_encode(output, gps_buf, sensor_buf, modem_dyn_buf,
+						     ui_buf, accel_buf, bat_buf, gps_buf_count,
+						     sensor_buf_count, modem_dyn_buf_count,
+						     ui_buf_count, accel_buf_count, bat_buf_count);
+	}
+
+	err = json_common_encode(output, batch_data_encode, &buffers);
+	if (err) {
+		return err;
 	}
 
-	output->buf = buffer;
-	output->len = strlen(buffer);
+	encoded_output_print("Encoded batch message:\n", output);
 
-exit:
-	cJSON_Delete(root_obj);
-	return err;
+	return 0;
 }
@@ -0,0 +1,1008 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+#include <errno.h>
+#include <date_time.h>
+
+#include "cloud_codec.h"
+#include "cbor_common.h"
+#include "json_protocol_names.h"
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(cbor_common, CONFIG_CLOUD_CODEC_LOG_LEVEL);
+
+/* CBOR major types, RFC 8949 section 3.1. */
+#define CBOR_UINT		0
+#define CBOR_NINT		1
+#define CBOR_TEXT		3
+#define CBOR_ARRAY		4
+#define CBOR_MAP		5
+#define CBOR_SIMPLE		7
+
+/* Additional information giving the length of the argument. */
+#define CBOR_ARG_1		24
+#define CBOR_ARG_2		25
+#define CBOR_ARG_4		26
+#define CBOR_ARG_8		27
+
+/* Size of the longest head: initial byte and 8-byte argument. */
+#define CBOR_HEAD_MAX_LEN	9
+
+/* Largest integer that a double holds exactly. */
+#define DOUBLE_INT_MAX		9007199254740992.0
+
+/* Scale of the fixed-point coordinates of the delta encoding, in units of 1e-7 degrees. */
+#define DELTA_FIXED_SCALE	10000000.0
+
+/* Largest number of fields of an entry in the delta encoding. */
+#define DELTA_FIELDS_MAX	6
+
+/* The output is encoded twice: a first pass without buffer gives the length of the output, and
+ * a second pass writes it into a buffer of this length. Nothing is modified in the first pass.
+ */
+struct encoder {
+	/* Output buffer, NULL in the first pass. */
+	uint8_t *buf;
+	size_t size;
+	size_t len;
+};
+
+enum delta_field_type {
+	/* Number, written when it changes. */
+	DELTA_NUMBER,
+	/* Integer, written when it changes. */
+	DELTA_INT,
+	/* Fixed-point integer, written as the difference from its previous value. */
+	DELTA_FIXED,
+	/* Text, written when it changes. */
+	DELTA_TEXT,
+};
+
+union delta_value {
+	double number;
+	/* Value of DELTA_INT and DELTA_FIXED fields. */
+	int64_t integer;
+	const char *text;
+};
+
+/* Values of an entry in the delta encoding. */
+struct delta_record {
+	/* Uptime of the entry, before it is converted. */
+	int64_t ts;
+	/* Timestamp of the entry, converted if it is written in full. */
+	int64_t *ts_ptr;
+	/* Bit n is set if field n has a value. */
+	uint8_t fields;
+	union delta_value values[DELTA_FIELDS_MAX];
+};
+
+/* Fields of the entries of a data type in the delta encoding. */
+struct delta_schema {
+	const enum delta_field_type *types;
+	size_t field_count;
+	/* Gets the values of an entry. Returns -ENODATA if the entry is not to be encoded. */
+	int (*record_get)(void *entry, struct delta_record *record);
+	void (*unqueue)(void *entry);
+};
+
+struct buffer {
+	const char *label;
+	/* Encodes an entry. Returns -ENODATA if the entry is not to be encoded. */
+	int (*encode)(struct encoder *enc, void *entry);
+	uint8_t *entries;
+	size_t entry_size;
+	size_t count;
+	/* Encode the entries in an array, instead of the first one only. */
+	bool array;
+	/* Number of entries to encode, found in the first pass. */
+	size_t queued;
+	/* Delta encoding of the entries, instead of encode, if not NULL. */
+	const struct delta_schema *delta;
+	/* Index of the oldest entry to encode, found in the first pass of the delta encoding. */
+	size_t first;
+};
+
+#define BUFFER(_label, _encode, _entries, _count, _array)	\
+	{							\
+		.label = _label,				\
+		.encode = _encode,				\
+		.entries = (uint8_t *)_entries,			\
+		.entry_size = sizeof(*(_entries)),		\
+		.count = _count,				\
+		.array = _array,				\
+	}
+
+#define DELTA_BUFFER(_label, _schema, _entries, _count)	\
+	{							\
+		.label = _label,				\
+		.entries = (uint8_t *)_entries,			\
+		.entry_size = sizeof(*(_entries)),		\
+		.count = _count,				\
+		.array = true,					\
+		.delta = &_schema,				\
+	}
+
+static bool measuring(const struct encoder *enc)
+{
+	return enc->buf == NULL;
+}
+
+static void put(struct encoder *enc, const void *data, size_t len)
+{
+	if (!measuring(enc) && (enc->len + len <= enc->size)) {
+		memcpy(&enc->buf[enc->len], data, len);
+	}
+
+	enc->len += len;
+}
+
+/* Puts the initial byte of a data item and its argument in big-endian byte order. */
+static void arg_put(struct encoder *enc, uint8_t major, uint8_t info, uint64_t arg,
+		    size_t arg_len)
+{
+	uint8_t head[CBOR_HEAD_MAX_LEN];
+
+	head[0] = (major << 5) | info;
+
+	for (size_t i = 0; i < arg_len; i++) {
+		head[1 + i] = arg >> (8 * (arg_len - 1 - i));
+	}
+
+	put(enc, head, 1 + arg_len);
+}
+
+/* Puts the head of a data item, with its argument in as few bytes as possible. */
+static void head_put(struct encoder *enc, uint8_t major, uint64_t arg)
+{
+	if (arg < CBOR_ARG_1) {
+		arg_put(enc, major, arg, 0, 0);
+	} else if (arg <= UINT8_MAX) {
+		arg_put(enc, major, CBOR_ARG_1, arg, 1);
+	} else if (arg <= UINT16_MAX) {
+		arg_put(enc, major, CBOR_ARG_2, arg, 2);
+	} else if (arg <= UINT32_MAX) {
+		arg_put(enc, major, CBOR_ARG_4, arg, 4);
+	} else {
+		arg_put(enc, major, CBOR_ARG_8, arg, 8);
+	}
+}
+
+static void int_put(struct encoder *enc, int64_t value)
+{
+	if (value >= 0) {
+		head_put(enc, CBOR_UINT, value);
+	} else {
+		head_put(enc, CBOR_NINT, -(value + 1));
+	}
+}
+
+static void text_put(struct encoder *enc, const char *text)
+{
+	size_t len = strlen(text);
+
+	head_put(enc, CBOR_TEXT, len);
+	put(enc, text, len);
+}
+
+/* Integral values are encoded as integers, like cJSON prints them. Other values are encoded in
+ * single precision if they are exact in it, and in double precision otherwise.
+ */
+static void number_put(struct encoder *enc, double value)
+{
+	if ((value > -DOUBLE_INT_MAX) && (value < DOUBLE_INT_MAX) &&
+	    ((double)(int64_t)value == value)) {
+		int_put(enc, value);
+	} else if ((value >= -FLT_MAX) && (value <= FLT_MAX) &&
+		   ((double)(float)value == value)) {
+		float single = value;
+		uint32_t bits;
+
+		memcpy(&bits, &single, sizeof(bits));
+		arg_put(enc, CBOR_SIMPLE, CBOR_ARG_4, bits, sizeof(bits));
+	} else {
+		uint64_t bits;
+
+		memcpy(&bits, &value, sizeof(bits));
+		arg_put(enc, CBOR_SIMPLE, CBOR_ARG_8, bits, sizeof(bits));
+	}
+}
+
+/* The timestamp is converted to UNIX time when it is written. Its largest encoding is counted
+ * in the first pass, so that the conversion is done once.
+ */
+static int timestamp_put(struct encoder *enc, int64_t *ts)
+{
+	int err;
+
+	if (measuring(enc)) {
+		enc->len += CBOR_HEAD_MAX_LEN;
+		return 0;
+	}
+
+	err = date_time_uptime_to_unix_time_ms(ts);
+	if (err) {
+		LOG_ERR("date_time_uptime_to_unix_time_ms, error: %d", err);
+		return err;
+	}
+
+	int_put(enc, *ts);
+
+	return 0;
+}
+
+/* Puts the head of an entry, followed by the label of its value. */
+static void entry_start(struct encoder *enc)
+{
+	head_put(enc, CBOR_MAP, 2);
+	text_put(enc, DATA_VALUE);
+}
+
+/* Converts mccmnc to unsigned long integer. */
+static int mccmnc_get(const char *str, uint32_t *mccmnc)
+{
+	char *end_ptr;
+
+	errno = 0;
+	*mccmnc = strtoul(str, &end_ptr, 10);
+
+	if ((errno == ERANGE) || (*end_ptr != '\0')) {
+		LOG_ERR("MCCMNC string could not be converted.");
+		return -ENOTEMPTY;
+	}
+
+	return 0;
+}
+
+static int modem_dynamic_data_encode(struct encoder *enc, void *entry)
+{
+	struct cloud_data_modem_dynamic *data = entry;
+	uint32_t mccmnc = 0;
+	size_t values;
+	int err;
+
+	if (!data->queued) {
+		return -ENODATA;
+	}
+
+	if (data->mccmnc_fresh) {
+		err = mccmnc_get(data->mccmnc, &mccmnc);
+		if (err) {
+			return err;
+		}
+	}
+
+	values = data->rsrp_fresh + data->area_code_fresh + data->mccmnc_fresh +
+		 data->cell_id_fresh + data->ip_address_fresh;
+	if (values == 0) {
+		if (!measuring(enc)) {
+			data->queued = false;
+			LOG_WRN("No valid dynamic modem data values present, entry unqueued");
+		}
+		return -ENODATA;
+	}
+
+	entry_start(enc);
+	head_put(enc, CBOR_MAP, values);
+
+	if (data->rsrp_fresh) {
+		text_put(enc, MODEM_RSRP);
+		int_put(enc, data->rsrp);
+	}
+
+	if (data->area_code_fresh) {
+		text_put(enc, MODEM_AREA_CODE);
+		int_put(enc, data->area);
+	}
+
+	if (data->mccmnc_fresh) {
+		text_put(enc, MODEM_MCCMNC);
+		int_put(enc, mccmnc);
+	}
+
+	if (data->cell_id_fresh) {
+		text_put(enc, MODEM_CELL_ID);
+		int_put(enc, data->cell);
+	}
+
+	if (data->ip_address_fresh) {
+		text_put(enc, MODEM_IP_ADDRESS);
+		text_put(enc, data->ip);
+	}
+
+	text_put(enc, DATA_TIMESTAMP);
+	err = timestamp_put(enc, &data->ts);
+	if (err) {
+		return err;
+	}
+
+	if (!measuring(enc)) {
+		data->queued = false;
+	}
+
+	return 0;
+}
+
+static int gps_data_encode(struct encoder *enc, void *entry)
+{
+	struct cloud_data_gps *data = entry;
+	int err;
+
+	if (!data->queued) {
+		return -ENODATA;
+	}
+
+	entry_start(enc);
+	head_put(enc, CBOR_MAP, 6);
+	text_put(enc, DATA_GPS_LONGITUDE);
+	number_put(enc, data->longi);
+	text_put(enc, DATA_GPS_LATITUDE);
+	number_put(enc, data->lat);
+	text_put(enc, DATA_MOVEMENT);
+	number_put(enc, data->acc);
+	text_put(enc, DATA_GPS_ALTITUDE);
+	number_put(enc, data->alt);
+	text_put(enc, DATA_GPS_SPEED);
+	number_put(enc, data->spd);
+	text_put(enc, DATA_GPS_HEADING);
+	number_put(enc, data->hdg);
+
+	text_put(enc, DATA_TIMESTAMP);
+	err = timestamp_put(enc, &data->gps_ts);
+	if (err) {
+		return err;
+	}
+
+	if (!measuring(enc)) {
+		data->queued = false;
+	}
+
+	return 0;
+}
+
+static int sensor_data_encode(struct encoder *enc, void *entry)
+{
+	struct cloud_data_sensors *data = entry;
+	int err;
+
+	if (!data->queued) {
+		return -ENODATA;
+	}
+
+	entry_start(enc);
+	head_put(enc, CBOR_MAP, 2);
+	text_put(enc, DATA_TEMPERATURE);
+	number_put(enc, data->temp);
+	text_put(enc, DATA_HUMID);
+	number_put(enc, data->hum);
+
+	text_put(enc, DATA_TIMESTAMP);
+	err = timestamp_put(enc, &data->env_ts);
+	if (err) {
+		return err;
+	}
+
+	if (!measuring(enc)) {
+		data->queued = false;
+	}
+
+	return 0;
+}
+
+static int ui_data_encode(struct encoder *enc, void *entry)
+{
+	struct cloud_data_ui *data = entry;
+	int err;
+
+	if (!data->queued) {
+		return -ENODATA;
+	}
+
+	entry_start(enc);
+	int_put(enc, data->btn);
+
+	text_put(enc, DATA_TIMESTAMP);
+	err = timestamp_put(enc, &data->btn_ts);
+	if (err) {
+		return err;
+	}
+
+	if (!measuring(enc)) {
+		data->queued = false;
+	}
+
+	return 0;
+}
+
+static int battery_data_encode(struct encoder *enc, void *entry)
+{
+	struct cloud_data_battery *data = entry;
+	int err;
+
+	if (!data->queued) {
+		return -ENODATA;
+	}
+
+	entry_start(enc);
+	int_put(enc, data->bat);
+
+	text_put(enc, DATA_TIMESTAMP);
+	err = timestamp_put(enc, &data->bat_ts);
+	if (err) {
+		return err;
+	}
+
+	if (!measuring(enc)) {
+		data->queued = false;
+	}
+
+	return 0;
+}
+
+static int accel_data_encode(struct encoder *enc, void *entry)
+{
+	struct cloud_data_accelerometer *data = entry;
+	int err;
+
+	if (!data->queued) {
+		return -ENODATA;
+	}
+
+	entry_start(enc);
+	head_put(enc, CBOR_MAP, 3);
+	text_put(enc, DATA_MOVEMENT_X);
+	number_put(enc, data->values[0]);
+	text_put(enc, DATA_MOVEMENT_Y);
+	number_put(enc, data->values[1]);
+	text_put(enc, DATA_MOVEMENT_Z);
+	number_put(enc, data->values[2]);
+
+	text_put(enc, DATA_TIMESTAMP);
+	err = timestamp_put(enc, &data->ts);
+	if (err) {
+		return err;
+	}
+
+	if (!measuring(enc)) {
+		data->queued = false;
+	}
+
+	return 0;
+}
+
+static int modem_dynamic_record_get(void *entry, struct delta_record *record)
+{
+	struct cloud_data_modem_dynamic *data = entry;
+	uint32_t mccmnc;
+	int err;
+
+	if (!data->queued) {
+		return -ENODATA;
+	}
+
+	record->ts = data->ts;
+	record->ts_ptr = &data->ts;
+	record->fields = 0;
+
+	if (data->rsrp_fresh) {
+		record->fields |= BIT(0);
+		record->values[0].integer = data->rsrp;
+	}
+
+	if (data->area_code_fresh) {
+		record->fields |= BIT(1);
+		record->values[1].integer = data->area;
+	}
+
+	if (data->mccmnc_fresh) {
+		err = mccmnc_get(data->mccmnc, &mccmnc);
+		if (err) {
+			return err;
+		}
+
+		record->fields |= BIT(2);
+		record->values[2].integer = mccmnc;
+	}
+
+	if (data->cell_id_fresh) {
+		record->fields |= BIT(3);
+		record->values[3].integer = data->cell;
+	}
+
+	if (data->ip_address_fresh) {
+		record->fields |= BIT(4);
+		record->values[4].text = data->ip;
+	}
+
+	/* Unqueued without being encoded. */
+	if (record->fields == 0) {
+		return -ENODATA;
+	}
+
+	return 0;
+}
+
+static void modem_dynamic_unqueue(void *entry)
+{
+	((struct cloud_data_modem_dynamic *)entry)->queued = false;
+}
+
+static int gps_record_get(void *entry, struct delta_record *record)
+{
+	struct cloud_data_gps *data = entry;
+
+	if (!data->queued) {
+		return -ENODATA;
+	}
+
+	record->ts = data->gps_ts;
+	record->ts_ptr = &data->gps_ts;
+	record->fields = BIT_MASK(6);
+	record->values[0].integer = llround(data->longi * DELTA_FIXED_SCALE);
+	record->values[1].integer = llround(data->lat * DELTA_FIXED_SCALE);
+	record->values[2].number = data->acc;
+	record->values[3].number = data->alt;
+	record->values[4].number = data->spd;
+	record->values[5].number = data->hdg;
+
+	return 0;
+}
+
+static void gps_unqueue(void *entry)
+{
+	((struct cloud_data_gps *)entry)->queued = false;
+}
+
+static int sensor_record_get(void *entry, struct delta_record *record)
+{
+	struct cloud_data_sensors *data = entry;
+
+	if (!data->queued) {
+		return -ENODATA;
+	}
+
+	record->ts = data->env_ts;
+	record->ts_ptr = &data->env_ts;
+	record->fields = BIT_MASK(2);
+	record->values[0].number = data->temp;
+	record->values[1].number = data->hum;
+
+	return 0;
+}
+
+static void sensor_unqueue(void *entry)
+{
+	((struct cloud_data_sensors *)entry)->queued = false;
+}
+
+static int ui_record_get(void *entry, struct delta_record *record)
+{
+	struct cloud_data_ui *data = entry;
+
+	if (!data->queued) {
+		return -ENODATA;
+	}
+
+	record->ts = data->btn_ts;
+	record->ts_ptr = &data->btn_ts;
+	record->fields = BIT(0);
+	record->values[0].integer = data->btn;
+
+	return 0;
+}
+
+static void ui_unqueue(void *entry)
+{
+	((struct cloud_data_ui *)entry)->queued = false;
+}
+
+static int battery_record_get(void *entry, struct delta_record *record)
+{
+	struct cloud_data_battery *data = entry;
+
+	if (!data->queued) {
+		return -ENODATA;
+	}
+
+	record->ts = data->bat_ts;
+	record->ts_ptr = &data->bat_ts;
+	record->fields = BIT(0);
+	record->values[0].integer = data->bat;
+
+	return 0;
+}
+
+static void battery_unqueue(void *entry)
+{
+	((struct cloud_data_battery *)entry)->queued = false;
+}
+
+static int accel_record_get(void *entry, struct delta_record *record)
+{
+	struct cloud_data_accelerometer *data = entry;
+
+	if (!data->queued) {
+		return -ENODATA;
+	}
+
+	record->ts = data->ts;
+	record->ts_ptr = &data->ts;
+	record->fields = BIT_MASK(3);
+	record->values[0].number = data->values[0];
+	record->values[1].number = data->values[1];
+	record->values[2].number = data->values[2];
+
+	return 0;
+}
+
+static void accel_unqueue(void *entry)
+{
+	((struct cloud_data_accelerometer *)entry)->queued = false;
+}
+
+/* The fields are in the same order as the values of the JSON entries. */
+static const enum delta_field_type modem_dynamic_fields[] = {
+	DELTA_INT, DELTA_INT, DELTA_INT, DELTA_INT, DELTA_TEXT
+};
+static const enum delta_field_type gps_fields[] = {
+	DELTA_FIXED, DELTA_FIXED, DELTA_NUMBER, DELTA_NUMBER, DELTA_NUMBER, DELTA_NUMBER
+};
+static const enum delta_field_type sensor_fields[] = { DELTA_NUMBER, DELTA_NUMBER };
+static const enum delta_field_type ui_fields[] = { DELTA_INT };
+static const enum delta_field_type battery_fields[] = { DELTA_INT };
+static const enum delta_field_type accel_fields[] = {
+	DELTA_NUMBER, DELTA_NUMBER, DELTA_NUMBER
+};
+
+#define DELTA_SCHEMA(_name)						\
+	static const struct delta_schema _name##_schema = {		\
+		.types = _name##_fields,				\
+		.field_count = ARRAY_SIZE(_name##_fields),		\
+		.record_get = _name##_record_get,			\
+		.unqueue = _name##_unqueue,				\
+	};								\
+	BUILD_ASSERT(ARRAY_SIZE(_name##_fields) <= DELTA_FIELDS_MAX, "Too many fields")
+
+DELTA_SCHEMA(modem_dynamic);
+DELTA_SCHEMA(gps);
+DELTA_SCHEMA(sensor);
+DELTA_SCHEMA(ui);
+DELTA_SCHEMA(battery);
+DELTA_SCHEMA(accel);
+
+static bool delta_value_equal(enum delta_field_type type, const union delta_value *a,
+			      const union delta_value *b)
+{
+	switch (type) {
+	case DELTA_NUMBER:
+		return a->number == b->number;
+	case DELTA_TEXT:
+		return strcmp(a->text, b->text) == 0;
+	default:
+		return a->integer == b->integer;
+	}
+}
+
+/* Puts an entry as an array of its timestamp, the mask of the fields that it changes, and the
+ * values of these fields. The state holds the last value of each field, as the decoder has it.
+ * The first entry has no previous values, so that it is written in full with its UNIX time.
+ */
+static int delta_entry_put(struct encoder *enc, const struct delta_schema *schema,
+			   const struct delta_record *record, struct delta_record *state,
+			   bool first)
+{
+	int err;
+	uint8_t changed = 0;
+	size_t changed_count = 0;
+
+	for (size_t i = 0; i < schema->field_count; i++) {
+		if (!(record->fields & BIT(i))) {
+			continue;
+		}
+
+		if ((state->fields & BIT(i)) &&
+		    delta_value_equal(schema->types[i], &record->values[i], &state->values[i])) {
+			continue;
+		}
+
+		changed |= BIT(i);
+		changed_count++;
+	}
+
+	head_put(enc, CBOR_ARRAY, 2 + changed_count);
+
+	if (first) {
+		err = timestamp_put(enc, record->ts_ptr);
+		if (err) {
+			return err;
+		}
+	} else {
+		int_put(enc, record->ts - state->ts);
+	}
+
+	head_put(enc, CBOR_UINT, changed);
+
+	for (size_t i = 0; i < schema->field_count; i++) {
+		const union delta_value *value = &record->values[i];
+
+		if (!(changed & BIT(i))) {
+			continue;
+		}
+
+		switch (schema->types[i]) {
+		case DELTA_NUMBER:
+			number_put(enc, value->number);
+			break;
+		case DELTA_INT:
+			int_put(enc, value->integer);
+			break;
+		case DELTA_FIXED:
+			if (state->fields & BIT(i)) {
+				int_put(enc, value->integer - state->values[i].integer);
+			} else {
+				int_put(enc, value->integer);
+			}
+			break;
+		case DELTA_TEXT:
+			text_put(enc, value->text);
+			break;
+		}
+
+		state->values[i] = *value;
+	}
+
+	state->fields |= changed;
+	state->ts = record->ts;
+
+	return 0;
+}
+
+/* Encodes the entries of a buffer from the oldest one, so that the differences between the
+ * entries are small. The oldest entry is found in the first pass.
+ */
+static int delta_buffer_encode(struct encoder *enc, struct buffer *buffer)
+{
+	int err;
+	const struct delta_schema *schema = buffer->delta;
+	struct delta_record record;
+	struct delta_record state = { 0 };
+	size_t written = 0;
+
+	if (measuring(enc)) {
+		int64_t oldest = INT64_MAX;
+
+		buffer->queued = 0;
+		buffer->first = 0;
+
+		for (size_t i = 0; i < buffer->count; i++) {
+			err = schema->record_get(&buffer->entries[i * buffer->entry_size], &record);
+			if (err == -ENODATA) {
+				continue;
+			} else if (err) {
+				LOG_ERR("Failed encoding %s entry, error: %d", buffer->label, err);
+				return err;
+			}
+
+			if (record.ts < oldest) {
+				oldest = record.ts;
+				buffer->first = i;
+			}
+
+			buffer->queued++;
+		}
+	}
+
+	if (buffer->queued > 0) {
+		text_put(enc, buffer->label);
+		head_put(enc, CBOR_ARRAY, buffer->queued);
+	}
+
+	for (size_t i = 0; i < buffer->count; i++) {
+		size_t index = (buffer->first + i) % buffer->count;
+		void *entry = &buffer->entries[index * buffer->entry_size];
+
+		err = schema->record_get(entry, &record);
+		if (err == -ENODATA) {
+			if (!measuring(enc)) {
+				/* Entries without values are unqueued as well. */
+				schema->unqueue(entry);
+			}
+			continue;
+		} else if (err) {
+			LOG_ERR("Failed encoding %s entry, error: %d", buffer->label, err);
+			return err;
+		}
+
+		err = delta_entry_put(enc, schema, &record, &state, written == 0);
+		if (err) {
+			LOG_ERR("Failed encoding %s entry, error: %d", buffer->label, err);
+			return err;
+		}
+
+		if (!measuring(enc)) {
+			schema->unqueue(entry);
+		}
+
+		written++;
+	}
+
+	return 0;
+}
+
+/* Encodes the entries of a buffer, or the first one if it is not encoded in an array. */
+static int buffer_encode(struct encoder *enc, struct buffer *buffer)
+{
+	int err;
+	size_t count = buffer->array ? buffer->count : MIN(buffer->count, 1);
+	size_t queued = 0;
+
+	if (buffer->delta != NULL) {
+		return delta_buffer_encode(enc, buffer);
+	}
+
+	if (!measuring(enc)) {
+		if (buffer->queued == 0) {
+			return 0;
+		}
+
+		text_put(enc, buffer->label);
+
+		if (buffer->array) {
+			head_put(enc, CBOR_ARRAY, buffer->queued);
+		}
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		err = buffer->encode(enc, &buffer->entries[i * buffer->entry_size]);
+		if (err == 0) {
+			queued++;
+		} else if (err != -ENODATA) {
+			LOG_ERR("Failed encoding %s entry, error: %d", buffer->label, err);
+			return err;
+		}
+	}
+
+	if (measuring(enc)) {
+		buffer->queued = queued;
+
+		if (queued > 0) {
+			text_put(enc, buffer->label);
+
+			if (buffer->array) {
+				head_put(enc, CBOR_ARRAY, queued);
+			}
+		}
+	}
+
+	return 0;
+}
+
+/* Encodes a map of the buffers that have entries to encode. */
+static int buffers_encode(struct cloud_codec_data *output, struct buffer *buffers,
+			  size_t buffer_count)
+{
+	int err;
+	struct encoder enc = { 0 };
+	size_t map_size = 0;
+
+	for (size_t i = 0; i < buffer_count; i++) {
+		err = buffer_encode(&enc, &buffers[i]);
+		if (err) {
+			return err;
+		}
+
+		if (buffers[i].queued > 0) {
+			map_size++;
+		}
+	}
+
+	if (map_size == 0) {
+		LOG_DBG("No data to encode, CBOR output empty...");
+		return -ENODATA;
+	}
+
+	head_put(&enc, CBOR_MAP, map_size);
+
+	enc.size = enc.len;
+	enc.len = 0;
+	enc.buf = k_malloc(enc.size);
+	if (enc.buf == NULL) {
+		LOG_ERR("Failed to allocate memory for CBOR output");
+		return -ENOMEM;
+	}
+
+	head_put(&enc, CBOR_MAP, map_size);
+
+	for (size_t i = 0; i < buffer_count; i++) {
+		err = buffer_encode(&enc, &buffers[i]);
+		if (err) {
+			k_free(enc.buf);
+			return err;
+		}
+	}
+
+	if (enc.len > enc.size) {
+		LOG_ERR("Encoded output overflowed the buffer");
+		k_free(enc.buf);
+		return -ENOMEM;
+	}
+
+	LOG_HEXDUMP_DBG(enc.buf, enc.len, "Encoded message:");
+
+	output->buf = (char *)enc.buf;
+	output->len = enc.len;
+
+	return 0;
+}
+
+int cbor_common_ui_data_encode(struct cloud_codec_data *output,
+			       struct cloud_data_ui *ui_buf)
+{
+	struct buffer buffers[] = {
+		BUFFER(DATA_BUTTON, ui_data_encode, ui_buf, 1, false),
+	};
+
+	return buffers_encode(output, buffers, ARRAY_SIZE(buffers));
+}
+
+int cbor_common_batch_data_encode(struct cloud_codec_data *output,
+				  struct cloud_data_gps *gps_buf,
+				  struct cloud_data_sensors *sensor_buf,
+				  struct cloud_data_modem_dynamic *modem_dyn_buf,
+				  struct cloud_data_ui *ui_buf,
+				  struct cloud_data_accelerometer *accel_buf,
+				  struct cloud_data_battery *bat_buf,
+				  size_t gps_buf_count,
+				  size_t sensor_buf_count,
+				  size_t modem_dyn_buf_count,
+				  size_t ui_buf_count,
+				  size_t accel_buf_count,
+				  size_t bat_buf_count)
+{
+	/* Same order as the arrays of the JSON batch message. */
+	struct buffer buffers[] = {
+		BUFFER(DATA_MODEM_DYNAMIC, modem_dynamic_data_encode, modem_dyn_buf,
+		       modem_dyn_buf_count, true),
+		BUFFER(DATA_GPS, gps_data_encode, gps_buf, gps_buf_count, true),
+		BUFFER(DATA_ENVIRONMENTALS, sensor_data_encode, sensor_buf, sensor_buf_count, true),
+		BUFFER(DATA_BUTTON, ui_data_encode, ui_buf, ui_buf_count, true),
+		BUFFER(DATA_BATTERY, battery_data_encode, bat_buf, bat_buf_count, true),
+		BUFFER(DATA_MOVEMENT, accel_data_encode, accel_buf, accel_buf_count, true),
+	};
+
+	return buffers_encode(output, buffers, ARRAY_SIZE(buffers));
+}
+
+int cbor_common_batch_data_delta_encode(struct cloud_codec_data *output,
+					struct cloud_data_gps *gps_buf,
+					struct cloud_data_sensors *sensor_buf,
+					struct cloud_data_modem_dynamic *modem_dyn_buf,
+					struct cloud_data_ui *ui_buf,
+					struct cloud_data_accelerometer *accel_buf,
+					struct cloud_data_battery *bat_buf,
+					size_t gps_buf_count,
+					size_t sensor_buf_count,
+					size_t modem_dyn_buf_count,
+					size_t ui_buf_count,
+					size_t accel_buf_count,
+					size_t bat_buf_count)
+{
+	struct buffer buffers[] = {
+		DELTA_BUFFER(DATA_MODEM_DYNAMIC, modem_dynamic_schema, modem_dyn_buf,
+			     modem_dyn_buf_count),
+		DELTA_BUFFER(DATA_GPS, gps_schema, gps_buf, gps_buf_count),
+		DELTA_BUFFER(DATA_ENVIRONMENTALS, sensor_schema, sensor_buf, sensor_buf_count),
+		DELTA_BUFFER(DATA_BUTTON, ui_schema, ui_buf, ui_buf_count),
+		DELTA_BUFFER(DATA_BATTERY, battery_schema, bat_buf, bat_buf_count),
+		DELTA_BUFFER(DATA_MOVEMENT, accel_schema, accel_buf, accel_buf_count),
+	};
+
+	return buffers_encode(output, buffers, ARRAY_SIZE(buffers));
+}
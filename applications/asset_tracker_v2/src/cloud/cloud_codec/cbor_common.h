@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/**@file
+ * @brief CBOR common library header.
+ */
+
+#ifndef CBOR_COMMON_H__
+#define CBOR_COMMON_H__
+
+/**@file
+ *
+ * @defgroup CBOR common cbor_common
+ * @brief    Module containing common CBOR encoding functions.
+ *
+ * @details The data is encoded into the same structure as with the JSON common library, using
+ *	    the same labels, so that any CBOR decoder gives back the JSON document.
+ *	    Numbers are binary: integers are encoded in as few bytes as possible, and floating
+ *	    point numbers are encoded in single precision when it does not lose precision.
+ *	    The data is written directly into the output buffer without intermediate objects.
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <zephyr.h>
+
+#include "cloud_codec.h"
+
+/**
+ * @brief Encode button data.
+ *
+ * @details The output is a map with the button data labelled DATA_BUTTON, similarly to the
+ *	    JSON object encoded by json_common_ui_data_add().
+ *
+ * @param[out] output Encoded output. The buffer is allocated on the heap and must be freed with
+ *		      cloud_codec_release_data() after use.
+ * @param[in] ui_buf Pointer to data that is to be encoded.
+ *
+ * @return 0 on success. -ENODATA if the passed in data is not valid. Otherwise a negative error
+ *         code is returned.
+ */
+int cbor_common_ui_data_encode(struct cloud_codec_data *output,
+			       struct cloud_data_ui *ui_buf);
+
+/**
+ * @brief Encode the queued entries of the data buffers.
+ *
+ * @details The output is a map with an array of entries per data type, labelled like the arrays
+ *	    added by json_common_batch_data_add(). Data types without queued entries are left out.
+ *	    The encoded entries are unqueued.
+ *
+ * @param[out] output Encoded output. The buffer is allocated on the heap and must be freed with
+ *		      cloud_codec_release_data() after use.
+ *
+ * @return 0 on success. -ENODATA if none of the buffers have queued entries. Otherwise a negative
+ *         error code is returned.
+ */
+int cbor_common_batch_data_encode(struct cloud_codec_data *output,
+				  struct cloud_data_gps *gps_buf,
+				  struct cloud_data_sensors *sensor_buf,
+				  struct cloud_data_modem_dynamic *modem_dyn_buf,
+				  struct cloud_data_ui *ui_buf,
+				  struct cloud_data_accelerometer *accel_buf,
+				  struct cloud_data_battery *bat_buf,
+				  size_t gps_buf_count,
+				  size_t sensor_buf_count,
+				  size_t modem_dyn_buf_count,
+				  size_t ui_buf_count,
+				  size_t accel_buf_count,
+				  size_t bat_buf_count);
+
+/**
+ * @brief Encode the queued entries of the data buffers with delta encoding.
+ *
+ * @details The output is a map with an array of entries per data type, labelled like in
+ *	    cbor_common_batch_data_encode(), but the entries are not maps. Each entry is an array
+ *	    of its timestamp, a mask where bit n is set if the entry changes field n, and the new
+ *	    values of these fields in the order of the fields. The fields are the values of the
+ *	    JSON entries, in the same order:
+ *
+ *	    - roam: rsrp, area, mccmnc, cell, ip.
+ *	    - gps: lng, lat, acc, alt, spd, hdg.
+ *	    - env: temp, hum.
+ *	    - btn: the button number.
+ *	    - bat: the battery voltage.
+ *	    - acc: x, y, z.
+ *
+ *	    The entries are encoded from the oldest one. The first entry is the base record: its
+ *	    timestamp is in UNIX milliseconds and it has all of its fields. In the next entries,
+ *	    the timestamp is relative to the previous entry, and a field is left out if its value
+ *	    is the same as in the previous entries. A dynamic modem value that is not fresh is
+ *	    left out as well, so that the decoder keeps the previous value.
+ *
+ *	    The longitude and latitude are integers in units of 1e-7 degrees. They are written
+ *	    as the difference from their previous value, except in the base record. The other
+ *	    values are written like in cbor_common_batch_data_encode().
+ *
+ *	    The encoded entries are unqueued.
+ *
+ * @param[out] output Encoded output. The buffer is allocated on the heap and must be freed with
+ *		      cloud_codec_release_data() after use.
+ *
+ * @return 0 on success. -ENODATA if none of the buffers have queued entries. Otherwise a negative
+ *         error code is returned.
+ */
+int cbor_common_batch_data_delta_encode(struct cloud_codec_data *output,
+					struct cloud_data_gps *gps_buf,
+					struct cloud_data_sensors *sensor_buf,
+					struct cloud_data_modem_dynamic *modem_dyn_buf,
+					struct cloud_data_ui *ui_buf,
+					struct cloud_data_accelerometer *accel_buf,
+					struct cloud_data_battery *bat_buf,
+					size_t gps_buf_count,
+					size_t sensor_buf_count,
+					size_t modem_dyn_buf_count,
+					size_t ui_buf_count,
+					size_t accel_buf_count,
+					size_t bat_buf_count);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CBOR_COMMON_H__ */
@@ -5,7 +5,11 @@
  */
 
 #include <zephyr.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
 #include <cJSON.h>
+#include <json_writer.h>
 #include <date_time.h>
 
 #include "cloud_codec.h"
@@ -16,191 +20,162 @@
 #include <logging/log.h>
 LOG_MODULE_REGISTER(json_common, CONFIG_CLOUD_CODEC_LOG_LEVEL);
 
-static int op_code_handle(cJSON *parent, enum json_common_op_code op,
-			  const char *object_label, cJSON *child, cJSON **parent_ref)
+
+/* The timestamp of the data is converted into a copy, which is stored back in the data only when
+ * the data is written. This way, the data is unchanged when the writer only measures the output.
+ */
+static int timestamp_convert(int64_t *ts)
 {
-	switch (op) {
-	case JSON_COMMON_ADD_DATA_TO_ARRAY:
-		if (!cJSON_IsArray(parent)) {
-			LOG_WRN("Passed in parent object is not an array");
-			return -EINVAL;
-		}
-		json_add_obj_array(parent, child);
-		break;
-	case JSON_COMMON_ADD_DATA_TO_OBJECT:
-		if (!cJSON_IsObject(parent)) {
-			LOG_WRN("Passed in parent object is not an object");
-			return -EINVAL;
-		}
+	int err = date_time_uptime_to_unix_time_ms(ts);
 
-		if (object_label == NULL) {
-			LOG_WRN("Missing object label");
-			return -EINVAL;
-		}
-		json_add_obj(parent, object_label, child);
-		break;
-	case JSON_COMMON_GET_POINTER_TO_OBJECT:
-		if (*parent_ref != NULL) {
-			LOG_WRN("Passed in parent reference is not NULL");
-			return -EINVAL;
-		}
-		*parent_ref = child;
-		break;
-	default:
-		LOG_WRN("OP code invalid");
-		return -EINVAL;
+	if (err) {
+		LOG_ERR("date_time_uptime_to_unix_time_ms, error: %d", err);
 	}
 
-	return 0;
+	return err;
 }
 
-int json_common_modem_static_data_add(cJSON *parent,
-				      struct cloud_data_modem_static *data,
-				      enum json_common_op_code op,
-				      const char *object_label,
-				      cJSON **parent_ref)
+static bool modem_dynamic_values_fresh(struct cloud_data_modem_dynamic *data)
 {
-	int err;
-	char nw_mode[50] = {0};
+	return data->rsrp_fresh || data->area_code_fresh || data->mccmnc_fresh ||
+	       data->cell_id_fresh || data->ip_address_fresh;
+}
 
-	static const char lte_string[] = "LTE-M";
-	static const char nbiot_string[] = "NB-IoT";
-	static const char gps_string[] = " GPS";
+int json_common_encode(struct cloud_codec_data *output, json_common_encode_t encode,
+		       void *user_data)
+{
+	int err;
+	int len;
+	char *buffer;
+	struct json_writer writer;
 
-	if (!data->queued) {
-		return -ENODATA;
-	}
+	/* Measure the output first, to allocate a buffer of the exact size. */
+	json_writer_init(&writer, NULL, 0, NULL, NULL);
 
-	err = date_time_uptime_to_unix_time_ms(&data->ts);
+	err = encode(&writer, user_data);
 	if (err) {
-		LOG_ERR("date_time_uptime_to_unix_time_ms, error: %d", err);
 		return err;
 	}
 
-	cJSON *modem_obj = cJSON_CreateObject();
-	cJSON *modem_val_obj = cJSON_CreateObject();
-
-	if (modem_obj == NULL || modem_val_obj == NULL) {
-		err = -ENOMEM;
-		goto exit;
+	len = json_writer_finish(&writer);
+	if (len < 0) {
+		LOG_ERR("Encoding error: %d returned at %s:%d", len, __FILE__, __LINE__);
+		return len;
 	}
 
-	if (data->nw_lte_m) {
-		strcpy(nw_mode, lte_string);
-	} else if (data->nw_nb_iot) {
-		strcpy(nw_mode, nbiot_string);
+	buffer = k_malloc(len + 1);
+	if (buffer == NULL) {
+		LOG_ERR("Failed to allocate memory for JSON string");
+		return -ENOMEM;
 	}
 
-	if (data->nw_gps) {
-		strcat(nw_mode, gps_string);
-	}
+	json_writer_init(&writer, buffer, len + 1, NULL, NULL);
 
-	err = json_add_number(modem_val_obj, MODEM_CURRENT_BAND, data->bnd);
+	err = encode(&writer, user_data);
 	if (err) {
-		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
 		goto exit;
 	}
 
-	err = json_add_str(modem_val_obj, MODEM_NETWORK_MODE, nw_mode);
-	if (err) {
+	err = json_writer_finish(&writer);
+	if (err < 0) {
 		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
 		goto exit;
 	}
 
-	err = json_add_str(modem_val_obj, MODEM_ICCID, data->iccid);
-	if (err) {
-		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-		goto exit;
+	output->buf = buffer;
+	output->len = len;
+
+	return 0;
+
+exit:
+	k_free(buffer);
+	return err;
+}
+
+int json_common_modem_static_data_add(struct json_writer *writer,
+				      struct cloud_data_modem_static *data,
+				      const char *object_label)
+{
+	int err;
+	int64_t ts = data->ts;
+	char nw_mode[50] = {0};
+
+	static const char lte_string[] = "LTE-M";
+	static const char nbiot_string[] = "NB-IoT";
+	static const char gps_string[] = " GPS";
+
+	if (!data->queued) {
+		return -ENODATA;
 	}
 
-	err = json_add_str(modem_val_obj, MODEM_FIRMWARE_VERSION, data->fw);
-	if (err) {
-		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-		goto exit;
+	if (writer == NULL) {
+		return -EINVAL;
 	}
 
-	err = json_add_str(modem_val_obj, MODEM_BOARD, data->brdv);
+	err = timestamp_convert(&ts);
 	if (err) {
-		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-		goto exit;
+		return err;
 	}
 
-	err = json_add_str(modem_val_obj, MODEM_APP_VERSION, data->appv);
-	if (err) {
-		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-		goto exit;
+	if (data->nw_lte_m) {
+		strcpy(nw_mode, lte_string);
+	} else if (data->nw_nb_iot) {
+		strcpy(nw_mode, nbiot_string);
 	}
 
-	json_add_obj(modem_obj, DATA_VALUE, modem_val_obj);
+	if (data->nw_gps) {
+		strcat(nw_mode, gps_string);
+	}
 
-	err = json_add_number(modem_obj, DATA_TIMESTAMP, data->ts);
+	json_writer_object_start(writer, object_label);
+	json_writer_object_start(writer, DATA_VALUE);
+	json_writer_number(writer, MODEM_CURRENT_BAND, data->bnd);
+	json_writer_string(writer, MODEM_NETWORK_MODE, nw_mode);
+	json_writer_string(writer, MODEM_ICCID, data->iccid);
+	json_writer_string(writer, MODEM_FIRMWARE_VERSION, data->fw);
+	json_writer_string(writer, MODEM_BOARD, data->brdv);
+	json_writer_string(writer, MODEM_APP_VERSION, data->appv);
+	json_writer_object_end(writer);
+	json_writer_number(writer, DATA_TIMESTAMP, ts);
+
+	err = json_writer_object_end(writer);
 	if (err) {
 		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-		cJSON_Delete(modem_obj);
 		return err;
 	}
 
-	err = op_code_handle(parent, op, object_label, modem_obj, parent_ref);
-	if (err) {
-		cJSON_Delete(modem_obj);
-		return err;
+	if (!json_writer_is_measuring(writer)) {
+		data->ts = ts;
+		data->queued = false;
 	}
 
-	data->queued = false;
-
 	return 0;
-
-exit:
-	cJSON_Delete(modem_obj);
-	cJSON_Delete(modem_val_obj);
-	return err;
 }
 
-int json_common_modem_dynamic_data_add(cJSON *parent,
+int json_common_modem_dynamic_data_add(struct json_writer *writer,
 				       struct cloud_data_modem_dynamic *data,
-				       enum json_common_op_code op,
-				       const char *object_label,
-				       cJSON **parent_ref)
+				       const char *object_label)
 {
 	int err;
-	uint32_t mccmnc;
+	int64_t ts = data->ts;
+	uint32_t mccmnc = 0;
 	char *end_ptr;
-	bool values_added = false;
 
 	if (!data->queued) {
 		return -ENODATA;
 	}
 
-	err = date_time_uptime_to_unix_time_ms(&data->ts);
-	if (err) {
-		LOG_ERR("date_time_uptime_to_unix_time_ms, error: %d", err);
-		return err;
-	}
-
-	cJSON *modem_obj = cJSON_CreateObject();
-	cJSON *modem_val_obj = cJSON_CreateObject();
-
-	if (modem_obj == NULL || modem_val_obj == NULL) {
-		err = -ENOMEM;
-		goto exit;
+	if (writer == NULL) {
+		return -EINVAL;
 	}
 
-	if (data->rsrp_fresh) {
-		err = json_add_number(modem_val_obj, MODEM_RSRP, data->rsrp);
-		if (err) {
-			LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-			goto exit;
+	if (!modem_dynamic_values_fresh(data)) {
+		if (!json_writer_is_measuring(writer)) {
+			data->queued = false;
+			LOG_WRN("No valid dynamic modem data values present, entry unqueued");
 		}
-		values_added = true;
-	}
 
-	if (data->area_code_fresh) {
-		err = json_add_number(modem_val_obj, MODEM_AREA_CODE, data->area);
-		if (err) {
-			LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-			goto exit;
-		}
-		values_added = true;
+		return -ENODATA;
 	}
 
 	if (data->mccmnc_fresh) {
@@ -210,479 +185,313 @@ int json_common_modem_dynamic_data_add(cJSON *parent,
 
 		if ((errno == ERANGE) || (*end_ptr != '\0')) {
 			LOG_ERR("MCCMNC string could not be converted.");
-			err = -ENOTEMPTY;
-			goto exit;
+			return -ENOTEMPTY;
 		}
+	}
 
-		err = json_add_number(modem_val_obj, MODEM_MCCMNC, mccmnc);
-		if (err) {
-			LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-			goto exit;
-		}
-		values_added = true;
+	err = timestamp_convert(&ts);
+	if (err) {
+		return err;
 	}
 
-	if (data->cell_id_fresh) {
-		err = json_add_number(modem_val_obj, MODEM_CELL_ID, data->cell);
-		if (err) {
-			LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-			goto exit;
-		}
-		values_added = true;
+	json_writer_object_start(writer, object_label);
+	json_writer_object_start(writer, DATA_VALUE);
+
+	if (data->rsrp_fresh) {
+		json_writer_number(writer, MODEM_RSRP, data->rsrp);
 	}
 
-	if (data->ip_address_fresh) {
-		err = json_add_str(modem_val_obj, MODEM_IP_ADDRESS, data->ip);
-		if (err) {
-			LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-			goto exit;
-		}
-		values_added = true;
+	if (data->area_code_fresh) {
+		json_writer_number(writer, MODEM_AREA_CODE, data->area);
 	}
 
-	if (!values_added) {
-		err = -ENODATA;
-		data->queued = false;
-		LOG_WRN("No valid dynamic modem data values present, entry unqueued");
-		goto exit;
+	if (data->mccmnc_fresh) {
+		json_writer_number(writer, MODEM_MCCMNC, mccmnc);
 	}
 
-	json_add_obj(modem_obj, DATA_VALUE, modem_val_obj);
+	if (data->cell_id_fresh) {
+		json_writer_number(writer, MODEM_CELL_ID, data->cell);
+	}
 
-	err = json_add_number(modem_obj, DATA_TIMESTAMP, data->ts);
-	if (err) {
-		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-		cJSON_Delete(modem_obj);
-		return err;
+	if (data->ip_address_fresh) {
+		json_writer_string(writer, MODEM_IP_ADDRESS, data->ip);
 	}
 
-	err = op_code_handle(parent, op, object_label, modem_obj, parent_ref);
+	json_writer_object_end(writer);
+	json_writer_number(writer, DATA_TIMESTAMP, ts);
+
+	err = json_writer_object_end(writer);
 	if (err) {
-		cJSON_Delete(modem_obj);
+		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
 		return err;
 	}
 
-	data->queued = false;
+	if (!json_writer_is_measuring(writer)) {
+		data->ts = ts;
+		data->queued = false;
+	}
 
 	return 0;
-
-exit:
-	cJSON_Delete(modem_obj);
-	cJSON_Delete(modem_val_obj);
-	return err;
 }
 
-int json_common_sensor_data_add(cJSON *parent,
+int json_common_sensor_data_add(struct json_writer *writer,
 				struct cloud_data_sensors *data,
-				enum json_common_op_code op,
-				const char *object_label,
-				cJSON **parent_ref)
+				const char *object_label)
 {
 	int err;
+	int64_t ts = data->env_ts;
 
 	if (!data->queued) {
 		return -ENODATA;
 	}
 
-	err = date_time_uptime_to_unix_time_ms(&data->env_ts);
-	if (err) {
-		LOG_ERR("date_time_uptime_to_unix_time_ms, error: %d", err);
-		return err;
-	}
-
-	cJSON *sensor_obj = cJSON_CreateObject();
-	cJSON *sensor_val_obj = cJSON_CreateObject();
-
-	if (sensor_obj == NULL || sensor_val_obj == NULL) {
-		err = -ENOMEM;
-		goto exit;
-	}
-
-	err = json_add_number(sensor_val_obj, DATA_TEMPERATURE, data->temp);
-	if (err) {
-		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-		goto exit;
+	if (writer == NULL) {
+		return -EINVAL;
 	}
 
-	err = json_add_number(sensor_val_obj, DATA_HUMID, data->hum);
+	err = timestamp_convert(&ts);
 	if (err) {
-		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-		goto exit;
+		return err;
 	}
 
-	json_add_obj(sensor_obj, DATA_VALUE, sensor_val_obj);
+	json_writer_object_start(writer, object_label);
+	json_writer_object_start(writer, DATA_VALUE);
+	json_writer_number(writer, DATA_TEMPERATURE, data->temp);
+	json_writer_number(writer, DATA_HUMID, data->hum);
+	json_writer_object_end(writer);
+	json_writer_number(writer, DATA_TIMESTAMP, ts);
 
-	err = json_add_number(sensor_obj, DATA_TIMESTAMP, data->env_ts);
+	err = json_writer_object_end(writer);
 	if (err) {
 		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-		cJSON_Delete(sensor_obj);
 		return err;
 	}
 
-	err = op_code_handle(parent, op, object_label, sensor_obj, parent_ref);
-	if (err) {
-		cJSON_Delete(sensor_obj);
-		return err;
+	if (!json_writer_is_measuring(writer)) {
+		data->env_ts = ts;
+		data->queued = false;
 	}
 
-	data->queued = false;
-
 	return 0;
-
-exit:
-	cJSON_Delete(sensor_obj);
-	cJSON_Delete(sensor_val_obj);
-	return err;
 }
 
-int json_common_gps_data_add(cJSON *parent,
+int json_common_gps_data_add(struct json_writer *writer,
 			     struct cloud_data_gps *data,
-			     enum json_common_op_code op,
-			     const char *object_label,
-			     cJSON **parent_ref)
+			     const char *object_label)
 {
 	int err;
+	int64_t ts = data->gps_ts;
 
 	if (!data->queued) {
 		return -ENODATA;
 	}
 
-	err = date_time_uptime_to_unix_time_ms(&data->gps_ts);
-	if (err) {
-		LOG_ERR("date_time_uptime_to_unix_time_ms, error: %d", err);
-		return err;
-	}
-
-	cJSON *gps_obj = cJSON_CreateObject();
-	cJSON *gps_val_obj = cJSON_CreateObject();
-
-	if (gps_obj == NULL || gps_val_obj == NULL) {
-		err = -ENOMEM;
-		goto exit;
-	}
-
-	err = json_add_number(gps_val_obj, DATA_GPS_LONGITUDE, data->longi);
-	if (err) {
-		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-		goto exit;
-	}
-
-	err = json_add_number(gps_val_obj, DATA_GPS_LATITUDE, data->lat);
-	if (err) {
-		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-		goto exit;
-	}
-
-	err = json_add_number(gps_val_obj, DATA_MOVEMENT, data->acc);
-	if (err) {
-		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-		goto exit;
-	}
-
-	err = json_add_number(gps_val_obj, DATA_GPS_ALTITUDE, data->alt);
-	if (err) {
-		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-		goto exit;
-	}
-
-	err = json_add_number(gps_val_obj, DATA_GPS_SPEED, data->spd);
-	if (err) {
-		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-		goto exit;
+	if (writer == NULL) {
+		return -EINVAL;
 	}
 
-	err = json_add_number(gps_val_obj, DATA_GPS_HEADING, data->hdg);
+	err = timestamp_convert(&ts);
 	if (err) {
-		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-		goto exit;
+		return err;
 	}
 
-	json_add_obj(gps_obj, DATA_VALUE, gps_val_obj);
+	json_writer_object_start(writer, object_label);
+	json_writer_object_start(writer, DATA_VALUE);
+	json_writer_number(writer, DATA_GPS_LONGITUDE, data->longi);
+	json_writer_number(writer, DATA_GPS_LATITUDE, data->lat);
+	json_writer_number(writer, DATA_MOVEMENT, data->acc);
+	json_writer_number(writer, DATA_GPS_ALTITUDE, data->alt);
+	json_writer_number(writer, DATA_GPS_SPEED, data->spd);
+	json_writer_number(writer, DATA_GPS_HEADING, data->hdg);
+	json_writer_object_end(writer);
+	json_writer_number(writer, DATA_TIMESTAMP, ts);
 
-	err = json_add_number(gps_obj, DATA_TIMESTAMP, data->gps_ts);
+	err = json_writer_object_end(writer);
 	if (err) {
 		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-		cJSON_Delete(gps_obj);
 		return err;
 	}
 
-	err = op_code_handle(parent, op, object_label, gps_obj, parent_ref);
-	if (err) {
-		cJSON_Delete(gps_obj);
-		return err;
+	if (!json_writer_is_measuring(writer)) {
+		data->gps_ts = ts;
+		data->queued = false;
 	}
 
-	data->queued = false;
-
 	return 0;
-
-exit:
-	cJSON_Delete(gps_obj);
-	cJSON_Delete(gps_val_obj);
-	return err;
 }
 
-int json_common_accel_data_add(cJSON *parent,
+int json_common_accel_data_add(struct json_writer *writer,
 			       struct cloud_data_accelerometer *data,
-			       enum json_common_op_code op,
-			       const char *object_label,
-			       cJSON **parent_ref)
+			       const char *object_label)
 {
 	int err;
+	int64_t ts = data->ts;
 
 	if (!data->queued) {
 		return -ENODATA;
 	}
 
-	err = date_time_uptime_to_unix_time_ms(&data->ts);
-	if (err) {
-		LOG_ERR("date_time_uptime_to_unix_time_ms, error: %d", err);
-		return err;
-	}
-
-	cJSON *accel_obj = cJSON_CreateObject();
-	cJSON *accel_val_obj = cJSON_CreateObject();
-
-	if (accel_obj == NULL || accel_val_obj == NULL) {
-		err = -ENOMEM;
-		goto exit;
-	}
-
-	err = json_add_number(accel_val_obj, DATA_MOVEMENT_X, data->values[0]);
-	if (err) {
-		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-		goto exit;
-	}
-
-	err = json_add_number(accel_val_obj, DATA_MOVEMENT_Y, data->values[1]);
-	if (err) {
-		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-		goto exit;
+	if (writer == NULL) {
+		return -EINVAL;
 	}
 
-	err = json_add_number(accel_val_obj, DATA_MOVEMENT_Z, data->values[2]);
+	err = timestamp_convert(&ts);
 	if (err) {
-		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-		goto exit;
+		return err;
 	}
 
-	json_add_obj(accel_obj, DATA_VALUE, accel_val_obj);
+	json_writer_object_start(writer, object_label);
+	json_writer_object_start(writer, DATA_VALUE);
+	json_writer_number(writer, DATA_MOVEMENT_X, data->values[0]);
+	json_writer_number(writer, DATA_MOVEMENT_Y, data->values[1]);
+	json_writer_number(writer, DATA_MOVEMENT_Z, data->values[2]);
+	json_writer_object_end(writer);
+	json_writer_number(writer, DATA_TIMESTAMP, ts);
 
-	err = json_add_number(accel_obj, DATA_TIMESTAMP, data->ts);
+	err = json_writer_object_end(writer);
 	if (err) {
 		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-		cJSON_Delete(accel_obj);
 		return err;
 	}
 
-	err = op_code_handle(parent, op, object_label, accel_obj, parent_ref);
-	if (err) {
-		cJSON_Delete(accel_obj);
-		return err;
+	if (!json_writer_is_measuring(writer)) {
+		data->ts = ts;
+		data->queued = false;
 	}
 
-	data->queued = false;
-
 	return 0;
-
-exit:
-	cJSON_Delete(accel_obj);
-	cJSON_Delete(accel_val_obj);
-	return err;
 }
 
-int json_common_ui_data_add(cJSON *parent,
+int json_common_ui_data_add(struct json_writer *writer,
 			    struct cloud_data_ui *data,
-			    enum json_common_op_code op,
-			    const char *object_label,
-			    cJSON **parent_ref)
+			    const char *object_label)
 {
 	int err;
+	int64_t ts = data->btn_ts;
 
 	if (!data->queued) {
 		return -ENODATA;
 	}
 
-	err = date_time_uptime_to_unix_time_ms(&data->btn_ts);
-	if (err) {
-		LOG_ERR("date_time_uptime_to_unix_time_ms, error: %d", err);
-		return err;
-	}
-
-	cJSON *button_obj = cJSON_CreateObject();
-
-	if (button_obj == NULL) {
-		err = -ENOMEM;
-		goto exit;
+	if (writer == NULL) {
+		return -EINVAL;
 	}
 
-	err = json_add_number(button_obj, DATA_VALUE, data->btn);
+	err = timestamp_convert(&ts);
 	if (err) {
-		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-		goto exit;
+		return err;
 	}
 
-	err = json_add_number(button_obj, DATA_TIMESTAMP, data->btn_ts);
+	json_writer_object_start(writer, object_label);
+	json_writer_number(writer, DATA_VALUE, data->btn);
+	json_writer_number(writer, DATA_TIMESTAMP, ts);
+
+	err = json_writer_object_end(writer);
 	if (err) {
 		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-		goto exit;
+		return err;
 	}
 
-	err = op_code_handle(parent, op, object_label, button_obj, parent_ref);
-	if (err) {
-		goto exit;
+	if (!json_writer_is_measuring(writer)) {
+		data->btn_ts = ts;
+		data->queued = false;
 	}
 
-	data->queued = false;
-
 	return 0;
-
-exit:
-	cJSON_Delete(button_obj);
-	return err;
 }
 
-int json_common_battery_data_add(cJSON *parent,
+int json_common_battery_data_add(struct json_writer *writer,
 				 struct cloud_data_battery *data,
-				 enum json_common_op_code op,
-				 const char *object_label,
-				 cJSON **parent_ref)
+				 const char *object_label)
 {
 	int err;
+	int64_t ts = data->bat_ts;
 
 	if (!data->queued) {
 		return -ENODATA;
 	}
 
-	err = date_time_uptime_to_unix_time_ms(&data->bat_ts);
-	if (err) {
-		LOG_ERR("date_time_uptime_to_unix_time_ms, error: %d", err);
-		return err;
-	}
-
-	cJSON *battery_obj = cJSON_CreateObject();
-
-	if (battery_obj == NULL) {
-		err = -ENOMEM;
-		goto exit;
+	if (writer == NULL) {
+		return -EINVAL;
 	}
 
-	err = json_add_number(battery_obj, DATA_VALUE, data->bat);
+	err = timestamp_convert(&ts);
 	if (err) {
-		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-		goto exit;
+		return err;
 	}
 
-	err = json_add_number(battery_obj, DATA_TIMESTAMP, data->bat_ts);
+	json_writer_object_start(writer, object_label);
+	json_writer_number(writer, DATA_VALUE, data->bat);
+	json_writer_number(writer, DATA_TIMESTAMP, ts);
+
+	err = json_writer_object_end(writer);
 	if (err) {
 		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-		goto exit;
+		return err;
 	}
 
-	err = op_code_handle(parent, op, object_label, battery_obj, parent_ref);
-	if (err) {
-		goto exit;
+	if (!json_writer_is_measuring(writer)) {
+		data->bat_ts = ts;
+		data->queued = false;
 	}
 
-	data->queued = false;
-
 	return 0;
-
-exit:
-	cJSON_Delete(battery_obj);
-	return err;
 }
 
-int json_common_config_add(cJSON *parent, struct cloud_data_cfg *data, const char *object_label)
+int json_common_config_add(struct json_writer *writer, struct cloud_data_cfg *data,
+			   const char *object_label)
 {
 	int err;
-	bool values_added = false;
 
 	if (object_label == NULL) {
 		LOG_WRN("Missing object label");
 		return -EINVAL;
 	}
 
-	cJSON *config_obj = cJSON_CreateObject();
+	if (writer == NULL) {
+		return -EINVAL;
+	}
 
-	if (config_obj == NULL) {
-		err = -ENOMEM;
-		goto exit;
+	if (!data->active_mode_fresh && !data->gps_timeout_fresh &&
+	    !data->active_wait_timeout_fresh && !data->movement_resolution_fresh &&
+	    !data->movement_timeout_fresh && !data->accelerometer_threshold_fresh) {
+		LOG_WRN("No valid configuration data values present");
+		return -ENODATA;
 	}
 
+	json_writer_object_start(writer, object_label);
+
 	if (data->active_mode_fresh) {
-		err = json_add_bool(config_obj, CONFIG_DEVICE_MODE,
-				    data->active_mode);
-		if (err) {
-			LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-			goto exit;
-		}
-		values_added = true;
+		json_writer_bool(writer, CONFIG_DEVICE_MODE, data->active_mode);
 	}
 
 	if (data->gps_timeout_fresh) {
-		err = json_add_number(config_obj, CONFIG_GPS_TIMEOUT,
-				      data->gps_timeout);
-		if (err) {
-			LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-			goto exit;
-		}
-		values_added = true;
+		json_writer_number(writer, CONFIG_GPS_TIMEOUT, data->gps_timeout);
 	}
 
 	if (data->active_wait_timeout_fresh) {
-		err = json_add_number(config_obj, CONFIG_ACTIVE_TIMEOUT,
-				      data->active_wait_timeout);
-		if (err) {
-			LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-			goto exit;
-		}
-		values_added = true;
+		json_writer_number(writer, CONFIG_ACTIVE_TIMEOUT, data->active_wait_timeout);
 	}
 
 	if (data->movement_resolution_fresh) {
-		err = json_add_number(config_obj, CONFIG_MOVE_RES,
-				      data->movement_resolution);
-		if (err) {
-			LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-			goto exit;
-		}
-		values_added = true;
+		json_writer_number(writer, CONFIG_MOVE_RES, data->movement_resolution);
 	}
 
 	if (data->movement_timeout_fresh) {
-		err = json_add_number(config_obj, CONFIG_MOVE_TIMEOUT,
-				      data->movement_timeout);
-		if (err) {
-			LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-			goto exit;
-		}
-		values_added = true;
+		json_writer_number(writer, CONFIG_MOVE_TIMEOUT, data->movement_timeout);
 	}
 
 	if (data->accelerometer_threshold_fresh) {
-		err = json_add_number(config_obj, CONFIG_ACC_THRESHOLD,
-				      data->accelerometer_threshold);
-		if (err) {
-			LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
-			goto exit;
-		}
-		values_added = true;
+		json_writer_number(writer, CONFIG_ACC_THRESHOLD, data->accelerometer_threshold);
 	}
 
-	if (!values_added) {
-		err = -ENODATA;
-		LOG_WRN("No valid configuration data values present");
-		goto exit;
+	err = json_writer_object_end(writer);
+	if (err) {
+		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
+		return err;
 	}
 
-	json_add_obj(parent, object_label, config_obj);
-
 	return 0;
-
-exit:
-	cJSON_Delete(config_obj);
-	return err;
 }
 
 void json_common_config_get(cJSON *parent, struct cloud_data_cfg *data)
@@ -719,116 +528,107 @@ void json_common_config_get(cJSON *parent, struct cloud_data_cfg *data)
 	}
 }
 
-int json_common_batch_data_add(cJSON *parent, enum json_common_buffer_type type, void *buf,
-			       size_t buf_count, const char *object_label)
+/* Returns true if the entry is queued and would be written by its encoding function. */
+static bool batch_entry_queued(enum json_common_buffer_type type, void *buf, size_t i)
 {
-	int err = 0;
-	cJSON *array_obj = cJSON_CreateArray();
+	switch (type) {
+	case JSON_COMMON_UI:
+		return ((struct cloud_data_ui *)buf)[i].queued;
+	case JSON_COMMON_MODEM_STATIC:
+		return ((struct cloud_data_modem_static *)buf)[i].queued;
+	case JSON_COMMON_MODEM_DYNAMIC: {
+		struct cloud_data_modem_dynamic *data = &((struct cloud_data_modem_dynamic *)buf)[i];
+
+		return data->queued && modem_dynamic_values_fresh(data);
+	}
+	case JSON_COMMON_GPS:
+		return ((struct cloud_data_gps *)buf)[i].queued;
+	case JSON_COMMON_SENSOR:
+		return ((struct cloud_data_sensors *)buf)[i].queued;
+	case JSON_COMMON_ACCELEROMETER:
+		return ((struct cloud_data_accelerometer *)buf)[i].queued;
+	case JSON_COMMON_BATTERY:
+		return ((struct cloud_data_battery *)buf)[i].queued;
+	default:
+		LOG_WRN("Unknown buffer type: %d", type);
+		return false;
+	}
+}
 
-	if (parent == NULL || array_obj == NULL) {
-		cJSON_Delete(array_obj);
-		return -ENOMEM;
+static int batch_entry_add(struct json_writer *writer, enum json_common_buffer_type type,
+			   void *buf, size_t i)
+{
+	switch (type) {
+	case JSON_COMMON_UI:
+		return json_common_ui_data_add(writer, &((struct cloud_data_ui *)buf)[i], NULL);
+	case JSON_COMMON_MODEM_STATIC:
+		return json_common_modem_static_data_add(
+					writer, &((struct cloud_data_modem_static *)buf)[i], NULL);
+	case JSON_COMMON_MODEM_DYNAMIC:
+		return json_common_modem_dynamic_data_add(
+					writer, &((struct cloud_data_modem_dynamic *)buf)[i], NULL);
+	case JSON_COMMON_GPS:
+		return json_common_gps_data_add(writer, &((struct cloud_data_gps *)buf)[i], NULL);
+	case JSON_COMMON_SENSOR:
+		return json_common_sensor_data_add(
+					writer, &((struct cloud_data_sensors *)buf)[i], NULL);
+	case JSON_COMMON_ACCELEROMETER:
+		return json_common_accel_data_add(
+					writer, &((struct cloud_data_accelerometer *)buf)[i], NULL);
+	case JSON_COMMON_BATTERY:
+		return json_common_battery_data_add(
+					writer, &((struct cloud_data_battery *)buf)[i], NULL);
+	default:
+		return -ENODATA;
+	}
+}
+
+int json_common_batch_data_add(struct json_writer *writer, enum json_common_buffer_type type,
+			       void *buf, size_t buf_count, const char *object_label)
+{
+	int err;
+	bool array_started = false;
+
+	if (writer == NULL) {
+		return -EINVAL;
 	}
 
 	if (object_label == NULL) {
 		LOG_WRN("Missing object label");
-		cJSON_Delete(array_obj);
 		return -EINVAL;
 	}
 
-	for (int i = 0; i < buf_count; i++) {
-		switch (type) {
-		case JSON_COMMON_UI: {
-			struct cloud_data_ui *data =
-					(struct cloud_data_ui *)buf;
-			err = json_common_ui_data_add(array_obj,
-						      &data[i],
-						      JSON_COMMON_ADD_DATA_TO_ARRAY,
-						      NULL,
-						      NULL);
-		}
-			break;
-		case JSON_COMMON_MODEM_STATIC: {
-			struct cloud_data_modem_static *data =
-					(struct cloud_data_modem_static *)buf;
-			err = json_common_modem_static_data_add(array_obj,
-								&data[i],
-								JSON_COMMON_ADD_DATA_TO_ARRAY,
-								NULL,
-								NULL);
-		}
-			break;
-		case JSON_COMMON_MODEM_DYNAMIC: {
-			struct cloud_data_modem_dynamic *data =
-					(struct cloud_data_modem_dynamic *)buf;
-			err = json_common_modem_dynamic_data_add(array_obj,
-								 &data[i],
-								 JSON_COMMON_ADD_DATA_TO_ARRAY,
-								 NULL,
-								 NULL);
-		}
-			break;
-		case JSON_COMMON_GPS: {
-			struct cloud_data_gps *data =
-					(struct cloud_data_gps *)buf;
-			err = json_common_gps_data_add(array_obj,
-						       &data[i],
-						       JSON_COMMON_ADD_DATA_TO_ARRAY,
-						       NULL,
-						       NULL);
-		}
-			break;
-		case JSON_COMMON_SENSOR: {
-			struct cloud_data_sensors *data =
-					(struct cloud_data_sensors *)buf;
-			err = json_common_sensor_data_add(array_obj,
-							  &data[i],
-							  JSON_COMMON_ADD_DATA_TO_ARRAY,
-							  NULL,
-							  NULL);
-		}
-			break;
-		case JSON_COMMON_ACCELEROMETER: {
-			struct cloud_data_accelerometer *data =
-					(struct cloud_data_accelerometer *)buf;
-			err = json_common_accel_data_add(array_obj,
-							 &data[i],
-							 JSON_COMMON_ADD_DATA_TO_ARRAY,
-							 NULL,
-							 NULL);
-		}
-			break;
-		case JSON_COMMON_BATTERY: {
-			struct cloud_data_battery *data =
-					(struct cloud_data_battery *)buf;
-			err = json_common_battery_data_add(array_obj,
-							   &data[i],
-							   JSON_COMMON_ADD_DATA_TO_ARRAY,
-							   NULL,
-							   NULL);
-		}
-			break;
-		default:
-			LOG_WRN("Unknown buffer type: %d", type);
-			break;
+	for (size_t i = 0; i < buf_count; i++) {
+		/* The array is started at the first entry to encode, so that nothing is written
+		 * if the buffer has no queued entries.
+		 */
+		if (!array_started && batch_entry_queued(type, buf, i)) {
+			err = json_writer_array_start(writer, object_label);
+			if (err) {
+				LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__,
+					__LINE__);
+				return err;
+			}
+
+			array_started = true;
 		}
 
+		err = batch_entry_add(writer, type, buf, i);
 		if ((err != 0) && (err != -ENODATA)) {
 			LOG_ERR("Failed adding data to array object");
-			cJSON_Delete(array_obj);
 			return err;
 		}
 	}
 
-	if (cJSON_GetArraySize(array_obj) == 0) {
-		cJSON_Delete(array_obj);
-		/* At this point err can be either 0 or -ENODATA depending on the return
-		 * value of the function that adds the last item present in the respective buffer.
-		 * Because of this we explicitly set err to -ENODATA if the array is empty.
-		 */
+	if (!array_started) {
 		return -ENODATA;
 	}
 
-	json_add_obj(parent, object_label, array_obj);
+	err = json_writer_array_end(writer);
+	if (err) {
+		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
+		return err;
+	}
+
 	return 0;
 }
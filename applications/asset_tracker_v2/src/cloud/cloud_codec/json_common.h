@@ -24,6 +24,7 @@ extern "C" {
 
 #include <zephyr.h>
 #include <cJSON.h>
+#include <json_writer.h>
 
 #include "cloud_codec.h"
 #include "json_protocol_names.h"
@@ -43,176 +44,152 @@ enum json_common_buffer_type {
 	JSON_COMMON_COUNT
 };
 
-/** @brief Operation to be carried out with the passed in data. */
-enum json_common_op_code {
-	JSON_COMMON_INVALID,
-	/** Encode data and add it to a passed in parent array object. This option does not
-	 *  label the encoded data.
-	 */
-	JSON_COMMON_ADD_DATA_TO_ARRAY,
-	/** Encode data and add it to a passed in parent object. */
-	JSON_COMMON_ADD_DATA_TO_OBJECT,
-	/** Encode data and set the passed in object pointer to point to it. */
-	JSON_COMMON_GET_POINTER_TO_OBJECT
-};
+/**
+ * @brief Function that writes a document with a JSON writer.
+ *
+ * @param[in, out] writer JSON writer.
+ * @param[in] user_data User data passed to json_common_encode().
+ *
+ * @return 0 on success. Otherwise a negative error code is returned.
+ */
+typedef int (*json_common_encode_t)(struct json_writer *writer, void *user_data);
+
+/**
+ * @brief Encode a document into a buffer of the exact size of the document.
+ *
+ * @details The encoding function is called twice: first with a writer that only counts the
+ *	    length of the output, then with a writer on a buffer of this length. The encoding
+ *	    functions of this library modify the passed in data, for instance by unqueueing
+ *	    entries, only in the second call.
+ *
+ * @param[out] output Encoded output. The buffer is allocated on the heap and must be freed with
+ *		      cloud_codec_release_data() after use.
+ * @param[in] encode Function that writes the document.
+ * @param[in] user_data User data passed to the encoding function.
+ *
+ * @return 0 on success. Otherwise the error returned by the encoding function or the JSON writer,
+ *         or -ENOMEM if the buffer could not be allocated.
+ */
+int json_common_encode(struct cloud_codec_data *output, json_common_encode_t encode,
+		       void *user_data);
 
 /**
- * @brief Encode and add static modem data to the parent object.
+ * @brief Encode static modem data and write it with the JSON writer.
  *
- * @param[out] parent Pointer to object that the encoded data is added to.
+ * @param[in, out] writer JSON writer.
  * @param[in] data Pointer to data that is to be encoded.
- * @param[in] op Operation that is to be carried out.
- * @param[in] object_label Name of the encoded object.
- * @param[out] parent_ref Reference to an unallocated parent object pointer. Used when getting the
- *			  pointer to the encoded data object when setting
- *			  JSON_COMMON_GET_POINTER_TO_OBJECT as the opcode. The cJSON object pointed
- *			  to after this function call must be manually freed after use.
+ * @param[in] object_label Name of the encoded object if it is written inside an object, or NULL
+ *			   if it is written inside an array.
  *
  * @return 0 on success. -ENODATA if the passed in data is not valid. Otherwise a negative error
  *         code is returned.
  */
-int json_common_modem_static_data_add(cJSON *parent,
+int json_common_modem_static_data_add(struct json_writer *writer,
 				      struct cloud_data_modem_static *data,
-				      enum json_common_op_code op,
-				      const char *object_label,
-				      cJSON **parent_ref);
+				      const char *object_label);
 
 /**
- * @brief Encode and add dynamic modem data to the parent object.
+ * @brief Encode dynamic modem data and write it with the JSON writer.
  *
- * @param[out] parent Pointer to object that the encoded data is added to.
+ * @param[in, out] writer JSON writer.
  * @param[in] data Pointer to data that is to be encoded.
- * @param[in] op Operation that is to be carried out.
- * @param[in] object_label Name of the encoded object.
- * @param[out] parent_ref Reference to an unallocated parent object pointer. Used when getting the
- *			  pointer to the encoded data object when setting
- *			  JSON_COMMON_GET_POINTER_TO_OBJECT as the opcode. The cJSON object pointed
- *			  to after this function call must be manually freed after use.
+ * @param[in] object_label Name of the encoded object if it is written inside an object, or NULL
+ *			   if it is written inside an array.
  *
  * @return 0 on success. -ENODATA if the passed in data is not valid. Otherwise a negative error
  *         code is returned.
  */
-int json_common_modem_dynamic_data_add(cJSON *parent,
+int json_common_modem_dynamic_data_add(struct json_writer *writer,
 				       struct cloud_data_modem_dynamic *data,
-				       enum json_common_op_code op,
-				       const char *object_label,
-				       cJSON **parent_ref);
+				       const char *object_label);
 
 /**
- * @brief Encode and add environmental sensor data to the parent object.
+ * @brief Encode environmental sensor data and write it with the JSON writer.
  *
- * @param[out] parent Pointer to object that the encoded data is added to.
+ * @param[in, out] writer JSON writer.
  * @param[in] data Pointer to data that is to be encoded.
- * @param[in] op Operation that is to be carried out.
- * @param[in] object_label Name of the encoded object.
- * @param[out] parent_ref Reference to an unallocated parent object pointer. Used when getting the
- *			  pointer to the encoded data object when setting
- *			  JSON_COMMON_GET_POINTER_TO_OBJECT as the opcode. The cJSON object pointed
- *			  to after this function call must be manually freed after use.
+ * @param[in] object_label Name of the encoded object if it is written inside an object, or NULL
+ *			   if it is written inside an array.
  *
  * @return 0 on success. -ENODATA if the passed in data is not valid. Otherwise a negative error
  *         code is returned.
  */
-int json_common_sensor_data_add(cJSON *parent,
+int json_common_sensor_data_add(struct json_writer *writer,
 				struct cloud_data_sensors *data,
-				enum json_common_op_code op,
-				const char *object_label,
-				cJSON **parent_ref);
+				const char *object_label);
 
 /**
- * @brief Encode and add GPS data to the parent object.
+ * @brief Encode GPS data and write it with the JSON writer.
  *
- * @param[out] parent Pointer to object that the encoded data is added to.
+ * @param[in, out] writer JSON writer.
  * @param[in] data Pointer to data that is to be encoded.
- * @param[in] op Operation that is to be carried out.
- * @param[in] object_label Name of the encoded object.
- * @param[out] parent_ref Reference to an unallocated parent object pointer. Used when getting the
- *			  pointer to the encoded data object when setting
- *			  JSON_COMMON_GET_POINTER_TO_OBJECT as the opcode. The cJSON object pointed
- *			  to after this function call must be manually freed after use.
+ * @param[in] object_label Name of the encoded object if it is written inside an object, or NULL
+ *			   if it is written inside an array.
  *
  * @return 0 on success. -ENODATA if the passed in data is not valid. Otherwise a negative error
  *         code is returned.
  */
-int json_common_gps_data_add(cJSON *parent,
+int json_common_gps_data_add(struct json_writer *writer,
 			     struct cloud_data_gps *data,
-			     enum json_common_op_code op,
-			     const char *object_label,
-			     cJSON **parent_ref);
+			     const char *object_label);
 
 /**
- * @brief Encode and add accelerometer data to the parent object.
+ * @brief Encode accelerometer data and write it with the JSON writer.
  *
- * @param[out] parent Pointer to object that the encoded data is added to.
+ * @param[in, out] writer JSON writer.
  * @param[in] data Pointer to data that is to be encoded.
- * @param[in] op Operation that is to be carried out.
- * @param[in] object_label Name of the encoded object.
- * @param[out] parent_ref Reference to an unallocated parent object pointer. Used when getting the
- *			  pointer to the encoded data object when setting
- *			  JSON_COMMON_GET_POINTER_TO_OBJECT as the opcode. The cJSON object pointed
- *			  to after this function call must be manually freed after use.
+ * @param[in] object_label Name of the encoded object if it is written inside an object, or NULL
+ *			   if it is written inside an array.
  *
  * @return 0 on success. -ENODATA if the passed in data is not valid. Otherwise a negative error
  *         code is returned.
  */
-int json_common_accel_data_add(cJSON *parent,
+int json_common_accel_data_add(struct json_writer *writer,
 			       struct cloud_data_accelerometer *data,
-			       enum json_common_op_code op,
-			       const char *object_label,
-			       cJSON **parent_ref);
+			       const char *object_label);
 
 /**
- * @brief Encode and add User Interface data to the parent object.
+ * @brief Encode User Interface data and write it with the JSON writer.
  *
- * @param[out] parent Pointer to object that the encoded data is added to.
+ * @param[in, out] writer JSON writer.
  * @param[in] data Pointer to data that is to be encoded.
- * @param[in] op Operation that is to be carried out.
- * @param[in] object_label Name of the encoded object.
- * @param[out] parent_ref Reference to an unallocated parent object pointer. Used when getting the
- *			  pointer to the encoded data object when setting
- *			  JSON_COMMON_GET_POINTER_TO_OBJECT as the opcode. The cJSON object pointed
- *			  to after this function call must be manually freed after use.
+ * @param[in] object_label Name of the encoded object if it is written inside an object, or NULL
+ *			   if it is written inside an array.
  *
  * @return 0 on success. -ENODATA if the passed in data is not valid. Otherwise a negative error
  *         code is returned.
  */
-int json_common_ui_data_add(cJSON *parent,
+int json_common_ui_data_add(struct json_writer *writer,
 			    struct cloud_data_ui *data,
-			    enum json_common_op_code op,
-			    const char *object_label,
-			    cJSON **parent_ref);
+			    const char *object_label);
 
 /**
- * @brief Encode and add battery data to the parent object.
+ * @brief Encode battery data and write it with the JSON writer.
  *
- * @param[out] parent Pointer to object that the encoded data is added to.
+ * @param[in, out] writer JSON writer.
  * @param[in] data Pointer to data that is to be encoded.
- * @param[in] op Operation that is to be carried out.
- * @param[in] object_label Name of the encoded object.
- * @param[out] parent_ref Reference to an unallocated parent object pointer. Used when getting the
- *			  pointer to the encoded data object when setting
- *			  JSON_COMMON_GET_POINTER_TO_OBJECT as the opcode. The cJSON object pointed
- *			  to after this function call must be manually freed after use.
+ * @param[in] object_label Name of the encoded object if it is written inside an object, or NULL
+ *			   if it is written inside an array.
  *
  * @return 0 on success. -ENODATA if the passed in data is not valid. Otherwise a negative error
  *         code is returned.
  */
-int json_common_battery_data_add(cJSON *parent,
+int json_common_battery_data_add(struct json_writer *writer,
 				 struct cloud_data_battery *data,
-				 enum json_common_op_code op,
-				 const char *object_label,
-				 cJSON **parent_ref);
+				 const char *object_label);
 
 /**
- * @brief Encode and add configuration data to the parent object.
+ * @brief Encode configuration data and write it with the JSON writer.
  *
- * @param[out] parent Pointer to object that the encoded data is added to.
+ * @param[in, out] writer JSON writer.
  * @param[in] data Pointer to data that is to be encoded.
  * @param[in] object_label Name of the encoded object.
  *
- * @return 0 on success. Otherwise a negative error code is returned.
+ * @return 0 on success. -ENODATA if none of the configuration values are fresh. Otherwise a
+ *         negative error code is returned.
  */
-int json_common_config_add(cJSON *parent, struct cloud_data_cfg *data, const char *object_label);
+int json_common_config_add(struct json_writer *writer, struct cloud_data_cfg *data,
+			   const char *object_label);
 
 /**
  * @brief Extract configuration values from parent object.
@@ -224,20 +201,20 @@ int json_common_config_add(cJSON *parent, struct cloud_data_cfg *data, const cha
 void json_common_config_get(cJSON *parent, struct cloud_data_cfg *data);
 
 /**
- * @brief Encode all queued entries in the passed in buffer and add it to the parent object
+ * @brief Encode all queued entries in the passed in buffer and write them with the JSON writer
  *        as an array.
  *
- * @param[out] parent Pointer to object that the encoded data is added to.
+ * @param[in, out] writer JSON writer. The array is written inside an object.
  * @param[in] type Type of data passed in to the function.
  * @param[in] buf Pointer to data buffer that is to be encoded.
  * @param[in] buf_count Number of entries in passed in data buffer.
- * @param[in] object_label Name of the array entry that is added to the parent object.
+ * @param[in] object_label Name of the array.
  *
  * @return 0 on success. -ENODATA if the passed in data is not valid. Otherwise a negative error
  *         code is returned.
  */
-int json_common_batch_data_add(cJSON *parent, enum json_common_buffer_type type, void *buf,
-			       size_t buf_count, const char *object_label);
+int json_common_batch_data_add(struct json_writer *writer, enum json_common_buffer_type type,
+			       void *buf, size_t buf_count, const char *object_label);
 
 #ifdef __cplusplus
 }
@@ -9,6 +9,10 @@
 #include <settings/settings.h>
 #include <date_time.h>
 
+#if defined(CONFIG_DATA_FLASH_QUEUE)
+#include <flash_queue.h>
+#endif
+
 #include "cloud/cloud_codec/cloud_codec.h"
 
 #define MODULE data_module
@@ -127,11 +131,25 @@ struct ack_data {
 	enum data_type type;
 	size_t len;
 	void *ptr;
+	/* Sequence number of the data in the flash queue, 0 if the data was
+	 * not read from the flash queue.
+	 */
+	uint32_t seq;
 };
 
 /* Data that has been attempted to be sent but failed. */
 static struct ack_data failed_data[CONFIG_FAILED_DATA_COUNT];
 
+#if defined(CONFIG_DATA_FLASH_QUEUE)
+/* Data that has been attempted to be sent but failed, stored in flash until it
+ * is sent.
+ */
+static struct flash_queue failed_queue;
+
+/* Sequence number of the last entry read from the flash queue. */
+static uint32_t failed_queue_seq_read;
+#endif
+
 /* Data that has been encoded and shipped on, but has not yet been ACKed. */
 static struct ack_data pending_data[CONFIG_PENDING_DATA_COUNT];
 
@@ -308,6 +326,7 @@ static void data_list_clear_entry(struct ack_data *data)
 	data->ptr = NULL,
 	data->len = 0;
 	data->type = UNUSED;
+	data->seq = 0;
 }
 
 static void data_list_clear_and_free(struct ack_data *list, size_t list_count)
@@ -322,8 +341,59 @@ static void data_list_clear_and_free(struct ack_data *list, size_t list_count)
 	LOG_WRN("Data list cleared and freed");
 }
 
+#if defined(CONFIG_DATA_FLASH_QUEUE)
+/* Stores data in the flash queue and frees it. */
+static int failed_queue_push(void *ptr, size_t len, enum data_type type)
+{
+	int err;
+
+	err = flash_queue_push(&failed_queue, type, ptr, len);
+	if (err) {
+		LOG_WRN("flash_queue_push, error: %d", err);
+		return err;
+	}
+
+	LOG_DBG("Failed data stored in flash: %p", ptr);
+
+	k_free(ptr);
+
+	return 0;
+}
+
+/* Acknowledges the entries read from the flash queue, up to the first entry
+ * that is still pending. The entries that failed to be sent again have been
+ * stored again in the flash queue.
+ */
+static void failed_queue_ack(void)
+{
+	int err;
+	uint32_t seq = failed_queue_seq_read;
+
+	for (size_t i = 0; i < ARRAY_SIZE(pending_data); i++) {
+		if ((pending_data[i].ptr != NULL) && (pending_data[i].seq != 0)) {
+			seq = MIN(seq, pending_data[i].seq - 1);
+		}
+	}
+
+	if (seq == 0) {
+		return;
+	}
+
+	err = flash_queue_ack(&failed_queue, seq);
+	if (err) {
+		LOG_ERR("flash_queue_ack, error: %d", err);
+	}
+}
+#endif
+
 static void data_list_add_failed(void *ptr, size_t len, enum data_type type)
 {
+#if defined(CONFIG_DATA_FLASH_QUEUE)
+	if (failed_queue_push(ptr, len, type) == 0) {
+		return;
+	}
+#endif
+
 	while (true) {
 		for (size_t i = 0; i < ARRAY_SIZE(failed_data); i++) {
 			if (failed_data[i].ptr == NULL) {
@@ -344,13 +414,15 @@ static void data_list_add_failed(void *ptr, size_t len, enum data_type type)
 	}
 }
 
-static void data_list_add_pending(void *ptr, size_t len, enum data_type type)
+static void data_list_add_pending(void *ptr, size_t len, enum data_type type,
+				  uint32_t seq)
 {
 	for (size_t i = 0; i < ARRAY_SIZE(pending_data); i++) {
 		if (pending_data[i].ptr == NULL) {
 			pending_data[i].ptr = ptr;
 			pending_data[i].len = len;
 			pending_data[i].type = type;
+			pending_data[i].seq = seq;
 
 			LOG_DBG("Pending data added: %p", pending_data[i].ptr);
 			return;
@@ -361,53 +433,130 @@ static void data_list_add_pending(void *ptr, size_t len, enum data_type type)
 	SEND_ERROR(data, DATA_EVT_ERROR, -ENFILE);
 }
 
-static void data_resend(void)
+static int data_resend_entry(const struct ack_data *entry)
 {
 	struct data_module_event *evt;
+	enum data_module_event_type type;
+
+	switch (entry->type) {
+	case GENERIC:
+		type = DATA_EVT_DATA_SEND;
+		break;
+	case BATCH:
+		type = DATA_EVT_DATA_SEND_BATCH;
+		break;
+	case CONFIG:
+		type = DATA_EVT_CONFIG_SEND;
+		break;
+	case UI:
+		type = DATA_EVT_UI_DATA_SEND;
+		break;
+	default:
+		LOG_WRN("Unknown associated data type");
+		SEND_ERROR(data, DATA_EVT_ERROR, -ENODATA);
+		return -ENODATA;
+	}
+
+	evt = new_data_module_event();
+	evt->type = type;
+	evt->data.buffer.buf = entry->ptr;
+	evt->data.buffer.len = entry->len;
+	LOG_WRN("Resending data: %.*s", entry->len, log_strdup(entry->ptr));
+	EVENT_SUBMIT(evt);
+
+	/* Add entry to pending data list. */
+	data_list_add_pending(entry->ptr, entry->len, entry->type, entry->seq);
+
+	return 0;
+}
 
+#if defined(CONFIG_DATA_FLASH_QUEUE)
+static bool data_list_pending_is_full(void)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(pending_data); i++) {
+		if (pending_data[i].ptr == NULL) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* Resends a batch of entries from the flash queue. The rest of the entries
+ * are resent the next time data is sent.
+ */
+static void failed_queue_resend(void)
+{
+	int err;
+	struct flash_queue_entry entry;
+	struct ack_data data;
+
+	for (size_t i = 0; i < CONFIG_DATA_FLASH_QUEUE_DRAIN_COUNT; i++) {
+		if (data_list_pending_is_full()) {
+			return;
+		}
+
+		err = flash_queue_peek(&failed_queue, &entry);
+		if (err == -ENODATA) {
+			return;
+		} else if (err) {
+			LOG_ERR("flash_queue_peek, error: %d", err);
+			return;
+		}
+
+		/* Room for a NUL terminator, the data is logged as a
+		 * string.
+		 */
+		data.ptr = k_malloc(entry.len + 1);
+		if (data.ptr == NULL) {
+			LOG_ERR("Could not allocate data read from flash");
+			return;
+		}
+
+		err = flash_queue_read(&failed_queue, &entry, data.ptr,
+				       entry.len);
+		if (err) {
+			LOG_ERR("flash_queue_read, error: %d", err);
+			k_free(data.ptr);
+			return;
+		}
+
+		((char *)data.ptr)[entry.len] = '\0';
+		data.len = entry.len;
+		data.type = entry.type;
+		data.seq = entry.seq;
+
+		failed_queue_seq_read = entry.seq;
+
+		err = data_resend_entry(&data);
+		if (err) {
+			/* Not sent, and never to be. */
+			k_free(data.ptr);
+			failed_queue_ack();
+			return;
+		}
+	}
+}
+#endif
+
+static void data_resend(void)
+{
 	for (size_t i = 0; i < ARRAY_SIZE(failed_data); i++) {
 		if (failed_data[i].ptr != NULL) {
-
-			evt = new_data_module_event();
-
-			switch (failed_data[i].type) {
-			case GENERIC:
-				evt->type = DATA_EVT_DATA_SEND;
-				break;
-			case BATCH:
-				evt->type = DATA_EVT_DATA_SEND_BATCH;
-				break;
-			case CONFIG:
-				evt->type = DATA_EVT_CONFIG_SEND;
-				break;
-			case UI:
-				evt->type = DATA_EVT_UI_DATA_SEND;
-				break;
-			default:
-				LOG_WRN("Unknown associated data type");
-				SEND_ERROR(data, DATA_EVT_ERROR, -ENODATA);
+			if (data_resend_entry(&failed_data[i])) {
 				return;
 			}
 
-			evt->data.buffer.buf = failed_data[i].ptr;
-			evt->data.buffer.len = failed_data[i].len;
-			LOG_WRN("Resending data: %.*s", failed_data[i].len,
-				log_strdup(failed_data[i].ptr));
-			EVENT_SUBMIT(evt);
-
-			/* Move data from failed to pending data list after
-			 * resend.
+			/* Remove entry from failed data list, it has been
+			 * moved to the pending data list.
 			 */
-
-			/* Add entry to pending data list. */
-			data_list_add_pending(failed_data[i].ptr,
-					      failed_data[i].len,
-					      failed_data[i].type);
-
-			/* Remove entry from failed data list. */
 			data_list_clear_entry(&failed_data[i]);
 		}
 	}
+
+#if defined(CONFIG_DATA_FLASH_QUEUE)
+	failed_queue_resend();
+#endif
 }
 
 static void data_ack(void *ptr, bool sent)
@@ -433,6 +582,10 @@ static void data_ack(void *ptr, bool sent)
 						     pending_data[i].type);
 			}
 			data_list_clear_entry(&pending_data[i]);
+
+#if defined(CONFIG_DATA_FLASH_QUEUE)
+			failed_queue_ack();
+#endif
 			return;
 		}
 	}
@@ -476,6 +629,19 @@ static int setup(void)
 		return err;
 	}
 
+#if defined(CONFIG_DATA_FLASH_QUEUE)
+	err = flash_queue_init(&failed_queue, FLASH_QUEUE_AREA_ID);
+	if (err) {
+		LOG_ERR("flash_queue_init, error: %d", err);
+		return err;
+	}
+
+	if (flash_queue_count(&failed_queue) > 0) {
+		LOG_DBG("%d entries to be resent from flash",
+			flash_queue_count(&failed_queue));
+	}
+#endif
+
 	return 0;
 }
 
@@ -545,7 +711,7 @@ static void data_send(void)
 	data_module_event_new->data.buffer.buf = codec.buf;
 	data_module_event_new->data.buffer.len = codec.len;
 
-	data_list_add_pending(codec.buf, codec.len, GENERIC);
+	data_list_add_pending(codec.buf, codec.len, GENERIC, 0);
 	EVENT_SUBMIT(data_module_event_new);
 
 	codec.buf = NULL;
@@ -578,7 +744,7 @@ static void data_send(void)
 	data_module_event_batch->data.buffer.buf = codec.buf;
 	data_module_event_batch->data.buffer.len = codec.len;
 
-	data_list_add_pending(codec.buf, codec.len, BATCH);
+	data_list_add_pending(codec.buf, codec.len, BATCH, 0);
 	EVENT_SUBMIT(data_module_event_batch);
 }
 
@@ -609,7 +775,7 @@ static void config_send(bool send_all)
 	evt->data.buffer.buf = codec.buf;
 	evt->data.buffer.len = codec.len;
 
-	data_list_add_pending(codec.buf, codec.len, CONFIG);
+	data_list_add_pending(codec.buf, codec.len, CONFIG, 0);
 	EVENT_SUBMIT(evt);
 
 exit:
@@ -646,7 +812,7 @@ static void data_ui_send(void)
 	evt->data.buffer.buf = codec.buf;
 	evt->data.buffer.len = codec.len;
 
-	data_list_add_pending(codec.buf, codec.len, UI);
+	data_list_add_pending(codec.buf, codec.len, UI, 0);
 
 	EVENT_SUBMIT(evt);
 }
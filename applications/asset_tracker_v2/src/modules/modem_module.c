@@ -44,8 +44,21 @@ static enum state_type {
 	STATE_SHUTDOWN,
 } state;
 
-/* Struct that holds data from the modem information module. */
-static struct modem_param_info modem_param;
+/* Fields of the modem information sampled for each data type. */
+#define STATIC_MODEM_DATA_FIELDS (MODEM_INFO_SNAPSHOT_FIELD(FW_VERSION) |	\
+				  MODEM_INFO_SNAPSHOT_FIELD(ICCID) |		\
+				  MODEM_INFO_SNAPSHOT_FIELD(SYSTEM_MODE) |	\
+				  MODEM_INFO_SNAPSHOT_FIELD(CUR_BAND))
+#define DYNAMIC_MODEM_DATA_FIELDS (MODEM_INFO_SNAPSHOT_FIELD(IP_ADDRESS) |	\
+				   MODEM_INFO_SNAPSHOT_FIELD(CELLID) |		\
+				   MODEM_INFO_SNAPSHOT_FIELD(OPERATOR) |	\
+				   MODEM_INFO_SNAPSHOT_FIELD(AREA_CODE))
+
+/* Snapshots that hold data from the modem information module. The dynamic
+ * snapshot keeps the previous values, to report only the ones that changed.
+ */
+static struct modem_info_snapshot static_snapshot;
+static struct modem_info_snapshot dynamic_snapshot;
 
 /* Value that always holds the latest RSRP value. */
 static uint16_t rsrp_value_latest;
@@ -265,10 +278,10 @@ static void check_modem_fw_version(void)
 	if (modem_fw_version_checked) {
 		return;
 	}
-	if (strcmp(modem_param.device.modem_fw.value_string,
+	if (strcmp(static_snapshot.modem_fw,
 		   CONFIG_EXPECTED_MODEM_FIRMWARE_VERSION) != 0) {
 		LOG_WRN("Unsupported modem firmware version: %s",
-			log_strdup(modem_param.device.modem_fw.value_string));
+			log_strdup(static_snapshot.modem_fw));
 		LOG_WRN("Expected firmware version: %s",
 			CONFIG_EXPECTED_MODEM_FIRMWARE_VERSION);
 		LOG_WRN("You can change the expected version through the");
@@ -286,9 +299,9 @@ static int static_modem_data_get(void)
 	int err;
 
 	/* Request data from modem information module. */
-	err = modem_info_params_get(&modem_param);
+	err = modem_info_snapshot_get(&static_snapshot, STATIC_MODEM_DATA_FIELDS);
 	if (err) {
-		LOG_ERR("modem_info_params_get, error: %d", err);
+		LOG_ERR("modem_info_snapshot_get, error: %d", err);
 		return err;
 	}
 
@@ -296,25 +309,28 @@ static int static_modem_data_get(void)
 
 	struct modem_module_event *modem_module_event = new_modem_module_event();
 
-	modem_module_event->data.modem_static.nw_mode_ltem = modem_param.network.lte_mode.value;
-	modem_module_event->data.modem_static.nw_mode_nbiot = modem_param.network.nbiot_mode.value;
-	modem_module_event->data.modem_static.nw_mode_gps = modem_param.network.gps_mode.value;
-	modem_module_event->data.modem_static.band = modem_param.network.current_band.value;
+	modem_module_event->data.modem_static.nw_mode_ltem =
+		!!(static_snapshot.system_mode & MODEM_INFO_SNAPSHOT_SYSTEM_MODE_LTEM);
+	modem_module_event->data.modem_static.nw_mode_nbiot =
+		!!(static_snapshot.system_mode & MODEM_INFO_SNAPSHOT_SYSTEM_MODE_NBIOT);
+	modem_module_event->data.modem_static.nw_mode_gps =
+		!!(static_snapshot.system_mode & MODEM_INFO_SNAPSHOT_SYSTEM_MODE_GPS);
+	modem_module_event->data.modem_static.band = static_snapshot.current_band;
 
 	strncpy(modem_module_event->data.modem_static.app_version,
 		CONFIG_ASSET_TRACKER_V2_APP_VERSION,
 		sizeof(modem_module_event->data.modem_static.app_version) - 1);
 
 	strncpy(modem_module_event->data.modem_static.board_version,
-		modem_param.device.board,
+		CONFIG_BOARD,
 		sizeof(modem_module_event->data.modem_static.board_version) - 1);
 
 	strncpy(modem_module_event->data.modem_static.modem_fw,
-		modem_param.device.modem_fw.value_string,
+		static_snapshot.modem_fw,
 		sizeof(modem_module_event->data.modem_static.modem_fw) - 1);
 
 	strncpy(modem_module_event->data.modem_static.iccid,
-		modem_param.sim.iccid.value_string,
+		static_snapshot.iccid,
 		sizeof(modem_module_event->data.modem_static.iccid) - 1);
 
 	modem_module_event->data.modem_static.app_version
@@ -337,13 +353,18 @@ static int static_modem_data_get(void)
 }
 
 static void populate_event_with_dynamic_modem_data(struct modem_module_event *event,
-						   struct modem_param_info *param)
+						   struct modem_info_snapshot *snapshot)
 {
 	/* If this flag is set all sampled parameter values will be included in the event regardless
 	 * if they have changed or not.
 	 */
 	bool include = IS_ENABLED(CONFIG_MODEM_SEND_ALL_SAMPLED_DATA);
 
+	/* Fields to include in the event, the snapshot flags the ones that changed since the
+	 * last sample request.
+	 */
+	uint32_t fields = include ? snapshot->present : snapshot->changed;
+
 	/* Flag that checks if parameters has been added to the event. */
 	bool params_added = false;
 
@@ -353,68 +374,52 @@ static void populate_event_with_dynamic_modem_data(struct modem_module_event *ev
 	 */
 	memset(&event->data.modem_dynamic, 0, sizeof(struct modem_module_dynamic_modem_data));
 
-	/* Structure that holds previous sampled dynamic modem data. By default, set all members of
-	 * the structure to invalid values.
+	/* Previous sampled RSRP value, it is not part of the snapshot. By default, set to an
+	 * invalid value.
 	 */
-	static struct modem_module_dynamic_modem_data prev = { .rsrp = UINT8_MAX };
+	static uint16_t prev_rsrp = UINT8_MAX;
 
-	/* Compare the latest sampled parameters with the previous. If there has been a change we
-	 * want to include the parameters in the event.
-	 */
-	if ((prev.rsrp != rsrp_value_latest) || include) {
+	if ((prev_rsrp != rsrp_value_latest) || include) {
 		event->data.modem_dynamic.rsrp = rsrp_value_latest;
-		prev.rsrp = rsrp_value_latest;
+		prev_rsrp = rsrp_value_latest;
 
 		event->data.modem_dynamic.rsrp_fresh = true;
 		params_added = true;
 	}
 
-	if ((strcmp(prev.ip_address, param->network.ip_address.value_string) != 0) || include) {
+	if (fields & MODEM_INFO_SNAPSHOT_FIELD(IP_ADDRESS)) {
 		strncpy(event->data.modem_dynamic.ip_address,
-			modem_param.network.ip_address.value_string,
+			snapshot->ip_address,
 			sizeof(event->data.modem_dynamic.ip_address) - 1);
 
-		strncpy(prev.ip_address,
-			param->network.ip_address.value_string,
-			sizeof(prev.ip_address) - 1);
-
 		event->data.modem_dynamic.ip_address
 			[sizeof(event->data.modem_dynamic.ip_address) - 1] = '\0';
 
-		prev.ip_address[sizeof(prev.ip_address) - 1] = '\0';
-
 		event->data.modem_dynamic.ip_address_fresh = true;
 		params_added = true;
 	}
 
-	if ((prev.cell_id != param->network.cellid_dec) || include) {
-		event->data.modem_dynamic.cell_id = param->network.cellid_dec;
-		prev.cell_id = param->network.cellid_dec;
+	if (fields & MODEM_INFO_SNAPSHOT_FIELD(CELLID)) {
+		event->data.modem_dynamic.cell_id = snapshot->cell_id;
 
 		event->data.modem_dynamic.cell_id_fresh = true;
 		params_added = true;
 	}
 
-	if ((strcmp(prev.mccmnc, param->network.current_operator.value_string) != 0) || include) {
+	if (fields & MODEM_INFO_SNAPSHOT_FIELD(OPERATOR)) {
 		strncpy(event->data.modem_dynamic.mccmnc,
-			modem_param.network.current_operator.value_string,
+			snapshot->mccmnc,
 			sizeof(event->data.modem_dynamic.mccmnc));
 
-		strncpy(prev.mccmnc, param->network.current_operator.value_string,
-			sizeof(prev.mccmnc));
-
 		event->data.modem_dynamic.mccmnc
 			[sizeof(event->data.modem_dynamic.mccmnc) - 1] = '\0';
 
-		prev.mccmnc[sizeof(prev.mccmnc) - 1] = '\0';
-
 		event->data.modem_dynamic.mccmnc_fresh = true;
 		params_added = true;
 	}
 
-	if ((prev.area_code != modem_param.network.area_code.value) || include) {
-		event->data.modem_dynamic.area_code = param->network.area_code.value;
-		prev.area_code = param->network.area_code.value;
+	if (fields & MODEM_INFO_SNAPSHOT_FIELD(AREA_CODE)) {
+		event->data.modem_dynamic.area_code = snapshot->area_code;
 
 		event->data.modem_dynamic.area_code_fresh = true;
 		params_added = true;
@@ -433,16 +438,20 @@ static int dynamic_modem_data_get(void)
 {
 	int err;
 
-	/* Request data from modem information module. */
-	err = modem_info_params_get(&modem_param);
-	if (err) {
-		LOG_ERR("modem_info_params_get, error: %d", err);
+	/* Request data from modem information module. The fields that could not be read keep
+	 * their previous value, and are not reported as changed.
+	 */
+	err = modem_info_snapshot_get(&dynamic_snapshot, DYNAMIC_MODEM_DATA_FIELDS);
+	if (err == -EAGAIN) {
+		LOG_WRN("Some dynamic modem parameters could not be read");
+	} else if (err) {
+		LOG_ERR("modem_info_snapshot_get, error: %d", err);
 		return err;
 	}
 
 	struct modem_module_event *modem_module_event = new_modem_module_event();
 
-	populate_event_with_dynamic_modem_data(modem_module_event, &modem_param);
+	populate_event_with_dynamic_modem_data(modem_module_event, &dynamic_snapshot);
 
 	EVENT_SUBMIT(modem_module_event);
 	return 0;
@@ -487,13 +496,12 @@ static bool battery_data_requested(enum app_module_data_type *data_list,
 static int battery_data_get(void)
 {
 	int err;
+	struct modem_info_snapshot snapshot = { 0 };
 
-	/* Replace this function with a function that specifically
-	 * requests battery.
-	 */
-	err = modem_info_params_get(&modem_param);
+	err = modem_info_snapshot_get(&snapshot,
+				      MODEM_INFO_SNAPSHOT_FIELD(BATTERY));
 	if (err) {
-		LOG_ERR("modem_info_params_get, error: %d", err);
+		LOG_ERR("modem_info_snapshot_get, error: %d", err);
 		return err;
 	}
 
@@ -501,7 +509,7 @@ static int battery_data_get(void)
 			new_modem_module_event();
 
 	modem_module_event->data.bat.battery_voltage =
-			modem_param.device.battery.value;
+			snapshot.battery;
 	modem_module_event->data.bat.timestamp = k_uptime_get();
 	modem_module_event->type = MODEM_EVT_BATTERY_DATA_READY;
 
@@ -551,12 +559,6 @@ static int modem_data_init(void)
 		return err;
 	}
 
-	err = modem_info_params_init(&modem_param);
-	if (err) {
-		LOG_INF("modem_info_params_init, error: %d", err);
-		return err;
-	}
-
 	err = modem_info_rsrp_register(modem_rsrp_handler);
 	if (err) {
 		LOG_INF("modem_info_rsrp_register, error: %d", err);
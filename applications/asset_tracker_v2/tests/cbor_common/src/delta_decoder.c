@@ -0,0 +1,455 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include "delta_decoder.h"
+#include "json_protocol_names.h"
+
+/* CBOR major types, RFC 8949 section 3.1. */
+#define CBOR_UINT		0
+#define CBOR_NINT		1
+#define CBOR_TEXT		3
+#define CBOR_ARRAY		4
+#define CBOR_MAP		5
+#define CBOR_SIMPLE		7
+
+/* Additional information giving the length of the argument. */
+#define CBOR_ARG_1		24
+#define CBOR_ARG_4		26
+#define CBOR_ARG_8		27
+
+#define FIXED_SCALE		10000000.0
+#define FIELDS_MAX		6
+#define TEXT_MAX_LEN		INET6_ADDRSTRLEN
+
+enum field_type {
+	FIELD_NUMBER,
+	FIELD_INT,
+	FIELD_FIXED,
+	FIELD_TEXT,
+};
+
+struct field_value {
+	double number;
+	int64_t integer;
+	char text[TEXT_MAX_LEN];
+};
+
+/* Last value of each field, carried over to the next entries. */
+struct state {
+	int64_t ts;
+	uint8_t fields;
+	struct field_value values[FIELDS_MAX];
+};
+
+struct schema {
+	const char *label;
+	const enum field_type *types;
+	size_t field_count;
+	/* Offset of the entry count in struct delta_batch. */
+	size_t count_offset;
+	/* Stores the state as entry n of the decoded batch. */
+	void (*store)(struct delta_batch *batch, size_t n, const struct state *state);
+};
+
+struct reader {
+	const uint8_t *buf;
+	size_t len;
+	size_t pos;
+};
+
+static int head_get(struct reader *reader, uint8_t *major, uint8_t *info, uint64_t *arg)
+{
+	size_t arg_len;
+
+	if (reader->pos >= reader->len) {
+		return -EBADMSG;
+	}
+
+	*major = reader->buf[reader->pos] >> 5;
+	*info = reader->buf[reader->pos] & 0x1f;
+	reader->pos++;
+
+	if (*info < CBOR_ARG_1) {
+		*arg = *info;
+		return 0;
+	} else if (*info > CBOR_ARG_8) {
+		return -EBADMSG;
+	}
+
+	arg_len = 1 << (*info - CBOR_ARG_1);
+	if (reader->len - reader->pos < arg_len) {
+		return -EBADMSG;
+	}
+
+	*arg = 0;
+
+	for (size_t i = 0; i < arg_len; i++) {
+		*arg = (*arg << 8) | reader->buf[reader->pos++];
+	}
+
+	return 0;
+}
+
+/* Gets the head of an array or a map, or an unsigned integer. */
+static int uint_get(struct reader *reader, uint8_t expected, uint64_t *value)
+{
+	int err;
+	uint8_t major;
+	uint8_t info;
+
+	err = head_get(reader, &major, &info, value);
+	if (err) {
+		return err;
+	}
+
+	return (major == expected) ? 0 : -EBADMSG;
+}
+
+static int int_get(struct reader *reader, int64_t *value)
+{
+	int err;
+	uint8_t major;
+	uint8_t info;
+	uint64_t arg;
+
+	err = head_get(reader, &major, &info, &arg);
+	if (err) {
+		return err;
+	}
+
+	if (major == CBOR_UINT) {
+		*value = arg;
+	} else if (major == CBOR_NINT) {
+		*value = -1 - (int64_t)arg;
+	} else {
+		return -EBADMSG;
+	}
+
+	return 0;
+}
+
+static int number_get(struct reader *reader, double *value)
+{
+	int err;
+	uint8_t major;
+	uint8_t info;
+	uint64_t arg;
+
+	err = head_get(reader, &major, &info, &arg);
+	if (err) {
+		return err;
+	}
+
+	if (major == CBOR_UINT) {
+		*value = arg;
+	} else if (major == CBOR_NINT) {
+		*value = -1 - (int64_t)arg;
+	} else if ((major == CBOR_SIMPLE) && (info == CBOR_ARG_4)) {
+		uint32_t bits = arg;
+		float single;
+
+		memcpy(&single, &bits, sizeof(single));
+		*value = single;
+	} else if ((major == CBOR_SIMPLE) && (info == CBOR_ARG_8)) {
+		memcpy(value, &arg, sizeof(*value));
+	} else {
+		return -EBADMSG;
+	}
+
+	return 0;
+}
+
+static int text_get(struct reader *reader, char *text, size_t size)
+{
+	int err;
+	uint64_t len;
+
+	err = uint_get(reader, CBOR_TEXT, &len);
+	if (err) {
+		return err;
+	}
+
+	if ((len >= size) || (reader->len - reader->pos < len)) {
+		return -EBADMSG;
+	}
+
+	memcpy(text, &reader->buf[reader->pos], len);
+	text[len] = '\0';
+	reader->pos += len;
+
+	return 0;
+}
+
+static void modem_dynamic_store(struct delta_batch *batch, size_t n, const struct state *state)
+{
+	struct cloud_data_modem_dynamic *data = &batch->modem_dyn[n];
+
+	*data = (struct cloud_data_modem_dynamic) {
+		.ts = state->ts,
+		.rsrp = state->values[0].integer,
+		.area = state->values[1].integer,
+		.cell = state->values[3].integer,
+		.queued = true,
+		.rsrp_fresh = (state->fields & BIT(0)) != 0,
+		.area_code_fresh = (state->fields & BIT(1)) != 0,
+		.mccmnc_fresh = (state->fields & BIT(2)) != 0,
+		.cell_id_fresh = (state->fields & BIT(3)) != 0,
+		.ip_address_fresh = (state->fields & BIT(4)) != 0,
+	};
+
+	if (data->mccmnc_fresh) {
+		snprintf(data->mccmnc, sizeof(data->mccmnc), "%d",
+			 (int)state->values[2].integer);
+	}
+
+	strcpy(data->ip, state->values[4].text);
+}
+
+static void gps_store(struct delta_batch *batch, size_t n, const struct state *state)
+{
+	batch->gps[n] = (struct cloud_data_gps) {
+		.gps_ts = state->ts,
+		.longi = state->values[0].integer / FIXED_SCALE,
+		.lat = state->values[1].integer / FIXED_SCALE,
+		.acc = state->values[2].number,
+		.alt = state->values[3].number,
+		.spd = state->values[4].number,
+		.hdg = state->values[5].number,
+		.queued = true
+	};
+}
+
+static void sensor_store(struct delta_batch *batch, size_t n, const struct state *state)
+{
+	batch->sensor[n] = (struct cloud_data_sensors) {
+		.env_ts = state->ts,
+		.temp = state->values[0].number,
+		.hum = state->values[1].number,
+		.queued = true
+	};
+}
+
+static void ui_store(struct delta_batch *batch, size_t n, const struct state *state)
+{
+	batch->ui[n] = (struct cloud_data_ui) {
+		.btn_ts = state->ts,
+		.btn = state->values[0].integer,
+		.queued = true
+	};
+}
+
+static void battery_store(struct delta_batch *batch, size_t n, const struct state *state)
+{
+	batch->bat[n] = (struct cloud_data_battery) {
+		.bat_ts = state->ts,
+		.bat = state->values[0].integer,
+		.queued = true
+	};
+}
+
+static void accel_store(struct delta_batch *batch, size_t n, const struct state *state)
+{
+	batch->accel[n] = (struct cloud_data_accelerometer) {
+		.ts = state->ts,
+		.values = {
+			state->values[0].number,
+			state->values[1].number,
+			state->values[2].number
+		},
+		.queued = true
+	};
+}
+
+static const enum field_type modem_dynamic_fields[] = {
+	FIELD_INT, FIELD_INT, FIELD_INT, FIELD_INT, FIELD_TEXT
+};
+static const enum field_type gps_fields[] = {
+	FIELD_FIXED, FIELD_FIXED, FIELD_NUMBER, FIELD_NUMBER, FIELD_NUMBER, FIELD_NUMBER
+};
+static const enum field_type sensor_fields[] = { FIELD_NUMBER, FIELD_NUMBER };
+static const enum field_type ui_fields[] = { FIELD_INT };
+static const enum field_type battery_fields[] = { FIELD_INT };
+static const enum field_type accel_fields[] = { FIELD_NUMBER, FIELD_NUMBER, FIELD_NUMBER };
+
+#define SCHEMA(_label, _name, _count)					\
+	{								\
+		.label = _label,					\
+		.types = _name##_fields,				\
+		.field_count = ARRAY_SIZE(_name##_fields),		\
+		.count_offset = offsetof(struct delta_batch, _count),	\
+		.store = _name##_store,					\
+	}
+
+static const struct schema schemas[] = {
+	SCHEMA(DATA_MODEM_DYNAMIC, modem_dynamic, modem_dyn_count),
+	SCHEMA(DATA_GPS, gps, gps_count),
+	SCHEMA(DATA_ENVIRONMENTALS, sensor, sensor_count),
+	SCHEMA(DATA_BUTTON, ui, ui_count),
+	SCHEMA(DATA_BATTERY, battery, bat_count),
+	SCHEMA(DATA_MOVEMENT, accel, accel_count),
+};
+
+/* Applies an entry to the state. */
+static int entry_decode(struct reader *reader, const struct schema *schema, struct state *state,
+			bool first)
+{
+	int err;
+	uint64_t len;
+	uint64_t changed;
+	int64_t ts;
+
+	err = uint_get(reader, CBOR_ARRAY, &len);
+	if (err) {
+		return err;
+	}
+
+	err = int_get(reader, &ts);
+	if (err) {
+		return err;
+	}
+
+	/* The first timestamp is absolute, the others are relative to the previous entry. */
+	state->ts = first ? ts : state->ts + ts;
+
+	err = uint_get(reader, CBOR_UINT, &changed);
+	if (err) {
+		return err;
+	}
+
+	if (changed & ~BIT_MASK(schema->field_count)) {
+		return -EBADMSG;
+	}
+
+	for (size_t i = 0; i < schema->field_count; i++) {
+		struct field_value *value = &state->values[i];
+		int64_t integer = 0;
+
+		if (!(changed & BIT(i))) {
+			continue;
+		}
+
+		len--;
+
+		switch (schema->types[i]) {
+		case FIELD_NUMBER:
+			err = number_get(reader, &value->number);
+			break;
+		case FIELD_INT:
+			err = int_get(reader, &value->integer);
+			break;
+		case FIELD_FIXED:
+			/* Relative to the previous value, if there is one. */
+			err = int_get(reader, &integer);
+			value->integer = (state->fields & BIT(i)) ? value->integer + integer :
+								     integer;
+			break;
+		case FIELD_TEXT:
+			err = text_get(reader, value->text, sizeof(value->text));
+			break;
+		}
+
+		if (err) {
+			return err;
+		}
+	}
+
+	if (len != 2) {
+		return -EBADMSG;
+	}
+
+	state->fields |= changed;
+
+	return 0;
+}
+
+static int entries_decode(struct reader *reader, const struct schema *schema,
+			  struct delta_batch *batch, size_t *count)
+{
+	int err;
+	uint64_t len;
+	struct state state = { 0 };
+
+	err = uint_get(reader, CBOR_ARRAY, &len);
+	if (err) {
+		return err;
+	}
+
+	if (len > *count) {
+		return -ENOMEM;
+	}
+
+	for (size_t n = 0; n < len; n++) {
+		err = entry_decode(reader, schema, &state, n == 0);
+		if (err) {
+			return err;
+		}
+
+		schema->store(batch, n, &state);
+	}
+
+	*count = len;
+
+	return 0;
+}
+
+int delta_batch_decode(const uint8_t *buf, size_t len, struct delta_batch *batch)
+{
+	int err;
+	uint64_t map_size;
+	char label[8];
+	size_t counts[ARRAY_SIZE(schemas)];
+	struct reader reader = {
+		.buf = buf,
+		.len = len,
+	};
+
+	for (size_t i = 0; i < ARRAY_SIZE(schemas); i++) {
+		size_t *count = (size_t *)((uint8_t *)batch + schemas[i].count_offset);
+
+		counts[i] = *count;
+		*count = 0;
+	}
+
+	err = uint_get(&reader, CBOR_MAP, &map_size);
+	if (err) {
+		return err;
+	}
+
+	for (size_t n = 0; n < map_size; n++) {
+		const struct schema *schema = NULL;
+		size_t i;
+
+		err = text_get(&reader, label, sizeof(label));
+		if (err) {
+			return err;
+		}
+
+		for (i = 0; i < ARRAY_SIZE(schemas); i++) {
+			if (strcmp(label, schemas[i].label) == 0) {
+				schema = &schemas[i];
+				break;
+			}
+		}
+
+		if (schema == NULL) {
+			return -EBADMSG;
+		}
+
+		err = entries_decode(&reader, schema, batch, &counts[i]);
+		if (err) {
+			return err;
+		}
+
+		*(size_t *)((uint8_t *)batch + schema->count_offset) = counts[i];
+	}
+
+	return (reader.pos == reader.len) ? 0 : -EBADMSG;
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/**@file
+ * @brief Reference decoder of the delta encoded batch messages.
+ */
+
+#ifndef DELTA_DECODER_H__
+#define DELTA_DECODER_H__
+
+#include <zephyr.h>
+
+#include "cloud_codec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Decoded batch. The counts give the size of the arrays, and are set to the number of
+ *	   decoded entries.
+ */
+struct delta_batch {
+	struct cloud_data_modem_dynamic *modem_dyn;
+	struct cloud_data_gps *gps;
+	struct cloud_data_sensors *sensor;
+	struct cloud_data_ui *ui;
+	struct cloud_data_battery *bat;
+	struct cloud_data_accelerometer *accel;
+	size_t modem_dyn_count;
+	size_t gps_count;
+	size_t sensor_count;
+	size_t ui_count;
+	size_t bat_count;
+	size_t accel_count;
+};
+
+/**
+ * @brief Decode a batch message encoded by cbor_common_batch_data_delta_encode().
+ *
+ * @details The entries are rebuilt in full, from the oldest one, with the values carried over
+ *	    from the previous entries. The decoded entries are queued, and each dynamic modem
+ *	    value that is known is flagged as fresh.
+ *
+ * @param[in] buf Encoded batch.
+ * @param[in] len Length of the encoded batch.
+ * @param[in, out] batch Decoded batch.
+ *
+ * @return 0 on success. -EBADMSG if the input is not a valid batch, -ENOMEM if an array of the
+ *	   decoded batch is too small.
+ */
+int delta_batch_decode(const uint8_t *buf, size_t len, struct delta_batch *batch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DELTA_DECODER_H__ */
@@ -0,0 +1,628 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <zephyr.h>
+#include <stdio.h>
+#include <string.h>
+#include <cJSON.h>
+#include <cJSON_os.h>
+
+#include "cbor_common.h"
+#include "delta_decoder.h"
+#include "json_common.h"
+#include "cloud_codec.h"
+#include "json_protocol_names.h"
+
+/* Timestamp set by the date_time mock, 0x0000016c23cd3673. */
+#define TEST_TS 0x1b, 0x00, 0x00, 0x01, 0x6c, 0x23, 0xcd, 0x36, 0x73
+#define TEST_TS_MS 1563968747123
+
+/* Time between the entries filled by buffers_fill(). */
+#define SAMPLE_INTERVAL_MS	60000
+
+/* Default sizes of the data module ring buffers. */
+#define GPS_COUNT		10
+#define SENSOR_COUNT		10
+#define MODEM_DYN_COUNT		3
+#define UI_COUNT		3
+#define ACCEL_COUNT		3
+#define BAT_COUNT		3
+
+#define BENCHMARK_ROUNDS	20
+
+static struct cloud_data_gps gps_buf[GPS_COUNT];
+static struct cloud_data_sensors sensor_buf[SENSOR_COUNT];
+static struct cloud_data_modem_dynamic modem_dyn_buf[MODEM_DYN_COUNT];
+static struct cloud_data_ui ui_buf[UI_COUNT];
+static struct cloud_data_accelerometer accel_buf[ACCEL_COUNT];
+static struct cloud_data_battery bat_buf[BAT_COUNT];
+
+static struct cloud_codec_data output;
+
+/* Copies of the buffers, to compare with the decoded entries. */
+static struct cloud_data_gps gps_copy[GPS_COUNT];
+static struct cloud_data_sensors sensor_copy[SENSOR_COUNT];
+static struct cloud_data_modem_dynamic modem_dyn_copy[MODEM_DYN_COUNT];
+static struct cloud_data_ui ui_copy[UI_COUNT];
+static struct cloud_data_accelerometer accel_copy[ACCEL_COUNT];
+static struct cloud_data_battery bat_copy[BAT_COUNT];
+
+static void output_check(const uint8_t *expected, size_t expected_len)
+{
+	zassert_equal(output.len, expected_len, "Wrong output length %d", (int)output.len);
+	zassert_mem_equal(output.buf, expected, expected_len, "Wrong output");
+}
+
+static int batch_encode(void)
+{
+	return cbor_common_batch_data_encode(&output, gps_buf, sensor_buf, modem_dyn_buf, ui_buf,
+					     accel_buf, bat_buf, GPS_COUNT, SENSOR_COUNT,
+					     MODEM_DYN_COUNT, UI_COUNT, ACCEL_COUNT, BAT_COUNT);
+}
+
+static int batch_delta_encode(void)
+{
+	return cbor_common_batch_data_delta_encode(&output, gps_buf, sensor_buf, modem_dyn_buf,
+						   ui_buf, accel_buf, bat_buf, GPS_COUNT,
+						   SENSOR_COUNT, MODEM_DYN_COUNT, UI_COUNT,
+						   ACCEL_COUNT, BAT_COUNT);
+}
+
+static void test_encode_ui_data(void)
+{
+	int ret;
+	struct cloud_data_ui data = {
+		.btn = 1,
+		.btn_ts = 1000,
+		.queued = true
+	};
+	const uint8_t expected[] = {
+		0xa1,
+		0x63, 'b', 't', 'n',
+		0xa2,
+		0x61, 'v', 0x01,
+		0x62, 't', 's', TEST_TS
+	};
+
+	ret = cbor_common_ui_data_encode(&output, &data);
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+	zassert_false(data.queued, "Entry still queued");
+	output_check(expected, sizeof(expected));
+
+	/* Check for invalid inputs. */
+
+	ret = cbor_common_ui_data_encode(&output, &data);
+	zassert_equal(-ENODATA, ret, "Return value %d is wrong", ret);
+}
+
+static void test_encode_numbers(void)
+{
+	int ret;
+	const uint8_t expected[] = {
+		0xa1,
+		0x63, 'g', 'p', 's',
+		0x81,
+		0xa2,
+		0x61, 'v',
+		0xa6,
+		/* Exact in single precision */
+		0x63, 'l', 'n', 'g', 0xfa, 0x41, 0x28, 0x00, 0x00,
+		/* Not exact in single precision */
+		0x63, 'l', 'a', 't', 0xfb, 0x40, 0x4f, 0xb7, 0x1a, 0xf6, 0x25, 0x8b, 0xab,
+		/* Integers */
+		0x63, 'a', 'c', 'c', 0x18, 0x18,
+		0x63, 'a', 'l', 't', 0xfa, 0x43, 0x2a, 0x80, 0x00,
+		0x63, 's', 'p', 'd', 0x00,
+		0x63, 'h', 'd', 'g', 0x20,
+		0x62, 't', 's', TEST_TS
+	};
+
+	gps_buf[1] = (struct cloud_data_gps) {
+		.longi = 10.5,
+		.lat = 63.4305103,
+		.acc = 24,
+		.alt = 170.5,
+		.spd = 0,
+		.hdg = -1,
+		.gps_ts = 1000,
+		.queued = true
+	};
+
+	ret = batch_encode();
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+	output_check(expected, sizeof(expected));
+}
+
+static void test_encode_modem_dynamic_data(void)
+{
+	int ret;
+	const uint8_t expected[] = {
+		0xa1,
+		0x64, 'r', 'o', 'a', 'm',
+		0x81,
+		0xa2,
+		0x61, 'v',
+		0xa2,
+		0x64, 'r', 's', 'r', 'p', 0x14,
+		0x66, 'm', 'c', 'c', 'm', 'n', 'c', 0x19, 0x5e, 0x8a,
+		0x62, 't', 's', TEST_TS
+	};
+
+	modem_dyn_buf[0] = (struct cloud_data_modem_dynamic) {
+		.rsrp = 20,
+		.area = 12,
+		.mccmnc = "24202",
+		.ts = 1000,
+		.queued = true,
+		.rsrp_fresh = true,
+		.mccmnc_fresh = true
+	};
+	/* No fresh values, unqueued without being encoded. */
+	modem_dyn_buf[2] = (struct cloud_data_modem_dynamic) {
+		.rsrp = 20,
+		.ts = 1000,
+		.queued = true
+	};
+
+	ret = batch_encode();
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+	zassert_false(modem_dyn_buf[0].queued, "Entry still queued");
+	zassert_false(modem_dyn_buf[2].queued, "Entry without values still queued");
+	output_check(expected, sizeof(expected));
+}
+
+static void test_encode_batch_invalid(void)
+{
+	int ret;
+
+	ret = batch_encode();
+	zassert_equal(-ENODATA, ret, "Return value %d is wrong", ret);
+
+	bat_buf[0] = (struct cloud_data_battery) {
+		.bat = 3600,
+		.bat_ts = 1000,
+		.queued = true
+	};
+	modem_dyn_buf[0] = (struct cloud_data_modem_dynamic) {
+		.mccmnc = "242O2",
+		.ts = 1000,
+		.queued = true,
+		.mccmnc_fresh = true
+	};
+
+	/* Nothing is encoded or unqueued. */
+	ret = batch_encode();
+	zassert_equal(-ENOTEMPTY, ret, "Return value %d is wrong", ret);
+	zassert_true(bat_buf[0].queued, "Entry unqueued");
+	zassert_equal(bat_buf[0].bat_ts, 1000, "Timestamp converted");
+	zassert_true(modem_dyn_buf[0].queued, "Entry unqueued");
+}
+
+/* Timestamp of entry i of a ring buffer that has wrapped around, one sample interval apart. */
+static int64_t sample_ts(size_t i, size_t count)
+{
+	return 1000 + ((i + count / 2) % count) * SAMPLE_INTERVAL_MS;
+}
+
+/* Fills the buffers with entries like the ones sampled by the application. */
+static void buffers_fill(void)
+{
+	for (size_t i = 0; i < GPS_COUNT; i++) {
+		gps_buf[i] = (struct cloud_data_gps) {
+			.longi = 10.4216148 + i * 0.0001,
+			.lat = 63.4305103 - i * 0.0001,
+			.acc = 12.345678,
+			.alt = 57.910522,
+			.spd = 1.234,
+			.hdg = 176.12,
+			.gps_ts = sample_ts(i, GPS_COUNT),
+			.queued = true
+		};
+	}
+
+	for (size_t i = 0; i < SENSOR_COUNT; i++) {
+		sensor_buf[i] = (struct cloud_data_sensors) {
+			.temp = 23.24 + (i / 4) * 0.5,
+			.hum = 50.51,
+			.env_ts = sample_ts(i, SENSOR_COUNT),
+			.queued = true
+		};
+	}
+
+	for (size_t i = 0; i < MODEM_DYN_COUNT; i++) {
+		modem_dyn_buf[i] = (struct cloud_data_modem_dynamic) {
+			.rsrp = 20 + i,
+			.area = 12,
+			.mccmnc = "24202",
+			.cell = 33703719,
+			.ip = "10.81.183.99",
+			.ts = sample_ts(i, MODEM_DYN_COUNT),
+			.queued = true,
+			.area_code_fresh = true,
+			.cell_id_fresh = true,
+			.rsrp_fresh = true,
+			.ip_address_fresh = true,
+			.mccmnc_fresh = true
+		};
+	}
+
+	for (size_t i = 0; i < UI_COUNT; i++) {
+		ui_buf[i] = (struct cloud_data_ui) {
+			.btn = 1,
+			.btn_ts = sample_ts(i, UI_COUNT),
+			.queued = true
+		};
+	}
+
+	for (size_t i = 0; i < ACCEL_COUNT; i++) {
+		accel_buf[i] = (struct cloud_data_accelerometer) {
+			.values = { 0.12, -9.81, 1.5 },
+			.ts = sample_ts(i, ACCEL_COUNT),
+			.queued = true
+		};
+	}
+
+	for (size_t i = 0; i < BAT_COUNT; i++) {
+		bat_buf[i] = (struct cloud_data_battery) {
+			.bat = 3600 - i * 10,
+			.bat_ts = sample_ts(i, BAT_COUNT),
+			.queued = true
+		};
+	}
+}
+
+static void test_encode_delta_gps_data(void)
+{
+	int ret;
+	const uint8_t expected[] = {
+		0xa1,
+		0x63, 'g', 'p', 's',
+		0x82,
+		/* Base record, oldest entry */
+		0x88,
+		TEST_TS,
+		0x18, 0x3f,
+		0x1a, 0x06, 0x36, 0x36, 0x54,
+		0x1a, 0x25, 0xce, 0xba, 0x4f,
+		0x18, 0x18,
+		0xfa, 0x43, 0x2a, 0x80, 0x00,
+		0x00,
+		0x18, 0x5a,
+		/* Relative timestamp, changes of lng, lat and alt */
+		0x85,
+		0x19, 0xea, 0x60,
+		0x0b,
+		0x18, 0x64,
+		0x38, 0x63,
+		0x18, 0xab
+	};
+
+	gps_buf[1] = (struct cloud_data_gps) {
+		.longi = 10.4216248,
+		.lat = 63.4305003,
+		.acc = 24,
+		.alt = 171,
+		.spd = 0,
+		.hdg = 90,
+		.gps_ts = 61000,
+		.queued = true
+	};
+	gps_buf[3] = (struct cloud_data_gps) {
+		.longi = 10.4216148,
+		.lat = 63.4305103,
+		.acc = 24,
+		.alt = 170.5,
+		.spd = 0,
+		.hdg = 90,
+		.gps_ts = 1000,
+		.queued = true
+	};
+	/* No fresh values, unqueued without being encoded. */
+	modem_dyn_buf[0] = (struct cloud_data_modem_dynamic) {
+		.rsrp = 20,
+		.ts = 1000,
+		.queued = true
+	};
+
+	ret = batch_delta_encode();
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+	zassert_false(gps_buf[1].queued, "Entry still queued");
+	zassert_false(gps_buf[3].queued, "Entry still queued");
+	zassert_false(modem_dyn_buf[0].queued, "Entry without values still queued");
+	output_check(expected, sizeof(expected));
+}
+
+static void buffers_copy(void)
+{
+	memcpy(gps_copy, gps_buf, sizeof(gps_buf));
+	memcpy(sensor_copy, sensor_buf, sizeof(sensor_buf));
+	memcpy(modem_dyn_copy, modem_dyn_buf, sizeof(modem_dyn_buf));
+	memcpy(ui_copy, ui_buf, sizeof(ui_buf));
+	memcpy(accel_copy, accel_buf, sizeof(accel_buf));
+	memcpy(bat_copy, bat_buf, sizeof(bat_buf));
+}
+
+/* Index of decoded entry n in a ring buffer filled by buffers_fill(), and its timestamp. */
+static size_t decoded_index(size_t n, size_t count)
+{
+	return (n + count - count / 2) % count;
+}
+
+static int64_t decoded_ts(size_t n)
+{
+	return TEST_TS_MS + n * SAMPLE_INTERVAL_MS;
+}
+
+static void test_encode_delta_round_trip(void)
+{
+	int ret;
+	static struct cloud_data_gps gps[GPS_COUNT];
+	static struct cloud_data_sensors sensor[SENSOR_COUNT];
+	static struct cloud_data_modem_dynamic modem_dyn[MODEM_DYN_COUNT];
+	static struct cloud_data_ui ui[UI_COUNT];
+	static struct cloud_data_accelerometer accel[ACCEL_COUNT];
+	static struct cloud_data_battery bat[BAT_COUNT];
+	struct delta_batch batch = {
+		.modem_dyn = modem_dyn,
+		.gps = gps,
+		.sensor = sensor,
+		.ui = ui,
+		.bat = bat,
+		.accel = accel,
+		.modem_dyn_count = MODEM_DYN_COUNT,
+		.gps_count = GPS_COUNT,
+		.sensor_count = SENSOR_COUNT,
+		.ui_count = UI_COUNT,
+		.bat_count = BAT_COUNT,
+		.accel_count = ACCEL_COUNT,
+	};
+
+	buffers_fill();
+
+	/* The newest dynamic modem entry only has a fresh RSRP value, the other values are
+	 * carried over from the previous entry by the decoder.
+	 */
+	modem_dyn_buf[0].area_code_fresh = false;
+	modem_dyn_buf[0].cell_id_fresh = false;
+	modem_dyn_buf[0].ip_address_fresh = false;
+	modem_dyn_buf[0].mccmnc_fresh = false;
+
+	buffers_copy();
+
+	ret = batch_delta_encode();
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+
+	ret = delta_batch_decode((uint8_t *)output.buf, output.len, &batch);
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+
+	zassert_equal(batch.gps_count, GPS_COUNT, "Wrong number of GPS entries");
+	zassert_equal(batch.sensor_count, SENSOR_COUNT, "Wrong number of sensor entries");
+	zassert_equal(batch.modem_dyn_count, MODEM_DYN_COUNT, "Wrong number of modem entries");
+	zassert_equal(batch.ui_count, UI_COUNT, "Wrong number of UI entries");
+	zassert_equal(batch.accel_count, ACCEL_COUNT, "Wrong number of accelerometer entries");
+	zassert_equal(batch.bat_count, BAT_COUNT, "Wrong number of battery entries");
+
+	for (size_t n = 0; n < GPS_COUNT; n++) {
+		struct cloud_data_gps *data = &gps_copy[decoded_index(n, GPS_COUNT)];
+
+		zassert_equal(gps[n].gps_ts, decoded_ts(n), "Wrong timestamp");
+		/* Coordinates are rounded to 1e-7 degrees. */
+		zassert_within(gps[n].longi, data->longi, 0.6e-7, "Wrong longitude");
+		zassert_within(gps[n].lat, data->lat, 0.6e-7, "Wrong latitude");
+		zassert_equal(gps[n].acc, data->acc, "Wrong accuracy");
+		zassert_equal(gps[n].alt, data->alt, "Wrong altitude");
+		zassert_equal(gps[n].spd, data->spd, "Wrong speed");
+		zassert_equal(gps[n].hdg, data->hdg, "Wrong heading");
+	}
+
+	for (size_t n = 0; n < SENSOR_COUNT; n++) {
+		struct cloud_data_sensors *data = &sensor_copy[decoded_index(n, SENSOR_COUNT)];
+
+		zassert_equal(sensor[n].env_ts, decoded_ts(n), "Wrong timestamp");
+		zassert_equal(sensor[n].temp, data->temp, "Wrong temperature");
+		zassert_equal(sensor[n].hum, data->hum, "Wrong humidity");
+	}
+
+	for (size_t n = 0; n < MODEM_DYN_COUNT; n++) {
+		size_t i = decoded_index(n, MODEM_DYN_COUNT);
+		/* Values that are not fresh are the ones of the previous entry. */
+		struct cloud_data_modem_dynamic *data = &modem_dyn_copy[i];
+		struct cloud_data_modem_dynamic *previous = (i == 0) ?
+			&modem_dyn_copy[MODEM_DYN_COUNT - 1] : data;
+
+		zassert_equal(modem_dyn[n].ts, decoded_ts(n), "Wrong timestamp");
+		zassert_equal(modem_dyn[n].rsrp, data->rsrp, "Wrong RSRP");
+		zassert_equal(modem_dyn[n].area, previous->area, "Wrong area code");
+		zassert_equal(modem_dyn[n].cell, previous->cell, "Wrong cell ID");
+		zassert_equal(strcmp(modem_dyn[n].mccmnc, previous->mccmnc), 0, "Wrong MCCMNC");
+		zassert_equal(strcmp(modem_dyn[n].ip, previous->ip), 0, "Wrong IP address");
+	}
+
+	for (size_t n = 0; n < UI_COUNT; n++) {
+		struct cloud_data_ui *data = &ui_copy[decoded_index(n, UI_COUNT)];
+
+		zassert_equal(ui[n].btn_ts, decoded_ts(n), "Wrong timestamp");
+		zassert_equal(ui[n].btn, data->btn, "Wrong button");
+	}
+
+	for (size_t n = 0; n < ACCEL_COUNT; n++) {
+		struct cloud_data_accelerometer *data = &accel_copy[decoded_index(n, ACCEL_COUNT)];
+
+		zassert_equal(accel[n].ts, decoded_ts(n), "Wrong timestamp");
+		zassert_mem_equal(accel[n].values, data->values, sizeof(data->values),
+				  "Wrong accelerometer values");
+	}
+
+	for (size_t n = 0; n < BAT_COUNT; n++) {
+		struct cloud_data_battery *data = &bat_copy[decoded_index(n, BAT_COUNT)];
+
+		zassert_equal(bat[n].bat_ts, decoded_ts(n), "Wrong timestamp");
+		zassert_equal(bat[n].bat, data->bat, "Wrong battery voltage");
+	}
+}
+
+static void test_encode_delta_invalid(void)
+{
+	int ret;
+
+	ret = batch_delta_encode();
+	zassert_equal(-ENODATA, ret, "Return value %d is wrong", ret);
+
+	bat_buf[0] = (struct cloud_data_battery) {
+		.bat = 3600,
+		.bat_ts = 1000,
+		.queued = true
+	};
+	modem_dyn_buf[0] = (struct cloud_data_modem_dynamic) {
+		.mccmnc = "242O2",
+		.ts = 1000,
+		.queued = true,
+		.mccmnc_fresh = true
+	};
+
+	/* Nothing is encoded or unqueued. */
+	ret = batch_delta_encode();
+	zassert_equal(-ENOTEMPTY, ret, "Return value %d is wrong", ret);
+	zassert_true(bat_buf[0].queued, "Entry unqueued");
+	zassert_equal(bat_buf[0].bat_ts, 1000, "Timestamp converted");
+	zassert_true(modem_dyn_buf[0].queued, "Entry unqueued");
+}
+
+/* Encodes the batch like the JSON cloud codec does. */
+static int json_batch_write(struct json_writer *writer, void *user_data)
+{
+	int err;
+	struct {
+		enum json_common_buffer_type type;
+		void *buf;
+		size_t count;
+		const char *label;
+	} buffers[] = {
+		{ JSON_COMMON_MODEM_DYNAMIC, modem_dyn_buf, MODEM_DYN_COUNT, DATA_MODEM_DYNAMIC },
+		{ JSON_COMMON_GPS, gps_buf, GPS_COUNT, DATA_GPS },
+		{ JSON_COMMON_SENSOR, sensor_buf, SENSOR_COUNT, DATA_ENVIRONMENTALS },
+		{ JSON_COMMON_UI, ui_buf, UI_COUNT, DATA_BUTTON },
+		{ JSON_COMMON_BATTERY, bat_buf, BAT_COUNT, DATA_BATTERY },
+		{ JSON_COMMON_ACCELEROMETER, accel_buf, ACCEL_COUNT, DATA_MOVEMENT },
+	};
+
+	json_writer_object_start(writer, NULL);
+
+	for (size_t i = 0; i < ARRAY_SIZE(buffers); i++) {
+		err = json_common_batch_data_add(writer, buffers[i].type, buffers[i].buf,
+						 buffers[i].count, buffers[i].label);
+		if (err) {
+			return err;
+		}
+	}
+
+	return json_writer_object_end(writer);
+}
+
+static int json_batch_encode(void)
+{
+	return json_common_encode(&output, json_batch_write, NULL);
+}
+
+/* Average time and output size of the encoding of full buffers. */
+static void batch_encode_cost(int (*encode)(void), uint32_t *cycles, size_t *len)
+{
+	int ret;
+	uint32_t start;
+
+	*cycles = 0;
+
+	for (size_t i = 0; i < BENCHMARK_ROUNDS; i++) {
+		buffers_fill();
+
+		start = k_cycle_get_32();
+		ret = encode();
+		*cycles += k_cycle_get_32() - start;
+
+		zassert_equal(0, ret, "Return value %d is wrong", ret);
+
+		*len = output.len;
+		cloud_codec_release_data(&output);
+		output.buf = NULL;
+	}
+
+	*cycles /= BENCHMARK_ROUNDS;
+}
+
+static void test_encode_batch_cost(void)
+{
+	size_t cbor_len;
+	size_t delta_len;
+	size_t json_len;
+	uint32_t cbor_cycles;
+	uint32_t delta_cycles;
+	uint32_t json_cycles;
+
+	batch_encode_cost(batch_encode, &cbor_cycles, &cbor_len);
+	batch_encode_cost(batch_delta_encode, &delta_cycles, &delta_len);
+	batch_encode_cost(json_batch_encode, &json_cycles, &json_len);
+
+	/* Timing varies between platforms, so it is printed but not checked */
+	printk("Batch of %d entries:\n",
+	       GPS_COUNT + SENSOR_COUNT + MODEM_DYN_COUNT + UI_COUNT + ACCEL_COUNT + BAT_COUNT);
+	printk("  CBOR: %d bytes, %u cycles\n", (int)cbor_len, cbor_cycles);
+	printk("  CBOR delta: %d bytes, %u cycles\n", (int)delta_len, delta_cycles);
+	printk("  JSON: %d bytes, %u cycles\n", (int)json_len, json_cycles);
+
+	zassert_true(cbor_len < json_len, "CBOR output larger than JSON");
+	zassert_true(delta_len < cbor_len, "Delta encoded output larger than CBOR");
+}
+
+static void test_setup(void)
+{
+	memset(gps_buf, 0, sizeof(gps_buf));
+	memset(sensor_buf, 0, sizeof(sensor_buf));
+	memset(modem_dyn_buf, 0, sizeof(modem_dyn_buf));
+	memset(ui_buf, 0, sizeof(ui_buf));
+	memset(accel_buf, 0, sizeof(accel_buf));
+	memset(bat_buf, 0, sizeof(bat_buf));
+	memset(&output, 0, sizeof(output));
+}
+
+static void test_teardown(void)
+{
+	cloud_codec_release_data(&output);
+}
+
+void test_main(void)
+{
+	cJSON_Init();
+
+	ztest_test_suite(cbor_common,
+		ztest_unit_test_setup_teardown(test_encode_ui_data,
+					       test_setup,
+					       test_teardown),
+		ztest_unit_test_setup_teardown(test_encode_numbers,
+					       test_setup,
+					       test_teardown),
+		ztest_unit_test_setup_teardown(test_encode_modem_dynamic_data,
+					       test_setup,
+					       test_teardown),
+		ztest_unit_test_setup_teardown(test_encode_batch_invalid,
+					       test_setup,
+					       test_teardown),
+		ztest_unit_test_setup_teardown(test_encode_delta_gps_data,
+					       test_setup,
+					       test_teardown),
+		ztest_unit_test_setup_teardown(test_encode_delta_round_trip,
+					       test_setup,
+					       test_teardown),
+		ztest_unit_test_setup_teardown(test_encode_delta_invalid,
+					       test_setup,
+					       test_teardown),
+		ztest_unit_test_setup_teardown(test_encode_batch_cost,
+					       test_setup,
+					       test_teardown)
+	);
+
+	ztest_run_test_suite(cbor_common);
+}
@@ -10,6 +10,7 @@
 #include <string.h>
 #include <cJSON.h>
 #include <cJSON_os.h>
+#include <json_writer.h>
 
 #include "json_helpers.h"
 #include "json_common.h"
@@ -17,21 +18,34 @@
 #include "json_protocol_names.h"
 #include "json_validate.h"
 
-/* Structure used to generate cJSON objects and encoded output string buffers. */
+/* Writer and output buffer used in the tests. The setup functions start the root object or
+ * array of the document.
+ */
 static struct test_dummy {
-	cJSON *root_obj;
-	cJSON *array_obj;
-	char *buffer;
+	struct json_writer writer;
+	char buffer[2048];
+	bool array;
 } dummy;
 
+/* Function used to end the root object or array and finish the document. */
+static int output_finish(void)
+{
+	if (dummy.array) {
+		json_writer_array_end(&dummy.writer);
+	} else {
+		json_writer_object_end(&dummy.writer);
+	}
+
+	return json_writer_finish(&dummy.writer);
+}
+
 /* Function used to check the return value from the encoding functions in JSON common API and the
  * encoded output.
  */
-static int encoded_output_check(cJSON *object, char *validation_string, int8_t queued)
+static int encoded_output_check(char *validation_string, int8_t queued)
 {
-	dummy.buffer = cJSON_PrintUnformatted(object);
-	if (dummy.buffer == NULL) {
-		/* Buffer should not be NULL. */
+	if (output_finish() < 0) {
+		/* Document should be finished. */
 		return -1;
 	}
 
@@ -50,6 +64,30 @@ static int encoded_output_check(cJSON *object, char *validation_string, int8_t q
 	return 0;
 }
 
+/* Setup functions. Used to start the root object or array of the document written in a test. */
+
+static void test_setup_object(void)
+{
+	int ret;
+
+	json_writer_init(&dummy.writer, dummy.buffer, sizeof(dummy.buffer), NULL, NULL);
+	dummy.array = false;
+
+	ret = json_writer_object_start(&dummy.writer, NULL);
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+}
+
+static void test_setup_array(void)
+{
+	int ret;
+
+	json_writer_init(&dummy.writer, dummy.buffer, sizeof(dummy.buffer), NULL, NULL);
+	dummy.array = true;
+
+	ret = json_writer_array_start(&dummy.writer, NULL);
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+}
+
 /* Battery */
 
 static void test_encode_battery_data_object(void)
@@ -61,40 +99,34 @@ static void test_encode_battery_data_object(void)
 		.queued = true
 	};
 
-	ret = json_common_battery_data_add(dummy.root_obj,
+	ret = json_common_battery_data_add(&dummy.writer,
 					   &data,
-					   JSON_COMMON_ADD_DATA_TO_OBJECT,
-					   DATA_BATTERY,
-					   NULL);
+					   DATA_BATTERY);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 
-	ret = encoded_output_check(dummy.root_obj, TEST_VALIDATE_BATTERY_JSON_SCHEMA, data.queued);
+	ret = encoded_output_check(TEST_VALIDATE_BATTERY_JSON_SCHEMA, data.queued);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 
-	/* Check for invalid inputs. */
+	/* Check for invalid inputs, in a new document. */
+
+	test_setup_object();
 
 	data.queued = false;
 
-	ret = json_common_battery_data_add(dummy.root_obj,
+	ret = json_common_battery_data_add(&dummy.writer,
 					   &data,
-					   JSON_COMMON_ADD_DATA_TO_OBJECT,
-					   "",
-					   NULL);
+					   "");
 	zassert_equal(-ENODATA, ret, "Return value %d is wrong.", ret);
 
 	data.queued = true;
 
 	ret = json_common_battery_data_add(NULL,
 					   &data,
-					   JSON_COMMON_ADD_DATA_TO_OBJECT,
-					   "",
-					   NULL);
+					   "");
 	zassert_equal(-EINVAL, ret, "Return value %d is wrong.", ret);
 
-	ret = json_common_battery_data_add(dummy.root_obj,
+	ret = json_common_battery_data_add(&dummy.writer,
 					   &data,
-					   JSON_COMMON_ADD_DATA_TO_OBJECT,
-					   NULL,
 					   NULL);
 	zassert_equal(-EINVAL, ret, "Return value %d is wrong.", ret);
 }
@@ -108,15 +140,12 @@ static void test_encode_battery_data_array(void)
 		.queued = true
 	};
 
-	ret = json_common_battery_data_add(dummy.array_obj,
+	ret = json_common_battery_data_add(&dummy.writer,
 					   &data,
-					   JSON_COMMON_ADD_DATA_TO_ARRAY,
-					   NULL,
 					   NULL);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 
-	ret = encoded_output_check(dummy.array_obj, TEST_VALIDATE_ARRAY_BATTERY_JSON_SCHEMA,
-				   data.queued);
+	ret = encoded_output_check(TEST_VALIDATE_ARRAY_BATTERY_JSON_SCHEMA, data.queued);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 }
 
@@ -139,40 +168,34 @@ static void test_encode_gps_data_object(void)
 		.queued = true
 	};
 
-	ret = json_common_gps_data_add(dummy.root_obj,
+	ret = json_common_gps_data_add(&dummy.writer,
 				       &data,
-				       JSON_COMMON_ADD_DATA_TO_OBJECT,
-				       DATA_GPS,
-				       NULL);
+				       DATA_GPS);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 
-	ret = encoded_output_check(dummy.root_obj, TEST_VALIDATE_GPS_JSON_SCHEMA, data.queued);
+	ret = encoded_output_check(TEST_VALIDATE_GPS_JSON_SCHEMA, data.queued);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 
-	/* Check for invalid inputs. */
+	/* Check for invalid inputs, in a new document. */
+
+	test_setup_object();
 
 	data.queued = false;
 
-	ret = json_common_gps_data_add(dummy.root_obj,
+	ret = json_common_gps_data_add(&dummy.writer,
 				       &data,
-				       JSON_COMMON_ADD_DATA_TO_OBJECT,
-				       "",
-				       NULL);
+				       "");
 	zassert_equal(-ENODATA, ret, "Return value %d is wrong.", ret);
 
 	data.queued = true;
 
 	ret = json_common_gps_data_add(NULL,
 				       &data,
-				       JSON_COMMON_ADD_DATA_TO_OBJECT,
-				       "",
-				       NULL);
+				       "");
 	zassert_equal(-EINVAL, ret, "Return value %d is wrong.", ret);
 
-	ret = json_common_gps_data_add(dummy.root_obj,
+	ret = json_common_gps_data_add(&dummy.writer,
 				       &data,
-				       JSON_COMMON_ADD_DATA_TO_OBJECT,
-				       NULL,
 				       NULL);
 	zassert_equal(-EINVAL, ret, "Return value %d is wrong.", ret);
 }
@@ -194,15 +217,12 @@ static void test_encode_gps_data_array(void)
 		.queued = true
 	};
 
-	ret = json_common_gps_data_add(dummy.array_obj,
+	ret = json_common_gps_data_add(&dummy.writer,
 				       &data,
-				       JSON_COMMON_ADD_DATA_TO_ARRAY,
-				       NULL,
 				       NULL);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 
-	ret = encoded_output_check(dummy.array_obj, TEST_VALIDATE_ARRAY_GPS_JSON_SCHEMA,
-				   data.queued);
+	ret = encoded_output_check(TEST_VALIDATE_ARRAY_GPS_JSON_SCHEMA, data.queued);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 }
 
@@ -221,41 +241,34 @@ static void test_encode_environmental_data_object(void)
 		.queued = true
 	};
 
-	ret = json_common_sensor_data_add(dummy.root_obj,
+	ret = json_common_sensor_data_add(&dummy.writer,
 					&data,
-					JSON_COMMON_ADD_DATA_TO_OBJECT,
-					DATA_ENVIRONMENTALS,
-					NULL);
+					DATA_ENVIRONMENTALS);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 
-	ret = encoded_output_check(dummy.root_obj, TEST_VALIDATE_ENVIRONMENTAL_JSON_SCHEMA,
-				   data.queued);
+	ret = encoded_output_check(TEST_VALIDATE_ENVIRONMENTAL_JSON_SCHEMA, data.queued);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 
-	/* Check for invalid inputs. */
+	/* Check for invalid inputs, in a new document. */
+
+	test_setup_object();
 
 	data.queued = false;
 
-	ret = json_common_sensor_data_add(dummy.root_obj,
+	ret = json_common_sensor_data_add(&dummy.writer,
 					  &data,
-					  JSON_COMMON_ADD_DATA_TO_OBJECT,
-					  "",
-					  NULL);
+					  "");
 	zassert_equal(-ENODATA, ret, "Return value %d is wrong.", ret);
 
 	data.queued = true;
 
 	ret = json_common_sensor_data_add(NULL,
 					  &data,
-					  JSON_COMMON_ADD_DATA_TO_OBJECT,
-					  "",
-					  NULL);
+					  "");
 	zassert_equal(-EINVAL, ret, "Return value %d is wrong.", ret);
 
-	ret = json_common_sensor_data_add(dummy.root_obj,
+	ret = json_common_sensor_data_add(&dummy.writer,
 					  &data,
-					  JSON_COMMON_ADD_DATA_TO_OBJECT,
-					  NULL,
 					  NULL);
 	zassert_equal(-EINVAL, ret, "Return value %d is wrong.", ret);
 }
@@ -273,15 +286,12 @@ static void test_encode_environmental_data_array(void)
 		.queued = true
 	};
 
-	ret = json_common_sensor_data_add(dummy.array_obj,
+	ret = json_common_sensor_data_add(&dummy.writer,
 					  &data,
-					  JSON_COMMON_ADD_DATA_TO_ARRAY,
-					  NULL,
 					  NULL);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 
-	ret = encoded_output_check(dummy.array_obj, TEST_VALIDATE_ARRAY_ENVIRONMENTAL_JSON_SCHEMA,
-				   data.queued);
+	ret = encoded_output_check(TEST_VALIDATE_ARRAY_ENVIRONMENTAL_JSON_SCHEMA, data.queued);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 }
 
@@ -305,41 +315,34 @@ static void test_encode_modem_dynamic_data_object(void)
 		.mccmnc_fresh = true
 	};
 
-	ret = json_common_modem_dynamic_data_add(dummy.root_obj,
+	ret = json_common_modem_dynamic_data_add(&dummy.writer,
 						 &data,
-						 JSON_COMMON_ADD_DATA_TO_OBJECT,
-						 DATA_MODEM_DYNAMIC,
-						 NULL);
+						 DATA_MODEM_DYNAMIC);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 
-	ret = encoded_output_check(dummy.root_obj, TEST_VALIDATE_MODEM_DYNAMIC_JSON_SCHEMA,
-				   data.queued);
+	ret = encoded_output_check(TEST_VALIDATE_MODEM_DYNAMIC_JSON_SCHEMA, data.queued);
 	zassert_equal(0, ret, "Return value %d is wrong, ret");
 
-	/* Check for invalid inputs. */
+	/* Check for invalid inputs, in a new document. */
+
+	test_setup_object();
 
 	data.queued = false;
 
-	ret = json_common_modem_dynamic_data_add(dummy.root_obj,
+	ret = json_common_modem_dynamic_data_add(&dummy.writer,
 						 &data,
-						 JSON_COMMON_ADD_DATA_TO_OBJECT,
-						 "",
-						 NULL);
+						 "");
 	zassert_equal(-ENODATA, ret, "Return value %d is wrong.", ret);
 
 	data.queued = true;
 
 	ret = json_common_modem_dynamic_data_add(NULL,
 						 &data,
-						 JSON_COMMON_ADD_DATA_TO_OBJECT,
-						 "",
-						 NULL);
+						 "");
 	zassert_equal(-EINVAL, ret, "Return value %d is wrong.", ret);
 
-	ret = json_common_modem_dynamic_data_add(dummy.root_obj,
+	ret = json_common_modem_dynamic_data_add(&dummy.writer,
 						 &data,
-						 JSON_COMMON_ADD_DATA_TO_OBJECT,
-						 NULL,
 						 NULL);
 	zassert_equal(-EINVAL, ret, "Return value %d is wrong.", ret);
 }
@@ -362,15 +365,12 @@ static void test_encode_modem_dynamic_data_array(void)
 		.mccmnc_fresh = true
 	};
 
-	ret = json_common_modem_dynamic_data_add(dummy.array_obj,
+	ret = json_common_modem_dynamic_data_add(&dummy.writer,
 						 &data,
-						 JSON_COMMON_ADD_DATA_TO_ARRAY,
-						 NULL,
 						 NULL);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 
-	ret = encoded_output_check(dummy.array_obj, TEST_VALIDATE_ARRAY_MODEM_DYNAMIC_JSON_SCHEMA,
-				   data.queued);
+	ret = encoded_output_check(TEST_VALIDATE_ARRAY_MODEM_DYNAMIC_JSON_SCHEMA, data.queued);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 }
 
@@ -391,41 +391,34 @@ static void test_encode_modem_static_data_object(void)
 		.queued = true
 	};
 
-	ret = json_common_modem_static_data_add(dummy.root_obj,
+	ret = json_common_modem_static_data_add(&dummy.writer,
 						&data,
-						JSON_COMMON_ADD_DATA_TO_OBJECT,
-						DATA_MODEM_STATIC,
-						NULL);
+						DATA_MODEM_STATIC);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 
-	ret = encoded_output_check(dummy.root_obj, TEST_VALIDATE_MODEM_STATIC_JSON_SCHEMA,
-				   data.queued);
+	ret = encoded_output_check(TEST_VALIDATE_MODEM_STATIC_JSON_SCHEMA, data.queued);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 
-	/* Check for invalid inputs. */
+	/* Check for invalid inputs, in a new document. */
+
+	test_setup_object();
 
 	data.queued = false;
 
-	ret = json_common_modem_static_data_add(dummy.root_obj,
+	ret = json_common_modem_static_data_add(&dummy.writer,
 						&data,
-						JSON_COMMON_ADD_DATA_TO_OBJECT,
-						"",
-						NULL);
+						"");
 	zassert_equal(-ENODATA, ret, "Return value %d is wrong.", ret);
 
 	data.queued = true;
 
 	ret = json_common_modem_static_data_add(NULL,
 						&data,
-						JSON_COMMON_ADD_DATA_TO_OBJECT,
-						"",
-						NULL);
+						"");
 	zassert_equal(-EINVAL, ret, "Return value %d is wrong.", ret);
 
-	ret = json_common_modem_static_data_add(dummy.root_obj,
+	ret = json_common_modem_static_data_add(&dummy.writer,
 						&data,
-						JSON_COMMON_ADD_DATA_TO_OBJECT,
-						NULL,
 						NULL);
 	zassert_equal(-EINVAL, ret, "Return value %d is wrong.", ret);
 }
@@ -445,15 +438,12 @@ static void test_encode_modem_static_data_array(void)
 		.queued = true
 	};
 
-	ret = json_common_modem_static_data_add(dummy.array_obj,
+	ret = json_common_modem_static_data_add(&dummy.writer,
 						&data,
-						JSON_COMMON_ADD_DATA_TO_ARRAY,
-						NULL,
 						NULL);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 
-	ret = encoded_output_check(dummy.array_obj, TEST_VALIDATE_ARRAY_MODEM_STATIC_JSON_SCHEMA,
-				   data.queued);
+	ret = encoded_output_check(TEST_VALIDATE_ARRAY_MODEM_STATIC_JSON_SCHEMA, data.queued);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 }
 
@@ -468,40 +458,34 @@ static void test_encode_ui_data_object(void)
 		.queued = true
 	};
 
-	ret = json_common_ui_data_add(dummy.root_obj,
+	ret = json_common_ui_data_add(&dummy.writer,
 				      &data,
-				      JSON_COMMON_ADD_DATA_TO_OBJECT,
-				      DATA_BUTTON,
-				      NULL);
+				      DATA_BUTTON);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 
-	ret = encoded_output_check(dummy.root_obj, TEST_VALIDATE_UI_JSON_SCHEMA, data.queued);
+	ret = encoded_output_check(TEST_VALIDATE_UI_JSON_SCHEMA, data.queued);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 
-	/* Check for invalid inputs. */
+	/* Check for invalid inputs, in a new document. */
+
+	test_setup_object();
 
 	data.queued = false;
 
-	ret = json_common_ui_data_add(dummy.root_obj,
+	ret = json_common_ui_data_add(&dummy.writer,
 				      &data,
-				      JSON_COMMON_ADD_DATA_TO_OBJECT,
-				      "",
-				      NULL);
+				      "");
 	zassert_equal(-ENODATA, ret, "Return value %d is wrong.", ret);
 
 	data.queued = true;
 
 	ret = json_common_ui_data_add(NULL,
 				      &data,
-				      JSON_COMMON_ADD_DATA_TO_OBJECT,
-				      "",
-				      NULL);
+				      "");
 	zassert_equal(-EINVAL, ret, "Return value %d is wrong.", ret);
 
-	ret = json_common_ui_data_add(dummy.root_obj,
+	ret = json_common_ui_data_add(&dummy.writer,
 				      &data,
-				      JSON_COMMON_ADD_DATA_TO_OBJECT,
-				      NULL,
 				      NULL);
 	zassert_equal(-EINVAL, ret, "Return value %d is wrong.", ret);
 }
@@ -515,15 +499,12 @@ static void test_encode_ui_data_array(void)
 		.queued = true
 	};
 
-	ret = json_common_ui_data_add(dummy.array_obj,
+	ret = json_common_ui_data_add(&dummy.writer,
 				      &data,
-				      JSON_COMMON_ADD_DATA_TO_ARRAY,
-				      NULL,
 				      NULL);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 
-	ret = encoded_output_check(dummy.array_obj, TEST_VALIDATE_ARRAY_UI_JSON_SCHEMA,
-				   data.queued);
+	ret = encoded_output_check(TEST_VALIDATE_ARRAY_UI_JSON_SCHEMA, data.queued);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 }
 
@@ -540,41 +521,34 @@ static void test_encode_accelerometer_data_object(void)
 		.queued = true
 	};
 
-	ret = json_common_accel_data_add(dummy.root_obj,
+	ret = json_common_accel_data_add(&dummy.writer,
 					 &data,
-					 JSON_COMMON_ADD_DATA_TO_OBJECT,
-					 DATA_MOVEMENT,
-					 NULL);
+					 DATA_MOVEMENT);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 
-	ret = encoded_output_check(dummy.root_obj, TEST_VALIDATE_ACCELEROMETER_JSON_SCHEMA,
-				   data.queued);
+	ret = encoded_output_check(TEST_VALIDATE_ACCELEROMETER_JSON_SCHEMA, data.queued);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 
-	/* Check for invalid inputs. */
+	/* Check for invalid inputs, in a new document. */
+
+	test_setup_object();
 
 	data.queued = false;
 
-	ret = json_common_accel_data_add(dummy.root_obj,
+	ret = json_common_accel_data_add(&dummy.writer,
 					 &data,
-					 JSON_COMMON_ADD_DATA_TO_OBJECT,
-					 "",
-					 NULL);
+					 "");
 	zassert_equal(-ENODATA, ret, "Return value %d is wrong.", ret);
 
 	data.queued = true;
 
 	ret = json_common_accel_data_add(NULL,
 					 &data,
-					 JSON_COMMON_ADD_DATA_TO_OBJECT,
-					 "",
-					 NULL);
+					 "");
 	zassert_equal(-EINVAL, ret, "Return value %d is wrong.", ret);
 
-	ret = json_common_accel_data_add(dummy.root_obj,
+	ret = json_common_accel_data_add(&dummy.writer,
 					 &data,
-					 JSON_COMMON_ADD_DATA_TO_OBJECT,
-					 NULL,
 					 NULL);
 	zassert_equal(-EINVAL, ret, "Return value %d is wrong.", ret);
 }
@@ -590,15 +564,12 @@ static void test_encode_accelerometer_data_array(void)
 		.queued = true
 	};
 
-	ret = json_common_accel_data_add(dummy.array_obj,
+	ret = json_common_accel_data_add(&dummy.writer,
 					 &data,
-					 JSON_COMMON_ADD_DATA_TO_ARRAY,
-					 NULL,
 					 NULL);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 
-	ret = encoded_output_check(dummy.array_obj, TEST_VALIDATE_ARRAY_ACCELEROMETER_JSON_SCHEMA,
-				   data.queued);
+	ret = encoded_output_check(TEST_VALIDATE_ARRAY_ACCELEROMETER_JSON_SCHEMA, data.queued);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 }
 
@@ -622,15 +593,15 @@ static void test_encode_configuration_data_object(void)
 		.accelerometer_threshold_fresh = true,
 	};
 
-	ret = json_common_config_add(dummy.root_obj, &data, DATA_CONFIG);
+	ret = json_common_config_add(&dummy.writer, &data, DATA_CONFIG);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 
-	ret = encoded_output_check(dummy.root_obj, TEST_VALIDATE_CONFIGURATION_JSON_SCHEMA, -1);
+	ret = encoded_output_check(TEST_VALIDATE_CONFIGURATION_JSON_SCHEMA, -1);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 
 	/* Check for invalid input. */
 
-	ret = json_common_config_add(dummy.root_obj, &data, NULL);
+	ret = json_common_config_add(&dummy.writer, &data, NULL);
 	zassert_equal(-EINVAL, ret, "Return value %d is wrong.", ret);
 }
 
@@ -775,64 +746,64 @@ static void test_encode_batch_data_object(void)
 		[1].queued = true
 	};
 
-	ret = json_common_batch_data_add(dummy.root_obj,
+	ret = json_common_batch_data_add(&dummy.writer,
 					 JSON_COMMON_BATTERY,
 					 &battery,
 					 ARRAY_SIZE(battery),
 					 DATA_BATTERY);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 
-	ret = json_common_batch_data_add(dummy.root_obj,
+	ret = json_common_batch_data_add(&dummy.writer,
 					 JSON_COMMON_UI,
 					 &ui,
 					 ARRAY_SIZE(ui),
 					 DATA_BUTTON);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 
-	ret = json_common_batch_data_add(dummy.root_obj,
+	ret = json_common_batch_data_add(&dummy.writer,
 					 JSON_COMMON_GPS,
 					 &gps,
 					 ARRAY_SIZE(gps),
 					 DATA_GPS);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 
-	ret = json_common_batch_data_add(dummy.root_obj,
+	ret = json_common_batch_data_add(&dummy.writer,
 					 JSON_COMMON_SENSOR,
 					 &environmental,
 					 ARRAY_SIZE(environmental),
 					 DATA_ENVIRONMENTALS);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 
-	ret = json_common_batch_data_add(dummy.root_obj,
+	ret = json_common_batch_data_add(&dummy.writer,
 					 JSON_COMMON_ACCELEROMETER,
 					 &accelerometer,
 					 ARRAY_SIZE(accelerometer),
 					 DATA_MOVEMENT);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 
-	ret = json_common_batch_data_add(dummy.root_obj,
+	ret = json_common_batch_data_add(&dummy.writer,
 					 JSON_COMMON_MODEM_DYNAMIC,
 					 &modem_dynamic,
 					 ARRAY_SIZE(modem_dynamic),
 					 DATA_MODEM_DYNAMIC);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 
-	ret = json_common_batch_data_add(dummy.root_obj,
+	ret = json_common_batch_data_add(&dummy.writer,
 					 JSON_COMMON_MODEM_STATIC,
 					 &modem_static,
 					 ARRAY_SIZE(modem_static),
 					 DATA_MODEM_STATIC);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 
-	ret = encoded_output_check(dummy.root_obj, TEST_VALIDATE_BATCH_JSON_SCHEMA, -1);
+	ret = encoded_output_check(TEST_VALIDATE_BATCH_JSON_SCHEMA, -1);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 
 	/* Check for invalid inputs. */
 
 	ret = json_common_batch_data_add(NULL, -1, NULL, 0, "");
-	zassert_equal(-ENOMEM, ret, "Return value %d is wrong.", ret);
+	zassert_equal(-EINVAL, ret, "Return value %d is wrong.", ret);
 
-	ret = json_common_batch_data_add(dummy.root_obj, -1, NULL, 0, NULL);
+	ret = json_common_batch_data_add(&dummy.writer, -1, NULL, 0, NULL);
 	zassert_equal(-EINVAL, ret, "Return value %d is wrong.", ret);
 }
 
@@ -859,16 +830,14 @@ static void test_floating_point_encoding_gps(void)
 		.queued = true
 	};
 
-	ret = json_common_gps_data_add(dummy.root_obj,
+	ret = json_common_gps_data_add(&dummy.writer,
 				       &data,
-				       JSON_COMMON_ADD_DATA_TO_OBJECT,
-				       DATA_GPS,
-				       NULL);
+				       DATA_GPS);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 	zassert_false(data.queued, "Queued flag was not set to false by function %s", __func__);
 
-	dummy.buffer = cJSON_PrintUnformatted(dummy.root_obj);
-	zassert_not_null(dummy.buffer, "Printed JSON string is NULL");
+	ret = output_finish();
+	zassert_true(ret > 0, "Return value %d is wrong", ret);
 
 	decoded_root_obj = cJSON_Parse(dummy.buffer);
 	zassert_not_null(decoded_root_obj, "Root object is NULL");
@@ -925,16 +894,14 @@ static void test_floating_point_encoding_accelerometer(void)
 		.queued = true
 	};
 
-	ret = json_common_accel_data_add(dummy.root_obj,
+	ret = json_common_accel_data_add(&dummy.writer,
 					 &data,
-					 JSON_COMMON_ADD_DATA_TO_OBJECT,
-					 DATA_MOVEMENT,
-					 NULL);
+					 DATA_MOVEMENT);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 	zassert_false(data.queued, "Queued flag was not set to false by function %s", __func__);
 
-	dummy.buffer = cJSON_PrintUnformatted(dummy.root_obj);
-	zassert_not_null(dummy.buffer, "Printed JSON string is NULL");
+	ret = output_finish();
+	zassert_true(ret > 0, "Return value %d is wrong", ret);
 
 	decoded_root_obj = cJSON_Parse(dummy.buffer);
 	zassert_not_null(decoded_root_obj, "Root object is NULL");
@@ -981,16 +948,14 @@ static void test_floating_point_encoding_environmental(void)
 		.queued = true
 	};
 
-	ret = json_common_sensor_data_add(dummy.root_obj,
+	ret = json_common_sensor_data_add(&dummy.writer,
 					  &data,
-					  JSON_COMMON_ADD_DATA_TO_OBJECT,
-					  DATA_ENVIRONMENTALS,
-					  NULL);
+					  DATA_ENVIRONMENTALS);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
 	zassert_false(data.queued, "Queued flag was not set to false by function %s", __func__);
 
-	dummy.buffer = cJSON_PrintUnformatted(dummy.root_obj);
-	zassert_not_null(dummy.buffer, "Printed JSON string is NULL");
+	ret = output_finish();
+	zassert_true(ret > 0, "Return value %d is wrong", ret);
 
 	decoded_root_obj = cJSON_Parse(dummy.buffer);
 	zassert_not_null(decoded_root_obj, "Root object is NULL");
@@ -1027,11 +992,11 @@ static void test_floating_point_encoding_configuration(void)
 		.accelerometer_threshold_fresh = true
 	};
 
-	ret = json_common_config_add(dummy.root_obj, &data, DATA_CONFIG);
+	ret = json_common_config_add(&dummy.writer, &data, DATA_CONFIG);
 	zassert_equal(0, ret, "Return value %d is wrong", ret);
-	dummy.buffer = cJSON_PrintUnformatted(dummy.root_obj);
 
-	zassert_not_null(dummy.buffer, "Printed JSON string is NULL");
+	ret = output_finish();
+	zassert_true(ret > 0, "Return value %d is wrong", ret);
 
 	decoded_root_obj = cJSON_Parse(dummy.buffer);
 	zassert_not_null(decoded_root_obj, "Root object is NULL");
@@ -1051,32 +1016,259 @@ static void test_floating_point_encoding_configuration(void)
 	cJSON_Delete(decoded_root_obj);
 }
 
-/* Setup and teardown functions. Used to allocate root and array objects used in test and to
- * cleanup allocated memory afterwards.
+/* The JSON writer must give the same output as cJSON, which the encoding functions used before.
+ * The output is checked against cJSON by parsing it and printing it again with cJSON.
  */
 
-static void test_setup_object(void)
+static struct cloud_data_gps gps_buf[2];
+static struct cloud_data_sensors sensor_buf[2];
+static struct cloud_data_modem_dynamic modem_dyn_buf[2];
+static struct cloud_data_ui ui_buf[2];
+static struct cloud_data_accelerometer accel_buf[2];
+static struct cloud_data_battery bat_buf[2];
+
+static void buffers_fill(void)
 {
-	dummy.root_obj = cJSON_CreateObject();
-	zassert_not_null(dummy.root_obj, "Root object is NULL");
+	for (size_t i = 0; i < 2; i++) {
+		gps_buf[i] = (struct cloud_data_gps) {
+			.longi = 10.417852141870654,
+			.lat = -63.43278762669529,
+			.acc = 15.455987930297852,
+			.alt = 53.67230987548828,
+			.spd = 0.4443884789943695,
+			.hdg = 176.12345298374867,
+			.gps_ts = 1000,
+			.queued = true
+		};
+		sensor_buf[i] = (struct cloud_data_sensors) {
+			.temp = 26.27,
+			.hum = 1e-7,
+			.env_ts = 1000,
+			.queued = true
+		};
+		modem_dyn_buf[i] = (struct cloud_data_modem_dynamic) {
+			.rsrp = 20,
+			.area = 12,
+			.mccmnc = "24202",
+			.cell = 33703719,
+			.ip = "10.81.183.99",
+			.ts = 1000,
+			.queued = true,
+			.area_code_fresh = true,
+			.cell_id_fresh = true,
+			.rsrp_fresh = true,
+			.ip_address_fresh = true,
+			.mccmnc_fresh = true
+		};
+		ui_buf[i] = (struct cloud_data_ui) {
+			.btn = 1,
+			.btn_ts = 1000,
+			.queued = true
+		};
+		accel_buf[i] = (struct cloud_data_accelerometer) {
+			.values = { 1.49061, 0.617818, -9.924329 },
+			.ts = 1000,
+			.queued = true
+		};
+		bat_buf[i] = (struct cloud_data_battery) {
+			.bat = 3600,
+			.bat_ts = 1000,
+			.queued = true
+		};
+	}
 }
 
-static void test_teardown_object(void)
+/* Adds the batch to an open object, like the JSON cloud codec does. */
+static int batch_add(struct json_writer *writer)
 {
-	cJSON_FreeString(dummy.buffer);
-	cJSON_Delete(dummy.root_obj);
+	int err;
+	struct {
+		enum json_common_buffer_type type;
+		void *buf;
+		const char *label;
+	} buffers[] = {
+		{ JSON_COMMON_MODEM_DYNAMIC, modem_dyn_buf, DATA_MODEM_DYNAMIC },
+		{ JSON_COMMON_GPS, gps_buf, DATA_GPS },
+		{ JSON_COMMON_SENSOR, sensor_buf, DATA_ENVIRONMENTALS },
+		{ JSON_COMMON_UI, ui_buf, DATA_BUTTON },
+		{ JSON_COMMON_BATTERY, bat_buf, DATA_BATTERY },
+		{ JSON_COMMON_ACCELEROMETER, accel_buf, DATA_MOVEMENT },
+	};
+
+	for (size_t i = 0; i < ARRAY_SIZE(buffers); i++) {
+		err = json_common_batch_data_add(writer, buffers[i].type, buffers[i].buf, 2,
+						 buffers[i].label);
+		if (err) {
+			return err;
+		}
+	}
+
+	return 0;
 }
 
-static void test_setup_array(void)
+static int batch_write(struct json_writer *writer, void *user_data)
 {
-	dummy.array_obj = cJSON_CreateArray();
-	zassert_not_null(dummy.root_obj, "Root object is NULL");
+	int err;
+
+	json_writer_object_start(writer, NULL);
+
+	err = batch_add(writer);
+	if (err) {
+		return err;
+	}
+
+	return json_writer_object_end(writer);
+}
+
+static void test_encode_output_equal_to_cjson(void)
+{
+	int ret;
+	cJSON *decoded_root_obj;
+	char *printed;
+	struct cloud_data_modem_static data = {
+		.bnd = 20,
+		.nw_lte_m = 1,
+		.iccid = "89450421180216216095",
+		.fw = "mfw_nrf9160_1.2.3",
+		/* Characters that are escaped in JSON strings. */
+		.brdv = "\"nrf9160dk\"\\\b\f\n\r\t\x01\x1f",
+		.appv = "v1.0.0-\xc3\xa6\xc3\xb8\xc3\xa5",
+		.ts = 1000,
+		.queued = true
+	};
+
+	buffers_fill();
+
+	ret = batch_add(&dummy.writer);
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+
+	ret = json_common_modem_static_data_add(&dummy.writer, &data, DATA_MODEM_STATIC);
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+
+	ret = output_finish();
+	zassert_true(ret > 0, "Return value %d is wrong", ret);
+
+	decoded_root_obj = cJSON_Parse(dummy.buffer);
+	zassert_not_null(decoded_root_obj, "Root object is NULL");
+
+	printed = cJSON_PrintUnformatted(decoded_root_obj);
+	cJSON_Delete(decoded_root_obj);
+	zassert_not_null(printed, "Printed JSON string is NULL");
+
+	ret = strcmp(printed, dummy.buffer);
+	cJSON_FreeString(printed);
+	zassert_equal(0, ret, "Output differs from cJSON");
+}
+
+/* Peak heap usage. The allocations are wrapped to track the size of the allocated memory. */
+
+#define ALLOCATIONS_MAX 512
+
+static struct {
+	void *ptr;
+	size_t size;
+} allocations[ALLOCATIONS_MAX];
+static size_t heap_used;
+static size_t heap_peak;
+
+void *__real_k_malloc(size_t size);
+void *__real_k_calloc(size_t nmemb, size_t size);
+void __real_k_free(void *ptr);
+
+static void allocation_add(void *ptr, size_t size)
+{
+	if (ptr == NULL) {
+		return;
+	}
+
+	for (size_t i = 0; i < ALLOCATIONS_MAX; i++) {
+		if (allocations[i].ptr == NULL) {
+			allocations[i].ptr = ptr;
+			allocations[i].size = size;
+			heap_used += size;
+			heap_peak = MAX(heap_peak, heap_used);
+			return;
+		}
+	}
+}
+
+void *__wrap_k_malloc(size_t size)
+{
+	void *ptr = __real_k_malloc(size);
+
+	allocation_add(ptr, size);
+
+	return ptr;
+}
+
+void *__wrap_k_calloc(size_t nmemb, size_t size)
+{
+	void *ptr = __real_k_calloc(nmemb, size);
+
+	allocation_add(ptr, nmemb * size);
+
+	return ptr;
 }
 
-static void test_teardown_array(void)
+void __wrap_k_free(void *ptr)
 {
-	cJSON_FreeString(dummy.buffer);
-	cJSON_Delete(dummy.array_obj);
+	for (size_t i = 0; (ptr != NULL) && (i < ALLOCATIONS_MAX); i++) {
+		if (allocations[i].ptr == ptr) {
+			heap_used -= allocations[i].size;
+			allocations[i].ptr = NULL;
+			break;
+		}
+	}
+
+	__real_k_free(ptr);
+}
+
+static void test_encode_peak_heap_usage(void)
+{
+	int ret;
+	size_t heap_base;
+	size_t writer_peak;
+	size_t cjson_peak;
+	char *printed;
+	cJSON *root_obj;
+	struct cloud_codec_data output = {0};
+
+	buffers_fill();
+
+	/* Encoding with the JSON writer allocates the output only. */
+	heap_base = heap_used;
+	heap_peak = heap_base;
+
+	ret = json_common_encode(&output, batch_write, NULL);
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+	zassert_equal(output.len, strlen(output.buf), "Output length is wrong");
+
+	writer_peak = heap_peak - heap_base;
+
+	/* Encoding with cJSON allocates a tree of the same values before printing it. */
+	heap_base = heap_used;
+	heap_peak = heap_base;
+
+	root_obj = cJSON_Parse(output.buf);
+	zassert_not_null(root_obj, "Root object is NULL");
+
+	printed = cJSON_PrintUnformatted(root_obj);
+	zassert_not_null(printed, "Printed JSON string is NULL");
+
+	cjson_peak = heap_peak - heap_base;
+
+	printk("Peak heap usage when encoding a batch of 12 entries:\n");
+	printk("  JSON writer: %d bytes\n", (int)writer_peak);
+	printk("  cJSON: %d bytes\n", (int)cjson_peak);
+
+	ret = strcmp(printed, output.buf);
+
+	cJSON_FreeString(printed);
+	cJSON_Delete(root_obj);
+	cloud_codec_release_data(&output);
+
+	zassert_equal(0, ret, "Output differs from cJSON");
+	zassert_true(writer_peak < cjson_peak, "JSON writer uses more heap than cJSON");
 }
 
 void test_main(void)
@@ -1088,63 +1280,63 @@ void test_main(void)
 		/* Battery */
 		ztest_unit_test_setup_teardown(test_encode_battery_data_object,
 					       test_setup_object,
-					       test_teardown_object),
+					       unit_test_noop),
 		ztest_unit_test_setup_teardown(test_encode_battery_data_array,
 					       test_setup_array,
-					       test_teardown_array),
+					       unit_test_noop),
 
 		/* GPS */
 		ztest_unit_test_setup_teardown(test_encode_gps_data_object,
 					       test_setup_object,
-					       test_teardown_object),
+					       unit_test_noop),
 		ztest_unit_test_setup_teardown(test_encode_gps_data_array,
 					       test_setup_array,
-					       test_teardown_array),
+					       unit_test_noop),
 
 		/* Environmental */
 		ztest_unit_test_setup_teardown(test_encode_environmental_data_object,
 					       test_setup_object,
-					       test_teardown_object),
+					       unit_test_noop),
 		ztest_unit_test_setup_teardown(test_encode_environmental_data_array,
 					       test_setup_array,
-					       test_teardown_array),
+					       unit_test_noop),
 
 		/* Modem dynamic */
 		ztest_unit_test_setup_teardown(test_encode_modem_dynamic_data_object,
 					       test_setup_object,
-					       test_teardown_object),
+					       unit_test_noop),
 		ztest_unit_test_setup_teardown(test_encode_modem_dynamic_data_array,
 					       test_setup_array,
-					       test_teardown_array),
+					       unit_test_noop),
 
 		/* Modem static */
 		ztest_unit_test_setup_teardown(test_encode_modem_static_data_object,
 					       test_setup_object,
-					       test_teardown_object),
+					       unit_test_noop),
 		ztest_unit_test_setup_teardown(test_encode_modem_static_data_array,
 					       test_setup_array,
-					       test_teardown_array),
+					       unit_test_noop),
 
 		/* UI */
 		ztest_unit_test_setup_teardown(test_encode_ui_data_object,
 					       test_setup_object,
-					       test_teardown_object),
+					       unit_test_noop),
 		ztest_unit_test_setup_teardown(test_encode_ui_data_array,
 					       test_setup_array,
-					       test_teardown_array),
+					       unit_test_noop),
 
 		/* Accelerometer */
 		ztest_unit_test_setup_teardown(test_encode_accelerometer_data_object,
 					       test_setup_object,
-					       test_teardown_object),
+					       unit_test_noop),
 		ztest_unit_test_setup_teardown(test_encode_accelerometer_data_array,
 					       test_setup_array,
-					       test_teardown_array),
+					       unit_test_noop),
 
 		/* Configuration encode */
 		ztest_unit_test_setup_teardown(test_encode_configuration_data_object,
 					       test_setup_object,
-					       test_teardown_object),
+					       unit_test_noop),
 
 		/* Configuration decode */
 		ztest_unit_test(test_decode_configuration_data),
@@ -1152,27 +1344,35 @@ void test_main(void)
 		/* Batch */
 		ztest_unit_test_setup_teardown(test_encode_batch_data_object,
 					       test_setup_object,
-					       test_teardown_object),
+					       unit_test_noop),
 
 		/* GPS floating point values comparison */
 		ztest_unit_test_setup_teardown(test_floating_point_encoding_gps,
 					       test_setup_object,
-					       test_teardown_object),
+					       unit_test_noop),
 
 		/* Accelerometer floating point values comparison */
 		ztest_unit_test_setup_teardown(test_floating_point_encoding_accelerometer,
 					       test_setup_object,
-					       test_teardown_object),
+					       unit_test_noop),
 
 		/* Accelerometer floating point values comparison */
 		ztest_unit_test_setup_teardown(test_floating_point_encoding_environmental,
 					       test_setup_object,
-					       test_teardown_object),
+					       unit_test_noop),
 
 		/* Configuration floating point values comparison */
 		ztest_unit_test_setup_teardown(test_floating_point_encoding_configuration,
 					       test_setup_object,
-					       test_teardown_object)
+					       unit_test_noop),
+
+		/* Output compared with cJSON */
+		ztest_unit_test_setup_teardown(test_encode_output_equal_to_cjson,
+					       test_setup_object,
+					       unit_test_noop),
+
+		/* Peak heap usage compared with cJSON */
+		ztest_unit_test(test_encode_peak_heap_usage)
 	);
 
 	ztest_run_test_suite(json_common);
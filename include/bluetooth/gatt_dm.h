@@ -43,6 +43,30 @@ struct bt_gatt_dm_attr {
 	uint8_t		perm;
 };
 
+/** @brief Discovery Manager memory usage statistics
+ *
+ * The statistics of a Discovery Manager instance, kept across the
+ * discoveries that use this instance.
+ */
+struct bt_gatt_dm_stats {
+	/** Number of attributes stored */
+	uint16_t attr_cnt;
+	/** Maximum number of attributes stored at the same time */
+	uint16_t attr_max;
+	/** Number of bytes of attribute data stored, with alignment */
+	uint16_t data_len;
+	/** Maximum number of bytes of attribute data stored at the same time */
+	uint16_t data_max;
+	/** Number of memory chunks used */
+	uint8_t chunk_cnt;
+	/** Maximum number of memory chunks used at the same time */
+	uint8_t chunk_max;
+	/** Number of attributes that could not be stored because the attribute
+	 *  array or the memory pool was full
+	 */
+	uint16_t nomem_cnt;
+};
+
 /** @brief Discovery callback structure.
  *
  *  This structure is used for tracking the result of a discovery.
@@ -143,6 +167,14 @@ struct bt_conn *bt_gatt_dm_conn_get(struct bt_gatt_dm *dm);
  */
 size_t bt_gatt_dm_attr_cnt(const struct bt_gatt_dm *dm);
 
+/** @brief Get memory usage statistics
+ *
+ * @param[in]  dm Discovery Manager instance.
+ * @param[out] stats Statistics of the instance.
+ */
+void bt_gatt_dm_stats_get(const struct bt_gatt_dm *dm,
+			  struct bt_gatt_dm_stats *stats);
+
 /** @brief Get service value
  *
  * Function returns the value that contains UUID and attribute
@@ -264,9 +296,10 @@ const struct bt_gatt_dm_attr *bt_gatt_dm_desc_next(
  * This function is asynchronous. Discovery results are passed through
  * the supplied callback.
  *
- * @note Only one discovery procedure can be started simultaneously. To start
- * another one, wait for the result of the previous procedure to finish
- * and call @ref bt_gatt_dm_data_release if it was successful.
+ * @note Up to @option{CONFIG_BT_GATT_DM_MAX_INSTANCES} discovery procedures
+ * can be started simultaneously, for example with different connections.
+ * Each procedure uses an instance until its result is received and
+ * @ref bt_gatt_dm_data_release is called if it was successful.
  *
  * @param[in]     conn Connection object.
  * @param[in]     svc_uuid UUID of target service
@@ -279,8 +312,17 @@ const struct bt_gatt_dm_attr *bt_gatt_dm_desc_next(
  * If @p svc_uuid is set to NULL, all services may be discovered.
  * To process the next service, call @ref bt_gatt_dm_continue.
  *
+ * @note
+ * If @option{CONFIG_BT_GATT_DM_CACHE} is enabled, @p svc_uuid is set,
+ * and the peer is bonded, the Database Hash of the peer is read first.
+ * If it did not change since the service was discovered, the service is
+ * loaded from the cache instead of being discovered. The cache is read and
+ * written from the system work queue, which then calls the callbacks.
+ *
  * @retval 0 If the operation was successful.
- *           Otherwise, a (negative) error code is returned.
+ * @retval -EALREADY If all the instances are in use.
+ * @retval -ENOMEM If the memory pool is full.
+ *         Otherwise, a (negative) error code is returned.
  */
 int bt_gatt_dm_start(struct bt_conn *conn,
 		     const struct bt_uuid *svc_uuid,
@@ -313,6 +355,19 @@ int bt_gatt_dm_continue(struct bt_gatt_dm *dm, void *context);
  */
 int bt_gatt_dm_data_release(struct bt_gatt_dm *dm);
 
+/** @brief Remove the cached services of a peer.
+ *
+ * Call this function when the bond with the peer is removed.
+ *
+ * @note Requires @option{CONFIG_BT_GATT_DM_CACHE}.
+ *
+ * @param[in] addr Address of the peer.
+ *
+ * @retval 0 If the operation was successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int bt_gatt_dm_cache_clear(const bt_addr_le_t *addr);
+
 /** @brief Print service discovery data.
  *
  * This function prints GATT attributes that belong to the discovered service.
@@ -278,6 +278,23 @@ struct bt_scan_filter_match {
 	struct bt_scan_manufacturer_data_filter_status manufacturer_data;
 };
 
+/**@brief RSSI of the advertising reports of a device that were
+ *        deduplicated since the previous event of this device.
+ */
+struct bt_scan_rssi_stats {
+	/** Number of deduplicated reports, saturated at UINT16_MAX. */
+	uint16_t count;
+
+	/** Minimum RSSI. */
+	int8_t min;
+
+	/** Maximum RSSI. */
+	int8_t max;
+
+	/** Average RSSI. */
+	int8_t avg;
+};
+
 /**@brief Structure containing device data needed to establish
  *        connection and advertising information.
  */
@@ -294,6 +311,13 @@ struct bt_scan_device_info {
 	 *  advertising data type.
 	 */
 	struct net_buf_simple *adv_data;
+
+	/** RSSI of the reports of the device that were deduplicated
+	 *  since its previous event. NULL if
+	 *  @option{CONFIG_BT_SCAN_DEDUP_RSSI} is disabled or if no report
+	 *  was deduplicated.
+	 */
+	const struct bt_scan_rssi_stats *rssi_stats;
 };
 
 /** @brief Initializing macro for scanning module.
@@ -543,6 +567,42 @@ int bt_scan_blocklist_device_add(const bt_addr_le_t *addr);
  */
 void bt_scan_blocklist_clear(void);
 
+/**@brief Advertising report deduplication statistics.
+ */
+struct bt_scan_dedup_stats {
+	/** Number of reports that repeated a recent report and did not
+	 *  generate any event.
+	 */
+	uint32_t hits;
+
+	/** Number of reports that generated an event, because they were
+	 *  new or their time to live expired.
+	 */
+	uint32_t misses;
+
+	/** Number of reports removed from the cache to make room for new
+	 *  ones.
+	 */
+	uint32_t evictions;
+};
+
+/**@brief Get the advertising report deduplication statistics.
+ *
+ * @details The statistics are counted from the initialization of the
+ *          module or from the last call to @ref bt_scan_dedup_clear.
+ *
+ * @param[out] stats Deduplication statistics.
+ */
+void bt_scan_dedup_stats_get(struct bt_scan_dedup_stats *stats);
+
+/**@brief Clear the advertising report deduplication.
+ *
+ * @details Use this function to remove all reports from the
+ *          deduplication cache, so that the next report of each device
+ *          generates an event, and to reset the statistics.
+ */
+void bt_scan_dedup_clear(void);
+
 #ifdef __cplusplus
 }
 #endif
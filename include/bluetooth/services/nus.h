@@ -15,6 +15,7 @@
  */
 
 #include <zephyr/types.h>
+#include <kernel.h>
 #include <bluetooth/conn.h>
 #include <bluetooth/uuid.h>
 #include <bluetooth/gatt.h>
@@ -47,6 +48,30 @@ enum bt_nus_send_status {
 	BT_NUS_SEND_STATUS_DISABLED,
 };
 
+/** @brief NUS stream statistics. */
+struct bt_nus_stream_stats {
+	/** Number of bytes sent in notifications. */
+	uint32_t tx_bytes;
+
+	/** Number of notifications sent. */
+	uint32_t tx_notif;
+
+	/** Number of notifications that the Bluetooth stack could not
+	 *  take, and that are sent again later.
+	 */
+	uint32_t tx_retries;
+
+	/** Number of times the data could not be written at once because
+	 *  the stream buffer was full.
+	 */
+	uint32_t buf_full;
+
+	/** Time in milliseconds from the first notification until the last
+	 *  notification that was sent.
+	 */
+	uint32_t tx_time;
+};
+
 /** @brief Pointers to the callback functions for service events. */
 struct bt_nus_cb {
 	/** @brief Data received callback.
@@ -113,6 +138,54 @@ int bt_nus_init(struct bt_nus_cb *callbacks);
  */
 int bt_nus_send(struct bt_conn *conn, const uint8_t *data, uint16_t len);
 
+/**@brief Stream data to a connected peer.
+ *
+ * @details This function copies the data to the stream buffer of the
+ *          connection. The buffered data is sent in notifications of the
+ *          maximum length that the ATT MTU allows, with up to
+ *          CONFIG_BT_NUS_STREAM_TX_MAX notifications in flight. When the
+ *          buffer is full, the function waits until the data that is
+ *          sent frees enough space.
+ *
+ *          The notifications of all the connections use the
+ *          CONFIG_BT_CONN_TX_MAX buffers of the Bluetooth stack. When no
+ *          buffer is left, the data is sent later.
+ *
+ *          The data that is not sent yet is dropped when the peer
+ *          disconnects or disables the notifications. The @ref
+ *          bt_nus_cb.sent callback is not called for the streamed data.
+ *
+ *          Must not be called from the Bluetooth RX thread or from the
+ *          system workqueue with a timeout other than K_NO_WAIT.
+ *
+ * @param[in] conn    Pointer to connection object.
+ * @param[in] data    Pointer to a data buffer.
+ * @param[in] len     Length of the data in the buffer.
+ * @param[in] timeout Time to wait for free space in the stream buffer,
+ *                    for the whole write.
+ *
+ * @return Number of bytes written to the stream buffer, which is less
+ *         than @p len if the timeout expired or the peer disconnected.
+ *         Otherwise, a negative error code is returned.
+ * @retval -EINVAL If the peer did not enable the notifications.
+ * @retval -EACCES If the service is not initialized.
+ */
+int bt_nus_stream_write(struct bt_conn *conn, const uint8_t *data,
+			size_t len, k_timeout_t timeout);
+
+/**@brief Get the statistics of the stream of a connection.
+ *
+ * The statistics are cleared when the peer disconnects.
+ *
+ * @param[in]  conn  Pointer to connection object.
+ * @param[out] stats Stream statistics.
+ *
+ * @retval 0 If the statistics are read.
+ *           Otherwise, a negative value is returned.
+ */
+int bt_nus_stream_stats_get(struct bt_conn *conn,
+			    struct bt_nus_stream_stats *stats);
+
 /**@brief Get maximum data length that can be used for @ref bt_nus_send.
  *
  * @param[in] conn Pointer to connection Object.
@@ -54,6 +54,47 @@ extern "C" {
 #define SUBS_PRIO_COUNT (SUBS_PRIO_MAX - SUBS_PRIO_MIN + 1)
 
 
+/** @brief Event processing lanes.
+ *
+ * Every lane has its own event queue and is processed in its own context.
+ * Events submitted to the same lane are processed in the order of
+ * submission.
+ */
+enum event_lane {
+	/** Latency-critical events processed by a dedicated thread. */
+	EVENT_LANE_HIGH,
+
+	/** Events processed by the system workqueue. */
+	EVENT_LANE_NORMAL,
+
+	/** Low-priority events processed by a dedicated thread. */
+	EVENT_LANE_BACKGROUND,
+
+	/** Number of event processing lanes. */
+	EVENT_LANE_COUNT
+};
+
+
+/** @brief Event processing lane statistics.
+ */
+struct event_lane_stats {
+	/** Number of events waiting in the lane queue. */
+	atomic_t queue_depth;
+
+	/** Maximum number of events waiting in the lane queue. */
+	atomic_val_t queue_depth_max;
+
+	/** Number of dispatched events. */
+	uint32_t dispatch_cnt;
+
+	/** Sum of dispatch latencies (submit to dispatch) in cycles. */
+	uint64_t latency_total;
+
+	/** Maximum dispatch latency in cycles. */
+	uint32_t latency_max;
+};
+
+
 /** @brief Event header.
  *
  * When defining an event structure, the event header
@@ -65,6 +106,11 @@ struct event_header {
 
 	/** Pointer to the event type object. */
 	const struct event_type *type_id;
+
+#ifdef CONFIG_EVENT_MANAGER_EVENT_TIMESTAMP
+	/** Event submission time in cycles. */
+	uint32_t timestamp;
+#endif
 };
 
 
@@ -96,11 +142,34 @@ struct event_listener {
 };
 
 
+/** @brief Event subscriber statistics.
+ */
+struct event_subscriber_stats {
+	/** Number of notifications. */
+	uint32_t call_cnt;
+
+	/** Total execution time of the event handler in cycles. */
+	uint64_t exec_time_total;
+
+	/** Maximum execution time of the event handler in cycles. */
+	uint32_t exec_time_max;
+};
+
+
 /** @brief Event subscriber.
  */
 struct event_subscriber {
 	/** Pointer to the listener. */
 	const struct event_listener *listener;
+
+	/** Pointer to the function that is called when an event of the
+	 *  subscribed type is handled or NULL if the notification function
+	 *  of the listener is used. */
+	bool (*notification)(const struct event_header *eh);
+
+	/** Statistics of the subscriber or NULL if
+	 *  CONFIG_EVENT_MANAGER_STATS is disabled. */
+	struct event_subscriber_stats *stats;
 };
 
 
@@ -122,6 +191,48 @@ struct event_info {
 };
 
 
+/** @brief Event memory pool.
+ *
+ * Fixed-size memory pool used to allocate events of a given type instead
+ * of the heap. Event memory pools must be defined using
+ * @ref EVENT_POOL_DEFINE.
+ */
+struct event_pool {
+	/** Memory slab holding the event blocks. */
+	struct k_mem_slab *slab;
+
+	/** Maximum number of blocks used at the same time. */
+	atomic_t max_used;
+
+	/** Number of events allocated from the heap because the pool
+	 *  was exhausted. */
+	atomic_t heap_fallback_cnt;
+};
+
+
+/** @brief Event type statistics.
+ */
+struct event_type_stats {
+	/** Number of submitted events. */
+	uint32_t submit_cnt;
+
+	/** Number of dispatched events. */
+	uint32_t dispatch_cnt;
+
+	/** Number of events waiting in the queue. */
+	atomic_t queued;
+
+	/** Maximum number of events waiting in the queue. */
+	atomic_val_t queued_max;
+
+	/** Total time spent by the events in the queue in cycles. */
+	uint64_t queue_time_total;
+
+	/** Maximum time spent by an event in the queue in cycles. */
+	uint32_t queue_time_max;
+};
+
+
 /** @brief Event type.
  */
 struct event_type {
@@ -138,12 +249,23 @@ struct event_type {
 	/** Bool indicating if the event is logged by default. */
 	bool init_log_enable;
 
+	/** Lane used to process events of this type. */
+	enum event_lane lane;
+
 	/** Function to log data from this event. */
 	int (*log_event)(const struct event_header *eh, char *buf,
 			      size_t buf_len);
 
 	/** Logging and formatting information. */
 	const struct event_info *ev_info;
+
+	/** Memory pool used to allocate events or NULL if events are
+	 *  allocated from the heap. */
+	struct event_pool *pool;
+
+	/** Statistics of the event type or NULL if
+	 *  CONFIG_EVENT_MANAGER_STATS is disabled. */
+	struct event_type_stats *stats;
 };
 
 
@@ -157,7 +279,9 @@ extern const struct event_type __stop_event_types[];
 /** Create an event listener object.
  *
  * @param lname   Module name.
- * @param cb_fn  Pointer to the event handler function.
+ * @param cb_fn  Pointer to the event handler function. Can be NULL if
+ *               the listener subscribes to events only with event type
+ *               specific handlers (see @ref EVENT_SUBSCRIBE_CB).
  */
 #define EVENT_LISTENER(lname, cb_fn) _EVENT_LISTENER(lname, cb_fn)
 
@@ -193,6 +317,48 @@ extern const struct event_type __stop_event_types[];
 	const struct {} _CONCAT(_CONCAT(__event_subscriber_, ename), final_sub_redefined) = {}
 
 
+/** Subscribe a listener to the early notification list for an
+ *  event type with an event handler specific for the event type.
+ *
+ * The handler is called directly by the Event Manager instead of the
+ * notification function of the listener. The handler gets a pointer to
+ * the event of the given type and returns true to consume the event.
+ *
+ * @param lname  Name of the listener.
+ * @param ename  Name of the event.
+ * @param cb_fn  Pointer to the event type specific handler.
+ */
+#define EVENT_SUBSCRIBE_EARLY_CB(lname, ename, cb_fn) \
+	_EVENT_SUBSCRIBE_CB(lname, ename, _SUBS_PRIO_ID(_SUBS_PRIO_FIRST), cb_fn)
+
+
+/** Subscribe a listener to the normal notification list for an event
+ *  type with an event handler specific for the event type.
+ *
+ * See @ref EVENT_SUBSCRIBE_EARLY_CB for details.
+ *
+ * @param lname  Name of the listener.
+ * @param ename  Name of the event.
+ * @param cb_fn  Pointer to the event type specific handler.
+ */
+#define EVENT_SUBSCRIBE_CB(lname, ename, cb_fn) \
+	_EVENT_SUBSCRIBE_CB(lname, ename, _SUBS_PRIO_ID(_SUBS_PRIO_NORMAL), cb_fn)
+
+
+/** Subscribe a listener to an event type as final module that is
+ *  being notified with an event handler specific for the event type.
+ *
+ * See @ref EVENT_SUBSCRIBE_EARLY_CB for details.
+ *
+ * @param lname  Name of the listener.
+ * @param ename  Name of the event.
+ * @param cb_fn  Pointer to the event type specific handler.
+ */
+#define EVENT_SUBSCRIBE_FINAL_CB(lname, ename, cb_fn)						\
+	_EVENT_SUBSCRIBE_CB(lname, ename, _SUBS_PRIO_ID(_SUBS_PRIO_FINAL), cb_fn);		\
+	const struct {} _CONCAT(_CONCAT(__event_subscriber_, ename), final_sub_redefined) = {}
+
+
 /** Encode event data types or labels.
  *
  * @param ... Data types or labels to be encoded.
@@ -258,7 +424,48 @@ extern const struct event_type __stop_event_types[];
  * @param ev_info_struct   Data structure describing the event type.
  */
 #define EVENT_TYPE_DEFINE(ename, init_log_en, log_fn, ev_info_struct) \
-	_EVENT_TYPE_DEFINE(ename, init_log_en, log_fn, ev_info_struct)
+	_EVENT_TYPE_DEFINE(ename, EVENT_LANE_NORMAL, init_log_en, log_fn, ev_info_struct)
+
+
+/** Define an event type processed in a given lane.
+ *
+ * This macro works as @ref EVENT_TYPE_DEFINE, but events of the defined
+ * type are processed in the given lane instead of @ref EVENT_LANE_NORMAL.
+ * Listeners of events processed in different lanes can be called from
+ * different threads.
+ *
+ * @note If CONFIG_EVENT_MANAGER_LANES is disabled, all events are
+ *       processed in @ref EVENT_LANE_NORMAL.
+ *
+ * @param ename            Name of the event.
+ * @param lane             Event processing lane (@ref event_lane).
+ * @param init_log_en      Bool indicating if the event is logged
+ *                         by default.
+ * @param log_fn           Function to stringify an event of this type.
+ * @param ev_info_struct   Data structure describing the event type.
+ */
+#define EVENT_TYPE_LANE_DEFINE(ename, lane, init_log_en, log_fn, ev_info_struct) \
+	_EVENT_TYPE_DEFINE(ename, lane, init_log_en, log_fn, ev_info_struct)
+
+
+/** Define a memory pool for an event type.
+ *
+ * This macro defines a fixed-size memory pool that is used by
+ * new_<i>%event_type</i> to allocate events of the given type instead of
+ * the heap. The size of a pool block is derived from the event structure.
+ * The macro must be placed in the same source file as
+ * @ref EVENT_TYPE_DEFINE.
+ *
+ * If the pool is exhausted, or an event with dynamic data does not fit in
+ * a pool block, the event is allocated from the heap.
+ *
+ * @note Requires CONFIG_EVENT_MANAGER_EVENT_POOLS to be enabled.
+ *
+ * @param ename  Name of the event.
+ * @param count  Number of events that can be allocated from the pool
+ *               at the same time.
+ */
+#define EVENT_POOL_DEFINE(ename, count) _EVENT_POOL_DEFINE(ename, count)
 
 
 /** Verify if an event ID is valid.
@@ -273,6 +480,94 @@ extern const struct event_type __stop_event_types[];
 	__ASSERT_NO_MSG((id >= __start_event_types) && (id < __stop_event_types))
 
 
+/** Allocate memory for an event.
+ *
+ * @note This function is used by the event allocators and should not be
+ *       called directly.
+ *
+ * @param et    Pointer to the event type.
+ * @param size  Size of the event.
+ *
+ * @return Pointer to the allocated memory or NULL if out of memory.
+ */
+void *_event_manager_alloc(const struct event_type *et, size_t size);
+
+
+/** Get the number of events currently allocated from the event type pool.
+ *
+ * @param et  Pointer to the event type.
+ *
+ * @return Number of used pool blocks or 0 if the event type has no pool.
+ */
+size_t event_manager_pool_used_get(const struct event_type *et);
+
+
+/** Get the maximum number of events allocated from the event type pool
+ *  at the same time.
+ *
+ * @param et  Pointer to the event type.
+ *
+ * @return High-water mark of the pool or 0 if the event type has no pool.
+ */
+size_t event_manager_pool_max_used_get(const struct event_type *et);
+
+
+/** Get statistics of an event processing lane.
+ *
+ * @param lane   Event processing lane.
+ * @param stats  Pointer to the structure to be filled with statistics.
+ *
+ * @retval 0 If the operation was successful.
+ * @retval -EINVAL If the lane or the pointer is invalid.
+ * @retval -ENOTSUP If CONFIG_EVENT_MANAGER_LANES is disabled.
+ */
+int event_manager_lane_stats_get(enum event_lane lane,
+				 struct event_lane_stats *stats);
+
+
+/** Get statistics of an event type.
+ *
+ * @param et     Pointer to the event type.
+ * @param stats  Pointer to the structure to be filled with statistics.
+ *
+ * @retval 0 If the operation was successful.
+ * @retval -EINVAL If a pointer is invalid.
+ * @retval -ENOTSUP If CONFIG_EVENT_MANAGER_STATS is disabled.
+ */
+int event_manager_stats_get(const struct event_type *et,
+			    struct event_type_stats *stats);
+
+
+/** Get statistics of an event subscriber.
+ *
+ * Subscribers of an event type can be accessed through
+ * @ref event_type.subs_start and @ref event_type.subs_stop.
+ *
+ * @param es     Pointer to the event subscriber.
+ * @param stats  Pointer to the structure to be filled with statistics.
+ *
+ * @retval 0 If the operation was successful.
+ * @retval -EINVAL If a pointer is invalid.
+ * @retval -ENOTSUP If CONFIG_EVENT_MANAGER_STATS is disabled.
+ */
+int event_manager_subscriber_stats_get(const struct event_subscriber *es,
+				       struct event_subscriber_stats *stats);
+
+
+/** Reset statistics of all event types and subscribers.
+ */
+void event_manager_stats_reset(void);
+
+
+/** Get name of an event processing lane.
+ *
+ * @param lane  Event processing lane.
+ *
+ * @return Name of the lane.
+ */
+const char *event_manager_lane_name_get(enum event_lane lane);
+
+
 /** Submit an event to the Event Manager.
  *
  * @param eh  Pointer to the event header element in the event object.
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef FLASH_QUEUE_H__
+#define FLASH_QUEUE_H__
+
+#include <zephyr.h>
+#include <zephyr/types.h>
+#include <storage/flash_map.h>
+#include <fs/fcb.h>
+
+#if USE_PARTITION_MANAGER
+#include <pm_config.h>
+#endif
+
+/**
+ * @defgroup flash_queue Flash queue
+ * @{
+ * @brief Library that queues data in flash until it is acknowledged, across
+ *        reboots.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Flash area of the partition reserved for the queue. */
+#if USE_PARTITION_MANAGER
+#define FLASH_QUEUE_AREA_ID PM_FLASH_QUEUE_STORAGE_ID
+#else
+#define FLASH_QUEUE_AREA_ID FLASH_AREA_ID(storage)
+#endif
+
+/** @brief Flash queue.
+ *
+ *  The members are internal to the library.
+ */
+struct flash_queue {
+	struct fcb fcb;
+	struct flash_sector sectors[CONFIG_FLASH_QUEUE_SECTOR_COUNT_MAX];
+	/* Size of the smallest sector, which bounds the size of an entry. */
+	size_t sector_size_min;
+	struct k_mutex lock;
+	/* Location of the last record read, or NULL sector to read from the
+	 * oldest record.
+	 */
+	struct fcb_entry read_loc;
+	/* Sequence number of the next entry. */
+	uint32_t seq_next;
+	/* Sequence number of the last entry read. */
+	uint32_t seq_read;
+	/* Sequence number of the last acknowledged entry. */
+	uint32_t seq_acked;
+	/* Number of entries that are not acknowledged. */
+	size_t count;
+	/* Number of entries dropped to make room since initialization. */
+	uint32_t dropped;
+};
+
+/** @brief Entry of a flash queue. */
+struct flash_queue_entry {
+	/** Sequence number, increasing by one for each entry. */
+	uint32_t seq;
+	/** Type given by the application. */
+	uint8_t type;
+	/** Length of the data. */
+	size_t len;
+};
+
+/** @brief Initialize a flash queue.
+ *
+ *  The entries that are stored in the flash area and that are not
+ *  acknowledged are queued again. If the flash area does not contain a queue,
+ *  it is erased.
+ *
+ *  @param[out] queue Queue.
+ *  @param[in] area_id Flash area, usually FLASH_QUEUE_AREA_ID.
+ *
+ *  @return 0        If the operation was successful.
+ *  @return -ENOMEM  If the flash area has more than
+ *                   CONFIG_FLASH_QUEUE_SECTOR_COUNT_MAX sectors.
+ *  @return -EINVAL  If the flash area has less than two sectors, or if the
+ *                   write block size of the flash is not supported.
+ *  @return Otherwise a negative error code from the flash driver.
+ */
+int flash_queue_init(struct flash_queue *queue, int area_id);
+
+/** @brief Append an entry to a flash queue.
+ *
+ *  If the flash area is full, the oldest sector is erased. The entries of
+ *  this sector that are not acknowledged are dropped.
+ *
+ *  @param[in, out] queue Queue.
+ *  @param[in] type Type of the entry, returned with it.
+ *  @param[in] data Data.
+ *  @param[in] len Length of the data.
+ *
+ *  @return 0        If the operation was successful.
+ *  @return -EFBIG   If the entry does not fit in a flash sector.
+ *  @return Otherwise a negative error code from the flash driver.
+ */
+int flash_queue_push(struct flash_queue *queue, uint8_t type, const void *data,
+		     size_t len);
+
+/** @brief Get the next entry to read from a flash queue, without reading it.
+ *
+ *  @param[in, out] queue Queue.
+ *  @param[out] entry Next entry.
+ *
+ *  @return 0        If the operation was successful.
+ *  @return -ENODATA If all the entries have been read.
+ *  @return Otherwise a negative error code from the flash driver.
+ */
+int flash_queue_peek(struct flash_queue *queue,
+		     struct flash_queue_entry *entry);
+
+/** @brief Read the next entry of a flash queue.
+ *
+ *  The entries are read in the order in which they were appended. An entry
+ *  that has been read stays in flash until it is acknowledged with
+ *  flash_queue_ack().
+ *
+ *  @param[in, out] queue Queue.
+ *  @param[out] entry Entry that was read.
+ *  @param[out] buf Buffer for the data.
+ *  @param[in] size Size of the buffer.
+ *
+ *  @return 0        If the operation was successful.
+ *  @return -ENODATA If all the entries have been read.
+ *  @return -ENOMEM  If the data does not fit in the buffer. The entry is
+ *                   not read.
+ *  @return Otherwise a negative error code from the flash driver.
+ */
+int flash_queue_read(struct flash_queue *queue, struct flash_queue_entry *entry,
+		     void *buf, size_t size);
+
+/** @brief Acknowledge the entries of a flash queue up to an entry.
+ *
+ *  The entry and all the entries before it are removed from the queue. They
+ *  are erased from flash when their sector is needed for new entries.
+ *
+ *  @param[in, out] queue Queue.
+ *  @param[in] seq Sequence number of the last entry to acknowledge.
+ *
+ *  @return 0        If the operation was successful.
+ *  @return -EINVAL  If the entry has not been read.
+ *  @return Otherwise a negative error code from the flash driver.
+ */
+int flash_queue_ack(struct flash_queue *queue, uint32_t seq);
+
+/** @brief Remove all the entries of a flash queue, and erase its flash area.
+ *
+ *  @param[in, out] queue Queue.
+ *
+ *  @return 0 if the operation was successful, otherwise a negative error code
+ *          from the flash driver.
+ */
+int flash_queue_clear(struct flash_queue *queue);
+
+/** @brief Get the number of entries of a flash queue that are not
+ *         acknowledged.
+ *
+ *  @param[in] queue Queue.
+ *
+ *  @return Number of entries.
+ */
+static inline size_t flash_queue_count(const struct flash_queue *queue)
+{
+	return queue->count;
+}
+
+/** @brief Get the number of entries dropped from a flash queue to make room
+ *         for new entries since it was initialized.
+ *
+ *  @param[in] queue Queue.
+ *
+ *  @return Number of entries.
+ */
+static inline uint32_t flash_queue_dropped(const struct flash_queue *queue)
+{
+	return queue->dropped;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+
+#endif /* FLASH_QUEUE_H__ */
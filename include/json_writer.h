@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef JSON_WRITER_H__
+#define JSON_WRITER_H__
+
+#include <zephyr/types.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * @defgroup json_writer JSON writer
+ * @{
+ * @brief Library that writes JSON text directly into a buffer, without building
+ *        an object tree first.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Handler that is called with the output when the buffer of the writer
+ *         is full, and with the rest of the output when the writer is finished.
+ *
+ *  @param[in] buf Output.
+ *  @param[in] len Length of the output.
+ *  @param[in] user_data User data given to json_writer_init().
+ *
+ *  @return 0 to continue writing, or a negative error code that is then
+ *          returned by the writer.
+ */
+typedef int (*json_writer_flush_t)(const char *buf, size_t len,
+				   void *user_data);
+
+/** @brief JSON writer.
+ *
+ *  The members are internal to the library.
+ */
+struct json_writer {
+	char *buf;
+	size_t size;
+	size_t len;
+	size_t total_len;
+	json_writer_flush_t flush;
+	void *user_data;
+	/* First error, returned by all the functions after it. */
+	int err;
+	/* Number of open objects and arrays. */
+	uint8_t depth;
+	/* Bit n is set if the container at depth n is an object. */
+	uint32_t objects;
+	/* Bit n is set if the container at depth n has a value. */
+	uint32_t values;
+};
+
+/** @brief Initialize a JSON writer.
+ *
+ *  The output is written into the buffer. If a flush handler is given, the
+ *  handler is called each time the buffer is full, and the output can be
+ *  larger than the buffer. Otherwise, the output is NUL-terminated and must fit
+ *  in the buffer with the terminator.
+ *
+ *  If the buffer is NULL and no handler is given, nothing is written and the
+ *  writer only counts the length of the output. This can be used to allocate a
+ *  buffer of the right size.
+ *
+ *  @param[out] writer Writer.
+ *  @param[in] buf Output buffer.
+ *  @param[in] size Size of the output buffer.
+ *  @param[in] flush Flush handler, or NULL.
+ *  @param[in] user_data User data given to the flush handler.
+ */
+void json_writer_init(struct json_writer *writer, char *buf, size_t size,
+		      json_writer_flush_t flush, void *user_data);
+
+/** @brief Start an object.
+ *
+ *  All the functions writing a value take the name of the value as key. The key
+ *  must be given inside an object, and must be NULL inside an array and for the
+ *  top-level value.
+ *
+ *  @param[in, out] writer Writer.
+ *  @param[in] key Name of the object inside an object, otherwise NULL.
+ *
+ *  @return 0        If the operation was successful.
+ *  @return -EINVAL  If the key is given or missing when it should not be, or
+ *                   if there already is a top-level value.
+ *  @return -E2BIG   If CONFIG_JSON_WRITER_DEPTH_MAX containers are already open.
+ *  @return -ENOMEM  If the output does not fit in the buffer.
+ *  @return Otherwise the error returned by the flush handler, or the previous
+ *          error of the writer.
+ */
+int json_writer_object_start(struct json_writer *writer, const char *key);
+
+/** @brief End an object.
+ *
+ *  @param[in, out] writer Writer.
+ *
+ *  @return 0        If the operation was successful.
+ *  @return -EINVAL  If the innermost open container is not an object.
+ *  @return Otherwise, the same errors as json_writer_object_start().
+ */
+int json_writer_object_end(struct json_writer *writer);
+
+/** @brief Start an array.
+ *
+ *  @param[in, out] writer Writer.
+ *  @param[in] key Name of the array inside an object, otherwise NULL.
+ *
+ *  @return The same values as json_writer_object_start().
+ */
+int json_writer_array_start(struct json_writer *writer, const char *key);
+
+/** @brief End an array.
+ *
+ *  @param[in, out] writer Writer.
+ *
+ *  @return 0        If the operation was successful.
+ *  @return -EINVAL  If the innermost open container is not an array.
+ *  @return Otherwise, the same errors as json_writer_object_start().
+ */
+int json_writer_array_end(struct json_writer *writer);
+
+/** @brief Write a string.
+ *
+ *  @param[in, out] writer Writer.
+ *  @param[in] key Name of the string inside an object, otherwise NULL.
+ *  @param[in] value NUL-terminated string, escaped as needed.
+ *
+ *  @return The same values as json_writer_object_start(), except -E2BIG.
+ */
+int json_writer_string(struct json_writer *writer, const char *key,
+		       const char *value);
+
+/** @brief Write a number.
+ *
+ *  The number is written with the same format as cJSON: with 15 significant
+ *  digits if they give back the same value, and 17 otherwise. NaN and infinity
+ *  are written as null.
+ *
+ *  @param[in, out] writer Writer.
+ *  @param[in] key Name of the number inside an object, otherwise NULL.
+ *  @param[in] value Number.
+ *
+ *  @return The same values as json_writer_object_start(), except -E2BIG.
+ */
+int json_writer_number(struct json_writer *writer, const char *key,
+		       double value);
+
+/** @brief Write a boolean.
+ *
+ *  @param[in, out] writer Writer.
+ *  @param[in] key Name of the boolean inside an object, otherwise NULL.
+ *  @param[in] value Boolean.
+ *
+ *  @return The same values as json_writer_object_start(), except -E2BIG.
+ */
+int json_writer_bool(struct json_writer *writer, const char *key, bool value);
+
+/** @brief Write null.
+ *
+ *  @param[in, out] writer Writer.
+ *  @param[in] key Name of the null value inside an object, otherwise NULL.
+ *
+ *  @return The same values as json_writer_object_start(), except -E2BIG.
+ */
+int json_writer_null(struct json_writer *writer, const char *key);
+
+/** @brief Finish writing.
+ *
+ *  Passes the rest of the output to the flush handler if there is one,
+ *  otherwise NUL-terminates the output.
+ *
+ *  @param[in, out] writer Writer.
+ *
+ *  @return The length of the output, without the NUL terminator, if the
+ *          operation was successful.
+ *  @return -EINVAL  If an object or an array is still open.
+ *  @return Otherwise, the first error of the writer.
+ */
+int json_writer_finish(struct json_writer *writer);
+
+/** @brief Get the first error of a writer.
+ *
+ *  The functions writing values do nothing after an error, so the error can be
+ *  checked once after writing several values.
+ *
+ *  @param[in] writer Writer.
+ *
+ *  @return 0 if there has been no error, otherwise the first error.
+ */
+static inline int json_writer_error(const struct json_writer *writer)
+{
+	return writer->err;
+}
+
+/** @brief Check if a writer only counts the length of the output.
+ *
+ *  @param[in] writer Writer.
+ *
+ *  @return true if the writer was initialized without buffer and without
+ *          flush handler.
+ */
+static inline bool json_writer_is_measuring(const struct json_writer *writer)
+{
+	return (writer->buf == NULL) && (writer->flush == NULL);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+
+#endif /* JSON_WRITER_H__ */
@@ -54,6 +54,54 @@ enum at_cmd_state {
  */
 typedef void (*at_cmd_handler_t)(const char *response);
 
+struct at_cmd_req;
+struct k_poll_signal;
+
+/**
+ * @typedef at_cmd_req_handler_t
+ *
+ * Handler called when an AT command submitted with @ref at_cmd_write_async()
+ * has completed.
+ *
+ * @param req      The request, with its result in the @c code and @c state
+ *                 fields. The request can be reused or freed by the handler.
+ * @param response Null terminated string containing the modem response,
+ *                 without the return code, or NULL if no response was
+ *                 received.
+ */
+typedef void (*at_cmd_req_handler_t)(struct at_cmd_req *req,
+				     const char *response);
+
+/**
+ * @brief AT command request
+ *
+ * The request is not copied by @ref at_cmd_write_async(), it is owned by the
+ * AT command driver until it completes. The caller can embed it in a larger
+ * structure to find its own context from the completion handler.
+ */
+struct at_cmd_req {
+	/** Null terminated AT command. */
+	const char *cmd;
+	/** Buffer to put the response in, or NULL. */
+	char *resp;
+	/** Size of the response buffer. */
+	size_t resp_size;
+	/** Handler called on completion, or NULL. See
+	 *  @ref at_cmd_write_async() for the calling context.
+	 */
+	at_cmd_req_handler_t callback;
+	/** Signal raised with the result code on completion, or NULL.
+	 *  Requires CONFIG_POLL.
+	 */
+	struct k_poll_signal *signal;
+	/** Result code, as returned by @ref at_cmd_write(), or -EINPROGRESS
+	 *  until the request completes.
+	 */
+	int code;
+	/** Result state, valid once the request has completed. */
+	enum at_cmd_state state;
+};
+
 /**@brief Initialize or recover the AT command driver.
  *
  * @return Zero on success, non-zero otherwise.
@@ -132,6 +180,37 @@ int at_cmd_write(const char *const cmd,
 		 size_t buf_len,
 		 enum at_cmd_state *state);
 
+/**
+ * @brief Function to queue an AT command without waiting for its response
+ *
+ * The command is written to the modem as soon as the previous commands have
+ * completed. Neither the request nor the command is copied, so several
+ * commands can be queued without allocating memory, and their responses
+ * are put directly in the buffers of the requests. Completion is reported
+ * through the handler or the signal of the request, or both.
+ *
+ * @param req Request describing the command. The request, the command
+ *            and the response buffer must remain valid until the request
+ *            completes.
+ *
+ * @note The handler function runs from at_cmd's thread. When a command
+ *       cannot be written to the modem, the handler of its request runs
+ *       from the thread that was writing it, which can be the thread
+ *       queuing another request. The handler is called without any lock
+ *       of the driver held. It may queue new requests, but must not call
+ *       at_cmd_write from at_cmd's thread, as that would lead to a
+ *       deadlock.
+ *
+ * @retval 0 If the command was queued. The result is reported in the
+ *           @c code and @c state fields of the request on completion.
+ * @retval -EINVAL is returned if the request or its command is invalid.
+ * @retval -ENOBUFS is returned if the queue is full and the function is
+ *         called from at_cmd's thread. Otherwise, the function waits for
+ *         room in the queue, see CONFIG_AT_CMD_QUEUE_LEN.
+ * @retval -EHOSTDOWN is returned if the Modem library is shutdown.
+ */
+int at_cmd_write_async(struct at_cmd_req *req);
+
 /**
  * @brief Function to set AT command global notification handler
  *
@@ -78,6 +78,55 @@ int at_notif_register_handler(void *context, at_notif_handler_t handler);
  */
 int at_notif_deregister_handler(void *context, at_notif_handler_t handler);
 
+/**
+ * @brief Function to register a handler for the notifications with a prefix
+ *
+ * The handler only receives the notifications whose name, the text before
+ * the colon, is @p prefix. For example, a handler registered for "+CEREG"
+ * receives "+CEREG: 1", but not "+CEREGX: 1". Handlers registered with
+ * @ref at_notif_register_handler() still receive all notifications.
+ *
+ * The handlers are kept in a hash table indexed by prefix, so that the cost
+ * of dispatching a notification does not grow with the number of handlers
+ * registered for other notifications.
+ *
+ * @note  If the same combination of prefix, context and handler exists in
+ *        the table, then the request will be ignored and command execution
+ *        will be regarded as finished successfully.
+ *
+ * @param prefix  Name of the notifications, for example "%XMODEMSLEEP".
+ *                The string is not copied and must remain valid until the
+ *                handler is de-registered.
+ * @param context Pointer to context provided by the module which has
+ *                registered the handler.
+ * @param handler Pointer to a received notification handler function of type
+ *                @ref at_notif_handler_t.
+ *
+ * @retval 0            If command execution was successful.
+ * @retval -ENOBUFS     If the table of handlers is full, see
+ *                      CONFIG_AT_NOTIF_PREFIX_HANDLERS_MAX.
+ * @retval -EINVAL      If handler is a NULL pointer, or prefix is empty or
+ *                      contains a colon.
+ */
+int at_notif_register_prefix_handler(const char *prefix, void *context,
+				     at_notif_handler_t handler);
+
+/**
+ * @brief Function to de-register a handler for the notifications with a prefix
+ *
+ * @param prefix  Name of the notifications the handler was registered for.
+ * @param context Pointer to context provided by the module which has
+ *                registered the handler.
+ * @param handler Pointer to a received notification handler function of type
+ *                @ref at_notif_handler_t.
+ *
+ * @retval 0            If command execution was successful.
+ * @retval -EINVAL      If handler is a NULL pointer, or prefix is empty or
+ *                      contains a colon.
+ */
+int at_notif_deregister_prefix_handler(const char *prefix, void *context,
+				       at_notif_handler_t handler);
+
 /** @} */
 
 #ifdef __cplusplus
@@ -22,10 +22,16 @@
  * All parameters values are copied in the list. Parameters should be
  * cleared to free that memory. Getter and setter methods are available
  * to read and write parameter values.
+ *
+ * Alternatively, a list can be created over an array provided by the
+ * caller with @ref at_params_list_view_init. Such a list does not allocate
+ * any memory: string and array parameters refer to the parsed string
+ * instead of being copied, and are decoded by the getter methods.
  */
 #ifndef AT_PARAMS_H__
 #define AT_PARAMS_H__
 
+#include <stdbool.h>
 #include <zephyr/types.h>
 
 #ifdef __cplusplus
@@ -72,6 +78,10 @@ struct at_param {
 struct at_param_list {
 	size_t param_count;
 	struct at_param *params;
+	/** Parameters refer to the parsed string, see
+	 *  @ref at_params_list_view_init.
+	 */
+	bool view;
 };
 
 /**
@@ -90,6 +100,30 @@ struct at_param_list {
  */
 int at_params_list_init(struct at_param_list *list, size_t max_params_count);
 
+/**
+ * @brief Create a list of parameters over an array provided by the caller.
+ *
+ * Unlike @ref at_params_list_init, no memory is allocated, neither for the
+ * list nor for the parameters stored in it. String and array parameters are
+ * not copied; they refer to the string given to the parser, which must
+ * remain valid and unchanged as long as the parameters are used.
+ * Array parameters are decoded each time they are read.
+ *
+ * The getter methods work the same as for a list created with
+ * @ref at_params_list_init. @ref at_params_string_put stores a reference to
+ * the string instead of a copy, and @ref at_params_array_put is not
+ * supported.
+ *
+ * @param[in] list Parameter list to initialize.
+ * @param[in] params Array of parameters, used as the list storage.
+ * @param[in] max_params_count Number of elements in @p params.
+ *
+ * @retval 0 If the operation was successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int at_params_list_view_init(struct at_param_list *list,
+			     struct at_param *params, size_t max_params_count);
+
 /**
  * @brief Clear/reset all parameter types and values.
  *
@@ -103,6 +137,8 @@ void at_params_list_clear(struct at_param_list *list);
  * @brief Free a list of parameters.
  *
  * First the list is cleared. Then the list and its elements are deleted.
+ * For a list created with @ref at_params_list_view_init, the array of
+ * parameters belongs to the caller and is not freed.
  *
  * @param[in] list Parameter list to free.
  */
@@ -276,6 +312,24 @@ int at_params_int64_get(const struct at_param_list *list, size_t index, int64_t
 int at_params_string_get(const struct at_param_list *list, size_t index,
 			 char *value, size_t *len);
 
+/**
+ * @brief Get a pointer to a string parameter, without copying it.
+ *
+ * The string is not null-terminated. It remains valid until the parameter
+ * is changed or cleared, and, for a list created with
+ * @ref at_params_list_view_init, as long as the parsed string is valid.
+ *
+ * @param[in]  list    Parameter list.
+ * @param[in]  index   Parameter index in the list.
+ * @param[out] str     Pointer to the string value.
+ * @param[out] len     Length of the string value in bytes.
+ *
+ * @retval 0 If the operation was successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int at_params_string_ptr_get(const struct at_param_list *list, size_t index,
+			     const char **str, size_t *len);
+
 /**
  * @brief Get a parameter value as a array.
  *
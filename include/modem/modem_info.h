@@ -11,6 +11,7 @@
 #include <cJSON.h>
 #endif
 
+#include <sys/util.h>
 #include <modem/at_params.h>
 
 #ifdef __cplusplus
@@ -237,6 +238,116 @@ int modem_info_json_object_encode(struct modem_param_info *modem,
  */
 int modem_info_params_get(struct modem_param_info *modem_param);
 
+/**@brief Fields of a modem information snapshot. */
+enum modem_info_snapshot_field {
+	MODEM_INFO_SNAPSHOT_CUR_BAND,	/**< Current LTE band. */
+	MODEM_INFO_SNAPSHOT_UE_MODE,	/**< Current mode. */
+	MODEM_INFO_SNAPSHOT_OPERATOR,	/**< Current operator. */
+	MODEM_INFO_SNAPSHOT_CELLID,	/**< Cell ID of the device. */
+	MODEM_INFO_SNAPSHOT_AREA_CODE,	/**< Tracking area code. */
+	MODEM_INFO_SNAPSHOT_IP_ADDRESS,	/**< IP address of the device. */
+	MODEM_INFO_SNAPSHOT_APN,	/**< Access point name. */
+	MODEM_INFO_SNAPSHOT_SYSTEM_MODE,/**< Supported system modes. */
+	MODEM_INFO_SNAPSHOT_UICC,	/**< UICC state. */
+	MODEM_INFO_SNAPSHOT_BATTERY,	/**< Battery voltage. */
+	MODEM_INFO_SNAPSHOT_DATE_TIME,	/**< Mobile network time and date. */
+	/* Fields that do not change, read only once. */
+	MODEM_INFO_SNAPSHOT_SUP_BAND,	/**< Supported LTE bands. */
+	MODEM_INFO_SNAPSHOT_FW_VERSION,	/**< Modem firmware version. */
+	MODEM_INFO_SNAPSHOT_ICCID,	/**< SIM ICCID. */
+	MODEM_INFO_SNAPSHOT_IMSI,	/**< Mobile subscriber identity. */
+	MODEM_INFO_SNAPSHOT_IMEI,	/**< Modem serial number. */
+	MODEM_INFO_SNAPSHOT_FIELD_COUNT,/**< Number of fields. */
+};
+
+/** Bit of a field in the field masks of a snapshot. */
+#define MODEM_INFO_SNAPSHOT_FIELD(field) BIT(MODEM_INFO_SNAPSHOT_##field)
+
+/** Mask of all the fields of a snapshot. */
+#define MODEM_INFO_SNAPSHOT_ALL BIT_MASK(MODEM_INFO_SNAPSHOT_FIELD_COUNT)
+
+/** Bit of the LTE-M system mode in @ref modem_info_snapshot.system_mode. */
+#define MODEM_INFO_SNAPSHOT_SYSTEM_MODE_LTEM BIT(0)
+/** Bit of the NB-IoT system mode in @ref modem_info_snapshot.system_mode. */
+#define MODEM_INFO_SNAPSHOT_SYSTEM_MODE_NBIOT BIT(1)
+/** Bit of the GPS system mode in @ref modem_info_snapshot.system_mode. */
+#define MODEM_INFO_SNAPSHOT_SYSTEM_MODE_GPS BIT(2)
+
+/** Largest LTE band number in @ref modem_info_snapshot.sup_bands. */
+#define MODEM_INFO_SNAPSHOT_BAND_MAX 95
+
+/**@brief Snapshot of the modem parameters.
+ *
+ * A compact alternative to @ref modem_param_info, filled by
+ * @ref modem_info_snapshot_get.
+ */
+struct modem_info_snapshot {
+	/** Mask of the fields read from the modem. */
+	uint32_t present;
+	/** Mask of the fields changed by the last call to
+	 *  @ref modem_info_snapshot_get.
+	 */
+	uint32_t changed;
+	/** Cell ID of the device. */
+	uint32_t cell_id;
+	/** Tracking area code. */
+	uint16_t area_code;
+	/** Battery voltage, in millivolts. */
+	uint16_t battery;
+	/** Current LTE band. */
+	uint8_t current_band;
+	/** Current mode. */
+	uint8_t ue_mode;
+	/** Supported system modes, MODEM_INFO_SNAPSHOT_SYSTEM_MODE_ bits. */
+	uint8_t system_mode;
+	/** UICC state. */
+	uint8_t uicc;
+	/** Current operator, as mobile country and network codes. */
+	char mccmnc[7];
+	/** Mobile network time and date, "yy/MM/dd,hh:mm:ss+zz". */
+	char date_time[21];
+	/** IP address of the device. */
+	char ip_address[46];
+	/** Access point name. */
+	char apn[64];
+	/** Supported LTE bands, one bit per band number. */
+	uint8_t sup_bands[(MODEM_INFO_SNAPSHOT_BAND_MAX + 8) / 8];
+	/** Modem firmware version. */
+	char modem_fw[32];
+	/** SIM ICCID. */
+	char iccid[21];
+	/** Mobile subscriber identity. */
+	char imsi[16];
+	/** Modem serial number. */
+	char imei[16];
+};
+
+/** @brief Update a snapshot of the modem parameters.
+ *
+ * The AT commands needed to read the requested fields are queued at once,
+ * each command only once even if it reads several fields, and their
+ * responses are parsed without allocating memory. The fields that do not
+ * change, like the IMEI, the modem firmware version or the ICCID, are only
+ * read from the modem the first time they are requested.
+ *
+ * The fields that differ from their value in @p snapshot are set in the
+ * @c changed mask, so that only these can be reported. All the fields
+ * read are considered changed in a new, zero-initialized, snapshot.
+ *
+ * @param snapshot Snapshot to update.
+ * @param fields   Mask of the fields to read, see
+ *                 @ref MODEM_INFO_SNAPSHOT_FIELD and
+ *                 @ref MODEM_INFO_SNAPSHOT_ALL.
+ *
+ * @retval 0 If all the requested fields were read.
+ * @retval -EAGAIN If some of the requested fields could not be read. They
+ *                 are not set in the @c present mask of the snapshot, and
+ *                 keep their previous value.
+ * @retval -EINVAL If the snapshot is NULL.
+ */
+int modem_info_snapshot_get(struct modem_info_snapshot *snapshot,
+			    uint32_t fields);
+
 /** @} */
 
 #ifdef __cplusplus
@@ -40,6 +40,25 @@ enum sms_type {
  */
 #define SMS_MAX_PAYLOAD_LEN_CHARS 160
 
+/**
+ * @brief Maximum length of the decoded payload of one SMS in bytes.
+ *
+ * @details UCS2 text is decoded into UTF-8, where 70 UCS2 characters
+ * may take up to 210 bytes.
+ */
+#define SMS_MAX_PAYLOAD_LEN_BYTES 210
+
+#if defined(CONFIG_SMS_REASSEMBLY)
+/**
+ * @brief Size of the payload buffer, large enough for a concatenated message
+ * reassembled from the maximum number of parts.
+ */
+#define SMS_PAYLOAD_BUF_LEN (CONFIG_SMS_REASSEMBLY_PARTS_MAX * SMS_MAX_PAYLOAD_LEN_BYTES + 1)
+#else
+/** @brief Size of the payload buffer. */
+#define SMS_PAYLOAD_BUF_LEN (SMS_MAX_PAYLOAD_LEN_BYTES + 1)
+#endif
+
 /**
  * @brief Maximum length of SMS address, i.e., phone number, in characters
  * as specified in 3GPP TS 23.040 Section 9.1.2.3.
@@ -86,7 +105,11 @@ struct sms_udh_concat {
 	uint16_t ref_number;
 	/** @brief Maximum number of short messages in the concatenated short message. */
 	uint8_t total_msgs;
-	/** @brief Sequence number of the current short message. */
+	/**
+	 * @brief Sequence number of the current short message.
+	 *
+	 * @details Zero if the message has been reassembled from all of its parts.
+	 */
 	uint8_t seq_number;
 };
 
@@ -146,11 +169,12 @@ struct sms_data {
 	 * but the length of the received payload is in payload_len variable.
 	 *
 	 * Generally the message is of text type in which case you can treat it as string.
+	 * GSM 7 bit text is decoded into ASCII and UCS2 text into UTF-8.
 	 * However, header may contain information that determines it for specific purpose,
 	 * e.g., via application port information, in which case it should be treated as
 	 * specified for that purpose.
 	 */
-	uint8_t payload[SMS_MAX_PAYLOAD_LEN_CHARS + 1];
+	uint8_t payload[SMS_PAYLOAD_BUF_LEN];
 };
 
 /** @brief SMS listener callback function. */
@@ -63,9 +63,16 @@ enum download_client_evt_id {
 	DOWNLOAD_CLIENT_EVT_DONE,
 };
 
+/**
+ * @brief Download fragment.
+ */
 struct download_fragment {
+	/** Fragment data. */
 	const void *buf;
+	/** Fragment length, in bytes. */
 	size_t len;
+	/** Offset of the fragment in the file. */
+	size_t offset;
 };
 
 /**
@@ -103,9 +110,19 @@ struct download_client_cfg {
 	 */
 	uint8_t pdn_id;
 	/** Maximum fragment size to download. 0 indicates that Kconfigured
-	 *  values shall be used.
+	 *  values shall be used. When downloading over HTTP(S), it may be
+	 *  as large as the buffer set with @ref download_client_buf_set.
 	 */
 	size_t frag_size_override;
+	/** Maximum number of HTTP range requests in flight. 0 indicates
+	 *  that the Kconfigured value shall be used.
+	 */
+	uint8_t pipeline_depth;
+	/** Maximum number of CoAP block requests in flight, up to
+	 *  @option{CONFIG_DOWNLOAD_CLIENT_COAP_WINDOW}. 0 indicates
+	 *  that the Kconfigured value shall be used.
+	 */
+	uint8_t coap_window;
 	/** Set hostname for TLS Server Name Indication extension */
 	bool set_tls_hostname;
 };
@@ -126,6 +143,66 @@ struct download_client_cfg {
 typedef int (*download_client_callback_t)(
 	const struct download_client_evt *event);
 
+/**
+ * @brief Statistics of a CoAP download.
+ */
+struct download_client_coap_stats {
+	/** Number of blocks received. */
+	uint32_t blocks;
+	/** Number of requests sent, including retransmissions. */
+	uint32_t requests;
+	/** Number of retransmissions. */
+	uint32_t retransmissions;
+	/** Smallest round trip time, in milliseconds. */
+	uint32_t rtt_min;
+	/** Largest round trip time, in milliseconds. */
+	uint32_t rtt_max;
+	/** Sum of the round trip times, in milliseconds. */
+	uint32_t rtt_total;
+	/** Number of round trip time samples. Requests that have been
+	 *  retransmitted are not sampled.
+	 */
+	uint32_t rtt_samples;
+	/** Current block size, in bytes. */
+	uint16_t block_size;
+};
+
+/**
+ * @brief State of a CoAP request slot.
+ */
+enum download_client_coap_req_state {
+	/** Free. */
+	DOWNLOAD_CLIENT_COAP_REQ_FREE,
+	/** Waiting for the response. */
+	DOWNLOAD_CLIENT_COAP_REQ_SENT,
+	/** Response received out of order, the block must be requested
+	 *  again once the blocks before it are received.
+	 */
+	DOWNLOAD_CLIENT_COAP_REQ_DISCARDED,
+};
+
+/**
+ * @brief CoAP request in flight.
+ */
+struct download_client_coap_req {
+	/** Token. */
+	uint8_t token[8];
+	/** Message ID. */
+	uint16_t id;
+	/** Block size exponent. */
+	uint8_t szx;
+	/** Number of retransmissions. */
+	uint8_t retransmits;
+	/** State. */
+	enum download_client_coap_req_state state;
+	/** Offset of the block in the file. */
+	size_t off;
+	/** Uptime of the last transmission, in milliseconds. */
+	uint32_t sent;
+	/** Time to wait for the response, in milliseconds. */
+	uint32_t timeout;
+};
+
 /**
  * @brief Download client instance.
  */
@@ -134,9 +211,16 @@ struct download_client {
 	int fd;
 	/** Response buffer. */
 	char buf[CONFIG_DOWNLOAD_CLIENT_BUF_SIZE];
-	/** Buffer offset. */
+	/** Offset in the buffer currently receiving data. */
 	size_t offset;
 
+	/** Buffer receiving the HTTP(S) payload. Either @c buf or
+	 *  the buffer set with @ref download_client_buf_set.
+	 */
+	char *frag_buf;
+	/** Size of the fragment buffer. */
+	size_t frag_buf_size;
+
 	/** Size of the file being downloaded, in bytes. */
 	size_t file_size;
 	/** Download progress, number of bytes downloaded. */
@@ -159,11 +243,43 @@ struct download_client {
 		bool has_header;
 		/** The server has closed the connection. */
 		bool connection_close;
+		/** Offset of the first byte not requested yet. */
+		size_t requested;
+		/** Number of range requests in flight. */
+		size_t in_flight;
+		/** Number of bytes of the next response received
+		 *  together with the current one.
+		 */
+		size_t pending;
+		/** Offset of those bytes in the buffer. */
+		size_t pending_off;
 	} http;
 
+	/** Interleaved download, see @ref download_client_parallel. */
+	struct {
+		/** Offset of the first fragment downloaded by this client. */
+		size_t base;
+		/** Number of bytes to skip after each fragment,
+		 *  downloaded by the other clients. Zero to download
+		 *  the whole file.
+		 */
+		size_t stride;
+	} stripe;
+
 	struct {
-		/** CoAP block context. */
-		struct coap_block_context block_ctx;
+		/** Requests in flight. */
+		struct download_client_coap_req
+			req[CONFIG_DOWNLOAD_CLIENT_COAP_WINDOW];
+		/** Offset of the first byte not requested yet. */
+		size_t requested;
+		/** Block size exponent of the next requests. */
+		uint8_t szx;
+		/** Blocks received since the last retransmission. */
+		uint8_t good;
+		/** Statistics of the current download. */
+		struct download_client_coap_stats stats;
+		/** Payload of the last block, in @c buf. */
+		const uint8_t *payload;
 	} coap;
 
 	/** Internal thread ID. */
@@ -203,6 +319,34 @@ int download_client_init(struct download_client *client,
 int download_client_connect(struct download_client *client, const char *host,
 			    const struct download_client_cfg *config);
 
+/**
+ * @brief Set the buffer receiving the payload of HTTP(S) downloads.
+ *
+ * By default, the payload is received in the internal buffer of the client
+ * and the application has to copy the fragments somewhere else before
+ * returning from the @ref DOWNLOAD_CLIENT_EVT_FRAGMENT event.
+ * With this function, the application can instead provide the memory where
+ * the payload is received, for example the write buffer of a DFU target,
+ * and the fragment events then point into that memory.
+ * Only the HTTP response header and the CoAP datagrams are received in the
+ * internal buffer.
+ *
+ * The buffer is reused for every fragment. It can be changed from the
+ * fragment event callback to receive the next fragment in a different buffer.
+ * The fragment size can be up to the size of the buffer, see
+ * @ref download_client_cfg.frag_size_override.
+ *
+ * @param[in] client	Client instance.
+ * @param[in] buf	Buffer, or NULL to revert to the internal buffer.
+ * @param[in] len	Size of the buffer, at least
+ *			@option{CONFIG_DOWNLOAD_CLIENT_BUF_SIZE} bytes, to fit
+ *			any payload received together with the HTTP header.
+ *
+ * @retval int Zero on success, a negative error code otherwise.
+ */
+int download_client_buf_set(struct download_client *client, void *buf,
+			    size_t len);
+
 /**
  * @brief Download a file.
  *
@@ -248,6 +392,19 @@ void download_client_resume(struct download_client *client);
  */
 int download_client_file_size_get(struct download_client *client, size_t *size);
 
+/**
+ * @brief Retrieve the statistics of the current CoAP download.
+ *
+ * The statistics are reset when a download is started.
+ *
+ * @param[in]  client	Client instance.
+ * @param[out] stats	Statistics.
+ *
+ * @retval int Zero on success, a negative error code otherwise.
+ */
+int download_client_coap_stats_get(const struct download_client *client,
+				   struct download_client_coap_stats *stats);
+
 /**
  * @brief Disconnect from the server.
  *
@@ -257,6 +414,121 @@ int download_client_file_size_get(struct download_client *client, size_t *size);
  */
 int download_client_disconnect(struct download_client *client);
 
+#if defined(CONFIG_DOWNLOAD_CLIENT_PARALLEL) || defined(__DOXYGEN__)
+
+/**
+ * @brief Connection of a parallel download.
+ */
+struct download_client_parallel_conn {
+	/** Client downloading over this connection. */
+	struct download_client client;
+	/** Parallel download this connection belongs to. */
+	struct download_client_parallel *parent;
+	/** Signaled when the next fragment to deliver is this client's. */
+	struct k_sem turn;
+	/** The client has downloaded all its fragments. */
+	bool done;
+};
+
+/**
+ * @brief Parallel download instance.
+ *
+ * A parallel download splits a file in fragments of
+ * @ref download_client_cfg.frag_size_override bytes
+ * (@option{CONFIG_DOWNLOAD_CLIENT_HTTP_FRAG_SIZE} by default) and
+ * downloads them over several HTTP(S) connections, each connection
+ * requesting every n-th fragment.
+ */
+struct download_client_parallel {
+	/** Connections. */
+	struct download_client_parallel_conn
+		conn[CONFIG_DOWNLOAD_CLIENT_PARALLEL_MAX_CONNECTIONS];
+	/** Number of connections in use. */
+	size_t count;
+	/** Whether fragments are delivered in order. */
+	bool ordered;
+	/** Fragment size. */
+	size_t frag_size;
+	/** Offset of the first byte to download. */
+	size_t from;
+	/** Offset of the next byte to deliver, when ordered. */
+	size_t next;
+	/** File name, null-terminated. */
+	const char *file;
+	/** All the connections have been started. */
+	bool started;
+	/** The download has been stopped. */
+	bool stopped;
+	/** Serializes the application callback. */
+	struct k_mutex lock;
+	/** Event handler. */
+	download_client_callback_t callback;
+};
+
+/**
+ * @brief Initialize a parallel download.
+ *
+ * @param[in] dl	Parallel download instance.
+ * @param[in] count	Number of connections, up to the value of
+ *		@option{CONFIG_DOWNLOAD_CLIENT_PARALLEL_MAX_CONNECTIONS}.
+ * @param[in] ordered	Deliver the fragments in order. Otherwise,
+ *			fragments are delivered as soon as they are
+ *			received, and the application must write them
+ *			at @ref download_fragment.offset.
+ * @param[in] callback	Callback function. It is called from the
+ *			thread of each connection, one call at a time.
+ *			A single @ref DOWNLOAD_CLIENT_EVT_DONE event is
+ *			sent when all the connections are done. The
+ *			download stops on errors after which a
+ *			connection cannot resume, and on any error for
+ *			which the callback returns non-zero.
+ *
+ * @retval int Zero on success, otherwise a negative error code.
+ */
+int download_client_parallel_init(struct download_client_parallel *dl,
+				  size_t count, bool ordered,
+				  download_client_callback_t callback);
+
+/**
+ * @brief Establish the connections to the server.
+ *
+ * @param[in] dl	Parallel download instance.
+ * @param[in] host	Name of the host to connect to, see
+ *			@ref download_client_connect.
+ * @param[in] config	Configuration options, used for all connections.
+ *
+ * @retval int Zero on success, a negative error code otherwise.
+ */
+int download_client_parallel_connect(struct download_client_parallel *dl,
+				     const char *host,
+				     const struct download_client_cfg *config);
+
+/**
+ * @brief Download a file over all connections.
+ *
+ * The first connection starts the download, the others start
+ * when the file size is known.
+ *
+ * @param[in] dl	Parallel download instance.
+ * @param[in] file	File to download, null-terminated.
+ * @param[in] from	Offset from where to download.
+ *
+ * @retval int Zero on success, a negative error code otherwise.
+ */
+int download_client_parallel_start(struct download_client_parallel *dl,
+				   const char *file, size_t from);
+
+/**
+ * @brief Disconnect all the connections from the server.
+ *
+ * @param[in] dl	Parallel download instance.
+ *
+ * @retval int Zero on success, a negative error code otherwise.
+ */
+int download_client_parallel_disconnect(struct download_client_parallel *dl);
+
+#endif /* CONFIG_DOWNLOAD_CLIENT_PARALLEL */
+
 #ifdef __cplusplus
 }
 #endif
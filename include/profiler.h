@@ -196,6 +196,33 @@ static inline void profiler_log_send(struct log_event_buf *buf,
 #endif
 
 
+/** @brief Statistics of the Nordic profiler backend.
+ */
+struct profiler_nordic_stats {
+	/** Number of events sent to the host. */
+	uint32_t sent_events;
+	/** Number of frames sent to the host. */
+	uint32_t sent_frames;
+	/** Number of events dropped because of lack of buffer space. */
+	uint32_t dropped_events;
+};
+
+
+/** @brief Function for getting statistics of the Nordic profiler backend.
+ *
+ * @param stats Pointer to the structure to be filled with statistics.
+ */
+#ifdef CONFIG_PROFILER_NORDIC
+void profiler_nordic_stats_get(struct profiler_nordic_stats *stats);
+#else
+static inline void profiler_nordic_stats_get(
+				struct profiler_nordic_stats *stats)
+{
+	*stats = (struct profiler_nordic_stats){0};
+}
+#endif
+
+
 /**
  * @}
  */
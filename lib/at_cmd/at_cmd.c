@@ -28,19 +28,17 @@ LOG_MODULE_REGISTER(at_cmd, CONFIG_AT_CMD_LOG_LEVEL);
 #define AT_CMD_CMS_STR   "+CMS ERROR:"
 #define AT_CMD_CME_STR   "+CME ERROR:"
 
-/* Flags describing an AT command request */
-enum at_cmd_flags {
-	AT_CMD_BUF_CMD = 1 << 0,	/* Command is buffered by at_cmd */
-	AT_CMD_SYNC = 1 << 1,		/* Command is synchronous */
+/* Request of at_cmd_write_with_callback(), with a copy of the command */
+struct buffered_req {
+	struct at_cmd_req req;
+	at_cmd_handler_t handler;	/* Callback to execute on result */
+	char cmd[];			/* 0-terminated command */
 };
 
-/* Metadata for a queued AT command */
-struct cmd_item  {
-	char *cmd;			/* Pointer to 0-terminated command */
-	char *resp;			/* Pointer to response buffer */
-	at_cmd_handler_t callback;	/* Callback to execute on result */
-	size_t resp_size;		/* Size of response buffer */
-	enum at_cmd_flags flags;	/* Flags describing the request */
+/* Request of at_cmd_write(), completed when the caller can return */
+struct sync_req {
+	struct at_cmd_req req;
+	struct k_sem done;
 };
 
 /* Metadata for an AT response */
@@ -61,16 +59,13 @@ static atomic_t shutdown_mode;
 /* Mutex to guard the at_cmd init from simultaneous entry. */
 static K_MUTEX_DEFINE(at_cmd_init_mutex);
 
-/* Structure holding current command. current_cmd.cmd=NULL signifies no cmd. */
-static struct cmd_item current_cmd;
+/* Request being processed. current_req=NULL signifies no request. */
+static struct at_cmd_req *current_req;
 K_MUTEX_DEFINE(current_cmd_mutex);
 
-/* Queue for queued command metadata */
-K_MSGQ_DEFINE(commands, sizeof(struct cmd_item), CONFIG_AT_CMD_QUEUE_LEN, 4);
-
-/* Message queue to return the result in the case of a synchronous call */
-K_MSGQ_DEFINE(response_sync, sizeof(struct resp_item), 1, 4);
-K_MUTEX_DEFINE(response_sync_get);
+/* Queue of requests waiting to be written. The requests are not copied. */
+K_MSGQ_DEFINE(commands, sizeof(struct at_cmd_req *), CONFIG_AT_CMD_QUEUE_LEN,
+	      4);
 
 static int open_socket(void)
 {
@@ -182,10 +177,33 @@ static inline int at_write(const char *const cmd)
 static void complete_cmd(void)
 {
 	k_mutex_lock(&current_cmd_mutex, K_FOREVER);
-	current_cmd.cmd = NULL;
+	current_req = NULL;
 	k_mutex_unlock(&current_cmd_mutex);
 }
 
+/*
+ * Notify the owner of a request that it is complete. The request may be
+ * reused or freed by its callback, so it is not accessed after that.
+ */
+static void notify_req(struct at_cmd_req *req, const char *response)
+{
+	at_cmd_req_handler_t callback = req->callback;
+#if defined(CONFIG_POLL)
+	struct k_poll_signal *signal = req->signal;
+	int code = req->code;
+#endif
+
+	if (callback != NULL) {
+		callback(req, response);
+	}
+
+#if defined(CONFIG_POLL)
+	if (signal != NULL) {
+		k_poll_signal_raise(signal, code);
+	}
+#endif
+}
+
 /*
  * Atomically load a new command if appropriate, then write it to the socket.
  * The operations are repeated until the queue is empty or a command is pending
@@ -195,35 +213,39 @@ static void complete_cmd(void)
 static void load_cmd_and_write(void)
 {
 	int ret;
-	struct resp_item resp;
+	struct at_cmd_req *req;
 
-	k_mutex_lock(&current_cmd_mutex, K_FOREVER);
 	do {
 		ret = 0;
 
+		k_mutex_lock(&current_cmd_mutex, K_FOREVER);
+
 		/* Do not load a new command if already loaded or none queued */
-		if (current_cmd.cmd != NULL ||
-		    k_msgq_get(&commands, &current_cmd, K_NO_WAIT) != 0) {
+		if (current_req != NULL ||
+		    k_msgq_get(&commands, &req, K_NO_WAIT) != 0) {
+			k_mutex_unlock(&current_cmd_mutex);
 			break;
 		}
 
-		ret = at_write(current_cmd.cmd);
+		current_req = req;
+		ret = at_write(req->cmd);
 
-		if (current_cmd.flags & AT_CMD_BUF_CMD) {
-			k_free(current_cmd.cmd);
+		/* If write failed, make an error response and complete cmd */
+		if (ret != 0) {
+			req->state = AT_CMD_ERROR_WRITE;
+			req->code = ret;
+			current_req = NULL;
 		}
 
-		/* If write failed, make an error response and complete cmd */
+		k_mutex_unlock(&current_cmd_mutex);
+
+		/* The owner is notified without the lock held, as it may
+		 * queue another command.
+		 */
 		if (ret != 0) {
-			resp.state = AT_CMD_ERROR_WRITE;
-			resp.code = ret;
-			if (current_cmd.flags & AT_CMD_SYNC) {
-				k_msgq_put(&response_sync, &resp, K_FOREVER);
-			}
-			complete_cmd();
+			notify_req(req, NULL);
 		}
 	} while (ret != 0);
-	k_mutex_unlock(&current_cmd_mutex);
 }
 
 static void socket_thread_fn(void *arg1, void *arg2, void *arg3)
@@ -231,6 +253,8 @@ static void socket_thread_fn(void *arg1, void *arg2, void *arg3)
 	static int bytes_read;
 	static size_t payload_len;
 	static struct resp_item ret;
+	static struct at_cmd_req *req;
+	static const char *response;
 	static char buf[CONFIG_AT_CMD_RESPONSE_MAX_LEN];
 
 	ARG_UNUSED(arg1);
@@ -249,6 +273,8 @@ static void socket_thread_fn(void *arg1, void *arg2, void *arg3)
 		/* Initialize the response */
 		ret.code  = 0;
 		ret.state = AT_CMD_OK;
+		req = current_req;
+		response = NULL;
 
 		/* Handle possible socket-level errors */
 
@@ -303,46 +329,83 @@ static void socket_thread_fn(void *arg1, void *arg2, void *arg3)
 
 		payload_len = get_return_code(buf, bytes_read, &ret);
 
+		/* Notifications are not a response to the current command */
+		if (ret.state == AT_CMD_NOTIFICATION) {
+			if (notification_handler != NULL) {
+				notification_handler(buf);
+			}
+			continue;
+		}
+
 		/* Verify the buffer size if provided, and copy the message */
-		if (current_cmd.cmd != NULL &&
-		    current_cmd.resp != NULL &&
-		    ret.state != AT_CMD_NOTIFICATION) {
-			if (current_cmd.resp_size < payload_len) {
+		if (req != NULL && req->resp != NULL) {
+			if (req->resp_size < payload_len) {
 				LOG_ERR("Response buffer not large enough");
 				ret.code  = -EMSGSIZE;
 				goto next;
 			}
-			memcpy(current_cmd.resp, buf, payload_len);
+			memcpy(req->resp, buf, payload_len);
 		}
 
-		/* Call the relevant callback, if any */
-		if (ret.state == AT_CMD_NOTIFICATION &&
-		    notification_handler != NULL) {
-			notification_handler(buf);
-		} else if (current_cmd.callback != NULL) {
-			current_cmd.callback(buf);
-		}
+		response = buf;
 
 next:
-		/* Dispatch response for sync call */
-		if (current_cmd.cmd != NULL &&
-		    current_cmd.flags & AT_CMD_SYNC &&
-		    ret.state != AT_CMD_NOTIFICATION) {
-			LOG_DBG("Enqueueing response for sync call");
-			k_msgq_put(&response_sync, &ret, K_FOREVER);
-		}
+		/* We have now handled a command, write the next one before
+		 * notifying the owner of this one, so that the modem
+		 * processes them in parallel.
+		 */
+		complete_cmd();
+		load_cmd_and_write();
 
-		/* We have now handled a command if it was not a notification */
-		if (ret.state != AT_CMD_NOTIFICATION) {
-			complete_cmd();
+		if (req != NULL) {
+			req->state = ret.state;
+			req->code = ret.code;
+			notify_req(req, response);
 		}
 	}
 }
 
+static int queue_req(struct at_cmd_req *req, k_timeout_t timeout)
+{
+	int ret;
+
+	req->state = AT_CMD_OK;
+	req->code = -EINPROGRESS;
+
+	ret = k_msgq_put(&commands, &req, timeout);
+	if (ret) {
+		LOG_ERR("Could not enqueue cmd, error %d", ret);
+		return (ret == -ENOMSG) ? -ENOBUFS : ret;
+	}
+
+	load_cmd_and_write();
+	return 0;
+}
+
+static void buffered_req_complete(struct at_cmd_req *req,
+				  const char *response)
+{
+	struct buffered_req *buffered =
+		CONTAINER_OF(req, struct buffered_req, req);
+
+	if (response != NULL && buffered->handler != NULL) {
+		buffered->handler(response);
+	}
+
+	k_free(buffered);
+}
+
+static void sync_req_complete(struct at_cmd_req *req, const char *response)
+{
+	ARG_UNUSED(response);
+
+	k_sem_give(&CONTAINER_OF(req, struct sync_req, req)->done);
+}
+
 int at_cmd_write_with_callback(const char *const cmd,
 			       at_cmd_handler_t  handler)
 {
-	struct cmd_item command;
+	struct buffered_req *buffered;
 	int ret;
 
 	if (atomic_get(&shutdown_mode) == 1) {
@@ -359,23 +422,40 @@ int at_cmd_write_with_callback(const char *const cmd,
 		return -EINVAL;
 	}
 
-	command.cmd = k_malloc(strlen(cmd) + 1);
-	if (command.cmd == NULL) {
+	buffered = k_malloc(sizeof(*buffered) + strlen(cmd) + 1);
+	if (buffered == NULL) {
 		return -ENOMEM;
 	}
-	strcpy(command.cmd, cmd);
+	strcpy(buffered->cmd, cmd);
 
-	command.resp = NULL;
-	command.callback = handler;
-	command.flags = AT_CMD_BUF_CMD;
+	buffered->handler = handler;
+	buffered->req = (struct at_cmd_req) {
+		.cmd = buffered->cmd,
+		.callback = buffered_req_complete,
+	};
 
-	ret = k_msgq_put(&commands, &command, K_FOREVER);
+	ret = queue_req(&buffered->req, K_FOREVER);
 	if (ret) {
-		return ret;
+		k_free(buffered);
 	}
 
-	load_cmd_and_write();
-	return 0;
+	return ret;
+}
+
+int at_cmd_write_async(struct at_cmd_req *req)
+{
+	if (atomic_get(&shutdown_mode) == 1) {
+		return -EHOSTDOWN;
+	}
+
+	if (req == NULL || check_cmd(req->cmd)) {
+		LOG_ERR("Invalid command");
+		return -EINVAL;
+	}
+
+	/* The socket thread must not wait for itself to empty the queue */
+	return queue_req(req, (k_current_get() == socket_tid) ?
+			      K_NO_WAIT : K_FOREVER);
 }
 
 int at_cmd_write(const char *const cmd,
@@ -383,8 +463,8 @@ int at_cmd_write(const char *const cmd,
 		 size_t buf_len,
 		 enum at_cmd_state *state)
 {
-	struct cmd_item command;
-	struct resp_item ret;
+	int ret;
+	struct sync_req sync;
 
 	if (atomic_get(&shutdown_mode) == 1) {
 		return -EHOSTDOWN;
@@ -409,37 +489,31 @@ int at_cmd_write(const char *const cmd,
 		return -EINVAL;
 	}
 
-	/* This cast is safe; we do not free cmd without AT_CMD_BUF_CMD */
-	command.cmd = (char *)cmd;
-	command.resp = buf;
-	command.resp_size = buf_len;
-	command.callback = NULL;
-	command.flags = AT_CMD_SYNC;
-
-	/* Ensure we get our own AT response, not an old one */
-	k_mutex_lock(&response_sync_get, K_FOREVER);
+	/* Each caller waits for its own request, and gets its own response */
+	sync.req = (struct at_cmd_req) {
+		.cmd = cmd,
+		.resp = buf,
+		.resp_size = buf_len,
+		.callback = sync_req_complete,
+	};
+	k_sem_init(&sync.done, 0, 1);
 
-	/* We borrow the return code field from the currently unused response */
-	ret.code = k_msgq_put(&commands, &command, K_FOREVER);
-	if (ret.code) {
-		LOG_ERR("Could not enqueue cmd, error %d", ret.code);
+	ret = queue_req(&sync.req, K_FOREVER);
+	if (ret) {
 		if (state) {
 			*state = AT_CMD_ERROR_QUEUE;
 		}
-		return ret.code;
+		return ret;
 	}
 
-	load_cmd_and_write();
-
 	LOG_DBG("Awaiting response for %s", log_strdup(cmd));
-	k_msgq_get(&response_sync, &ret, K_FOREVER);
-	k_mutex_unlock(&response_sync_get);
+	k_sem_take(&sync.done, K_FOREVER);
 
 	if (state) {
-		*state = ret.state;
+		*state = sync.req.state;
 	}
 
-	return ret.code;
+	return sync.req.code;
 }
 
 void at_cmd_set_notification_handler(at_cmd_handler_t handler)
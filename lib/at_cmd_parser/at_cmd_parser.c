@@ -24,6 +24,10 @@
 #define AT_CMD_XMODEMUUID_LEN   11
 #define AT_CMD_XICCID_LEN       7
 
+/* Defined in at_params.c */
+int at_params_array_view_put(const struct at_param_list *list, size_t index,
+			     const char *str, size_t count);
+
 enum at_parser_state {
 	IDLE,
 	ARRAY,
@@ -221,35 +225,23 @@ static int at_parse_process_element(const char **str, int index,
 
 		tmpstr++;
 	} else if (state == ARRAY) {
-		char *next;
-		size_t i = 0;
-		uint32_t tmparray[AT_CMD_MAX_ARRAY_SIZE];
-
-		tmparray[i++] = (uint32_t)strtoul(tmpstr, &next, 10);
-		tmpstr = next;
-
-		while (!is_array_stop(*tmpstr) && !is_terminated(*tmpstr)) {
-			if (is_separator(*tmpstr)) {
-				tmparray[i++] =
-					(uint32_t)strtoul(++tmpstr, &next, 10);
-
-				if (strlen(tmpstr) == strlen(next)) {
-					break;
-				} else {
-					tmpstr = next;
-				}
-
-			} else {
-				tmpstr++;
-			}
+		size_t i;
+		const char *start_ptr = tmpstr;
 
-			if (i == AT_CMD_MAX_ARRAY_SIZE) {
-				break;
-			}
+		if (list->view) {
+			/* Only count the numbers, they are decoded when read */
+			i = at_array_parse(&tmpstr, NULL,
+					   AT_CMD_MAX_ARRAY_SIZE);
+			at_params_array_view_put(list, index, start_ptr, i);
+		} else {
+			uint32_t tmparray[AT_CMD_MAX_ARRAY_SIZE];
+
+			i = at_array_parse(&tmpstr, tmparray,
+					   AT_CMD_MAX_ARRAY_SIZE);
+			at_params_array_put(list, index, tmparray,
+					    i * sizeof(uint32_t));
 		}
 
-		at_params_array_put(list, index, tmparray, i * sizeof(uint32_t));
-
 		tmpstr++;
 	} else if (state == NUMBER) {
 		char *next;
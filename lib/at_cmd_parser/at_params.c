@@ -13,6 +13,7 @@
 #include <kernel.h>
 
 #include <modem/at_params.h>
+#include "at_utils.h"
 
 /* Internal function. Parameter cannot be null. */
 static void at_param_init(struct at_param *param)
@@ -23,13 +24,15 @@ static void at_param_init(struct at_param *param)
 	memset(param, 0, sizeof(struct at_param));
 }
 
-/* Internal function. Parameter cannot be null. */
-static void at_param_clear(struct at_param *param)
+/* Internal function. Parameters cannot be null. */
+static void at_param_clear(const struct at_param_list *list,
+			   struct at_param *param)
 {
 	__ASSERT(param != NULL, "Parameter cannot be NULL.");
 
-	if ((param->type == AT_PARAM_TYPE_STRING) ||
-	    (param->type == AT_PARAM_TYPE_ARRAY)) {
+	/* Values of a view refer to the parsed string */
+	if (!list->view && ((param->type == AT_PARAM_TYPE_STRING) ||
+			    (param->type == AT_PARAM_TYPE_ARRAY))) {
 		k_free(param->value.str_val);
 	}
 
@@ -79,6 +82,23 @@ int at_params_list_init(struct at_param_list *list, size_t max_params_count)
 	}
 
 	list->param_count = max_params_count;
+	list->view = false;
+	return 0;
+}
+
+int at_params_list_view_init(struct at_param_list *list,
+			     struct at_param *params, size_t max_params_count)
+{
+	if (list == NULL || params == NULL) {
+		return -EINVAL;
+	}
+
+	/* Array initialized with empty parameters. */
+	memset(params, 0, max_params_count * sizeof(struct at_param));
+
+	list->params = params;
+	list->param_count = max_params_count;
+	list->view = true;
 	return 0;
 }
 
@@ -91,7 +111,7 @@ void at_params_list_clear(struct at_param_list *list)
 	for (size_t i = 0; i < list->param_count; ++i) {
 		struct at_param *params = list->params;
 
-		at_param_clear(&params[i]);
+		at_param_clear(list, &params[i]);
 		at_param_init(&params[i]);
 	}
 }
@@ -105,7 +125,9 @@ void at_params_list_free(struct at_param_list *list)
 	at_params_list_clear(list);
 
 	list->param_count = 0;
-	k_free(list->params);
+	if (!list->view) {
+		k_free(list->params);
+	}
 	list->params = NULL;
 }
 
@@ -121,7 +143,7 @@ int at_params_empty_put(const struct at_param_list *list, size_t index)
 		return -EINVAL;
 	}
 
-	at_param_clear(param);
+	at_param_clear(list, param);
 
 	param->type = AT_PARAM_TYPE_EMPTY;
 	param->value.int_val = 0;
@@ -141,7 +163,7 @@ int at_params_int_put(const struct at_param_list *list, size_t index, int64_t va
 		return -EINVAL;
 	}
 
-	at_param_clear(param);
+	at_param_clear(list, param);
 
 	param->type = AT_PARAM_TYPE_NUM_INT;
 	param->value.int_val = value;
@@ -161,15 +183,21 @@ int at_params_string_put(const struct at_param_list *list, size_t index,
 		return -EINVAL;
 	}
 
-	char *param_value = (char *)k_malloc(str_len + 1);
+	char *param_value;
 
-	if (param_value == NULL) {
-		return -ENOMEM;
-	}
+	if (list->view) {
+		/* Refer to the string instead of copying it */
+		param_value = (char *)str;
+	} else {
+		param_value = (char *)k_malloc(str_len + 1);
+		if (param_value == NULL) {
+			return -ENOMEM;
+		}
 
-	memcpy(param_value, str, str_len);
+		memcpy(param_value, str, str_len);
+	}
 
-	at_param_clear(param);
+	at_param_clear(list, param);
 	param->size = str_len;
 	param->type = AT_PARAM_TYPE_STRING;
 	param->value.str_val = param_value;
@@ -184,6 +212,10 @@ int at_params_array_put(const struct at_param_list *list, size_t index,
 		return -EINVAL;
 	}
 
+	if (list->view) {
+		return -ENOTSUP;
+	}
+
 	struct at_param *param = at_params_get(list, index);
 
 	if (param == NULL) {
@@ -198,7 +230,7 @@ int at_params_array_put(const struct at_param_list *list, size_t index,
 
 	memcpy(param_value, array, array_len);
 
-	at_param_clear(param);
+	at_param_clear(list, param);
 	param->size = array_len;
 	param->type = AT_PARAM_TYPE_ARRAY;
 	param->value.array_val = param_value;
@@ -206,6 +238,30 @@ int at_params_array_put(const struct at_param_list *list, size_t index,
 	return 0;
 }
 
+/* Used by the parser to store an array of a view. The array is kept as
+ * the text following the left parenthesis, and decoded when read.
+ */
+int at_params_array_view_put(const struct at_param_list *list, size_t index,
+			     const char *str, size_t count)
+{
+	if (list == NULL || list->params == NULL || str == NULL) {
+		return -EINVAL;
+	}
+
+	struct at_param *param = at_params_get(list, index);
+
+	if (param == NULL) {
+		return -EINVAL;
+	}
+
+	at_param_clear(list, param);
+	param->size = count * sizeof(uint32_t);
+	param->type = AT_PARAM_TYPE_ARRAY;
+	param->value.str_val = (char *)str;
+
+	return 0;
+}
+
 int at_params_size_get(const struct at_param_list *list, size_t index,
 		       size_t *len)
 {
@@ -400,12 +456,42 @@ int at_params_array_get(const struct at_param_list *list, size_t index,
 		return -ENOMEM;
 	}
 
-	memcpy(array, param->value.array_val, param_len);
+	if (list->view) {
+		const char *str = param->value.str_val;
+
+		at_array_parse(&str, array, param_len / sizeof(uint32_t));
+	} else {
+		memcpy(array, param->value.array_val, param_len);
+	}
 	*len = param_len;
 
 	return 0;
 }
 
+int at_params_string_ptr_get(const struct at_param_list *list, size_t index,
+			     const char **str, size_t *len)
+{
+	if (list == NULL || list->params == NULL || str == NULL ||
+	    len == NULL) {
+		return -EINVAL;
+	}
+
+	struct at_param *param = at_params_get(list, index);
+
+	if (param == NULL) {
+		return -EINVAL;
+	}
+
+	if (param->type != AT_PARAM_TYPE_STRING) {
+		return -EINVAL;
+	}
+
+	*str = param->value.str_val;
+	*len = at_param_size(param);
+
+	return 0;
+}
+
 uint32_t at_params_valid_count_get(const struct at_param_list *list)
 {
 	if (list == NULL || list->params == NULL) {
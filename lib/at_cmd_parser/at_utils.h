@@ -18,6 +18,7 @@
 
 #include <zephyr/types.h>
 #include <stddef.h>
+#include <stdlib.h>
 #include <ctype.h>
 
 #define AT_PARAM_SEPARATOR ','
@@ -190,6 +191,60 @@ static inline bool is_array_stop(char chr)
 	return false;
 }
 
+/**
+ * @brief Parse the numbers of an array
+ *
+ * Numbers are separated by separator characters. A compound value is
+ * converted as far as it is numeric, ie. 5-23 results in 5. Parsing stops
+ * at the end of the array, at the end of the string, or after @p max
+ * numbers.
+ *
+ * @param[in,out] str   Array, after the left parenthesis. Points to where
+ *                      parsing stopped on return.
+ * @param[out]    array Numbers, or NULL to only count them
+ * @param[in]     max   Maximum number of numbers to parse
+ *
+ * @return Number of numbers parsed
+ */
+static inline size_t at_array_parse(const char **str, uint32_t *array,
+				    size_t max)
+{
+	char *next;
+	size_t i = 0;
+	uint32_t value;
+	const char *tmpstr = *str;
+
+	value = (uint32_t)strtoul(tmpstr, &next, 10);
+	if (array) {
+		array[i] = value;
+	}
+	i++;
+	tmpstr = next;
+
+	while ((i < max) && !is_array_stop(*tmpstr) &&
+	       !is_terminated(*tmpstr)) {
+		if (is_separator(*tmpstr)) {
+			value = (uint32_t)strtoul(++tmpstr, &next, 10);
+			if (array) {
+				array[i] = value;
+			}
+			i++;
+
+			if (next == tmpstr) {
+				break;
+			}
+
+			tmpstr = next;
+		} else {
+			tmpstr++;
+		}
+	}
+
+	*str = tmpstr;
+
+	return i;
+}
+
 /**
  * @brief Check if character is a number character (including + and -)
  *
@@ -253,7 +308,7 @@ static inline bool is_command(const char *str)
  * @retval true  If the string is a CLAC response
  * @retval false Otherwise
  */
-static bool is_clac(const char *str)
+static inline bool is_clac(const char *str)
 {
 	/* skip leading <CR><LF>, if any, as check not from index 0 */
 	while (is_lfcr(*str)) {
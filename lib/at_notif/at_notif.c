@@ -7,6 +7,7 @@
 #include <logging/log.h>
 #include <zephyr.h>
 #include <stdio.h>
+#include <string.h>
 #include <init.h>
 #include <modem/at_cmd.h>
 #include <modem/at_notif.h>
@@ -25,6 +26,143 @@ struct notif_handler {
 
 static sys_slist_t handler_list;
 
+/* Number of lists of the prefix table, a power of two */
+#define PREFIX_BUCKETS 32
+
+/**@brief Table element for a handler of the notifications with a given name. */
+struct prefix_handler {
+	const char         *prefix;
+	size_t             len;
+	uint32_t           hash;
+	/* Next element of the same list, plus one, or zero */
+	uint8_t            next;
+	void               *ctx;
+	at_notif_handler_t handler;
+};
+
+/* Handlers are kept in lists indexed by a hash of the notification name,
+ * so that the handlers of a notification are found without looking at the
+ * handlers of other notifications.
+ */
+static struct prefix_handler prefix_table[CONFIG_AT_NOTIF_PREFIX_HANDLERS_MAX];
+static uint8_t prefix_buckets[PREFIX_BUCKETS];
+
+/**
+ * @brief Hash the notification name, the text before the colon.
+ *
+ * @return The FNV-1a hash of the name and its length in @p len.
+ */
+static uint32_t notif_name_hash(const char *notif, size_t *len)
+{
+	size_t i;
+	uint32_t hash = 2166136261;
+
+	for (i = 0; notif[i] != '\0' && notif[i] != ':' &&
+		    notif[i] != '\r' && notif[i] != '\n'; i++) {
+		hash = (hash ^ (uint8_t)notif[i]) * 16777619;
+	}
+
+	*len = i;
+	return hash;
+}
+
+static bool prefix_match(const struct prefix_handler *entry, uint32_t hash,
+			 const char *name, size_t len)
+{
+	return entry->hash == hash && entry->len == len &&
+	       memcmp(entry->prefix, name, len) == 0;
+}
+
+/**@brief Add the handler in the prefix table if not already present. */
+static int insert_prefix_handler(const char *prefix, void *ctx,
+				 at_notif_handler_t handler)
+{
+	size_t len;
+	size_t slot;
+	uint32_t hash = notif_name_hash(prefix, &len);
+	uint8_t *link = &prefix_buckets[hash % PREFIX_BUCKETS];
+	struct prefix_handler *entry;
+
+	k_mutex_lock(&list_mtx, K_FOREVER);
+
+	/* Check if handler is already registered, and find the list end. */
+	while (*link != 0) {
+		entry = &prefix_table[*link - 1];
+		if (prefix_match(entry, hash, prefix, len) &&
+		    entry->ctx == ctx && entry->handler == handler) {
+			LOG_DBG("Handler already registered. Nothing to do");
+			k_mutex_unlock(&list_mtx);
+			return 0;
+		}
+		link = &entry->next;
+	}
+
+	for (slot = 0; slot < ARRAY_SIZE(prefix_table); slot++) {
+		if (prefix_table[slot].handler == NULL) {
+			break;
+		}
+	}
+
+	if (slot == ARRAY_SIZE(prefix_table)) {
+		k_mutex_unlock(&list_mtx);
+		return -ENOBUFS;
+	}
+
+	entry = &prefix_table[slot];
+	entry->prefix  = prefix;
+	entry->len     = len;
+	entry->hash    = hash;
+	entry->next    = 0;
+	entry->ctx     = ctx;
+	entry->handler = handler;
+
+	/* Append, to keep the handlers in registration order. */
+	*link = slot + 1;
+
+	k_mutex_unlock(&list_mtx);
+	return 0;
+}
+
+/**@brief Remove the handler from the prefix table if registered. */
+static int remove_prefix_handler(const char *prefix, void *ctx,
+				 at_notif_handler_t handler)
+{
+	size_t len;
+	uint32_t hash = notif_name_hash(prefix, &len);
+	uint8_t *link = &prefix_buckets[hash % PREFIX_BUCKETS];
+	struct prefix_handler *entry;
+
+	k_mutex_lock(&list_mtx, K_FOREVER);
+
+	while (*link != 0) {
+		entry = &prefix_table[*link - 1];
+		if (prefix_match(entry, hash, prefix, len) &&
+		    entry->ctx == ctx && entry->handler == handler) {
+			*link = entry->next;
+			memset(entry, 0, sizeof(*entry));
+			k_mutex_unlock(&list_mtx);
+			return 0;
+		}
+		link = &entry->next;
+	}
+
+	LOG_WRN("Handler not registered. Nothing to do");
+	k_mutex_unlock(&list_mtx);
+	return 0;
+}
+
+static bool is_valid_prefix(const char *prefix)
+{
+	size_t len;
+
+	if (prefix == NULL) {
+		return false;
+	}
+
+	(void)notif_name_hash(prefix, &len);
+
+	return len > 0 && prefix[len] == '\0';
+}
 
 /**
  * @brief Find the handler from the notification list.
@@ -102,12 +240,37 @@ static int remove_notif_handler(void *ctx, at_notif_handler_t handler)
 /**@brief AT command notifications handler. */
 static void notif_dispatch(const char *response)
 {
+	size_t len;
+	uint8_t next;
+	uint32_t hash;
+	struct prefix_handler *entry;
 	struct notif_handler *curr, *tmp;
 
 	k_mutex_lock(&list_mtx, K_FOREVER);
 
-	/* Dispatch notifications to all registered handlers */
+	/* Dispatch notifications to the handlers of their name first */
 	LOG_DBG("Dispatching events:");
+	if (response != NULL) {
+		hash = notif_name_hash(response, &len);
+		next = prefix_buckets[hash % PREFIX_BUCKETS];
+
+		while (next != 0) {
+			entry = &prefix_table[next - 1];
+			/* The handler may de-register itself */
+			next = entry->next;
+
+			if (!prefix_match(entry, hash, response, len)) {
+				continue;
+			}
+
+			LOG_DBG(" - prefix=%s, ctx=0x%08X, handler=0x%08X",
+				log_strdup(entry->prefix), (uint32_t)entry->ctx,
+				(uint32_t)entry->handler);
+			entry->handler(entry->ctx, response);
+		}
+	}
+
+	/* Then dispatch them to all handlers of every notification */
 	SYS_SLIST_FOR_EACH_CONTAINER_SAFE(&handler_list, curr, tmp, node) {
 		LOG_DBG(" - ctx=0x%08X, handler=0x%08X", (uint32_t)curr->ctx,
 			(uint32_t)curr->handler);
@@ -162,6 +325,28 @@ int at_notif_deregister_handler(void *context, at_notif_handler_t handler)
 	return remove_notif_handler(context, handler);
 }
 
+int at_notif_register_prefix_handler(const char *prefix, void *context,
+				     at_notif_handler_t handler)
+{
+	if (handler == NULL || !is_valid_prefix(prefix)) {
+		LOG_ERR("Invalid handler (context=0x%08X, handler=0x%08X)",
+			(uint32_t)context, (uint32_t)handler);
+		return -EINVAL;
+	}
+	return insert_prefix_handler(prefix, context, handler);
+}
+
+int at_notif_deregister_prefix_handler(const char *prefix, void *context,
+				       at_notif_handler_t handler)
+{
+	if (handler == NULL || !is_valid_prefix(prefix)) {
+		LOG_ERR("Invalid handler (context=0x%08X, handler=0x%08X)",
+			(uint32_t)context, (uint32_t)handler);
+		return -EINVAL;
+	}
+	return remove_prefix_handler(prefix, context, handler);
+}
+
 #ifdef CONFIG_AT_NOTIF_SYS_INIT
 SYS_INIT(module_init, APPLICATION, CONFIG_KERNEL_INIT_PRIORITY_DEFAULT);
 #endif
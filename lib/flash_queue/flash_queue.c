@@ -0,0 +1,514 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <string.h>
+#include <storage/flash_map.h>
+#include <fs/fcb.h>
+#include <flash_queue.h>
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(flash_queue, CONFIG_FLASH_QUEUE_LOG_LEVEL);
+
+#define FLASH_QUEUE_MAGIC	0x46515545
+#define FLASH_QUEUE_VERSION	1
+
+/* Room kept in each sector for the sector header and the length and CRC of
+ * an entry.
+ */
+#define SECTOR_OVERHEAD		32
+
+/* Each entry is a record with a header. An acknowledgment is a record without
+ * data, so that the acknowledged entries are known after a reboot.
+ */
+enum record_kind {
+	RECORD_DATA = 1,
+	RECORD_ACK,
+};
+
+struct record_header {
+	uint32_t seq;
+	uint8_t kind;
+	uint8_t type;
+	uint16_t reserved;
+};
+
+/* The data is written after the header, so the header must keep it aligned
+ * on the write block size.
+ */
+#define WRITE_BLOCK_SIZE_MAX	sizeof(struct record_header)
+
+static int header_read(const struct flash_queue *queue,
+		       const struct fcb_entry *loc, struct record_header *header)
+{
+	if (loc->fe_data_len < sizeof(*header)) {
+		/* Not written by this library. */
+		memset(header, 0, sizeof(*header));
+		return 0;
+	}
+
+	return flash_area_read(queue->fcb.fap, FCB_ENTRY_FA_DATA_OFF((*loc)),
+			       header, sizeof(*header));
+}
+
+/* Writes the data, padding the last write block with the erase value. */
+static int data_write(struct flash_queue *queue, off_t off, const void *data,
+		      size_t len)
+{
+	int err;
+	size_t align = queue->fcb.f_align;
+	size_t aligned_len = len & ~(align - 1);
+	uint8_t block[WRITE_BLOCK_SIZE_MAX];
+
+	if (aligned_len > 0) {
+		err = flash_area_write(queue->fcb.fap, off, data, aligned_len);
+		if (err) {
+			return err;
+		}
+	}
+
+	if (aligned_len == len) {
+		return 0;
+	}
+
+	memset(block, queue->fcb.f_erase_value, align);
+	memcpy(block, (const uint8_t *)data + aligned_len, len - aligned_len);
+
+	return flash_area_write(queue->fcb.fap, off + aligned_len, block, align);
+}
+
+struct sector_walk {
+	const struct flash_queue *queue;
+	/* Largest sequence numbers of the entries and of the acknowledgments. */
+	uint32_t seq_max;
+	uint32_t seq_acked;
+	/* Number of entries after seq_acked. */
+	size_t count;
+};
+
+static int seq_walk_cb(struct fcb_entry_ctx *loc_ctx, void *arg)
+{
+	struct sector_walk *walk = arg;
+	struct record_header header;
+	int err;
+
+	err = header_read(walk->queue, &loc_ctx->loc, &header);
+	if (err) {
+		return err;
+	}
+
+	if (header.kind == RECORD_DATA) {
+		walk->seq_max = MAX(walk->seq_max, header.seq);
+	} else if (header.kind == RECORD_ACK) {
+		walk->seq_acked = MAX(walk->seq_acked, header.seq);
+	}
+
+	return 0;
+}
+
+static int count_walk_cb(struct fcb_entry_ctx *loc_ctx, void *arg)
+{
+	struct sector_walk *walk = arg;
+	struct record_header header;
+	int err;
+
+	err = header_read(walk->queue, &loc_ctx->loc, &header);
+	if (err) {
+		return err;
+	}
+
+	if ((header.kind == RECORD_DATA) && (header.seq > walk->seq_acked)) {
+		walk->count++;
+	}
+
+	return 0;
+}
+
+/* Finds the state of the queue from the records in flash. */
+static int state_load(struct flash_queue *queue)
+{
+	int err;
+	struct sector_walk walk = {
+		.queue = queue,
+	};
+
+	err = fcb_walk(&queue->fcb, NULL, seq_walk_cb, &walk);
+	if (err) {
+		return err;
+	}
+
+	err = fcb_walk(&queue->fcb, NULL, count_walk_cb, &walk);
+	if (err) {
+		return err;
+	}
+
+	queue->seq_acked = walk.seq_acked;
+	queue->seq_read = walk.seq_acked;
+	queue->seq_next = MAX(walk.seq_max, walk.seq_acked) + 1;
+	queue->count = walk.count;
+	queue->read_loc.fe_sector = NULL;
+
+	return 0;
+}
+
+/* Erases the oldest sector. Its entries that are not acknowledged are
+ * dropped.
+ */
+static int oldest_sector_release(struct flash_queue *queue)
+{
+	int err;
+	struct sector_walk walk = {
+		.queue = queue,
+		.seq_acked = queue->seq_acked,
+	};
+
+	err = fcb_walk(&queue->fcb, queue->fcb.f_oldest, count_walk_cb, &walk);
+	if (err) {
+		return err;
+	}
+
+	err = fcb_rotate(&queue->fcb);
+	if (err) {
+		LOG_ERR("fcb_rotate, error: %d", err);
+		return err;
+	}
+
+	if (walk.count > 0) {
+		LOG_WRN("Flash queue full, %d entries dropped", walk.count);
+		queue->count -= walk.count;
+		queue->dropped += walk.count;
+	}
+
+	/* The last record read may have been erased. Reading restarts from the
+	 * oldest record, skipping the entries that have been read.
+	 */
+	queue->read_loc.fe_sector = NULL;
+
+	return 0;
+}
+
+static int record_append(struct flash_queue *queue,
+			 const struct record_header *header, const void *data,
+			 size_t len)
+{
+	int err = -ENOSPC;
+	struct fcb_entry loc;
+
+	/* The sectors are used in turn, which spreads the erases over the flash
+	 * area.
+	 */
+	for (size_t i = 0; i < queue->fcb.f_sector_cnt; i++) {
+		err = fcb_append(&queue->fcb, sizeof(*header) + len, &loc);
+		if (err != -ENOSPC) {
+			break;
+		}
+
+		err = oldest_sector_release(queue);
+		if (err) {
+			return err;
+		}
+	}
+
+	if (err) {
+		LOG_ERR("fcb_append, error: %d", err);
+		return err;
+	}
+
+	err = flash_area_write(queue->fcb.fap, FCB_ENTRY_FA_DATA_OFF(loc),
+			       header, sizeof(*header));
+	if (err) {
+		return err;
+	}
+
+	if (len > 0) {
+		err = data_write(queue,
+				 FCB_ENTRY_FA_DATA_OFF(loc) + sizeof(*header),
+				 data, len);
+		if (err) {
+			return err;
+		}
+	}
+
+	/* The record is valid once its CRC is written. A record that is not
+	 * complete after a power failure is skipped when reading.
+	 */
+	return fcb_append_finish(&queue->fcb, &loc);
+}
+
+/* Finds the next entry that has not been read. */
+static int next_entry_get(struct flash_queue *queue, struct fcb_entry *loc,
+			  struct record_header *header)
+{
+	int err;
+
+	*loc = queue->read_loc;
+
+	while (fcb_getnext(&queue->fcb, loc) == 0) {
+		err = header_read(queue, loc, header);
+		if (err) {
+			return err;
+		}
+
+		if ((header->kind == RECORD_DATA) &&
+		    (header->seq > queue->seq_read)) {
+			return 0;
+		}
+
+		/* Records before the next entry need not be read again. */
+		queue->read_loc = *loc;
+	}
+
+	return -ENODATA;
+}
+
+static int fcb_setup(struct flash_queue *queue, int area_id)
+{
+	int err;
+	uint32_t sector_cnt = ARRAY_SIZE(queue->sectors);
+	const struct flash_area *fap;
+
+	err = flash_area_get_sectors(area_id, &sector_cnt, queue->sectors);
+	if (err) {
+		LOG_ERR("flash_area_get_sectors, error: %d", err);
+		return err;
+	}
+
+	if (sector_cnt < 2) {
+		LOG_ERR("The flash area must have at least two sectors");
+		return -EINVAL;
+	}
+
+	queue->sector_size_min = queue->sectors[0].fs_size;
+	for (size_t i = 1; i < sector_cnt; i++) {
+		queue->sector_size_min = MIN(queue->sector_size_min,
+					     queue->sectors[i].fs_size);
+	}
+
+	err = flash_area_open(area_id, &fap);
+	if (err) {
+		return err;
+	}
+
+	if ((flash_area_align(fap) > WRITE_BLOCK_SIZE_MAX) ||
+	    ((flash_area_align(fap) & (flash_area_align(fap) - 1)) != 0)) {
+		LOG_ERR("Unsupported write block size: %d",
+			flash_area_align(fap));
+		flash_area_close(fap);
+		return -EINVAL;
+	}
+
+	flash_area_close(fap);
+
+	queue->fcb = (struct fcb) {
+		.f_magic = FLASH_QUEUE_MAGIC,
+		.f_version = FLASH_QUEUE_VERSION,
+		.f_sector_cnt = sector_cnt,
+		.f_scratch_cnt = 0,
+		.f_sectors = queue->sectors,
+	};
+
+	err = fcb_init(area_id, &queue->fcb);
+	if (err) {
+		LOG_WRN("No flash queue found, erasing the flash area");
+
+		err = flash_area_open(area_id, &fap);
+		if (err) {
+			return err;
+		}
+
+		err = flash_area_erase(fap, 0, fap->fa_size);
+		flash_area_close(fap);
+		if (err) {
+			return err;
+		}
+
+		err = fcb_init(area_id, &queue->fcb);
+		if (err) {
+			LOG_ERR("fcb_init, error: %d", err);
+			return err;
+		}
+	}
+
+	return 0;
+}
+
+int flash_queue_init(struct flash_queue *queue, int area_id)
+{
+	int err;
+
+	memset(queue, 0, sizeof(*queue));
+	k_mutex_init(&queue->lock);
+
+	err = fcb_setup(queue, area_id);
+	if (err) {
+		return err;
+	}
+
+	err = state_load(queue);
+	if (err) {
+		LOG_ERR("Failed to load the flash queue, error: %d", err);
+		return err;
+	}
+
+	LOG_DBG("Flash queue initialized, %d entries", queue->count);
+
+	return 0;
+}
+
+int flash_queue_push(struct flash_queue *queue, uint8_t type, const void *data,
+		     size_t len)
+{
+	int err;
+	struct record_header header = {
+		.kind = RECORD_DATA,
+		.type = type,
+	};
+
+	if ((sizeof(header) + len + SECTOR_OVERHEAD >
+	     queue->sector_size_min) ||
+	    (sizeof(header) + len > FCB_MAX_LEN)) {
+		return -EFBIG;
+	}
+
+	k_mutex_lock(&queue->lock, K_FOREVER);
+
+	header.seq = queue->seq_next;
+
+	err = record_append(queue, &header, data, len);
+	if (err == 0) {
+		queue->seq_next++;
+		queue->count++;
+	}
+
+	k_mutex_unlock(&queue->lock);
+
+	return err;
+}
+
+int flash_queue_peek(struct flash_queue *queue,
+		     struct flash_queue_entry *entry)
+{
+	int err;
+	struct fcb_entry loc;
+	struct record_header header;
+
+	k_mutex_lock(&queue->lock, K_FOREVER);
+
+	err = next_entry_get(queue, &loc, &header);
+	if (err == 0) {
+		entry->seq = header.seq;
+		entry->type = header.type;
+		entry->len = loc.fe_data_len - sizeof(header);
+	}
+
+	k_mutex_unlock(&queue->lock);
+
+	return err;
+}
+
+int flash_queue_read(struct flash_queue *queue, struct flash_queue_entry *entry,
+		     void *buf, size_t size)
+{
+	int err;
+	size_t len;
+	struct fcb_entry loc;
+	struct record_header header;
+
+	k_mutex_lock(&queue->lock, K_FOREVER);
+
+	err = next_entry_get(queue, &loc, &header);
+	if (err) {
+		goto exit;
+	}
+
+	len = loc.fe_data_len - sizeof(header);
+	if (len > size) {
+		err = -ENOMEM;
+		goto exit;
+	}
+
+	err = flash_area_read(queue->fcb.fap,
+			      FCB_ENTRY_FA_DATA_OFF(loc) + sizeof(header), buf,
+			      len);
+	if (err) {
+		goto exit;
+	}
+
+	entry->seq = header.seq;
+	entry->type = header.type;
+	entry->len = len;
+
+	queue->read_loc = loc;
+	queue->seq_read = header.seq;
+
+exit:
+	k_mutex_unlock(&queue->lock);
+
+	return err;
+}
+
+int flash_queue_ack(struct flash_queue *queue, uint32_t seq)
+{
+	int err = 0;
+	struct sector_walk walk = {
+		.queue = queue,
+		.seq_acked = seq,
+	};
+	struct record_header header = {
+		.seq = seq,
+		.kind = RECORD_ACK,
+	};
+
+	k_mutex_lock(&queue->lock, K_FOREVER);
+
+	if (seq > queue->seq_read) {
+		err = -EINVAL;
+		goto exit;
+	}
+
+	if (seq <= queue->seq_acked) {
+		goto exit;
+	}
+
+	err = record_append(queue, &header, NULL, 0);
+	if (err) {
+		goto exit;
+	}
+
+	queue->seq_acked = seq;
+
+	/* The entries that are left are the ones after the acknowledged
+	 * entry, some of them may have been dropped.
+	 */
+	err = fcb_walk(&queue->fcb, NULL, count_walk_cb, &walk);
+	if (err == 0) {
+		queue->count = walk.count;
+	}
+
+exit:
+	k_mutex_unlock(&queue->lock);
+
+	return err;
+}
+
+int flash_queue_clear(struct flash_queue *queue)
+{
+	int err;
+
+	k_mutex_lock(&queue->lock, K_FOREVER);
+
+	err = fcb_clear(&queue->fcb);
+	if (err == 0) {
+		queue->seq_acked = queue->seq_next - 1;
+		queue->seq_read = queue->seq_acked;
+		queue->count = 0;
+		queue->read_loc.fe_sector = NULL;
+	}
+
+	k_mutex_unlock(&queue->lock);
+
+	return err;
+}
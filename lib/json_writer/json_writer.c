@@ -0,0 +1,341 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <json_writer.h>
+
+/* The bits of the containers at depths 0 to CONFIG_JSON_WRITER_DEPTH_MAX. */
+BUILD_ASSERT(CONFIG_JSON_WRITER_DEPTH_MAX < 32,
+	     "The depth of each container must have a bit in a 32-bit mask");
+
+/* Longest number printed with 17 significant digits, as in cJSON. */
+#define NUMBER_LEN_MAX 25
+
+static void put(struct json_writer *writer, const char *data, size_t len)
+{
+	size_t capacity;
+	size_t chunk;
+	int err;
+
+	if (writer->err) {
+		return;
+	}
+
+	if (json_writer_is_measuring(writer)) {
+		writer->total_len += len;
+		return;
+	}
+
+	/* Without flush handler, room is kept for the NUL terminator. */
+	if (writer->flush == NULL) {
+		capacity = (writer->size > 0) ? writer->size - 1 : 0;
+	} else {
+		capacity = writer->size;
+	}
+
+	while (len > 0) {
+		if (writer->len == capacity) {
+			if (writer->flush == NULL) {
+				writer->err = -ENOMEM;
+				return;
+			}
+
+			err = writer->flush(writer->buf, writer->len,
+					    writer->user_data);
+			if (err) {
+				writer->err = err;
+				return;
+			}
+
+			writer->len = 0;
+		}
+
+		chunk = MIN(len, capacity - writer->len);
+		memcpy(&writer->buf[writer->len], data, chunk);
+		writer->len += chunk;
+		writer->total_len += chunk;
+		data += chunk;
+		len -= chunk;
+	}
+}
+
+/* Escapes the same characters as cJSON. */
+static void string_put(struct json_writer *writer, const char *str)
+{
+	const char *start = str;
+	char escape[7];
+
+	put(writer, "\"", 1);
+
+	for (; *str != '\0'; str++) {
+		unsigned char c = *str;
+		char code;
+
+		if ((c > 31) && (c != '"') && (c != '\\')) {
+			continue;
+		}
+
+		put(writer, start, str - start);
+		start = str + 1;
+
+		switch (c) {
+		case '"':
+			code = '"';
+			break;
+		case '\\':
+			code = '\\';
+			break;
+		case '\b':
+			code = 'b';
+			break;
+		case '\f':
+			code = 'f';
+			break;
+		case '\n':
+			code = 'n';
+			break;
+		case '\r':
+			code = 'r';
+			break;
+		case '\t':
+			code = 't';
+			break;
+		default:
+			code = 0;
+			break;
+		}
+
+		if (code) {
+			escape[0] = '\\';
+			escape[1] = code;
+			put(writer, escape, 2);
+		} else {
+			snprintf(escape, sizeof(escape), "\\u%04x", c);
+			put(writer, escape, 6);
+		}
+	}
+
+	put(writer, start, str - start);
+	put(writer, "\"", 1);
+}
+
+/* Writes the separator and the key of a value, after checking that the key is
+ * given only inside an object.
+ */
+static int value_start(struct json_writer *writer, const char *key)
+{
+	uint32_t level = BIT(writer->depth);
+
+	if (writer->err) {
+		return writer->err;
+	}
+
+	if (((writer->objects & level) != 0) != (key != NULL)) {
+		writer->err = -EINVAL;
+		return writer->err;
+	}
+
+	if (writer->values & level) {
+		if (writer->depth == 0) {
+			/* Only one top-level value */
+			writer->err = -EINVAL;
+			return writer->err;
+		}
+
+		put(writer, ",", 1);
+	}
+
+	writer->values |= level;
+
+	if (key != NULL) {
+		string_put(writer, key);
+		put(writer, ":", 1);
+	}
+
+	return writer->err;
+}
+
+static int container_start(struct json_writer *writer, const char *key,
+			   bool object)
+{
+	uint32_t level;
+
+	if (!writer->err && (writer->depth == CONFIG_JSON_WRITER_DEPTH_MAX)) {
+		writer->err = -E2BIG;
+	}
+
+	if (value_start(writer, key)) {
+		return writer->err;
+	}
+
+	writer->depth++;
+	level = BIT(writer->depth);
+	writer->values &= ~level;
+
+	if (object) {
+		writer->objects |= level;
+	} else {
+		writer->objects &= ~level;
+	}
+
+	put(writer, object ? "{" : "[", 1);
+
+	return writer->err;
+}
+
+static int container_end(struct json_writer *writer, bool object)
+{
+	if (writer->err) {
+		return writer->err;
+	}
+
+	if ((writer->depth == 0) ||
+	    (((writer->objects & BIT(writer->depth)) != 0) != object)) {
+		writer->err = -EINVAL;
+		return writer->err;
+	}
+
+	writer->depth--;
+	put(writer, object ? "}" : "]", 1);
+
+	return writer->err;
+}
+
+void json_writer_init(struct json_writer *writer, char *buf, size_t size,
+		      json_writer_flush_t flush, void *user_data)
+{
+	memset(writer, 0, sizeof(*writer));
+
+	writer->buf = buf;
+	writer->size = (buf != NULL) ? size : 0;
+	writer->flush = flush;
+	writer->user_data = user_data;
+
+	if ((flush != NULL) && (writer->size == 0)) {
+		writer->err = -EINVAL;
+	}
+}
+
+int json_writer_object_start(struct json_writer *writer, const char *key)
+{
+	return container_start(writer, key, true);
+}
+
+int json_writer_object_end(struct json_writer *writer)
+{
+	return container_end(writer, true);
+}
+
+int json_writer_array_start(struct json_writer *writer, const char *key)
+{
+	return container_start(writer, key, false);
+}
+
+int json_writer_array_end(struct json_writer *writer)
+{
+	return container_end(writer, false);
+}
+
+int json_writer_string(struct json_writer *writer, const char *key,
+		       const char *value)
+{
+	if (value_start(writer, key)) {
+		return writer->err;
+	}
+
+	string_put(writer, value);
+
+	return writer->err;
+}
+
+int json_writer_number(struct json_writer *writer, const char *key,
+		       double value)
+{
+	char number[NUMBER_LEN_MAX + 1];
+	int len;
+
+	if (value_start(writer, key)) {
+		return writer->err;
+	}
+
+	if (!isfinite(value)) {
+		put(writer, "null", 4);
+		return writer->err;
+	}
+
+	/* 15 significant digits avoid printing nonsignificant nonzero digits,
+	 * unless the value cannot be read back from them.
+	 */
+	len = snprintf(number, sizeof(number), "%1.15g", value);
+	if (strtod(number, NULL) != value) {
+		len = snprintf(number, sizeof(number), "%1.17g", value);
+	}
+
+	put(writer, number, len);
+
+	return writer->err;
+}
+
+int json_writer_bool(struct json_writer *writer, const char *key, bool value)
+{
+	if (value_start(writer, key)) {
+		return writer->err;
+	}
+
+	if (value) {
+		put(writer, "true", 4);
+	} else {
+		put(writer, "false", 5);
+	}
+
+	return writer->err;
+}
+
+int json_writer_null(struct json_writer *writer, const char *key)
+{
+	if (value_start(writer, key)) {
+		return writer->err;
+	}
+
+	put(writer, "null", 4);
+
+	return writer->err;
+}
+
+int json_writer_finish(struct json_writer *writer)
+{
+	int err;
+
+	if (writer->err) {
+		return writer->err;
+	}
+
+	if (writer->depth != 0) {
+		writer->err = -EINVAL;
+		return writer->err;
+	}
+
+	if (writer->flush != NULL) {
+		if (writer->len > 0) {
+			err = writer->flush(writer->buf, writer->len,
+					    writer->user_data);
+			if (err) {
+				writer->err = err;
+				return err;
+			}
+
+			writer->len = 0;
+		}
+	} else if (writer->buf != NULL) {
+		writer->buf[writer->len] = '\0';
+	}
+
+	return writer->total_len;
+}
@@ -330,11 +330,12 @@ static void at_handler(void *context, const char *response)
 
 		break;
 	case LTE_LC_NOTIF_NCELLMEAS: {
-		int ncell_count = neighborcell_count_get(response);
-		struct lte_lc_ncell *neighbor_cells;
+		/* Notifications are handled one at a time, from at_cmd's
+		 * thread, so the cells can be parsed in a static array.
+		 */
+		static struct lte_lc_ncell neighbor_cells[CONFIG_LTE_NEIGHBOR_CELLS_MAX];
 
 		LOG_DBG("%%NCELLMEAS notification");
-		LOG_DBG("Neighbor cell count: %d", ncell_count);
 
 		if (!evt_handler) {
 			/* No need to parse the response if there is no handler
@@ -343,21 +344,10 @@ static void at_handler(void *context, const char *response)
 			return;
 		}
 
-		if (ncell_count == 0) {
-			evt.type = LTE_LC_EVT_NEIGHBOR_CELL_MEAS;
-			evt_handler(&evt);
-			return;
-		}
-
-		neighbor_cells = k_calloc(sizeof(struct lte_lc_ncell), ncell_count);
-		if (neighbor_cells == NULL) {
-			LOG_ERR("Failed to allocate memory for neighbor cells");
-			return;
-		}
-
 		evt.cells_info.neighbor_cells = neighbor_cells;
 
-		err = parse_ncellmeas(response, &evt.cells_info);
+		err = parse_ncellmeas(response, &evt.cells_info,
+				      ARRAY_SIZE(neighbor_cells));
 
 		switch (err) {
 		case -E2BIG:
@@ -367,6 +357,8 @@ static void at_handler(void *context, const char *response)
 			/* Fall through */
 		case 0: /* Fall through */
 		case 1:
+			LOG_DBG("Neighbor cell count: %d",
+				evt.cells_info.ncells_count);
 			evt.type = LTE_LC_EVT_NEIGHBOR_CELL_MEAS;
 			evt_handler(&evt);
 			break;
@@ -375,8 +367,6 @@ static void at_handler(void *context, const char *response)
 			break;
 		}
 
-		k_free(neighbor_cells);
-
 		return;
 	}
 	case LTE_LC_NOTIF_XMODEMSLEEP:
@@ -488,6 +478,31 @@ static int enable_notifications(void)
 	return 0;
 }
 
+/* Deregister the handler of the first count notifications */
+static void at_handler_deregister(size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		(void)at_notif_deregister_prefix_handler(at_notifs[i], NULL,
+							 at_handler);
+	}
+}
+
+static int at_handler_register(void)
+{
+	int err;
+
+	for (size_t i = 0; i < ARRAY_SIZE(at_notifs); i++) {
+		err = at_notif_register_prefix_handler(at_notifs[i], NULL,
+						       at_handler);
+		if (err) {
+			at_handler_deregister(i);
+			return err;
+		}
+	}
+
+	return 0;
+}
+
 static int init_and_config(void)
 {
 	int err;
@@ -510,7 +525,7 @@ static int init_and_config(void)
 		LOG_DBG("Default system mode is used: %d", sys_mode_current);
 	}
 
-	err = at_notif_register_handler(NULL, at_handler);
+	err = at_handler_register();
 	if (err) {
 		LOG_ERR("Can't register AT handler, error: %d", err);
 		return err;
@@ -720,7 +735,7 @@ int lte_lc_deinit(void)
 {
 	if (is_initialized) {
 		is_initialized = false;
-		at_notif_deregister_handler(NULL, at_handler);
+		at_handler_deregister(ARRAY_SIZE(at_notifs));
 		return lte_lc_func_mode_set(LTE_LC_FUNC_MODE_POWER_OFF);
 	}
 
@@ -120,20 +120,6 @@ static int get_edrx_value(enum lte_lc_lte_mode lte_mode, uint8_t idx, float *edr
 	return 0;
 }
 
-/* Counts the frequency of a character in a null-terminated string. */
-static uint32_t get_char_frequency(const char *str, char c)
-{
-	uint32_t count = 0;
-
-	do {
-		if (*str == c) {
-			count++;
-		}
-	} while (*(str++) != '\0');
-
-	return count;
-}
-
 /**@brief Helper function to check if a response is what was expected
  *
  * @param response Pointer to response prefix
@@ -198,6 +184,7 @@ int parse_edrx(const char *at_response, struct lte_lc_edrx_cfg *cfg)
 	int err, tmp_int;
 	uint8_t idx;
 	struct at_param_list resp_list = {0};
+	struct at_param params[AT_CEDRXP_PARAMS_COUNT_MAX];
 	char tmp_buf[5];
 	size_t len = sizeof(tmp_buf) - 1;
 	float ptw_multiplier;
@@ -206,7 +193,8 @@ int parse_edrx(const char *at_response, struct lte_lc_edrx_cfg *cfg)
 		return -EINVAL;
 	}
 
-	err = at_params_list_init(&resp_list, AT_CEDRXP_PARAMS_COUNT_MAX);
+	err = at_params_list_view_init(&resp_list, params,
+				       ARRAY_SIZE(params));
 	if (err) {
 		LOG_ERR("Could not init AT params list, error: %d", err);
 		return err;
@@ -402,8 +390,10 @@ int parse_rrc_mode(const char *at_response,
 {
 	int err, temp_mode;
 	struct at_param_list resp_list = {0};
+	struct at_param params[AT_CSCON_PARAMS_COUNT_MAX];
 
-	err = at_params_list_init(&resp_list, AT_CSCON_PARAMS_COUNT_MAX);
+	err = at_params_list_view_init(&resp_list, params,
+				       ARRAY_SIZE(params));
 	if (err) {
 		LOG_ERR("Could not init AT params list, error: %d", err);
 		return err;
@@ -450,12 +440,14 @@ int parse_cereg(const char *at_response,
 {
 	int err, status;
 	struct at_param_list resp_list;
+	struct at_param params[AT_CEREG_PARAMS_COUNT_MAX];
 	char str_buf[10];
 	char  response_prefix[sizeof(AT_CEREG_RESPONSE_PREFIX)] = {0};
 	size_t response_prefix_len = sizeof(response_prefix);
 	size_t len = sizeof(str_buf) - 1;
 
-	err = at_params_list_init(&resp_list, AT_CEREG_PARAMS_COUNT_MAX);
+	err = at_params_list_view_init(&resp_list, params,
+				       ARRAY_SIZE(params));
 	if (err) {
 		LOG_ERR("Could not init AT params list, error: %d", err);
 		return err;
@@ -588,12 +580,14 @@ int parse_xt3412(const char *at_response, uint64_t *time)
 {
 	int err;
 	struct at_param_list resp_list = {0};
+	struct at_param params[AT_XT3412_PARAMS_COUNT_MAX];
 
 	if (time == NULL || at_response == NULL) {
 		return -EINVAL;
 	}
 
-	err = at_params_list_init(&resp_list, AT_XT3412_PARAMS_COUNT_MAX);
+	err = at_params_list_view_init(&resp_list, params,
+				       ARRAY_SIZE(params));
 	if (err) {
 		LOG_ERR("Could not init AT params list, error: %d", err);
 		return err;
@@ -623,260 +617,310 @@ clean_exit:
 	return err;
 }
 
-uint32_t neighborcell_count_get(const char *at_response)
+/* Move to the next parameter of a response.
+ * Returns false if there are no more parameters.
+ */
+static bool param_next(const char **str)
 {
-	uint32_t comma_count, ncell_elements, ncell_count;
-
-	if (at_response == NULL) {
-		LOG_ERR("at_response is NULL, can't get cell count");
-		return 0;
+	if (**str != ',') {
+		return false;
 	}
 
-	comma_count = get_char_frequency(at_response, ',');
-	if (comma_count < AT_NCELLMEAS_PRE_NCELLS_PARAMS_COUNT) {
-		return 0;
-	}
+	(*str)++;
 
-	/* Add one, as there's no comma after the last element. */
-	ncell_elements = comma_count - (AT_NCELLMEAS_PRE_NCELLS_PARAMS_COUNT - 1) + 1;
-	ncell_count = ncell_elements / AT_NCELLMEAS_N_PARAMS_COUNT;
+	while (**str == ' ') {
+		(*str)++;
+	}
 
-	return ncell_count;
+	return true;
 }
 
-/* Parse NCELLMEAS notification and put information into struct lte_lc_cells_info.
- *
- * Returns 0 on successful cell measurements and population of struct, 1 on
- * measurement failure, -E2BIG if not all cells were parsed due to memory
- * limitations, otherwise negative error code.
- */
-int parse_ncellmeas(const char *at_response, struct lte_lc_cells_info *cells)
+/* Parse an integer parameter and move past it. */
+static int param_int_get(const char **str, int64_t *value)
 {
-	int err, status, tmp, len;
-	struct at_param_list resp_list;
-	char  response_prefix[sizeof(AT_NCELLMEAS_RESPONSE_PREFIX)] = {0};
-	size_t response_prefix_len = sizeof(response_prefix);
-	char tmp_str[7];
-	bool incomplete = false;
-	/* Count the actual numbers of parameters in the AT response before
-	 * allocating heap for it. This may save quite a bit of heap as the
-	 * worst case scenario is 96 elements.
-	 * 3 is added to account for the parameters that do not have a trailng
-	 * comma.
-	 */
-	size_t param_count = get_char_frequency(at_response, ',') + 3;
+	char *end;
 
-	cells->ncells_count = 0;
-
-	err = at_params_list_init(&resp_list, param_count);
-	if (err) {
-		LOG_ERR("Could not init AT params list, error: %d", err);
-		return err;
+	*value = strtoll(*str, &end, 10);
+	if (end == *str) {
+		return -EBADMSG;
 	}
 
-	err = at_parser_params_from_str(at_response,
-					NULL,
-					&resp_list);
-	if (err && err != -E2BIG) {
-		LOG_ERR("Could not parse AT%%XNCELLMEAS  response, error: %d", err);
-		goto clean_exit;
-	} else if (err == -E2BIG) {
-		incomplete = true;
-	}
+	*str = end;
 
-	err = at_params_string_get(&resp_list,
-				   AT_RESPONSE_PREFIX_INDEX,
-				   response_prefix,
-				   &response_prefix_len);
-	if (err) {
-		LOG_ERR("Could not get response prefix, error: %d", err);
-		goto clean_exit;
-	}
+	return 0;
+}
 
-	if (!response_is_valid(response_prefix, response_prefix_len,
-			       AT_NCELLMEAS_RESPONSE_PREFIX)) {
-		/* The unsolicited response is not a NCELLMEAS response, ignore it. */
-		LOG_DBG("Not a valid NCELLMEAS response");
-		goto clean_exit;
-	}
+/* Parse a string parameter and move past it. The string is not copied. */
+static int param_string_get(const char **str, const char **value, size_t *len)
+{
+	const char *end;
 
-	/* Status code. */
-	err = at_params_int_get(&resp_list, AT_NCELLMEAS_STATUS_INDEX, &status);
-	if (err) {
-		goto clean_exit;
+	if (**str != '"') {
+		return -EBADMSG;
 	}
 
-	if (status != AT_NCELLMEAS_STATUS_VALUE_SUCCESS) {
-		err = 1;
-		goto clean_exit;
+	end = strchr(*str + 1, '"');
+	if (end == NULL) {
+		return -EBADMSG;
 	}
 
-	/* Current cell ID. */
-	err = string_param_to_int(&resp_list, AT_NCELLMEAS_CELL_ID_INDEX, &tmp, 16);
-	if (err) {
-		goto clean_exit;
-	}
+	*value = *str + 1;
+	*len = end - *value;
+	*str = end + 1;
 
-	cells->current_cell.id = tmp;
+	return 0;
+}
 
-	/* PLMN */
-	len = sizeof(tmp_str);
+/* Convert the digits of a string parameter to an integer, the string is not
+ * null-terminated.
+ */
+static int param_string_to_int(const char *value, size_t len, int base,
+			       int *output)
+{
+	char buf[sizeof("FFFFFFFF")];
 
-	err = at_params_string_get(&resp_list, AT_NCELLMEAS_PLMN_INDEX,
-				   tmp_str, &len);
-	if (err) {
-		goto clean_exit;
+	if (len == 0 || len >= sizeof(buf)) {
+		return -EBADMSG;
 	}
 
-	tmp_str[len] = '\0';
+	memcpy(buf, value, len);
+	buf[len] = '\0';
 
-	/* Read MNC and store as integer. The MNC starts as the fourth character
-	 * in the string, following three characters long MCC.
-	 */
-	err = string_to_int(&tmp_str[3], 10, &cells->current_cell.mnc);
-	if (err) {
-		goto clean_exit;
-	}
+	return string_to_int(buf, base, output);
+}
 
-	/* Null-terminated MCC, read and store it. */
-	tmp_str[3] = '\0';
+/* Parse the current cell of a successful NCELLMEAS notification, from the cell
+ * ID up to the measurement time.
+ */
+static int ncellmeas_current_cell_parse(const char **str,
+					struct lte_lc_cell *cell)
+{
+	int err;
+	int64_t tmp;
+	const char *value;
+	size_t len;
+	int id, tac;
 
-	err = string_to_int(tmp_str, 10, &cells->current_cell.mcc);
-	if (err) {
-		goto clean_exit;
+	/* Current cell ID. */
+	if (!param_next(str)) {
+		return -EBADMSG;
 	}
 
-	/* Tracking area code. */
-	err = string_param_to_int(&resp_list, AT_NCELLMEAS_TAC_INDEX, &tmp, 16);
+	err = param_string_get(str, &value, &len);
 	if (err) {
-		goto clean_exit;
+		return err;
 	}
 
-	cells->current_cell.tac = tmp;
-
-	/* Timing advance */
-	err = at_params_int_get(&resp_list, AT_NCELLMEAS_TIMING_ADV_INDEX,
-				&tmp);
+	err = param_string_to_int(value, len, 16, &id);
 	if (err) {
-		goto clean_exit;
+		return err;
 	}
 
-	cells->current_cell.timing_advance = tmp;
+	cell->id = id;
 
-	/* EARFCN */
-	err = at_params_int_get(&resp_list, AT_NCELLMEAS_EARFCN_INDEX,
-				&cells->current_cell.earfcn);
-	if (err) {
-		goto clean_exit;
+	/* PLMN, with a three digits long MCC followed by the MNC. */
+	if (!param_next(str)) {
+		return -EBADMSG;
 	}
 
-	/* Physical cell ID. */
-	err = at_params_short_get(&resp_list, AT_NCELLMEAS_PHYS_CELL_ID_INDEX,
-				&cells->current_cell.phys_cell_id);
-	if (err) {
-		goto clean_exit;
+	err = param_string_get(str, &value, &len);
+	if (err || len <= 3) {
+		return -EBADMSG;
 	}
 
-	/* RSRP */
-	err = at_params_int_get(&resp_list, AT_NCELLMEAS_RSRP_INDEX, &tmp);
+	err = param_string_to_int(value, 3, 10, &cell->mcc);
 	if (err) {
-		goto clean_exit;
+		return err;
 	}
 
-	cells->current_cell.rsrp = tmp;
-
-	/* RSRQ */
-	err = at_params_int_get(&resp_list, AT_NCELLMEAS_RSRQ_INDEX, &tmp);
+	err = param_string_to_int(value + 3, len - 3, 10, &cell->mnc);
 	if (err) {
-		goto clean_exit;
+		return err;
 	}
 
-	cells->current_cell.rsrq = tmp;
+	/* Tracking area code. */
+	if (!param_next(str)) {
+		return -EBADMSG;
+	}
 
-	/* Measurement time. */
-	err = at_params_int64_get(&resp_list, AT_NCELLMEAS_MEASUREMENT_TIME_INDEX,
-				  &cells->current_cell.measurement_time);
+	err = param_string_get(str, &value, &len);
 	if (err) {
-		goto clean_exit;
+		return err;
 	}
 
-	/* Neighbor cell count. */
-	cells->ncells_count = neighborcell_count_get(at_response);
-	if (cells->ncells_count == 0) {
-		return 0;
+	err = param_string_to_int(value, len, 16, &tac);
+	if (err) {
+		return err;
 	}
 
-	/* Neighboring cells. */
-	for (size_t i = 0; i < cells->ncells_count; i++) {
-		size_t start_idx = AT_NCELLMEAS_PRE_NCELLS_PARAMS_COUNT +
-				   i * AT_NCELLMEAS_N_PARAMS_COUNT;
+	cell->tac = tac;
 
-		/* EARFCN */
-		err = at_params_int_get(&resp_list,
-					start_idx + AT_NCELLMEAS_N_EARFCN_INDEX,
-					&cells->neighbor_cells[i].earfcn);
-		if (err) {
-			goto clean_exit;
+	/* Timing advance, EARFCN, physical cell ID, RSRP, RSRQ and
+	 * measurement time, all integers.
+	 */
+	for (size_t i = AT_NCELLMEAS_TIMING_ADV_INDEX;
+	     i <= AT_NCELLMEAS_MEASUREMENT_TIME_INDEX; i++) {
+		if (!param_next(str)) {
+			return -EBADMSG;
 		}
 
-		/* Physical cell ID. */
-		err = at_params_short_get(&resp_list,
-					  start_idx + AT_NCELLMEAS_N_PHYS_CELL_ID_INDEX,
-					  &cells->neighbor_cells[i].phys_cell_id);
+		err = param_int_get(str, &tmp);
 		if (err) {
-			goto clean_exit;
+			return err;
 		}
 
-		/* RSRP */
-		err = at_params_int_get(&resp_list,
-					start_idx + AT_NCELLMEAS_N_RSRP_INDEX,
-					&tmp);
-		if (err) {
-			goto clean_exit;
+		switch (i) {
+		case AT_NCELLMEAS_TIMING_ADV_INDEX:
+			cell->timing_advance = tmp;
+			break;
+		case AT_NCELLMEAS_EARFCN_INDEX:
+			cell->earfcn = tmp;
+			break;
+		case AT_NCELLMEAS_PHYS_CELL_ID_INDEX:
+			cell->phys_cell_id = tmp;
+			break;
+		case AT_NCELLMEAS_RSRP_INDEX:
+			cell->rsrp = tmp;
+			break;
+		case AT_NCELLMEAS_RSRQ_INDEX:
+			cell->rsrq = tmp;
+			break;
+		case AT_NCELLMEAS_MEASUREMENT_TIME_INDEX:
+			cell->measurement_time = tmp;
+			break;
 		}
+	}
 
-		cells->neighbor_cells[i].rsrp = tmp;
+	return 0;
+}
 
-		/* RSRQ */
-		err = at_params_int_get(&resp_list,
-					start_idx + AT_NCELLMEAS_N_RSRQ_INDEX,
-					&tmp);
-		if (err) {
-			goto clean_exit;
+/* Parse the next neighbor cell of a NCELLMEAS notification.
+ * Returns -ENODATA if there are no complete neighbor cells left.
+ */
+static int ncellmeas_ncell_parse(const char **str, struct lte_lc_ncell *ncell)
+{
+	int64_t values[AT_NCELLMEAS_N_PARAMS_COUNT];
+
+	for (size_t i = 0; i < ARRAY_SIZE(values); i++) {
+		if (!param_next(str) || param_int_get(str, &values[i])) {
+			return -ENODATA;
 		}
+	}
 
-		cells->neighbor_cells[i].rsrq = tmp;
+	ncell->earfcn = values[AT_NCELLMEAS_N_EARFCN_INDEX];
+	ncell->phys_cell_id = values[AT_NCELLMEAS_N_PHYS_CELL_ID_INDEX];
+	ncell->rsrp = values[AT_NCELLMEAS_N_RSRP_INDEX];
+	ncell->rsrq = values[AT_NCELLMEAS_N_RSRQ_INDEX];
+	ncell->time_diff = values[AT_NCELLMEAS_N_TIME_DIFF_INDEX];
 
-		/* Time difference. */
-		err = at_params_int_get(&resp_list,
-					start_idx + AT_NCELLMEAS_N_TIME_DIFF_INDEX,
-					&cells->neighbor_cells[i].time_diff);
+	return 0;
+}
+
+int parse_ncellmeas_stream(const char *at_response,
+			   struct lte_lc_cell *current_cell,
+			   ncellmeas_handler_t handler, void *context)
+{
+	int err;
+	int64_t status;
+	const char *str = at_response;
+	struct lte_lc_ncell ncell;
+
+	if (at_response == NULL || current_cell == NULL || handler == NULL) {
+		return -EINVAL;
+	}
+
+	if (strncmp(str, AT_NCELLMEAS_RESPONSE_PREFIX ":",
+		    sizeof(AT_NCELLMEAS_RESPONSE_PREFIX ":") - 1) != 0) {
+		LOG_DBG("Not a valid NCELLMEAS response");
+		return -EBADMSG;
+	}
+
+	str += sizeof(AT_NCELLMEAS_RESPONSE_PREFIX ":") - 1;
+
+	while (*str == ' ') {
+		str++;
+	}
+
+	/* Status code. */
+	err = param_int_get(&str, &status);
+	if (err) {
+		return err;
+	}
+
+	if (status != AT_NCELLMEAS_STATUS_VALUE_SUCCESS) {
+		return 1;
+	}
+
+	err = ncellmeas_current_cell_parse(&str, current_cell);
+	if (err) {
+		return err;
+	}
+
+	/* Neighbor cells, handed over one at a time. A truncated cell at the
+	 * end of the response is ignored.
+	 */
+	while (ncellmeas_ncell_parse(&str, &ncell) == 0) {
+		err = handler(&ncell, context);
 		if (err) {
-			goto clean_exit;
+			return err;
 		}
 	}
 
-	if (incomplete) {
-		err = -E2BIG;
+	return 0;
+}
+
+/* Store neighbor cells in the array of a struct lte_lc_cells_info. */
+struct ncells_array {
+	struct lte_lc_cells_info *cells;
+	size_t ncells_max;
+};
+
+static int ncells_array_put(const struct lte_lc_ncell *ncell, void *context)
+{
+	struct ncells_array *array = context;
+
+	if (array->cells->ncells_count >= array->ncells_max) {
+		return -E2BIG;
 	}
 
-clean_exit:
-	at_params_list_free(&resp_list);
+	array->cells->neighbor_cells[array->cells->ncells_count++] = *ncell;
 
-	return err;
+	return 0;
+}
+
+/* Parse NCELLMEAS notification and put information into struct lte_lc_cells_info.
+ *
+ * Returns 0 on successful cell measurements and population of struct, 1 on
+ * measurement failure, -E2BIG if not all cells were parsed due to memory
+ * limitations, otherwise negative error code.
+ */
+int parse_ncellmeas(const char *at_response, struct lte_lc_cells_info *cells,
+		    size_t ncells_max)
+{
+	struct ncells_array array = {
+		.cells = cells,
+		.ncells_max = ncells_max,
+	};
+
+	cells->ncells_count = 0;
+
+	return parse_ncellmeas_stream(at_response, &cells->current_cell,
+				      ncells_array_put, &array);
 }
 
 int parse_xmodemsleep(const char *at_response, struct lte_lc_modem_sleep *modem_sleep)
 {
 	int err;
 	struct at_param_list resp_list = {0};
+	struct at_param params[AT_XMODEMSLEEP_PARAMS_COUNT_MAX];
 	uint16_t type;
 
 	if (modem_sleep == NULL || at_response == NULL) {
 		return -EINVAL;
 	}
 
-	err = at_params_list_init(&resp_list, AT_XMODEMSLEEP_PARAMS_COUNT_MAX);
+	err = at_params_list_view_init(&resp_list, params,
+				       ARRAY_SIZE(params));
 	if (err) {
 		LOG_ERR("Could not init AT params list, error: %d", err);
 		return err;
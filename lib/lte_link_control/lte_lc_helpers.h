@@ -216,23 +216,44 @@ int parse_cereg(const char *at_response,
  */
 int parse_xt3412(const char *at_response, uint64_t *time);
 
-/* @brief Get the number of neighboring cells reported in an NCELLMEAS response.
+/* @brief Handler of the neighbor cells found by parse_ncellmeas_stream().
  *
- * @param at_response Pointer to buffer with AT response to parse.
+ * @param ncell Neighbor cell, only valid during the call.
+ * @param context Context given to parse_ncellmeas_stream().
  *
- * @return The number of neighbor cells found in the response.
+ * @return Zero to continue parsing, or an error code to stop and return it.
  */
-uint32_t neighborcell_count_get(const char *at_response);
+typedef int (*ncellmeas_handler_t)(const struct lte_lc_ncell *ncell,
+				   void *context);
+
+/* @brief Parses an NCELLMEAS notification in a single pass, without
+ *	  allocating memory, and hands over the neighbor cells one at a time.
+ *
+ * @param at_response Pointer to buffer with AT response.
+ * @param current_cell Pointer to where the current cell is stored.
+ * @param handler Handler called for each neighbor cell.
+ * @param context Context passed to the handler.
+ *
+ * @return Zero on success, 1 on measurement failure, the error returned by
+ *	   the handler, or (negative) error code otherwise.
+ */
+int parse_ncellmeas_stream(const char *at_response,
+			   struct lte_lc_cell *current_cell,
+			   ncellmeas_handler_t handler, void *context);
 
 /* @brief Parses an NCELLMEAS notification and stores neighboring cell
  *	  information in a struct.
  *
  * @param at_response Pointer to buffer with AT response.
- * @param ncell Pointer to ncell structure.
+ * @param cells Pointer to cells structure, with an array of neighbor cells.
+ * @param ncells_max Number of neighbor cells the array can hold.
  *
- * @return Zero on success or (negative) error code otherwise.
+ * @return Zero on success, 1 on measurement failure, -E2BIG if there were
+ *	   more neighbor cells than the array can hold, or (negative) error
+ *	   code otherwise.
  */
-int parse_ncellmeas(const char *at_response, struct lte_lc_cells_info *cells);
+int parse_ncellmeas(const char *at_response, struct lte_lc_cells_info *cells,
+		    size_t ncells_max);
 
 /* @brief Parses an XMODEMSLEEP response and extracts the sleep type and time.
  *
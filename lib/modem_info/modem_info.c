@@ -18,7 +18,9 @@
 #include <zephyr/types.h>
 #include <logging/log.h>
 
-LOG_MODULE_REGISTER(modem_info);
+#include "modem_info_internal.h"
+
+LOG_MODULE_REGISTER(modem_info, CONFIG_MODEM_INFO_LOG_LEVEL);
 
 #define INVALID_DESCRIPTOR	-1
 
@@ -348,7 +350,7 @@ static bool is_cesq_notification(const char *buf, size_t len)
 	return strstr(buf, AT_CMD_CESQ_RESP) ? true : false;
 }
 
-static void flip_iccid_string(char *buf)
+void modem_info_flip_iccid_string(char *buf)
 {
 	uint8_t current_char;
 	uint8_t next_char;
@@ -550,7 +552,7 @@ parse:
 	}
 
 	if (info == MODEM_INFO_ICCID) {
-		flip_iccid_string(buf);
+		modem_info_flip_iccid_string(buf);
 
 		/* Remove padding char from 19 digit (18+1) ICCIDs */
 		if ((len == ICCID_LEN) &&
@@ -636,7 +638,7 @@ int modem_info_rsrp_register(rsrp_cb_t cb)
 {
 	modem_info_rsrp_cb = cb;
 
-	int rc = at_notif_register_handler(NULL,
+	int rc = at_notif_register_prefix_handler(AT_CMD_CESQ_RESP, NULL,
 		modem_info_rsrp_subscribe_handler);
 	if (rc != 0) {
 		LOG_ERR("Can't register handler rc=%d", rc);
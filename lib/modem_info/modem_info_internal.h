@@ -0,0 +1,17 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _MODEM_INFO_INTERNAL_INCLUDE_H_
+#define _MODEM_INFO_INTERNAL_INCLUDE_H_
+
+/**
+ * @brief Swap the digits of each pair of an ICCID read from the SIM.
+ *
+ * @param buf Null-terminated ICCID, with an even number of digits.
+ */
+void modem_info_flip_iccid_string(char *buf);
+
+#endif
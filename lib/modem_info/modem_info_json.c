@@ -13,7 +13,7 @@
 #include <modem/at_params.h>
 #include <logging/log.h>
 
-LOG_MODULE_REGISTER(modem_info_json);
+LOG_MODULE_REGISTER(modem_info_json, CONFIG_MODEM_INFO_LOG_LEVEL);
 
 static int json_add_obj(cJSON *parent, const char *str, cJSON *item)
 {
@@ -11,7 +11,7 @@
 #include <modem/at_params.h>
 #include <logging/log.h>
 
-LOG_MODULE_REGISTER(modem_info_params);
+LOG_MODULE_REGISTER(modem_info_params, CONFIG_MODEM_INFO_LOG_LEVEL);
 
 int modem_info_params_init(struct modem_param_info *modem)
 {
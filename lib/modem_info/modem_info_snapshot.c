@@ -0,0 +1,447 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr.h>
+#include <zephyr/types.h>
+#include <modem/at_cmd.h>
+#include <modem/at_cmd_parser.h>
+#include <modem/at_params.h>
+#include <modem/modem_info.h>
+#include <logging/log.h>
+
+#include "modem_info_internal.h"
+
+LOG_MODULE_REGISTER(modem_info_snapshot, CONFIG_MODEM_INFO_LOG_LEVEL);
+
+#define SNAPSHOT_PARAMS_MAX	10
+#define SNAPSHOT_BANDS_MAX	32
+#define ICCID_LEN		20
+#define ICCID_PAD_CHAR		'F'
+
+#define FIELD(field) MODEM_INFO_SNAPSHOT_FIELD(field)
+
+/* Fields that do not change while the device is running */
+#define STATIC_FIELDS (FIELD(SUP_BAND) | FIELD(FW_VERSION) | FIELD(ICCID) | \
+		       FIELD(IMSI) | FIELD(IMEI))
+
+/* AT command reading one or more fields of a snapshot. The parser returns
+ * the mask of the fields it found in the response.
+ */
+struct snapshot_cmd {
+	const char *cmd;
+	uint32_t fields;
+	uint32_t (*parse)(const struct at_param_list *list,
+			  struct modem_info_snapshot *snapshot);
+};
+
+/* Request of a snapshot command */
+struct snapshot_req {
+	struct at_cmd_req req;
+	const struct snapshot_cmd *cmd;
+};
+
+/* Location of a field in a snapshot, to compare and copy it */
+struct snapshot_member {
+	uint16_t offset;
+	uint16_t size;
+};
+
+#define MEMBER(member) {						       \
+	.offset = offsetof(struct modem_info_snapshot, member),		       \
+	.size = sizeof(((struct modem_info_snapshot *)0)->member),	       \
+}
+
+static const struct snapshot_member members[] = {
+	[MODEM_INFO_SNAPSHOT_CUR_BAND]		= MEMBER(current_band),
+	[MODEM_INFO_SNAPSHOT_UE_MODE]		= MEMBER(ue_mode),
+	[MODEM_INFO_SNAPSHOT_OPERATOR]		= MEMBER(mccmnc),
+	[MODEM_INFO_SNAPSHOT_CELLID]		= MEMBER(cell_id),
+	[MODEM_INFO_SNAPSHOT_AREA_CODE]		= MEMBER(area_code),
+	[MODEM_INFO_SNAPSHOT_IP_ADDRESS]	= MEMBER(ip_address),
+	[MODEM_INFO_SNAPSHOT_APN]		= MEMBER(apn),
+	[MODEM_INFO_SNAPSHOT_SYSTEM_MODE]	= MEMBER(system_mode),
+	[MODEM_INFO_SNAPSHOT_UICC]		= MEMBER(uicc),
+	[MODEM_INFO_SNAPSHOT_BATTERY]		= MEMBER(battery),
+	[MODEM_INFO_SNAPSHOT_DATE_TIME]		= MEMBER(date_time),
+	[MODEM_INFO_SNAPSHOT_SUP_BAND]		= MEMBER(sup_bands),
+	[MODEM_INFO_SNAPSHOT_FW_VERSION]	= MEMBER(modem_fw),
+	[MODEM_INFO_SNAPSHOT_ICCID]		= MEMBER(iccid),
+	[MODEM_INFO_SNAPSHOT_IMSI]		= MEMBER(imsi),
+	[MODEM_INFO_SNAPSHOT_IMEI]		= MEMBER(imei),
+};
+
+BUILD_ASSERT(ARRAY_SIZE(members) == MODEM_INFO_SNAPSHOT_FIELD_COUNT,
+	     "Location of some snapshot fields is missing");
+BUILD_ASSERT(MODEM_INFO_SNAPSHOT_FIELD_COUNT <= 32,
+	     "Snapshot fields do not fit in a mask");
+
+/* Copy a string parameter, truncated and zero-padded to the destination */
+static bool string_copy(const struct at_param_list *list, size_t index,
+			char *buf, size_t size)
+{
+	const char *str;
+	size_t len;
+
+	if (at_params_string_ptr_get(list, index, &str, &len)) {
+		return false;
+	}
+
+	len = MIN(len, size - 1);
+	memcpy(buf, str, len);
+	memset(buf + len, 0, size - len);
+
+	return len > 0;
+}
+
+/* Get a string parameter holding a hexadecimal number */
+static bool hex_get(const struct at_param_list *list, size_t index,
+		    uint32_t *value)
+{
+	char buf[sizeof("FFFFFFFF")];
+	char *end;
+
+	if (!string_copy(list, index, buf, sizeof(buf))) {
+		return false;
+	}
+
+	*value = strtoul(buf, &end, 16);
+
+	return *end == '\0';
+}
+
+static bool u8_get(const struct at_param_list *list, size_t index,
+		   uint8_t *value)
+{
+	uint16_t tmp;
+
+	if (at_params_unsigned_short_get(list, index, &tmp) || tmp > UINT8_MAX) {
+		return false;
+	}
+
+	*value = tmp;
+
+	return true;
+}
+
+static uint32_t current_band_parse(const struct at_param_list *list,
+				   struct modem_info_snapshot *snapshot)
+{
+	return u8_get(list, 1, &snapshot->current_band) ? FIELD(CUR_BAND) : 0;
+}
+
+static uint32_t ue_mode_parse(const struct at_param_list *list,
+			      struct modem_info_snapshot *snapshot)
+{
+	return u8_get(list, 1, &snapshot->ue_mode) ? FIELD(UE_MODE) : 0;
+}
+
+static uint32_t operator_parse(const struct at_param_list *list,
+			       struct modem_info_snapshot *snapshot)
+{
+	return string_copy(list, 3, snapshot->mccmnc,
+			   sizeof(snapshot->mccmnc)) ? FIELD(OPERATOR) : 0;
+}
+
+static uint32_t network_status_parse(const struct at_param_list *list,
+				     struct modem_info_snapshot *snapshot)
+{
+	uint32_t fields = 0;
+	uint32_t value;
+
+	if (hex_get(list, 3, &value) && value <= UINT16_MAX) {
+		snapshot->area_code = value;
+		fields |= FIELD(AREA_CODE);
+	}
+
+	if (hex_get(list, 4, &value)) {
+		snapshot->cell_id = value;
+		fields |= FIELD(CELLID);
+	}
+
+	return fields;
+}
+
+static uint32_t pdp_context_parse(const struct at_param_list *list,
+				  struct modem_info_snapshot *snapshot)
+{
+	uint32_t fields = 0;
+	char *ipv6;
+
+	/* Only the first PDP context is parsed */
+	if (string_copy(list, 3, snapshot->apn, sizeof(snapshot->apn))) {
+		fields |= FIELD(APN);
+	}
+
+	if (string_copy(list, 4, snapshot->ip_address,
+			sizeof(snapshot->ip_address))) {
+		/* Keep the IPv4 address, the IPv6 one follows a space */
+		ipv6 = strchr(snapshot->ip_address, ' ');
+		if (ipv6) {
+			memset(ipv6, 0, sizeof(snapshot->ip_address) -
+					(ipv6 - snapshot->ip_address));
+		}
+		fields |= FIELD(IP_ADDRESS);
+	}
+
+	return fields;
+}
+
+static uint32_t system_mode_parse(const struct at_param_list *list,
+				  struct modem_info_snapshot *snapshot)
+{
+	uint16_t mode;
+
+	snapshot->system_mode = 0;
+
+	for (size_t i = 0; i < 3; i++) {
+		if (at_params_unsigned_short_get(list, i + 1, &mode)) {
+			return 0;
+		}
+
+		if (mode) {
+			snapshot->system_mode |= BIT(i);
+		}
+	}
+
+	return FIELD(SYSTEM_MODE);
+}
+
+static uint32_t uicc_parse(const struct at_param_list *list,
+			   struct modem_info_snapshot *snapshot)
+{
+	return u8_get(list, 1, &snapshot->uicc) ? FIELD(UICC) : 0;
+}
+
+static uint32_t battery_parse(const struct at_param_list *list,
+			      struct modem_info_snapshot *snapshot)
+{
+	return at_params_unsigned_short_get(list, 1, &snapshot->battery) ?
+	       0 : FIELD(BATTERY);
+}
+
+static uint32_t date_time_parse(const struct at_param_list *list,
+				struct modem_info_snapshot *snapshot)
+{
+	return string_copy(list, 1, snapshot->date_time,
+			   sizeof(snapshot->date_time)) ? FIELD(DATE_TIME) : 0;
+}
+
+static uint32_t supported_bands_parse(const struct at_param_list *list,
+				      struct modem_info_snapshot *snapshot)
+{
+	uint32_t bands[SNAPSHOT_BANDS_MAX];
+	size_t len = sizeof(bands);
+
+	if (at_params_array_get(list, 1, bands, &len)) {
+		return 0;
+	}
+
+	memset(snapshot->sup_bands, 0, sizeof(snapshot->sup_bands));
+
+	for (size_t i = 0; i < len / sizeof(bands[0]); i++) {
+		if (bands[i] <= MODEM_INFO_SNAPSHOT_BAND_MAX) {
+			snapshot->sup_bands[bands[i] / 8] |= BIT(bands[i] % 8);
+		}
+	}
+
+	return FIELD(SUP_BAND);
+}
+
+static uint32_t fw_version_parse(const struct at_param_list *list,
+				 struct modem_info_snapshot *snapshot)
+{
+	return string_copy(list, 0, snapshot->modem_fw,
+			   sizeof(snapshot->modem_fw)) ? FIELD(FW_VERSION) : 0;
+}
+
+static uint32_t iccid_parse(const struct at_param_list *list,
+			    struct modem_info_snapshot *snapshot)
+{
+	if (!string_copy(list, 3, snapshot->iccid, sizeof(snapshot->iccid))) {
+		return 0;
+	}
+
+	modem_info_flip_iccid_string(snapshot->iccid);
+
+	/* Remove padding char from 19 digit (18+1) ICCIDs */
+	if (snapshot->iccid[ICCID_LEN - 1] == ICCID_PAD_CHAR) {
+		snapshot->iccid[ICCID_LEN - 1] = '\0';
+	}
+
+	return FIELD(ICCID);
+}
+
+static uint32_t imsi_parse(const struct at_param_list *list,
+			   struct modem_info_snapshot *snapshot)
+{
+	return string_copy(list, 0, snapshot->imsi,
+			   sizeof(snapshot->imsi)) ? FIELD(IMSI) : 0;
+}
+
+static uint32_t imei_parse(const struct at_param_list *list,
+			   struct modem_info_snapshot *snapshot)
+{
+	return string_copy(list, 0, snapshot->imei,
+			   sizeof(snapshot->imei)) ? FIELD(IMEI) : 0;
+}
+
+/* Each command is sent once, even if it reads several fields */
+static const struct snapshot_cmd snapshot_cmds[] = {
+	{ "AT%XCBAND", FIELD(CUR_BAND), current_band_parse },
+	{ "AT+CEMODE?", FIELD(UE_MODE), ue_mode_parse },
+	{ "AT+COPS?", FIELD(OPERATOR), operator_parse },
+	{ "AT+CEREG?", FIELD(AREA_CODE) | FIELD(CELLID),
+	  network_status_parse },
+	{ "AT+CGDCONT?", FIELD(APN) | FIELD(IP_ADDRESS), pdp_context_parse },
+	{ "AT%XSYSTEMMODE?", FIELD(SYSTEM_MODE), system_mode_parse },
+	{ "AT%XSIM?", FIELD(UICC), uicc_parse },
+	{ "AT%XVBAT", FIELD(BATTERY), battery_parse },
+	{ "AT+CCLK?", FIELD(DATE_TIME), date_time_parse },
+	{ "AT%XCBAND=?", FIELD(SUP_BAND), supported_bands_parse },
+	{ "AT+CGMR", FIELD(FW_VERSION), fw_version_parse },
+	{ "AT+CRSM=176,12258,0,0,10", FIELD(ICCID), iccid_parse },
+	{ "AT+CIMI", FIELD(IMSI), imsi_parse },
+	{ "AT+CGSN", FIELD(IMEI), imei_parse },
+};
+
+static K_MUTEX_DEFINE(snapshot_mutex);
+static K_SEM_DEFINE(snapshot_sem, 0, ARRAY_SIZE(snapshot_cmds));
+
+static struct snapshot_req reqs[ARRAY_SIZE(snapshot_cmds)];
+
+/* Values read by the requests. The static fields are kept between calls. */
+static struct modem_info_snapshot values;
+/* Fields read by the current call, only accessed from at_cmd's thread while
+ * requests are pending.
+ */
+static uint32_t read_fields;
+/* Static fields already read */
+static uint32_t cached_fields;
+
+/* Parameters of the response being parsed. Responses are parsed one at a
+ * time, from at_cmd's thread.
+ */
+static struct at_param params[SNAPSHOT_PARAMS_MAX];
+static struct at_param_list param_list;
+
+static void snapshot_req_complete(struct at_cmd_req *req, const char *response)
+{
+	struct snapshot_req *snapshot_req =
+		CONTAINER_OF(req, struct snapshot_req, req);
+	const struct snapshot_cmd *cmd = snapshot_req->cmd;
+	int err;
+
+	if (req->code != 0 || response == NULL) {
+		LOG_WRN("%s failed: %d", log_strdup(cmd->cmd), req->code);
+		goto done;
+	}
+
+	/* Only the first line is parsed, and the parameters past the list
+	 * are not needed.
+	 */
+	err = at_parser_max_params_from_str(response, NULL, &param_list,
+					    SNAPSHOT_PARAMS_MAX);
+	if (err && err != -EAGAIN && err != -E2BIG) {
+		LOG_WRN("Unable to parse response of %s: %d",
+			log_strdup(cmd->cmd), err);
+		goto done;
+	}
+
+	read_fields |= cmd->parse(&param_list, &values) & cmd->fields;
+
+done:
+	k_sem_give(&snapshot_sem);
+}
+
+/* Update a snapshot with the fields read, and flag those that changed */
+static void snapshot_update(struct modem_info_snapshot *snapshot,
+			    uint32_t fields)
+{
+	snapshot->changed = 0;
+
+	for (size_t i = 0; i < MODEM_INFO_SNAPSHOT_FIELD_COUNT; i++) {
+		uint8_t *dst = (uint8_t *)snapshot + members[i].offset;
+		const uint8_t *src = (const uint8_t *)&values + members[i].offset;
+
+		if (!(fields & BIT(i))) {
+			continue;
+		}
+
+		if (!(snapshot->present & BIT(i)) ||
+		    memcmp(dst, src, members[i].size) != 0) {
+			memcpy(dst, src, members[i].size);
+			snapshot->changed |= BIT(i);
+		}
+	}
+
+	snapshot->present |= fields;
+}
+
+int modem_info_snapshot_get(struct modem_info_snapshot *snapshot,
+			    uint32_t fields)
+{
+	int err;
+	size_t pending = 0;
+	uint32_t requested;
+
+	if (snapshot == NULL) {
+		return -EINVAL;
+	}
+
+	fields &= MODEM_INFO_SNAPSHOT_ALL;
+
+	k_mutex_lock(&snapshot_mutex, K_FOREVER);
+
+	if (param_list.params == NULL) {
+		at_params_list_view_init(&param_list, params,
+					 SNAPSHOT_PARAMS_MAX);
+	}
+
+	read_fields = 0;
+	requested = fields & ~cached_fields;
+
+	/* Queue all the commands at once, the modem runs them back to back */
+	for (size_t i = 0; i < ARRAY_SIZE(snapshot_cmds); i++) {
+		if (!(snapshot_cmds[i].fields & requested)) {
+			continue;
+		}
+
+		reqs[i] = (struct snapshot_req){
+			.req = {
+				.cmd = snapshot_cmds[i].cmd,
+				.callback = snapshot_req_complete,
+			},
+			.cmd = &snapshot_cmds[i],
+		};
+
+		err = at_cmd_write_async(&reqs[i].req);
+		if (err) {
+			LOG_ERR("Unable to send %s: %d",
+				log_strdup(snapshot_cmds[i].cmd), err);
+			continue;
+		}
+
+		pending++;
+	}
+
+	while (pending--) {
+		k_sem_take(&snapshot_sem, K_FOREVER);
+	}
+
+	cached_fields |= read_fields & STATIC_FIELDS;
+
+	read_fields = (read_fields | cached_fields) & fields;
+	snapshot_update(snapshot, read_fields);
+
+	err = (read_fields == fields) ? 0 : -EAGAIN;
+
+	k_mutex_unlock(&snapshot_mutex);
+
+	return err;
+}
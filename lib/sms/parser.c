@@ -15,24 +15,26 @@
 
 LOG_MODULE_DECLARE(sms, CONFIG_SMS_LOG_LEVEL);
 
-int parser_create(struct parser *parser, struct parser_api *api)
+int parser_create(struct parser *parser, struct parser_api *api, void *data, size_t data_size)
 {
 	memset(parser, 0, sizeof(struct parser));
 
-	parser->api = api;
-
-	parser->data = k_calloc(1, api->data_size());
-	if (parser->data == NULL) {
-		LOG_ERR("Out of memory when creating parser");
+	if (data_size < api->data_size()) {
+		LOG_ERR("Parser data buffer too small (%d < %d)",
+			(int)data_size, (int)api->data_size());
 		return -ENOMEM;
 	}
 
+	memset(data, 0, data_size);
+
+	parser->api = api;
+	parser->data = data;
+
 	return 0;
 }
 
 int parser_delete(struct parser *parser)
 {
-	k_free(parser->data);
 	parser->data = NULL;
 
 	return 0;
@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
  */
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -77,17 +78,24 @@ struct parser {
 /**
  * @brief Parser instance creation.
  *
+ * @details The parser stores the parsed information in the given data buffer, so that
+ * no memory is allocated for each parsed message.
+ *
  * @param[in] parser Parser instance.
  * @param[in] api Parser API functions.
+ * @param[in] data Buffer to hold the parsed information.
+ * @param[in] data_size Size of the data buffer, at least the size returned by
+ *                      the data_size function of the parser API.
  *
+ * @retval -ENOMEM The data buffer is too small.
  * @return Zero if successful, negative value in error cases.
  */
-int parser_create(struct parser *parser, struct parser_api *api);
+int parser_create(struct parser *parser, struct parser_api *api, void *data, size_t data_size);
 
 /**
  * @brief Parser instance deletion.
  *
- * @details This function will destroy a parser instance and free up any memory used.
+ * @details This function will destroy a parser instance and release its data buffer.
  *
  * @param[in] parser Parser instance.
  *
@@ -18,6 +18,7 @@
 #include "sms_deliver.h"
 #include "sms_at.h"
 #include "sms_internal.h"
+#include "sms_reassembly.h"
 
 LOG_MODULE_REGISTER(sms, CONFIG_SMS_LOG_LEVEL);
 
@@ -36,6 +37,9 @@ LOG_MODULE_REGISTER(sms, CONFIG_SMS_LOG_LEVEL);
 /** @brief AT command to an ACK in PDU mode. */
 #define AT_SMS_PDU_ACK "AT+CNMA=1"
 
+/** @brief Names of the AT notifications carrying SMS messages. */
+static const char *const sms_notifs[] = { "+CMT", "+CDS" };
+
 /** @brief SMS structure where received SMS is parsed. */
 static struct sms_data sms_data_info;
 
@@ -48,6 +52,7 @@ static struct k_work sms_ack_work;
  * initialization in various places of the code.
  */
 static struct at_param_list resp_list;
+static struct at_param resp_params[AT_SMS_PARAMS_COUNT_MAX];
 
 /* Reserving internal temporary buffers that are used for various functions requiring memory. */
 uint8_t sms_buf_tmp[SMS_BUF_TMP_LEN];
@@ -106,12 +111,19 @@ void sms_at_handler(void *context, const char *at_notif)
 		return;
 	}
 
+	/* Parts of concatenated messages are delivered once all are received. */
+	if (IS_ENABLED(CONFIG_SMS_REASSEMBLY)) {
+		err = sms_reassembly_put(&sms_data_info);
+	}
+
 	/* Notify all subscribers. */
-	LOG_DBG("Valid SMS notification decoded");
-	for (size_t i = 0; i < ARRAY_SIZE(subscribers); i++) {
-		if (subscribers[i].listener != NULL) {
-			subscribers[i].listener(
-				&sms_data_info, subscribers[i].ctx);
+	if (err == 0) {
+		LOG_DBG("Valid SMS notification decoded");
+		for (size_t i = 0; i < ARRAY_SIZE(subscribers); i++) {
+			if (subscribers[i].listener != NULL) {
+				subscribers[i].listener(
+					&sms_data_info, subscribers[i].ctx);
+			}
 		}
 	}
 
@@ -121,6 +133,32 @@ void sms_at_handler(void *context, const char *at_notif)
 	k_work_submit(&sms_ack_work);
 }
 
+/** @brief De-register the handler of SMS notifications. */
+static void sms_at_handler_deregister(void)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(sms_notifs); i++) {
+		(void)at_notif_deregister_prefix_handler(sms_notifs[i], NULL,
+							 sms_at_handler);
+	}
+}
+
+/** @brief Register the handler of SMS notifications. */
+static int sms_at_handler_register(void)
+{
+	int ret;
+
+	for (size_t i = 0; i < ARRAY_SIZE(sms_notifs); i++) {
+		ret = at_notif_register_prefix_handler(sms_notifs[i], NULL,
+						       sms_at_handler);
+		if (ret) {
+			sms_at_handler_deregister();
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
 /**
  * @brief Initialize the SMS subscriber module.
  *
@@ -134,7 +172,9 @@ static int sms_init(void)
 
 	k_work_init(&sms_ack_work, &sms_ack);
 
-	ret = at_params_list_init(&resp_list, AT_SMS_PARAMS_COUNT_MAX);
+	/* Parameters refer to the parsed notification, without copies */
+	ret = at_params_list_view_init(&resp_list, resp_params,
+				       ARRAY_SIZE(resp_params));
 	if (ret) {
 		LOG_ERR("AT params error, err: %d", ret);
 		return ret;
@@ -174,7 +214,7 @@ static int sms_init(void)
 	}
 
 	/* Register for AT commands notifications before creating the client. */
-	ret = at_notif_register_handler(NULL, sms_at_handler);
+	ret = sms_at_handler_register();
 	if (ret) {
 		LOG_ERR("Cannot register AT notification handler, err: %d",
 			ret);
@@ -184,7 +224,7 @@ static int sms_init(void)
 	/* Register this module as an SMS client. */
 	ret = at_cmd_write(AT_SMS_SUBSCRIBER_REGISTER, NULL, 0, NULL);
 	if (ret) {
-		(void)at_notif_deregister_handler(NULL, sms_at_handler);
+		sms_at_handler_deregister();
 		LOG_ERR("Unable to register a new SMS client, err: %d", ret);
 		return ret;
 	}
@@ -270,7 +310,7 @@ static void sms_uninit(void)
 		LOG_DBG("SMS client unregistered");
 
 		/* Unregister from AT commands notifications. */
-		(void)at_notif_deregister_handler(NULL, sms_at_handler);
+		sms_at_handler_deregister();
 
 		/* Clear all observers. */
 		for (size_t i = 0; i < ARRAY_SIZE(subscribers); i++) {
@@ -282,6 +322,10 @@ static void sms_uninit(void)
 	/* Cleanup resources. */
 	at_params_list_free(&resp_list);
 
+	if (IS_ENABLED(CONFIG_SMS_REASSEMBLY)) {
+		sms_reassembly_reset();
+	}
+
 	sms_client_registered = false;
 }
 
@@ -23,6 +23,9 @@ LOG_MODULE_DECLARE(sms, CONFIG_SMS_LOG_LEVEL);
 /** @brief Length of TP-Service-Centre-Time-Stamp field. */
 #define SCTS_FIELD_SIZE 7
 
+/** @brief Maximum length of TP-User-Data in octets, as specified in 3GPP TS 23.040 Section 9.2.3.24. */
+#define SMS_MAX_UD_LEN_OCTETS 140
+
 /**
  * @brief User Data Header Information Element:
  *        Concatenated short messages, 8-bit reference number.
@@ -682,6 +685,12 @@ static int decode_pdu_ud_8bit(struct parser *parser, uint8_t *buf)
 	uint32_t actual_data_length =
 		MIN(parser->buf_size - parser->payload_pos, pdata->udl - pdata->udhl);
 
+	if (pdata->udl - pdata->udhl > SMS_MAX_UD_LEN_OCTETS) {
+		LOG_ERR("User Data Length exceeds maximum number of octets (%d) in SMS spec",
+			SMS_MAX_UD_LEN_OCTETS);
+		return -EMSGSIZE;
+	}
+
 	__ASSERT(parser->buf_size >= parser->payload_pos,
 		"Data length smaller than data iterator");
 	__ASSERT(actual_data_length <= parser->payload_buf_size,
@@ -692,6 +701,43 @@ static int decode_pdu_ud_8bit(struct parser *parser, uint8_t *buf)
 	return actual_data_length;
 }
 
+/**
+ * @brief Decode user data for UCS2 data coding scheme.
+ *
+ * @details This will decode the user data from UCS2, specified in 3GPP TS 23.038 Section 6.2.3,
+ * into UTF-8 so that the payload can be treated as string like for the other coding schemes.
+ *
+ * User Data Header is also taken into account as specified in 3GPP TS 23.040 Section 9.2.3.24.
+ *
+ * @param[in,out] parser Parser instance.
+ * @param[in] buf Buffer containing PDU and pointing to this field.
+ *
+ * @return Number of parsed bytes.
+ */
+static int decode_pdu_ud_ucs2(struct parser *parser, uint8_t *buf)
+{
+	struct pdu_deliver_data * const pdata = parser->data;
+	/* Data length to be used is the minimum from the remaining bytes in the input buffer and
+	 * length indicated by User-Data-Length taking into account User-Data-Header-Length.
+	 */
+	uint32_t actual_data_length =
+		MIN(parser->buf_size - parser->payload_pos, pdata->udl - pdata->udhl);
+
+	/* 140 octets of UCS2 take up to 210 bytes in UTF-8 */
+	if (pdata->udl - pdata->udhl > SMS_MAX_UD_LEN_OCTETS) {
+		LOG_ERR("User Data Length exceeds maximum number of octets (%d) in SMS spec",
+			SMS_MAX_UD_LEN_OCTETS);
+		return -EMSGSIZE;
+	}
+
+	__ASSERT(parser->buf_size >= parser->payload_pos,
+		"Data length smaller than data iterator");
+	__ASSERT(actual_data_length * 3 / 2 <= parser->payload_buf_size,
+		"UCS2 User-Data-Length shorter than output buffer");
+
+	return (int)string_conversion_ucs2_to_utf8(buf, parser->payload, actual_data_length);
+}
+
 /**
  * @brief Decode user data for SMS-DELIVER message based on data coding scheme.
  *
@@ -712,6 +758,8 @@ static int decode_pdu_deliver_message(struct parser *parser, uint8_t *buf)
 		return decode_pdu_ud_7bit(parser, buf);
 	case 1:
 		return decode_pdu_ud_8bit(parser, buf);
+	case 2:
+		return decode_pdu_ud_ucs2(parser, buf);
 	default:
 		return -ENOTSUP;
 	};
@@ -818,6 +866,7 @@ void *sms_deliver_get_api(void)
 int sms_deliver_pdu_parse(const char *pdu, struct sms_data *data)
 {
 	static struct parser sms_deliver;
+	static struct pdu_deliver_data sms_deliver_data;
 	struct sms_deliver_header *header;
 	int err = 0;
 
@@ -829,7 +878,8 @@ int sms_deliver_pdu_parse(const char *pdu, struct sms_data *data)
 	__ASSERT(header != NULL, "Parameter 'header' cannot be NULL.");
 	memset(header, 0, sizeof(struct sms_deliver_header));
 
-	err = parser_create(&sms_deliver, sms_deliver_get_api());
+	err = parser_create(&sms_deliver, sms_deliver_get_api(),
+			    &sms_deliver_data, sizeof(sms_deliver_data));
 	if (err) {
 		return err;
 	}
@@ -844,7 +894,7 @@ int sms_deliver_pdu_parse(const char *pdu, struct sms_data *data)
 
 	data->payload_len = parser_get_payload(&sms_deliver,
 					  data->payload,
-					  SMS_MAX_PAYLOAD_LEN_CHARS);
+					  SMS_MAX_PAYLOAD_LEN_BYTES);
 
 	if (data->payload_len < 0) {
 		LOG_ERR("Getting sms deliver payload failed: %d\n",
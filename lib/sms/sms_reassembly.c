@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <string.h>
+#include <zephyr.h>
+#include <sys/util.h>
+#include <modem/sms.h>
+#include <logging/log.h>
+
+#include "sms_reassembly.h"
+
+LOG_MODULE_DECLARE(sms, CONFIG_SMS_LOG_LEVEL);
+
+#define PARTS_MAX CONFIG_SMS_REASSEMBLY_PARTS_MAX
+#define TIMEOUT_MS (CONFIG_SMS_REASSEMBLY_TIMEOUT * MSEC_PER_SEC)
+
+/* The last part of a message is reassembled in place, without a segment. */
+BUILD_ASSERT(CONFIG_SMS_REASSEMBLY_SEGMENTS >= PARTS_MAX - 1,
+	     "Not enough segments for the parts of one message");
+BUILD_ASSERT(CONFIG_SMS_REASSEMBLY_SEGMENTS < UINT8_MAX,
+	     "Segment index does not fit into uint8_t");
+
+/** @brief Decoded payload of one part of a concatenated message. */
+struct sms_segment {
+	/** @brief Indicates whether the segment holds a part. */
+	bool in_use;
+	/** @brief Length of the payload. */
+	uint8_t len;
+	/** @brief Payload decoded into ASCII or UTF-8, or 8 bit data. */
+	uint8_t payload[SMS_MAX_PAYLOAD_LEN_BYTES];
+};
+
+/** @brief Concatenated message being reassembled. */
+struct sms_reassembly_msg {
+	/** @brief Indicates whether the message is being reassembled. */
+	bool in_use;
+	/** @brief Uptime in milliseconds when the first part was received. */
+	int64_t started;
+	/**
+	 * @brief Header of the first part, or of the first received part until
+	 * the first part is received. Originating address and concatenated
+	 * message reference number and count identify the message.
+	 */
+	struct sms_deliver_header header;
+	/** @brief Bitmask of the received parts, bit 0 for sequence number 1. */
+	uint32_t received;
+	/** @brief Index of the segment holding each received part. */
+	uint8_t segments[PARTS_MAX];
+};
+
+static struct sms_segment segments[CONFIG_SMS_REASSEMBLY_SEGMENTS];
+static struct sms_reassembly_msg msgs[CONFIG_SMS_REASSEMBLY_MSGS_MAX];
+
+static void msg_drop(struct sms_reassembly_msg *msg)
+{
+	for (size_t i = 0; i < msg->header.concatenated.total_msgs; i++) {
+		if (msg->received & BIT(i)) {
+			segments[msg->segments[i]].in_use = false;
+		}
+	}
+
+	msg->in_use = false;
+}
+
+/** @brief Drop the messages whose reassembly has timed out. */
+static void msgs_expire(int64_t now)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(msgs); i++) {
+		if (msgs[i].in_use && now - msgs[i].started >= TIMEOUT_MS) {
+			LOG_WRN("Concatenated message %d timed out",
+				msgs[i].header.concatenated.ref_number);
+			msg_drop(&msgs[i]);
+		}
+	}
+}
+
+/** @brief Find the oldest message being reassembled, other than the given one. */
+static struct sms_reassembly_msg *msg_oldest(const struct sms_reassembly_msg *except)
+{
+	struct sms_reassembly_msg *oldest = NULL;
+
+	for (size_t i = 0; i < ARRAY_SIZE(msgs); i++) {
+		if (!msgs[i].in_use || &msgs[i] == except) {
+			continue;
+		}
+
+		if (oldest == NULL || msgs[i].started < oldest->started) {
+			oldest = &msgs[i];
+		}
+	}
+
+	return oldest;
+}
+
+static struct sms_reassembly_msg *msg_find(const struct sms_deliver_header *header)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(msgs); i++) {
+		const struct sms_deliver_header *key = &msgs[i].header;
+
+		if (msgs[i].in_use &&
+		    key->concatenated.ref_number == header->concatenated.ref_number &&
+		    key->concatenated.total_msgs == header->concatenated.total_msgs &&
+		    strcmp(key->originating_address.address_str,
+			   header->originating_address.address_str) == 0) {
+			return &msgs[i];
+		}
+	}
+
+	return NULL;
+}
+
+static struct sms_reassembly_msg *msg_alloc(const struct sms_deliver_header *header,
+					    int64_t now)
+{
+	struct sms_reassembly_msg *msg = NULL;
+
+	for (size_t i = 0; i < ARRAY_SIZE(msgs); i++) {
+		if (!msgs[i].in_use) {
+			msg = &msgs[i];
+			break;
+		}
+	}
+
+	if (msg == NULL) {
+		msg = msg_oldest(NULL);
+		LOG_WRN("Too many concatenated messages, dropping message %d",
+			msg->header.concatenated.ref_number);
+		msg_drop(msg);
+	}
+
+	msg->in_use = true;
+	msg->started = now;
+	msg->header = *header;
+	msg->received = 0;
+
+	return msg;
+}
+
+/** @brief Allocate a segment for a part of the given message, dropping other messages if needed. */
+static struct sms_segment *segment_alloc(const struct sms_reassembly_msg *msg, uint8_t *index)
+{
+	struct sms_reassembly_msg *oldest;
+
+	while (true) {
+		for (size_t i = 0; i < ARRAY_SIZE(segments); i++) {
+			if (!segments[i].in_use) {
+				segments[i].in_use = true;
+				*index = i;
+				return &segments[i];
+			}
+		}
+
+		oldest = msg_oldest(msg);
+		if (oldest == NULL) {
+			return NULL;
+		}
+
+		LOG_WRN("Out of segments, dropping concatenated message %d",
+			oldest->header.concatenated.ref_number);
+		msg_drop(oldest);
+	}
+}
+
+/**
+ * @brief Reassemble a message into the payload of its last received part.
+ *
+ * @details The buffered parts are copied around the last part, which is first moved
+ * to its place in the payload buffer.
+ */
+static void msg_reassemble(struct sms_reassembly_msg *msg, struct sms_data *data)
+{
+	uint8_t last = data->header.deliver.concatenated.seq_number - 1;
+	uint8_t total = msg->header.concatenated.total_msgs;
+	size_t offset = 0;
+
+	for (size_t i = 0; i < last; i++) {
+		offset += segments[msg->segments[i]].len;
+	}
+
+	memmove(&data->payload[offset], data->payload, data->payload_len);
+
+	offset = 0;
+	for (size_t i = 0; i < total; i++) {
+		const struct sms_segment *segment = &segments[msg->segments[i]];
+
+		if (i == last) {
+			offset += data->payload_len;
+			continue;
+		}
+
+		memcpy(&data->payload[offset], segment->payload, segment->len);
+		offset += segment->len;
+	}
+
+	data->payload[offset] = '\0';
+	data->payload_len = offset;
+
+	if (last != 0) {
+		data->header.deliver = msg->header;
+	}
+	data->header.deliver.concatenated.seq_number = 0;
+
+	LOG_DBG("Concatenated message %d reassembled from %d parts, length %d",
+		msg->header.concatenated.ref_number, total, data->payload_len);
+
+	msg_drop(msg);
+}
+
+int sms_reassembly_put(struct sms_data *data)
+{
+	struct sms_deliver_header *header = &data->header.deliver;
+	const struct sms_udh_concat *concat = &header->concatenated;
+	struct sms_reassembly_msg *msg;
+	struct sms_segment *segment;
+	int64_t now;
+	uint32_t part;
+
+	if (data->type != SMS_TYPE_DELIVER || !concat->present || concat->total_msgs == 1) {
+		return 0;
+	}
+
+	if (concat->total_msgs > PARTS_MAX) {
+		LOG_WRN("Concatenated message %d has too many parts (%d) to reassemble",
+			concat->ref_number, concat->total_msgs);
+		return 0;
+	}
+
+	now = k_uptime_get();
+	part = BIT(concat->seq_number - 1);
+
+	msgs_expire(now);
+
+	msg = msg_find(header);
+	if (msg == NULL) {
+		msg = msg_alloc(header, now);
+	} else if (msg->received & part) {
+		LOG_DBG("Duplicate part %d of concatenated message %d",
+			concat->seq_number, concat->ref_number);
+		return -EAGAIN;
+	}
+
+	if ((msg->received | part) == BIT_MASK(concat->total_msgs)) {
+		msg_reassemble(msg, data);
+		return 0;
+	}
+
+	segment = segment_alloc(msg, &msg->segments[concat->seq_number - 1]);
+	if (segment == NULL) {
+		/* Not reached, there are segments for all parts of one message */
+		msg_drop(msg);
+		return -EAGAIN;
+	}
+
+	segment->len = data->payload_len;
+	memcpy(segment->payload, data->payload, data->payload_len);
+
+	msg->received |= part;
+	if (concat->seq_number == 1) {
+		msg->header = *header;
+	}
+
+	LOG_DBG("Part %d/%d of concatenated message %d buffered",
+		concat->seq_number, concat->total_msgs, concat->ref_number);
+
+	return -EAGAIN;
+}
+
+void sms_reassembly_reset(void)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(msgs); i++) {
+		if (msgs[i].in_use) {
+			msg_drop(&msgs[i]);
+		}
+	}
+}
@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _SMS_REASSEMBLY_INCLUDE_H_
+#define _SMS_REASSEMBLY_INCLUDE_H_
+
+/* Forward declaration */
+struct sms_data;
+
+/**
+ * @brief Reassemble a received SMS message if it is a part of a concatenated message.
+ *
+ * @details Parts are buffered until all parts of their message have been received.
+ * The last received part is then replaced with the reassembled message, whose
+ * header is the header of the first part with a zero sequence number.
+ *
+ * Messages that are not concatenated, or have more parts than can be reassembled,
+ * are left as they are.
+ *
+ * @param[in,out] data Decoded SMS message.
+ *
+ * @retval -EAGAIN The message is a buffered or duplicate part and shall not be
+ *                 delivered to the listeners.
+ * @return Zero if the message shall be delivered to the listeners.
+ */
+int sms_reassembly_put(struct sms_data *data);
+
+/**
+ * @brief Drop all messages being reassembled.
+ */
+void sms_reassembly_reset(void);
+
+#endif
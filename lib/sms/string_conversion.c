@@ -14,6 +14,11 @@
 #define STR_7BIT_CODE_MASK      0x7F
 #define STR_7BIT_ESCAPE_CODE    0x1B
 
+#define STR_UTF16_HIGH_SURROGATE     0xD800
+#define STR_UTF16_LOW_SURROGATE      0xDC00
+#define STR_UTF16_SURROGATE_END      0xDFFF
+#define STR_UNICODE_REPLACEMENT_CHAR 0xFFFD
+
 /**
  * @brief Conversion table from ASCII (with ISO-8859-15 extension) to GSM 7 bit
  * Default Alphabet character set (3GPP TS 23.038 chapter 6.2.1).
@@ -352,3 +357,77 @@ uint8_t string_conversion_7bit_sms_unpacking(
 
 	return index_char;
 }
+
+/**
+ * @brief Encode a Unicode code point into UTF-8.
+ *
+ * @param[in] code Code point, at most 0x10FFFF.
+ * @param[out] out_data Output buffer with room for 4 bytes.
+ *
+ * @return Number of bytes stored into "out_data".
+ */
+static uint8_t utf8_encode(uint32_t code, uint8_t *out_data)
+{
+	if (code < 0x80) {
+		out_data[0] = code;
+		return 1;
+	} else if (code < 0x800) {
+		out_data[0] = 0xC0 | (code >> 6);
+		out_data[1] = 0x80 | (code & 0x3F);
+		return 2;
+	} else if (code < 0x10000) {
+		out_data[0] = 0xE0 | (code >> 12);
+		out_data[1] = 0x80 | ((code >> 6) & 0x3F);
+		out_data[2] = 0x80 | (code & 0x3F);
+		return 3;
+	}
+
+	out_data[0] = 0xF0 | (code >> 18);
+	out_data[1] = 0x80 | ((code >> 12) & 0x3F);
+	out_data[2] = 0x80 | ((code >> 6) & 0x3F);
+	out_data[3] = 0x80 | (code & 0x3F);
+	return 4;
+}
+
+size_t string_conversion_ucs2_to_utf8(
+	const uint8_t *data,
+	uint8_t *out_data,
+	size_t num_bytes)
+{
+	size_t index_ucs2 = 0;
+	size_t index_utf8 = 0;
+	uint32_t code;
+	uint16_t low;
+
+	if ((data == NULL) || (out_data == NULL)) {
+		return 0;
+	}
+
+	/* A trailing odd byte is not a character and is ignored */
+	while (index_ucs2 + 1 < num_bytes) {
+		code = (data[index_ucs2] << 8) | data[index_ucs2 + 1];
+		index_ucs2 += 2;
+
+		if (code >= STR_UTF16_HIGH_SURROGATE && code < STR_UTF16_LOW_SURROGATE) {
+			/* Senders use UTF-16, where characters outside of the Basic
+			 * Multilingual Plane are encoded as surrogate pairs.
+			 */
+			low = (index_ucs2 + 1 < num_bytes) ?
+				(data[index_ucs2] << 8) | data[index_ucs2 + 1] : 0;
+
+			if (low >= STR_UTF16_LOW_SURROGATE && low <= STR_UTF16_SURROGATE_END) {
+				code = 0x10000 + ((code - STR_UTF16_HIGH_SURROGATE) << 10) +
+				       (low - STR_UTF16_LOW_SURROGATE);
+				index_ucs2 += 2;
+			} else {
+				code = STR_UNICODE_REPLACEMENT_CHAR;
+			}
+		} else if (code >= STR_UTF16_LOW_SURROGATE && code <= STR_UTF16_SURROGATE_END) {
+			code = STR_UNICODE_REPLACEMENT_CHAR;
+		}
+
+		index_utf8 += utf8_encode(code, &out_data[index_utf8]);
+	}
+
+	return index_utf8;
+}
@@ -157,4 +157,25 @@ uint8_t string_conversion_7bit_sms_unpacking(const uint8_t *packed,
 						   uint8_t *unpacked,
 						   uint8_t  num_char);
 
+/**
+ * @brief Convert UCS-2 characters to UTF-8.
+ *
+ * @details The characters are 16 bits each, in big-endian byte order. UTF-16 surrogate pairs
+ * are decoded too, as senders use them for characters outside of the Basic Multilingual Plane.
+ * Unpaired surrogates are replaced with U+FFFD.
+ *
+ * References: 3GPP TS 23.038 chapter 6.2.3: UCS2
+ *
+ * @param[in] data Pointer to the UCS-2 characters to be converted. No null termination.
+ * @param[out] out_data Pointer to buffer for the converted string. Shall have allocation of
+ *             at least 3 / 2 * "num_bytes" bytes. Note that this function does not add
+ *             null termination at the end of the string.
+ * @param[in] num_bytes Number of bytes in "data", twice the number of UCS-2 characters.
+ *
+ * @return Number of valid bytes in "out_data".
+ */
+size_t string_conversion_ucs2_to_utf8(const uint8_t *data,
+				      uint8_t *out_data,
+				      size_t num_bytes);
+
 #endif /* STRING_CONVERSION_H_ */
@@ -0,0 +1,44 @@
+#
+# Copyright (c) 2021 Nordic Semiconductor ASA
+#
+# SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+
+from trace_stats_nordic import TraceStatsNordic
+
+import argparse
+import logging
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Calculating streaming statistics for all events.')
+    parser.add_argument('dataset_name', help='Name of dataset')
+    parser.add_argument('--start_time', type=float, default=0,
+                        help='Measurement start time[s]')
+    parser.add_argument('--end_time', type=float, default=float('inf'),
+                        help='Measurement end time[s]')
+    parser.add_argument('--output', help='Name of json file for summary')
+    parser.add_argument('--histograms', action='store_true',
+                        help='Include histograms in summary file')
+    parser.add_argument('--verify', action='store_true',
+                        help='Verify that dataset files are consistent')
+    parser.add_argument('--log', help='Log level')
+    args = parser.parse_args()
+
+    if args.log is not None:
+        log_lvl_number = int(getattr(logging, args.log.upper(), None))
+    else:
+        log_lvl_number = logging.INFO
+
+    ts = TraceStatsNordic(args.dataset_name + ".csv",
+                          args.dataset_name + ".json", log_lvl_number)
+    if args.verify:
+        ts.verify()
+    ts.process(args.start_time, args.end_time)
+    ts.print_summary()
+
+    if args.output is not None:
+        ts.write_summary(args.output, args.histograms)
+
+if __name__ == "__main__":
+    main()
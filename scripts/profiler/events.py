@@ -85,8 +85,39 @@ class EventsData():
             self.logger.warning("Hash values of csv files do not match")
             self.logger.warning("Events and descriptions may be inconsistent")
 
+    def read_events_types_from_file(self, filename_event_types):
+        return self._read_events_types_json(filename_event_types)
+
+    def iter_events_from_file(self, filename_events):
+        """Read events from file one by one, without storing them."""
+        try:
+            with open(filename_events, 'r', newline='') as csvfile:
+                rd = csv.reader(csvfile, delimiter=',')
+                # skip header
+                next(rd, None)
+                for row in rd:
+                    yield EventsData._event_from_row(row)
+        except IOError:
+            self.logger.error("Problem with accessing file: " + filename_events)
+            sys.exit()
+
+    @staticmethod
+    def _event_from_row(row):
+        type_id = int(row[0])
+        timestamp = float(row[1])
+        # reading event data from single row in csv file
+        if (row[2][1:-1] != ''):
+            data = list(map(int, (row[2][1:-1].split(','))))
+        else:
+            data = []
+        return Event(type_id, timestamp, data)
+
     def _calculate_md5_hash_of_file(filename):
-        return hashlib.md5(open(filename, 'rb').read()).hexdigest()
+        md5 = hashlib.md5()
+        with open(filename, 'rb') as f:
+            for chunk in iter(lambda: f.read(1 << 20), b''):
+                md5.update(chunk)
+        return md5.hexdigest()
 
     def _write_events_csv(self, filename):
         try:
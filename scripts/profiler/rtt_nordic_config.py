@@ -13,6 +13,7 @@ RttNordicConfig = {
     'reset_on_start': True,
     'connection_timeout': -1,
     'timestamp_raw_max': 2**32, #timestamp on uC is stored as 32-bit value
+    'frame_id': 0xFF, #event type ID reserved for frame headers
     'rtt_read_period': 0.1, #in seconds
     'rtt_read_chunk_size': 64000,
     'rtt_additional_read_thresh': 4096
@@ -30,7 +30,9 @@ class RttNordicProfilerHost:
         self.queue = queue
         self.received_events = EventsData([], {})
         self.timestamp_overflows = 0
-        self.after_half = False
+        self.last_timestamp_raw = None
+        self.frame_remaining = 0
+        self.dropped_events = 0
 
         self.desc_buf = ""
         self.bufs = list()
@@ -230,29 +232,57 @@ class RttNordicProfilerHost:
         self.logger.info("Received events descriptions")
         self.logger.info("Ready to start logging events")
 
+    def _read_int(self, num_bytes, signed=False):
+        buf = self._read_bytes(num_bytes)
+        self.frame_remaining -= num_bytes
+        return int.from_bytes(buf, byteorder=self.config['byteorder'],
+                              signed=signed)
+
+    def _read_varint(self):
+        value = 0
+        shift = 0
+        while True:
+            byte = self._read_int(1)
+            value |= (byte & 0x7F) << shift
+            shift += 7
+            if not byte & 0x80:
+                return value
+
+    def _update_timestamp(self, timestamp_raw):
+        # Events are received in order, timestamp decrease means overflow
+        if self.last_timestamp_raw is not None \
+        and timestamp_raw < self.last_timestamp_raw:
+            self.timestamp_overflows += 1
+        self.last_timestamp_raw = timestamp_raw
+
+    def _read_frame_header(self):
+        self.frame_remaining = self._read_int(2)
+        timestamp_raw = self._read_int(4)
+        dropped_events = self._read_int(4)
+
+        if dropped_events != self.dropped_events:
+            self.logger.warning("{} events dropped by the device".format(
+                dropped_events - self.dropped_events))
+            self.dropped_events = dropped_events
+
+        self._update_timestamp(timestamp_raw)
+
     def _read_single_event_rtt(self):
-        id = int.from_bytes(
-            self._read_bytes(1),
-            byteorder=self.config['byteorder'],
-            signed=False)
-        et = self.received_events.registered_events_types[id]
+        id = self._read_int(1)
 
-        buf = self._read_bytes(4)
-        timestamp_raw = (
-            int.from_bytes(
-                buf,
-                byteorder=self.config['byteorder'],
-                signed=False))
+        if id == self.config['frame_id']:
+            self._read_frame_header()
+            return None
 
-        if self.after_half \
-        and timestamp_raw < 0.2 * self.config['timestamp_raw_max']:
-            self.timestamp_overflows += 1
-            self.after_half = False
+        if self.last_timestamp_raw is None:
+            self.logger.error("Received event outside of a frame")
+            return None
 
-        if timestamp_raw > 0.6 * self.config['timestamp_raw_max']:
-            if timestamp_raw < 0.9 * self.config['timestamp_raw_max']:
-                self.after_half = True
+        et = self.received_events.registered_events_types[id]
 
+        timestamp_raw = (self.last_timestamp_raw + self._read_varint()) \
+                        % self.config['timestamp_raw_max']
+        self._update_timestamp(timestamp_raw)
         timestamp = self._calculate_timestamp_from_clock_ticks(timestamp_raw)
 
         data = []
@@ -260,15 +290,15 @@ class RttNordicProfilerHost:
             signum = False
             if i[0] == 's':
                 signum = True
-            buf = self._read_bytes(4)
-            data.append(int.from_bytes(buf, byteorder=self.config['byteorder'],
-                                       signed=signum))
+            data.append(self._read_int(4, signed=signum))
         return Event(id, timestamp, data)
 
     def _read_remaining_events(self):
         self.reading_data = False
         while self.bcnt != 0:
             event = self._read_single_event_rtt()
+            if event is None:
+                continue
             self.received_events.events.append(event)
             if self.queue is not None:
                 self.queue.put(event)
@@ -284,10 +314,12 @@ class RttNordicProfilerHost:
         current_time = start_time
         while current_time - start_time < time_seconds or time_seconds < 0:
             event = self._read_single_event_rtt()
+            current_time = time.time()
+            if event is None:
+                continue
             self.received_events.events.append(event)
             if self.queue is not None:
                 self.queue.put(event)
-            current_time = time.time()
         self.logger.info("Real time transmission closed")
         self.shutdown()
         self.logger.info("Events data saved to files")
@@ -0,0 +1,266 @@
+#
+# Copyright (c) 2021 Nordic Semiconductor ASA
+#
+# SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+
+from events import EventsData
+import json
+import logging
+import math
+
+
+class LogHistogram():
+    """Histogram with logarithmic buckets and bounded relative error.
+
+    Values are stored in nanoseconds. Every power of two range is split into
+    SUB_BUCKETS / 2 linear buckets, so the relative error of a percentile is
+    lower than 2 / SUB_BUCKETS. Memory usage does not depend on the number
+    of samples.
+    """
+    SUB_BUCKETS_BITS = 5
+    SUB_BUCKETS = 1 << SUB_BUCKETS_BITS
+
+    def __init__(self):
+        self.buckets = {}
+        self.count = 0
+        self.total = 0
+        self.min = None
+        self.max = None
+
+    def _bucket_idx(self, value):
+        if value < LogHistogram.SUB_BUCKETS:
+            return value
+        shift = value.bit_length() - LogHistogram.SUB_BUCKETS_BITS
+        return (shift << LogHistogram.SUB_BUCKETS_BITS) + (value >> shift)
+
+    def _bucket_value(self, idx):
+        if idx < LogHistogram.SUB_BUCKETS:
+            return idx
+        shift = idx >> LogHistogram.SUB_BUCKETS_BITS
+        mantissa = idx & (LogHistogram.SUB_BUCKETS - 1)
+        # middle of the bucket
+        return (mantissa << shift) + (1 << (shift - 1))
+
+    def add(self, value_s):
+        value = max(0, int(round(value_s * 1e9)))
+        idx = self._bucket_idx(value)
+        self.buckets[idx] = self.buckets.get(idx, 0) + 1
+        self.count += 1
+        self.total += value
+        if self.min is None or value < self.min:
+            self.min = value
+        if self.max is None or value > self.max:
+            self.max = value
+
+    def percentile(self, pct):
+        if self.count == 0:
+            return None
+        rank = max(1, math.ceil(self.count * pct / 100))
+        acc = 0
+        for idx in sorted(self.buckets):
+            acc += self.buckets[idx]
+            if acc >= rank:
+                return min(max(self._bucket_value(idx), self.min), self.max)
+        return self.max
+
+    def summary(self):
+        if self.count == 0:
+            return None
+        to_us = lambda ns: ns / 1000
+        return {
+            'count': self.count,
+            'min_us': to_us(self.min),
+            'mean_us': to_us(self.total / self.count),
+            'p50_us': to_us(self.percentile(50)),
+            'p99_us': to_us(self.percentile(99)),
+            'p999_us': to_us(self.percentile(99.9)),
+            'max_us': to_us(self.max),
+        }
+
+    def serialize(self):
+        return {
+            'sub_buckets': LogHistogram.SUB_BUCKETS,
+            'buckets': dict((str(self._bucket_value(k)), v)
+                            for k, v in sorted(self.buckets.items())),
+        }
+
+
+class EventTypeStats():
+    def __init__(self, name):
+        self.name = name
+        self.count = 0
+        self.first_timestamp = None
+        self.last_timestamp = None
+        self.interval = LogHistogram()
+        self.queue_time = LogHistogram()
+        self.processing_time = LogHistogram()
+
+    def add_occurrence(self, timestamp):
+        if self.last_timestamp is not None:
+            self.interval.add(timestamp - self.last_timestamp)
+        else:
+            self.first_timestamp = timestamp
+        self.last_timestamp = timestamp
+        self.count += 1
+
+    def summary(self, with_histograms):
+        duration = 0
+        if self.count > 1:
+            duration = self.last_timestamp - self.first_timestamp
+
+        summary = {
+            'name': self.name,
+            'count': self.count,
+            'rate_per_s': (self.count - 1) / duration if duration > 0 else None,
+            'interval': self.interval.summary(),
+            'queue_time': self.queue_time.summary(),
+            'processing_time': self.processing_time.summary(),
+        }
+
+        if with_histograms:
+            summary['histograms'] = {
+                'interval': self.interval.serialize(),
+                'queue_time': self.queue_time.serialize(),
+                'processing_time': self.processing_time.serialize(),
+            }
+
+        return summary
+
+
+class TraceStatsNordic():
+    """Streaming statistics of events collected by the Nordic profiler.
+
+    Events are read from file one by one and are not stored, so captures of
+    any length can be processed in bounded memory. Event Manager event
+    submissions are matched with event_processing_start/end markers using
+    memory addresses of the events, to calculate the time spent in the queue
+    and the processing time.
+    """
+
+    def __init__(self, events_filename, events_types_filename, log_lvl):
+        self.events_filename = events_filename
+        self.raw_data = EventsData([], {})
+        self.csv_hash = self.raw_data.read_events_types_from_file(
+                                                        events_types_filename)
+        self.stats = dict((k, EventTypeStats(v.name))
+                          for k, v in
+                          self.raw_data.registered_events_types.items())
+
+        self.event_processing_start_id = self.raw_data.get_event_type_id(
+                                                     'event_processing_start')
+        self.event_processing_end_id = self.raw_data.get_event_type_id(
+                                                     'event_processing_end')
+        self.tracked_types = set(k for k, v in
+                                 self.raw_data.registered_events_types.items()
+                                 if len(v.data_descriptions) > 0
+                                 and v.data_descriptions[0] == 'mem_address')
+        self.tracked_types.discard(self.event_processing_start_id)
+        self.tracked_types.discard(self.event_processing_end_id)
+
+        # Submitted events waiting for processing, keyed by memory address.
+        # Memory address is reused only after the event is freed, so the
+        # number of entries is limited by the number of events that can
+        # exist at the same time.
+        self.submitted = {}
+        self.processing = None
+        self.unmatched = 0
+        self.events_cnt = 0
+
+        self.logger = logging.getLogger('Trace Stats Nordic')
+        self.logger_console = logging.StreamHandler()
+        self.logger.setLevel(log_lvl)
+        self.log_format = logging.Formatter(
+            '[%(levelname)s] %(name)s: %(message)s')
+        self.logger_console.setFormatter(self.log_format)
+        self.logger.addHandler(self.logger_console)
+
+    def verify(self):
+        csv_hash = EventsData._calculate_md5_hash_of_file(self.events_filename)
+        if csv_hash != self.csv_hash:
+            self.logger.warning("Hash values of csv files do not match")
+            self.logger.warning("Events and descriptions may be inconsistent")
+            return False
+        return True
+
+    def _process_start(self, ev):
+        submit = self.submitted.pop(ev.data[0], None)
+        if submit is None:
+            self.unmatched += 1
+            self.processing = None
+            return
+        type_id, submit_time = submit
+        self.stats[type_id].queue_time.add(ev.timestamp - submit_time)
+        self.processing = (ev.data[0], type_id, ev.timestamp)
+
+    def _process_end(self, ev):
+        if self.processing is None or self.processing[0] != ev.data[0]:
+            self.unmatched += 1
+            return
+        _, type_id, start_time = self.processing
+        self.stats[type_id].processing_time.add(ev.timestamp - start_time)
+        self.processing = None
+
+    def process_event(self, ev):
+        self.events_cnt += 1
+
+        if ev.type_id not in self.stats:
+            self.logger.warning("Unknown event type ID: {}".format(ev.type_id))
+            return
+
+        if ev.type_id == self.event_processing_start_id:
+            self._process_start(ev)
+        elif ev.type_id == self.event_processing_end_id:
+            self._process_end(ev)
+        else:
+            self.stats[ev.type_id].add_occurrence(ev.timestamp)
+            if ev.type_id in self.tracked_types:
+                self.submitted[ev.data[0]] = (ev.type_id, ev.timestamp)
+
+    def process(self, start_meas=0, end_meas=float('inf')):
+        for ev in self.raw_data.iter_events_from_file(self.events_filename):
+            if ev.timestamp < start_meas:
+                continue
+            if ev.timestamp > end_meas:
+                break
+            self.process_event(ev)
+
+            if self.events_cnt % 1000000 == 0:
+                self.logger.info("Processed {} events".format(self.events_cnt))
+
+        if self.unmatched > 0:
+            self.logger.warning("{} processing markers not matched".format(
+                                self.unmatched))
+
+    def summary(self, with_histograms=False):
+        return {
+            'events': self.events_cnt,
+            'unmatched_markers': self.unmatched,
+            'event_types': [s.summary(with_histograms)
+                            for k, s in sorted(self.stats.items())
+                            if s.count > 0],
+        }
+
+    def write_summary(self, filename, with_histograms=False):
+        try:
+            with open(filename, 'w') as wr:
+                json.dump(self.summary(with_histograms), wr, indent=4)
+        except IOError:
+            self.logger.error("Problem with accessing file: " + filename)
+
+    def print_summary(self):
+        def fmt(h, key):
+            if h is None:
+                return '-'
+            return '{:.1f}'.format(h[key])
+
+        header = '{:<40} {:>10} {:>10} {:>10} {:>10} {:>10} {:>10}'
+        print(header.format('Event', 'Count', 'Queue p50', 'Queue p99',
+                            'Queue p999', 'Proc p99', 'Proc max'))
+        for s in self.summary()['event_types']:
+            print(header.format(s['name'], s['count'],
+                                fmt(s['queue_time'], 'p50_us'),
+                                fmt(s['queue_time'], 'p99_us'),
+                                fmt(s['queue_time'], 'p999_us'),
+                                fmt(s['processing_time'], 'p99_us'),
+                                fmt(s['processing_time'], 'max_us')))
+        print('Times in microseconds')
@@ -7,17 +7,33 @@
 #include <inttypes.h>
 #include <zephyr.h>
 #include <logging/log.h>
+#include <settings/settings.h>
 
 #include <bluetooth/gatt_dm.h>
 
 LOG_MODULE_REGISTER(bt_gatt_dm, CONFIG_BT_GATT_DM_LOG_LEVEL);
 
-/* Available sizes: 128, 512, 2048... */
-#define CHUNK_DATA_SIZE (128 - sizeof(struct k_mem_block_id) \
-		- sizeof(struct data_chunk_item *))
+/* Data chunks are 128-byte blocks of the memory pool */
+#define CHUNK_SIZE 128
+#define CHUNK_DATA_SIZE (CHUNK_SIZE - sizeof(sys_snode_t))
 
 #define DATA_ALIGN 4U
 
+#if CONFIG_BT_GATT_DM_CACHE
+/* Format version of the cache entries */
+#define CACHE_VERSION 1
+#define CACHE_DB_HASH_LEN 16
+#define CACHE_UUID_MAX_LEN 16
+#define CACHE_UUID_STR_LEN (2 * CACHE_UUID_MAX_LEN + 1)
+/* Cache entry key: bt/dm/<peer address>/<service UUID> */
+#define CACHE_KEY_LEN (sizeof("bt/dm/") + 2 * sizeof(bt_addr_t) + 2 + \
+		       2 * CACHE_UUID_MAX_LEN)
+/* Largest attribute record: handle, permissions, UUID, and the UUID,
+ * handle, and properties of a characteristic value
+ */
+#define CACHE_RECORD_MAX_LEN (2 + 1 + 2 * (1 + CACHE_UUID_MAX_LEN) + 2 + 1)
+#endif
+
 /* They are placed in data_chunk without padding, so they must be aligned */
 BUILD_ASSERT(sizeof(struct bt_gatt_service_val) % DATA_ALIGN == 0);
 BUILD_ASSERT(sizeof(struct bt_gatt_chrc) % DATA_ALIGN == 0);
@@ -26,6 +42,7 @@ BUILD_ASSERT(sizeof(struct bt_gatt_chrc) % DATA_ALIGN == 0);
 enum {
 	STATE_ATTRS_LOCKED,
 	STATE_ATTRS_RELEASE_PENDING,
+	STATE_CACHE_STORE,
 	STATE_NUM
 };
 
@@ -37,6 +54,14 @@ struct data_chunk_item {
 	uint8_t data[CHUNK_DATA_SIZE];
 };
 
+BUILD_ASSERT(sizeof(struct data_chunk_item) == CHUNK_SIZE);
+
+/* Memory pool of the data chunks, shared by all instances */
+K_MEM_SLAB_DEFINE(data_chunk_slab,
+		  CHUNK_SIZE,
+		  CONFIG_BT_GATT_DM_MAX_INSTANCES * CONFIG_BT_GATT_DM_DATA_CHUNKS,
+		  DATA_ALIGN);
+
 /* The instance structure real declaration */
 struct bt_gatt_dm {
 	/* Connection object */
@@ -60,10 +85,38 @@ struct bt_gatt_dm {
 
 	/* The pointer to callback structure */
 	const struct bt_gatt_dm_cb *callback;
+
+	/* Memory usage statistics */
+	struct bt_gatt_dm_stats stats;
+
+#if CONFIG_BT_GATT_DM_CACHE
+	/* The address of the bonded peer */
+	bt_addr_le_t peer_addr;
+	/* The parameters used to read the Database Hash */
+	struct bt_gatt_read_params read_params;
+	/* The Database Hash of the peer */
+	uint8_t db_hash[CACHE_DB_HASH_LEN];
+	/* Loads or stores the service outside of the Bluetooth RX thread */
+	struct k_work cache_work;
+#endif
 };
 
-/* Currently only one instance is supported */
-static struct bt_gatt_dm bt_gatt_dm_inst;
+static struct bt_gatt_dm bt_gatt_dm_inst[CONFIG_BT_GATT_DM_MAX_INSTANCES];
+
+/* Returns a discovery instance that is not in use, locked */
+static struct bt_gatt_dm *dm_alloc(void)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(bt_gatt_dm_inst); i++) {
+		struct bt_gatt_dm *dm = &bt_gatt_dm_inst[i];
+
+		if (!atomic_test_and_set_bit(dm->state_flags,
+					     STATE_ATTRS_LOCKED)) {
+			return dm;
+		}
+	}
+
+	return NULL;
+}
 
 /* Returns pointer to newly allocated space in a dm->data_chunk */
 static void *user_data_alloc(struct bt_gatt_dm *dm,
@@ -82,15 +135,23 @@ static void *user_data_alloc(struct bt_gatt_dm *dm,
 	if (sys_slist_is_empty(&dm->chunk_list) ||
 	    dm->cur_chunk_len + len > CHUNK_DATA_SIZE) {
 
-		item = k_malloc(sizeof(struct data_chunk_item));
-
-		if (!item) {
+		/* Each instance is limited to its share of the pool, so
+		 * that it cannot starve the other instances.
+		 */
+		if ((dm->stats.chunk_cnt >= CONFIG_BT_GATT_DM_DATA_CHUNKS) ||
+		    k_mem_slab_alloc(&data_chunk_slab, (void **)&item,
+				     K_NO_WAIT)) {
+			dm->stats.nomem_cnt++;
 			return NULL;
 		}
 
 		sys_slist_append(&dm->chunk_list, &item->node);
 		dm->cur_chunk_len = 0;
 
+		dm->stats.chunk_cnt++;
+		dm->stats.chunk_max = MAX(dm->stats.chunk_max,
+					  dm->stats.chunk_cnt);
+
 	} else {
 
 		item = SYS_SLIST_PEEK_TAIL_CONTAINER(&dm->chunk_list, item,
@@ -101,6 +162,9 @@ static void *user_data_alloc(struct bt_gatt_dm *dm,
 	user_data_loc = &item->data[dm->cur_chunk_len];
 	dm->cur_chunk_len += len;
 
+	dm->stats.data_len += len;
+	dm->stats.data_max = MAX(dm->stats.data_max, dm->stats.data_len);
+
 	return user_data_loc;
 }
 
@@ -118,10 +182,14 @@ static void svc_attr_memory_release(struct bt_gatt_dm *dm)
 	while (!sys_slist_is_empty(&dm->chunk_list)) {
 		node = sys_slist_get_not_empty(&dm->chunk_list);
 		item = CONTAINER_OF(node, struct data_chunk_item, node);
-		k_free(item);
+		k_mem_slab_free(&data_chunk_slab, (void **)&item);
 	}
 
 	dm->cur_chunk_len = 0;
+
+	dm->stats.attr_cnt = 0;
+	dm->stats.data_len = 0;
+	dm->stats.chunk_cnt = 0;
 }
 
 /* Returns size of UUID structure with padding for memory alignment */
@@ -166,6 +234,7 @@ static struct bt_gatt_dm_attr *attr_store(struct bt_gatt_dm *dm,
 		attr->handle);
 	if (dm->cur_attr_id >= ARRAY_SIZE(dm->attrs)) {
 		LOG_ERR("No space for new attribute.");
+		dm->stats.nomem_cnt++;
 		return NULL;
 	}
 
@@ -184,6 +253,9 @@ static struct bt_gatt_dm_attr *attr_store(struct bt_gatt_dm *dm,
 
 	memcpy(cur_attr->uuid, attr->uuid, uuid_size);
 
+	dm->stats.attr_cnt = dm->cur_attr_id;
+	dm->stats.attr_max = MAX(dm->stats.attr_max, dm->stats.attr_cnt);
+
 	return cur_attr;
 }
 
@@ -198,6 +270,10 @@ static struct bt_uuid *uuid_store(struct bt_gatt_dm *dm,
 	size_t size = get_uuid_size(uuid);
 	void *buffer = user_data_alloc(dm, size);
 
+	if (!buffer) {
+		return NULL;
+	}
+
 	memcpy(buffer, uuid, size);
 
 	return (struct bt_uuid *)buffer;
@@ -231,9 +307,381 @@ static struct bt_gatt_dm_attr *attr_find_by_handle(
 	return NULL;
 }
 
+#if CONFIG_BT_GATT_DM_CACHE
+
+/* Any type of UUID read from the cache */
+union cache_uuid {
+	struct bt_uuid uuid;
+	struct bt_uuid_16 u16;
+	struct bt_uuid_32 u32;
+	struct bt_uuid_128 u128;
+};
+
+/* An entry holds at least one attribute after its header */
+BUILD_ASSERT(CONFIG_BT_GATT_DM_CACHE_MAX_SIZE >=
+	     1 + CACHE_DB_HASH_LEN + CACHE_RECORD_MAX_LEN);
+
+/* Serialized cache entry, shared by all instances */
+NET_BUF_SIMPLE_DEFINE_STATIC(cache_buf, CONFIG_BT_GATT_DM_CACHE_MAX_SIZE);
+static K_MUTEX_DEFINE(cache_buf_lock);
+
+/* Returns the length of the UUID value, in little-endian order */
+static size_t cache_uuid_val_get(const struct bt_uuid *uuid,
+				 uint8_t val[CACHE_UUID_MAX_LEN])
+{
+	switch (uuid->type) {
+	case BT_UUID_TYPE_16:
+		sys_put_le16(BT_UUID_16(uuid)->val, val);
+		return sizeof(uint16_t);
+	case BT_UUID_TYPE_32:
+		sys_put_le32(BT_UUID_32(uuid)->val, val);
+		return sizeof(uint32_t);
+	case BT_UUID_TYPE_128:
+		memcpy(val, BT_UUID_128(uuid)->val, CACHE_UUID_MAX_LEN);
+		return CACHE_UUID_MAX_LEN;
+	default:
+		__ASSERT(false, "Unknown UUID type.");
+		return 0;
+	}
+}
+
+static void cache_key_encode(char key[CACHE_KEY_LEN],
+			     const bt_addr_le_t *addr,
+			     const struct bt_uuid *uuid)
+{
+	int len;
+	uint8_t val[CACHE_UUID_MAX_LEN];
+	char uuid_str[CACHE_UUID_STR_LEN];
+
+	len = snprintk(key, CACHE_KEY_LEN, "bt/dm/%02x%02x%02x%02x%02x%02x%u",
+		       addr->a.val[5], addr->a.val[4], addr->a.val[3],
+		       addr->a.val[2], addr->a.val[1], addr->a.val[0],
+		       addr->type);
+
+	if (uuid) {
+		bin2hex(val, cache_uuid_val_get(uuid, val),
+			uuid_str, sizeof(uuid_str));
+		snprintk(&key[len], CACHE_KEY_LEN - len, "/%s", uuid_str);
+	}
+}
+
+static void cache_uuid_add(struct net_buf_simple *buf,
+			   const struct bt_uuid *uuid)
+{
+	uint8_t val[CACHE_UUID_MAX_LEN];
+	size_t len = cache_uuid_val_get(uuid, val);
+
+	net_buf_simple_add_u8(buf, len);
+	net_buf_simple_add_mem(buf, val, len);
+}
+
+static int cache_uuid_pull(struct net_buf_simple *buf, union cache_uuid *uuid)
+{
+	uint8_t len;
+
+	if (buf->len < sizeof(len)) {
+		return -EINVAL;
+	}
+
+	len = net_buf_simple_pull_u8(buf);
+	if ((buf->len < len) ||
+	    !bt_uuid_create(&uuid->uuid, net_buf_simple_pull_mem(buf, len),
+			    len)) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static bool is_service(const struct bt_uuid *uuid)
+{
+	return !bt_uuid_cmp(uuid, BT_UUID_GATT_PRIMARY) ||
+	       !bt_uuid_cmp(uuid, BT_UUID_GATT_SECONDARY);
+}
+
+static bool peer_bonded(struct bt_gatt_dm *dm)
+{
+	struct bt_conn_info info;
+
+	if (bt_conn_get_info(dm->conn, &info) ||
+	    (info.type != BT_CONN_TYPE_LE)) {
+		return false;
+	}
+
+	bt_addr_le_copy(&dm->peer_addr, info.le.dst);
+
+	return bt_addr_le_is_bonded(info.id, info.le.dst);
+}
+
+/* Stores the discovered service with the Database Hash of the peer */
+static void cache_store(struct bt_gatt_dm *dm)
+{
+	int err = 0;
+	char key[CACHE_KEY_LEN];
+	const struct bt_gatt_service_val *service_val;
+
+	k_mutex_lock(&cache_buf_lock, K_FOREVER);
+	net_buf_simple_reset(&cache_buf);
+
+	net_buf_simple_add_u8(&cache_buf, CACHE_VERSION);
+	net_buf_simple_add_mem(&cache_buf, dm->db_hash, sizeof(dm->db_hash));
+
+	for (size_t i = 0; i < dm->cur_attr_id; i++) {
+		const struct bt_gatt_dm_attr *attr = &dm->attrs[i];
+
+		if (net_buf_simple_tailroom(&cache_buf) <
+		    CACHE_RECORD_MAX_LEN) {
+			err = -ENOMEM;
+			break;
+		}
+
+		net_buf_simple_add_le16(&cache_buf, attr->handle);
+		net_buf_simple_add_u8(&cache_buf, attr->perm);
+		cache_uuid_add(&cache_buf, attr->uuid);
+
+		if (is_service(attr->uuid)) {
+			const struct bt_gatt_service_val *service_val =
+				bt_gatt_dm_attr_service_val(attr);
+
+			cache_uuid_add(&cache_buf, service_val->uuid);
+			net_buf_simple_add_le16(&cache_buf,
+						service_val->end_handle);
+		} else if (!bt_uuid_cmp(attr->uuid, BT_UUID_GATT_CHRC)) {
+			const struct bt_gatt_chrc *chrc =
+				bt_gatt_dm_attr_chrc_val(attr);
+
+			cache_uuid_add(&cache_buf, chrc->uuid);
+			net_buf_simple_add_le16(&cache_buf, chrc->value_handle);
+			net_buf_simple_add_u8(&cache_buf, chrc->properties);
+		}
+	}
+
+	if (!err) {
+		/* The UUID in the discovery parameters is cleared by then */
+		service_val = bt_gatt_dm_attr_service_val(&dm->attrs[0]);
+		cache_key_encode(key, &dm->peer_addr, service_val->uuid);
+		err = settings_save_one(key, cache_buf.data, cache_buf.len);
+	}
+
+	k_mutex_unlock(&cache_buf_lock);
+
+	if (err) {
+		LOG_WRN("Service not cached, error: %d.", err);
+	} else {
+		LOG_DBG("Service cached");
+	}
+}
+
+/* Drops the stored attributes, keeping the UUID of the service to discover */
+static int attrs_reset(struct bt_gatt_dm *dm)
+{
+	union cache_uuid svc_uuid;
+
+	memcpy(&svc_uuid, dm->discover_params.uuid,
+	       get_uuid_size(dm->discover_params.uuid));
+
+	svc_attr_memory_release(dm);
+	dm->cur_attr_id = 0;
+
+	dm->discover_params.uuid = uuid_store(dm, &svc_uuid.uuid);
+
+	return dm->discover_params.uuid ? 0 : -ENOMEM;
+}
+
+static int cache_attr_pull(struct bt_gatt_dm *dm, struct net_buf_simple *buf)
+{
+	union cache_uuid uuid;
+	union cache_uuid val_uuid;
+	struct bt_gatt_attr attr = {
+		.uuid = &uuid.uuid,
+	};
+	struct bt_gatt_dm_attr *cur_attr;
+
+	if (buf->len < sizeof(attr.handle) + sizeof(attr.perm)) {
+		return -EINVAL;
+	}
+
+	attr.handle = net_buf_simple_pull_le16(buf);
+	attr.perm = net_buf_simple_pull_u8(buf);
+
+	if (cache_uuid_pull(buf, &uuid)) {
+		return -EINVAL;
+	}
+
+	/* The attributes are searched by handle, they must be in order */
+	if (dm->cur_attr_id &&
+	    (attr.handle <= dm->attrs[dm->cur_attr_id - 1].handle)) {
+		return -EINVAL;
+	}
+
+	if (is_service(attr.uuid)) {
+		struct bt_gatt_service_val *service_val;
+
+		if (cache_uuid_pull(buf, &val_uuid) ||
+		    (buf->len < sizeof(service_val->end_handle))) {
+			return -EINVAL;
+		}
+
+		cur_attr = attr_store(dm, &attr, sizeof(*service_val));
+		if (!cur_attr) {
+			return -ENOMEM;
+		}
+
+		service_val = bt_gatt_dm_attr_service_val(cur_attr);
+		service_val->end_handle = net_buf_simple_pull_le16(buf);
+		service_val->uuid = uuid_store(dm, &val_uuid.uuid);
+		if (!service_val->uuid) {
+			return -ENOMEM;
+		}
+	} else if (!bt_uuid_cmp(attr.uuid, BT_UUID_GATT_CHRC)) {
+		struct bt_gatt_chrc *chrc;
+
+		if (cache_uuid_pull(buf, &val_uuid) ||
+		    (buf->len < sizeof(chrc->value_handle) +
+				sizeof(chrc->properties))) {
+			return -EINVAL;
+		}
+
+		cur_attr = attr_store(dm, &attr, sizeof(*chrc));
+		if (!cur_attr) {
+			return -ENOMEM;
+		}
+
+		chrc = bt_gatt_dm_attr_chrc_val(cur_attr);
+		chrc->value_handle = net_buf_simple_pull_le16(buf);
+		chrc->properties = net_buf_simple_pull_u8(buf);
+		chrc->uuid = uuid_store(dm, &val_uuid.uuid);
+		if (!chrc->uuid) {
+			return -ENOMEM;
+		}
+	} else if (!attr_store(dm, &attr, 0)) {
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static int cache_parse(struct bt_gatt_dm *dm, struct net_buf_simple *buf)
+{
+	int err = 0;
+	const struct bt_gatt_service_val *service_val;
+
+	if ((buf->len < sizeof(uint8_t) + sizeof(dm->db_hash)) ||
+	    (net_buf_simple_pull_u8(buf) != CACHE_VERSION) ||
+	    memcmp(net_buf_simple_pull_mem(buf, sizeof(dm->db_hash)),
+		   dm->db_hash, sizeof(dm->db_hash))) {
+		return -ESTALE;
+	}
+
+	while (buf->len && !err) {
+		err = cache_attr_pull(dm, buf);
+	}
+
+	if (!err) {
+		service_val = dm->cur_attr_id ?
+			bt_gatt_dm_attr_service_val(&dm->attrs[0]) : NULL;
+		if (!service_val ||
+		    bt_uuid_cmp(service_val->uuid, dm->discover_params.uuid)) {
+			err = -EINVAL;
+		}
+	}
+
+	return err;
+}
+
+static int cache_read_cb(const char *key, size_t len,
+			 settings_read_cb read_cb, void *cb_arg, void *param)
+{
+	struct net_buf_simple *buf = param;
+	ssize_t size;
+
+	/* Only the entry of the service, deleted entries are empty */
+	if (key || !len) {
+		return 0;
+	}
+
+	if (len > net_buf_simple_tailroom(buf)) {
+		return -ENOMEM;
+	}
+
+	size = read_cb(cb_arg, net_buf_simple_tail(buf), len);
+	if (size < 0) {
+		return size;
+	}
+
+	net_buf_simple_add(buf, size);
+
+	return 0;
+}
+
+/* Loads the service from the cache if the Database Hash of the peer
+ * did not change since it was stored
+ */
+static int cache_load(struct bt_gatt_dm *dm)
+{
+	int err;
+	char key[CACHE_KEY_LEN];
+	const struct bt_gatt_service_val *service_val;
+
+	cache_key_encode(key, &dm->peer_addr, dm->discover_params.uuid);
+
+	k_mutex_lock(&cache_buf_lock, K_FOREVER);
+	net_buf_simple_reset(&cache_buf);
+
+	err = settings_load_subtree_direct(key, cache_read_cb, &cache_buf);
+	if (!err && !cache_buf.len) {
+		err = -ENOENT;
+	}
+
+	if (!err) {
+		err = cache_parse(dm, &cache_buf);
+		if (err && dm->cur_attr_id) {
+			LOG_WRN("Invalid cache entry, error: %d.", err);
+			if (attrs_reset(dm)) {
+				err = -ENOMEM;
+			}
+		}
+	}
+
+	k_mutex_unlock(&cache_buf_lock);
+
+	if (!err) {
+		/* Leave the parameters as the discovery of the service does,
+		 * for bt_gatt_dm_continue(). The UUID is released with the
+		 * attributes.
+		 */
+		service_val = bt_gatt_dm_attr_service_val(&dm->attrs[0]);
+		dm->discover_params.uuid = NULL;
+		dm->discover_params.end_handle = service_val->end_handle;
+	}
+
+	return err;
+}
+
+/* The entries are read on demand, nothing is kept when they are loaded */
+static int cache_settings_set(const char *key, size_t len,
+			      settings_read_cb read_cb, void *cb_arg)
+{
+	return 0;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(bt_dm, "bt/dm", NULL, cache_settings_set,
+			       NULL, NULL);
+
+#endif /* CONFIG_BT_GATT_DM_CACHE */
+
 static void discovery_complete(struct bt_gatt_dm *dm)
 {
 	LOG_DBG("Discovery complete.");
+#if CONFIG_BT_GATT_DM_CACHE
+	/* Writing the flash would block the Bluetooth RX thread, the service
+	 * is stored from the work queue, which completes the discovery.
+	 */
+	if (atomic_test_bit(dm->state_flags, STATE_CACHE_STORE)) {
+		k_work_submit(&dm->cache_work);
+		return;
+	}
+#endif
 	atomic_set_bit(dm->state_flags, STATE_ATTRS_RELEASE_PENDING);
 	if (dm->callback->completed) {
 		dm->callback->completed(dm, dm->context);
@@ -406,30 +854,29 @@ static uint8_t discovery_callback(struct bt_conn *conn,
 			       const struct bt_gatt_attr *attr,
 			       struct bt_gatt_discover_params *params)
 {
+	struct bt_gatt_dm *dm = CONTAINER_OF(params, struct bt_gatt_dm,
+					     discover_params);
+
 	if (!attr) {
 		LOG_DBG("NULL attribute");
 	} else {
 		LOG_DBG("Attr: handle %u", attr->handle);
 	}
 
-	if (conn != bt_gatt_dm_inst.conn) {
+	if (conn != dm->conn) {
 		LOG_ERR("Unexpected conn object. Aborting.");
-		discovery_complete_error(&bt_gatt_dm_inst, -EFAULT);
+		discovery_complete_error(dm, -EFAULT);
 		return BT_GATT_ITER_STOP;
 	}
 
 	switch (params->type) {
 	case BT_GATT_DISCOVER_PRIMARY:
 	case BT_GATT_DISCOVER_SECONDARY:
-		return discovery_process_service(&bt_gatt_dm_inst,
-						 attr, params);
+		return discovery_process_service(dm, attr, params);
 	case BT_GATT_DISCOVER_ATTRIBUTE:
-		return discovery_process_attribute(&bt_gatt_dm_inst,
-						   attr, params);
+		return discovery_process_attribute(dm, attr, params);
 	case BT_GATT_DISCOVER_CHARACTERISTIC:
-		return discovery_process_characteristic(&bt_gatt_dm_inst,
-							attr,
-							params);
+		return discovery_process_characteristic(dm, attr, params);
 	default:
 		/* This should not be possible */
 		__ASSERT(false, "Unknown param type.");
@@ -468,6 +915,12 @@ size_t bt_gatt_dm_attr_cnt(const struct bt_gatt_dm *dm)
 	return dm->cur_attr_id;
 }
 
+void bt_gatt_dm_stats_get(const struct bt_gatt_dm *dm,
+			  struct bt_gatt_dm_stats *stats)
+{
+	*stats = dm->stats;
+}
+
 const struct bt_gatt_dm_attr *bt_gatt_dm_service_get(
 	const struct bt_gatt_dm *dm)
 {
@@ -568,6 +1021,146 @@ const struct bt_gatt_dm_attr *bt_gatt_dm_desc_next(
 	return curr;
 }
 
+#if CONFIG_BT_GATT_DM_CACHE
+
+/* Read by the stack after the read is started, it must not be on the stack */
+static struct bt_uuid_16 db_hash_uuid =
+	BT_UUID_INIT_16(BT_UUID_GATT_DB_HASH_VAL);
+
+/* Stores the discovered service, or loads it from the cache and discovers
+ * it if it was not cached
+ */
+static void cache_work_handler(struct k_work *work)
+{
+	int err;
+	struct bt_gatt_dm *dm = CONTAINER_OF(work, struct bt_gatt_dm,
+					     cache_work);
+
+	if (atomic_test_and_clear_bit(dm->state_flags, STATE_CACHE_STORE)) {
+		cache_store(dm);
+		discovery_complete(dm);
+		return;
+	}
+
+	err = cache_load(dm);
+	if (!err) {
+		LOG_DBG("Service loaded from the cache.");
+		discovery_complete(dm);
+		return;
+	}
+
+	if (err == -ENOMEM) {
+		discovery_complete_error(dm, err);
+		return;
+	}
+
+	atomic_set_bit(dm->state_flags, STATE_CACHE_STORE);
+
+	err = bt_gatt_discover(dm->conn, &dm->discover_params);
+	if (err) {
+		LOG_ERR("Discover failed, error: %d.", err);
+		atomic_clear_bit(dm->state_flags, STATE_CACHE_STORE);
+		discovery_complete_error(dm, err);
+	}
+}
+
+static uint8_t db_hash_read_cb(struct bt_conn *conn, uint8_t att_err,
+			       struct bt_gatt_read_params *params,
+			       const void *data, uint16_t length)
+{
+	int err;
+	struct bt_gatt_dm *dm = CONTAINER_OF(params, struct bt_gatt_dm,
+					     read_params);
+
+	if (!att_err && data && (length == sizeof(dm->db_hash))) {
+		memcpy(dm->db_hash, data, length);
+
+		/* Reading the flash would block the Bluetooth RX thread */
+		k_work_submit(&dm->cache_work);
+		return BT_GATT_ITER_STOP;
+	}
+
+	LOG_DBG("No Database Hash, the service is not cached.");
+
+	err = bt_gatt_discover(dm->conn, &dm->discover_params);
+	if (err) {
+		LOG_ERR("Discover failed, error: %d.", err);
+		discovery_complete_error(dm, err);
+	}
+
+	return BT_GATT_ITER_STOP;
+}
+
+/* Reads the Database Hash of the peer before the service is loaded from
+ * the cache or discovered
+ */
+static int cache_discover(struct bt_gatt_dm *dm)
+{
+	int err;
+
+	dm->read_params.func = db_hash_read_cb;
+	dm->read_params.handle_count = 0;
+	dm->read_params.by_uuid.uuid = &db_hash_uuid.uuid;
+	dm->read_params.by_uuid.start_handle = 0x0001;
+	dm->read_params.by_uuid.end_handle = 0xffff;
+
+	err = bt_gatt_read(dm->conn, &dm->read_params);
+	if (err) {
+		LOG_WRN("Database Hash read failed, error: %d.", err);
+		err = bt_gatt_discover(dm->conn, &dm->discover_params);
+	}
+
+	return err;
+}
+
+static int cache_first_key_cb(const char *key, size_t len,
+			      settings_read_cb read_cb, void *cb_arg,
+			      void *param)
+{
+	char *name = param;
+	size_t name_len;
+
+	if (!key || !len || name[0]) {
+		return 0;
+	}
+
+	name_len = settings_name_next(key, NULL);
+	if (name_len < CACHE_UUID_STR_LEN) {
+		memcpy(name, key, name_len);
+		name[name_len] = '\0';
+	}
+
+	return 0;
+}
+
+int bt_gatt_dm_cache_clear(const bt_addr_le_t *addr)
+{
+	int err;
+	char key[CACHE_KEY_LEN];
+	char name[CACHE_UUID_STR_LEN];
+	size_t len;
+
+	cache_key_encode(key, addr, NULL);
+	len = strlen(key);
+
+	do {
+		name[0] = '\0';
+		err = settings_load_subtree_direct(key, cache_first_key_cb,
+						   name);
+		if (err || !name[0]) {
+			break;
+		}
+
+		snprintk(&key[len], sizeof(key) - len, "/%s", name);
+		err = settings_delete(key);
+		key[len] = '\0';
+	} while (!err);
+
+	return err;
+}
+
+#endif /* CONFIG_BT_GATT_DM_CACHE */
+
 int bt_gatt_dm_start(struct bt_conn *conn,
 		     const struct bt_uuid *svc_uuid,
 		     const struct bt_gatt_dm_cb *cb,
@@ -586,9 +1179,8 @@ int bt_gatt_dm_start(struct bt_conn *conn,
 		return -EINVAL;
 	}
 
-	dm = &bt_gatt_dm_inst;
-
-	if (atomic_test_and_set_bit(dm->state_flags, STATE_ATTRS_LOCKED)) {
+	dm = dm_alloc();
+	if (!dm) {
 		return -EALREADY;
 	}
 
@@ -599,15 +1191,37 @@ int bt_gatt_dm_start(struct bt_conn *conn,
 	sys_slist_init(&dm->chunk_list);
 	dm->cur_chunk_len = 0;
 
-	dm->discover_params.uuid = svc_uuid ? uuid_store(dm, svc_uuid) : NULL;
+	if (svc_uuid) {
+		dm->discover_params.uuid = uuid_store(dm, svc_uuid);
+		if (!dm->discover_params.uuid) {
+			LOG_ERR("Not enough memory for service UUID.");
+			atomic_clear_bit(dm->state_flags, STATE_ATTRS_LOCKED);
+			return -ENOMEM;
+		}
+	} else {
+		dm->discover_params.uuid = NULL;
+	}
+
 	dm->discover_params.func = discovery_callback;
 	dm->discover_params.start_handle = 0x0001;
 	dm->discover_params.end_handle = 0xffff;
 	dm->discover_params.type = BT_GATT_DISCOVER_PRIMARY;
 
-	err = bt_gatt_discover(conn, &dm->discover_params);
+#if CONFIG_BT_GATT_DM_CACHE
+	atomic_clear_bit(dm->state_flags, STATE_CACHE_STORE);
+	k_work_init(&dm->cache_work, cache_work_handler);
+
+	if (svc_uuid && peer_bonded(dm)) {
+		err = cache_discover(dm);
+	} else
+#endif
+	{
+		err = bt_gatt_discover(conn, &dm->discover_params);
+	}
+
 	if (err) {
 		LOG_ERR("Discover failed, error: %d.", err);
+		svc_attr_memory_release(dm);
 		atomic_clear_bit(dm->state_flags, STATE_ATTRS_LOCKED);
 	}
 
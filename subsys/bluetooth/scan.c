@@ -196,6 +196,122 @@ struct bt_scan_filters {
 	bool all_mode;
 };
 
+/* Filter indexes are stored on 8 bits, plus one to tell an empty entry. */
+BUILD_ASSERT((CONFIG_BT_SCAN_NAME_CNT < UINT8_MAX) &&
+	     (CONFIG_BT_SCAN_SHORT_NAME_CNT < UINT8_MAX) &&
+	     (CONFIG_BT_SCAN_ADDRESS_CNT < UINT8_MAX) &&
+	     (CONFIG_BT_SCAN_UUID_CNT < UINT8_MAX) &&
+	     (CONFIG_BT_SCAN_MANUFACTURER_DATA_CNT < UINT8_MAX),
+	     "Too many filters of one type");
+
+/* A string of each filter can add one node per byte. */
+#define TRIE_NODE_CNT(_cnt, _len) ((_cnt) * (_len) + 1)
+
+#define NAME_NODE_CNT \
+	TRIE_NODE_CNT(CONFIG_BT_SCAN_NAME_CNT, CONFIG_BT_SCAN_NAME_MAX_LEN)
+#define SHORT_NAME_NODE_CNT \
+	TRIE_NODE_CNT(CONFIG_BT_SCAN_SHORT_NAME_CNT, \
+		      CONFIG_BT_SCAN_SHORT_NAME_MAX_LEN)
+#define MANUFACTURER_DATA_NODE_CNT \
+	TRIE_NODE_CNT(CONFIG_BT_SCAN_MANUFACTURER_DATA_CNT, \
+		      CONFIG_BT_SCAN_MANUFACTURER_DATA_MAX_LEN)
+
+BUILD_ASSERT((NAME_NODE_CNT <= UINT16_MAX) &&
+	     (SHORT_NAME_NODE_CNT <= UINT16_MAX) &&
+	     (MANUFACTURER_DATA_NODE_CNT <= UINT16_MAX),
+	     "Too many filter bytes");
+
+/* Hash tables are kept at most half full, so that an empty slot ends
+ * a lookup quickly.
+ */
+#define ADDR_SLOT_CNT (2 * CONFIG_BT_SCAN_ADDRESS_CNT + 1)
+#define UUID_SLOT_CNT (2 * CONFIG_BT_SCAN_UUID_CNT + 1)
+
+/* Node of a prefix tree of filter strings. Node 0 is the root, and the
+ * children of a node are linked through their siblings.
+ */
+struct filter_trie_node {
+	/* First child, 0 if none. */
+	uint16_t child;
+
+	/* Next sibling, 0 if none. */
+	uint16_t sibling;
+
+	/* Byte of the strings at the depth of the node. */
+	uint8_t byte;
+
+	/* Index + 1 of the filter whose string ends at this node,
+	 * 0 if none.
+	 */
+	uint8_t end;
+
+	/* Index + 1 of the first filter whose string goes through this node
+	 * and that matches a prefix of this length, 0 if none.
+	 */
+	uint8_t first;
+};
+
+/* Prefix tree of filter strings. */
+struct filter_trie {
+	struct filter_trie_node *nodes;
+
+	/* Number of nodes available. */
+	uint16_t size;
+
+	/* Number of nodes used. */
+	uint16_t cnt;
+};
+
+#define FILTER_TRIE_INIT(_nodes)		\
+	{					\
+		.nodes = _nodes,		\
+		.size = ARRAY_SIZE(_nodes),	\
+		.cnt = 1,			\
+	}
+
+/* UUID filter as compared with the advertised UUIDs. UUIDs that are
+ * 16-bit or 32-bit UUIDs written with the Bluetooth Base UUID are compared
+ * by value.
+ */
+struct filter_uuid_key {
+	/* Value of the UUID, if it is not a 128-bit UUID. */
+	uint32_t val;
+
+	/* Set to true for a 128-bit UUID. */
+	bool is_128;
+};
+
+/* Filters compiled into lookup structures. They are updated when a filter
+ * is added or removed, so that an advertising report is not compared
+ * with each filter.
+ */
+struct bt_scan_filter_index {
+	/* Number of filter types enabled. */
+	uint8_t filter_cnt;
+
+	/* Filter types enabled that check the advertising data. */
+	uint8_t adv_data_mode;
+
+	/* Name filters. */
+	struct filter_trie name;
+	struct filter_trie_node name_nodes[NAME_NODE_CNT];
+
+	/* Short name filters. */
+	struct filter_trie short_name;
+	struct filter_trie_node short_name_nodes[SHORT_NAME_NODE_CNT];
+
+	/* Manufacturer data filters. */
+	struct filter_trie manufacturer_data;
+	struct filter_trie_node manufacturer_data_nodes[MANUFACTURER_DATA_NODE_CNT];
+
+	/* Hash table of the address filters, index + 1 of each filter. */
+	uint8_t addr_slot[ADDR_SLOT_CNT];
+
+	/* Hash table of the UUID filters, index + 1 of each filter. */
+	uint8_t uuid_slot[UUID_SLOT_CNT];
+	struct filter_uuid_key uuid_key[CONFIG_BT_SCAN_UUID_CNT];
+};
+
 #if CONFIG_BT_SCAN_CONN_ATTEMPTS_FILTER
 /* Connection attempts filter device */
 struct conn_attempts_device {
@@ -230,6 +346,53 @@ struct conn_blocklist {
 };
 #endif /* CONFIG_BT_SCAN_BLOCKLIST */
 
+#if CONFIG_BT_SCAN_DEDUP
+/* Advertising report remembered by the deduplication. */
+struct dedup_entry {
+	/* Advertiser address. */
+	bt_addr_le_t addr;
+
+	/* Hash of the report type and advertising data. */
+	uint32_t hash;
+
+	/* Report count when the report was last seen. */
+	uint32_t seen;
+
+	/* Uptime when the report last generated an event, in ms. */
+	uint32_t notified;
+
+#if CONFIG_BT_SCAN_DEDUP_RSSI
+	/* Sum of the RSSI of the deduplicated reports. */
+	int64_t rssi_sum;
+
+	/* Number of the deduplicated reports, not limited to the range of
+	 * the reported count.
+	 */
+	uint32_t rssi_cnt;
+
+	/* RSSI of the deduplicated reports. */
+	struct bt_scan_rssi_stats rssi;
+#endif /* CONFIG_BT_SCAN_DEDUP_RSSI */
+};
+
+/* Advertising report deduplication cache. */
+struct dedup_cache {
+	/* Array of the cached reports. */
+	struct dedup_entry entry[CONFIG_BT_SCAN_DEDUP_CACHE_SIZE];
+
+	/* Count of the cached reports. */
+	size_t count;
+
+	/* Count of the received reports, used to find the least recently
+	 * seen report.
+	 */
+	uint32_t seen;
+
+	/* Deduplication statistics. */
+	struct bt_scan_dedup_stats stats;
+};
+#endif /* CONFIG_BT_SCAN_DEDUP */
+
 /* Scanning module instance. Options for the different scanning modes.
  * This structure stores all module settings. It is used to enable
  * or disable scanning modes and to configure filters.
@@ -238,6 +401,9 @@ static struct bt_scan {
 	/* Filter data. */
 	struct bt_scan_filters scan_filters;
 
+	/* Filter lookup structures. */
+	struct bt_scan_filter_index filter_index;
+
 	/* If set to true, the module automatically connects
 	 * after a filter match.
 	 */
@@ -264,7 +430,20 @@ static struct bt_scan {
 	struct conn_blocklist blocklist;
 #endif /* CONFIG_BT_SCAN_BLOCKLIST */
 
-} bt_scan;
+#if CONFIG_BT_SCAN_DEDUP
+	/* Advertising report deduplication. */
+	struct dedup_cache dedup;
+#endif /* CONFIG_BT_SCAN_DEDUP */
+
+} bt_scan = {
+	.filter_index = {
+		.name = FILTER_TRIE_INIT(bt_scan.filter_index.name_nodes),
+		.short_name =
+		FILTER_TRIE_INIT(bt_scan.filter_index.short_name_nodes),
+		.manufacturer_data =
+		FILTER_TRIE_INIT(bt_scan.filter_index.manufacturer_data_nodes),
+	},
+};
 
 static sys_slist_t callback_list;
 
@@ -501,22 +680,298 @@ static void scan_connect_with_target(struct bt_scan_control *control,
 	}
 }
 
+/* FNV-1a hash. */
+static uint32_t filter_hash(const uint8_t *data, size_t len)
+{
+	uint32_t hash = 2166136261U;
+
+	for (size_t i = 0; i < len; i++) {
+		hash = (hash ^ data[i]) * 16777619U;
+	}
+
+	return hash;
+}
+
+static void trie_reset(struct filter_trie *trie)
+{
+	trie->cnt = 1;
+	memset(&trie->nodes[0], 0, sizeof(trie->nodes[0]));
+}
+
+static uint16_t trie_child_find(const struct filter_trie *trie,
+				uint16_t node, uint8_t byte)
+{
+	uint16_t child = trie->nodes[node].child;
+
+	while (child && (trie->nodes[child].byte != byte)) {
+		child = trie->nodes[child].sibling;
+	}
+
+	return child;
+}
+
+/* Adds the string of a filter. The filter is the first match of the prefixes
+ * that are at least min_len long, if no filter added before matches them.
+ */
+static int trie_insert(struct filter_trie *trie, const uint8_t *str,
+		       size_t len, uint8_t idx, size_t min_len)
+{
+	uint16_t node = 0;
+	uint16_t child;
+
+	for (size_t depth = 0; ; depth++) {
+		if ((depth >= min_len) && !trie->nodes[node].first) {
+			trie->nodes[node].first = idx + 1;
+		}
+
+		if (depth == len) {
+			break;
+		}
+
+		child = trie_child_find(trie, node, str[depth]);
+		if (!child) {
+			if (trie->cnt >= trie->size) {
+				return -ENOMEM;
+			}
+
+			child = trie->cnt++;
+			memset(&trie->nodes[child], 0, sizeof(trie->nodes[0]));
+			trie->nodes[child].byte = str[depth];
+			trie->nodes[child].sibling = trie->nodes[node].child;
+			trie->nodes[node].child = child;
+		}
+
+		node = child;
+	}
+
+	if (!trie->nodes[node].end) {
+		trie->nodes[node].end = idx + 1;
+	}
+
+	return 0;
+}
+
+/* Finds the first filter string that starts with the data, comparing them
+ * as strncmp() does. Returns the filter index + 1, or 0 if none matches.
+ */
+static uint8_t trie_string_find(const struct filter_trie *trie,
+				const uint8_t *data, size_t len)
+{
+	uint16_t node = 0;
+
+	for (size_t i = 0; i < len; i++) {
+		if (data[i] == '\0') {
+			/* The comparison stops at the end of both strings. */
+			return trie->nodes[node].end;
+		}
+
+		node = trie_child_find(trie, node, data[i]);
+		if (!node) {
+			return 0;
+		}
+	}
+
+	return trie->nodes[node].first;
+}
+
+/* Finds the first filter string that the data starts with. Returns the
+ * filter index + 1, or 0 if none matches.
+ */
+static uint8_t trie_prefix_find(const struct filter_trie *trie,
+				const uint8_t *data, size_t len)
+{
+	uint16_t node = 0;
+	uint8_t match = 0;
+
+	for (size_t i = 0; i < len; i++) {
+		node = trie_child_find(trie, node, data[i]);
+		if (!node) {
+			break;
+		}
+
+		if (trie->nodes[node].end &&
+		    (!match || (trie->nodes[node].end < match))) {
+			match = trie->nodes[node].end;
+		}
+	}
+
+	return match;
+}
+
+static size_t addr_slot_get(const bt_addr_le_t *addr)
+{
+	return filter_hash((const uint8_t *)addr, sizeof(*addr)) %
+	       ADDR_SLOT_CNT;
+}
+
+static uint8_t addr_index_find(const bt_addr_le_t *addr)
+{
+	const struct bt_scan_filter_index *index = &bt_scan.filter_index;
+	const bt_addr_le_t *target_addr = bt_scan.scan_filters.addr.target_addr;
+	size_t slot = addr_slot_get(addr);
+
+	while (index->addr_slot[slot]) {
+		if (!bt_addr_le_cmp(addr,
+				    &target_addr[index->addr_slot[slot] - 1])) {
+			return index->addr_slot[slot];
+		}
+
+		slot = (slot + 1) % ADDR_SLOT_CNT;
+	}
+
+	return 0;
+}
+
+static void addr_index_add(const bt_addr_le_t *addr, uint8_t idx)
+{
+	struct bt_scan_filter_index *index = &bt_scan.filter_index;
+	size_t slot = addr_slot_get(addr);
+
+	while (index->addr_slot[slot]) {
+		slot = (slot + 1) % ADDR_SLOT_CNT;
+	}
+
+	index->addr_slot[slot] = idx + 1;
+}
+
+/* Little-endian Bluetooth Base UUID, without the 32-bit value. */
+static const uint8_t uuid_base[] = {
+	0xfb, 0x34, 0x9b, 0x5f, 0x80, 0x00, 0x00, 0x80, 0x00, 0x10, 0x00, 0x00
+};
+
+/* Reads an advertised UUID. */
+static void uuid_key_get(const uint8_t *data, size_t uuid_len,
+			 struct filter_uuid_key *key)
+{
+	switch (uuid_len) {
+	case sizeof(uint16_t):
+		key->val = sys_get_le16(data);
+		key->is_128 = false;
+		break;
+
+	case sizeof(uint32_t):
+		key->val = sys_get_le32(data);
+		key->is_128 = false;
+		break;
+
+	default:
+		key->is_128 = (memcmp(data, uuid_base, sizeof(uuid_base)) != 0);
+		key->val = sys_get_le32(&data[sizeof(uuid_base)]);
+		break;
+	}
+}
+
+static size_t uuid_slot_get(const uint8_t *data,
+			    const struct filter_uuid_key *key)
+{
+	if (key->is_128) {
+		return filter_hash(data, BT_SCAN_UUID_128_SIZE) % UUID_SLOT_CNT;
+	}
+
+	return filter_hash((const uint8_t *)&key->val, sizeof(key->val)) %
+	       UUID_SLOT_CNT;
+}
+
+static bool uuid_key_cmp(const struct filter_uuid_key *key,
+			 const uint8_t *data, uint8_t idx)
+{
+	const struct bt_scan_filter_index *index = &bt_scan.filter_index;
+	const struct bt_scan_uuid *target_uuid = bt_scan.scan_filters.uuid.uuid;
+
+	if (key->is_128 != index->uuid_key[idx].is_128) {
+		return false;
+	}
+
+	if (key->is_128) {
+		return memcmp(data, target_uuid[idx].uuid_data.uuid_128.val,
+			      BT_SCAN_UUID_128_SIZE) == 0;
+	}
+
+	return key->val == index->uuid_key[idx].val;
+}
+
+/* Finds the filter of an advertised UUID, returns its index + 1, or 0 if no
+ * filter has this UUID.
+ */
+static uint8_t uuid_index_find(const uint8_t *data, size_t uuid_len)
+{
+	const struct bt_scan_filter_index *index = &bt_scan.filter_index;
+	struct filter_uuid_key key;
+	size_t slot;
+
+	uuid_key_get(data, uuid_len, &key);
+	slot = uuid_slot_get(data, &key);
+
+	while (index->uuid_slot[slot]) {
+		if (uuid_key_cmp(&key, data, index->uuid_slot[slot] - 1)) {
+			return index->uuid_slot[slot];
+		}
+
+		slot = (slot + 1) % UUID_SLOT_CNT;
+	}
+
+	return 0;
+}
+
+static void uuid_index_add(const struct bt_uuid *uuid, uint8_t idx)
+{
+	struct bt_scan_filter_index *index = &bt_scan.filter_index;
+	struct filter_uuid_key *key = &index->uuid_key[idx];
+	const uint8_t *data = NULL;
+	size_t slot;
+
+	switch (uuid->type) {
+	case BT_UUID_TYPE_16:
+		key->val = BT_UUID_16(uuid)->val;
+		key->is_128 = false;
+		break;
+
+	case BT_UUID_TYPE_32:
+		key->val = BT_UUID_32(uuid)->val;
+		key->is_128 = false;
+		break;
+
+	default:
+		data = BT_UUID_128(uuid)->val;
+		uuid_key_get(data, BT_SCAN_UUID_128_SIZE, key);
+		break;
+	}
+
+	slot = uuid_slot_get(data, key);
+
+	while (index->uuid_slot[slot]) {
+		slot = (slot + 1) % UUID_SLOT_CNT;
+	}
+
+	index->uuid_slot[slot] = idx + 1;
+}
+
+static void filter_index_reset(void)
+{
+	struct bt_scan_filter_index *index = &bt_scan.filter_index;
+
+	trie_reset(&index->name);
+	trie_reset(&index->short_name);
+	trie_reset(&index->manufacturer_data);
+
+	memset(index->addr_slot, 0, sizeof(index->addr_slot));
+	memset(index->uuid_slot, 0, sizeof(index->uuid_slot));
+}
+
 static bool adv_addr_compare(const bt_addr_le_t *target_addr,
 			     struct bt_scan_control *control)
 {
 	const bt_addr_le_t *addr =
 			bt_scan.scan_filters.addr.target_addr;
-	uint8_t counter = bt_scan.scan_filters.addr.cnt;
-
-	for (size_t i = 0; i < counter; i++) {
-		if (bt_addr_le_cmp(target_addr, &addr[i]) == 0) {
-			control->filter_status.addr.addr = &addr[i];
+	uint8_t idx = addr_index_find(target_addr);
 
-			return true;
-		}
+	if (!idx) {
+		return false;
 	}
 
-	return false;
+	control->filter_status.addr.addr = &addr[idx - 1];
+
+	return true;
 }
 
 static bool is_addr_filter_enabled(void)
@@ -559,6 +1014,7 @@ static int scan_addr_filter_add(const bt_addr_le_t *target_addr)
 
 	/* Add target address to filter. */
 	bt_addr_le_copy(&addr_filter[counter], target_addr);
+	addr_index_add(target_addr, counter);
 
 	LOG_DBG("Filter set on address type %i",
 		addr_filter[counter].type);
@@ -573,36 +1029,25 @@ static int scan_addr_filter_add(const bt_addr_le_t *target_addr)
 	return 0;
 }
 
-static bool adv_name_cmp(const uint8_t *data,
-			 uint8_t data_len,
-			 const char *target_name)
-{
-	return strncmp(target_name, data, data_len) == 0;
-}
-
 static bool adv_name_compare(const struct bt_data *data,
 			     struct bt_scan_control *control)
 {
 	struct bt_scan_name_filter const *name_filter =
 			&bt_scan.scan_filters.name;
-	uint8_t counter = bt_scan.scan_filters.name.cnt;
 	uint8_t data_len = data->data_len;
+	uint8_t idx;
 
-	/* Compare the name found with the name filter. */
-	for (size_t i = 0; i < counter; i++) {
-		if (adv_name_cmp(data->data,
-				 data_len,
-				 name_filter->target_name[i])) {
-
-			control->filter_status.name.name =
-				name_filter->target_name[i];
-			control->filter_status.name.len = data_len;
-
-			return true;
-		}
+	/* Find the first name filter that starts with the name found. */
+	idx = trie_string_find(&bt_scan.filter_index.name, data->data,
+			       data_len);
+	if (!idx) {
+		return false;
 	}
 
-	return false;
+	control->filter_status.name.name = name_filter->target_name[idx - 1];
+	control->filter_status.name.len = data_len;
+
+	return true;
 }
 
 static inline bool is_name_filter_enabled(void)
@@ -628,6 +1073,7 @@ static int scan_name_filter_add(const char *name)
 {
 	uint8_t counter = bt_scan.scan_filters.name.cnt;
 	size_t name_len;
+	int err;
 
 	/* If no memory for filter. */
 	if (counter >= CONFIG_BT_SCAN_NAME_CNT) {
@@ -648,7 +1094,17 @@ static int scan_name_filter_add(const char *name)
 		}
 	}
 
-	/* Add name to filter. */
+	err = trie_insert(&bt_scan.filter_index.name, (const uint8_t *)name,
+			  name_len, counter, 0);
+	if (err) {
+		return err;
+	}
+
+	/* Add name to filter. The rest of a name added before
+	 * bt_scan_filter_remove_all() is cleared.
+	 */
+	memset(bt_scan.scan_filters.name.target_name[counter], 0,
+	       sizeof(bt_scan.scan_filters.name.target_name[counter]));
 	memcpy(bt_scan.scan_filters.name.target_name[counter],
 	       name, name_len);
 
@@ -659,43 +1115,28 @@ static int scan_name_filter_add(const char *name)
 	return 0;
 }
 
-static bool adv_short_name_cmp(const uint8_t *data,
-			       uint8_t data_len,
-			       const char *target_name,
-			       uint8_t short_name_min_len)
-{
-	if ((data_len >= short_name_min_len) &&
-	    (strncmp(target_name, data, data_len) == 0)) {
-		return true;
-	}
-
-	return false;
-}
-
 static bool adv_short_name_compare(const struct bt_data *data,
 				   struct bt_scan_control *control)
 {
 	const struct bt_scan_short_name_filter *name_filter =
 			&bt_scan.scan_filters.short_name;
-	uint8_t counter = bt_scan.scan_filters.short_name.cnt;
 	uint8_t data_len = data->data_len;
+	uint8_t idx;
 
-	/* Compare the name found with the name filters. */
-	for (size_t i = 0; i < counter; i++) {
-		if (adv_short_name_cmp(data->data,
-				       data_len,
-				       name_filter->name[i].target_name,
-				       name_filter->name[i].min_len)) {
-
-			control->filter_status.short_name.name =
-				name_filter->name[i].target_name;
-			control->filter_status.short_name.len = data_len;
-
-			return true;
-		}
+	/* Find the first short name filter that starts with the name found,
+	 * and that is not longer than the name found.
+	 */
+	idx = trie_string_find(&bt_scan.filter_index.short_name, data->data,
+			       data_len);
+	if (!idx || (data_len < name_filter->name[idx - 1].min_len)) {
+		return false;
 	}
 
-	return false;
+	control->filter_status.short_name.name =
+		name_filter->name[idx - 1].target_name;
+	control->filter_status.short_name.len = data_len;
+
+	return true;
 }
 
 static inline bool is_short_name_filter_enabled(void)
@@ -724,6 +1165,7 @@ static int scan_short_name_filter_add(const struct bt_scan_short_name *short_nam
 	struct bt_scan_short_name_filter *short_name_filter =
 		    &bt_scan.scan_filters.short_name;
 	uint8_t name_len;
+	int err;
 
 	/* If no memory for filter. */
 	if (counter >= CONFIG_BT_SCAN_SHORT_NAME_CNT) {
@@ -746,7 +1188,16 @@ static int scan_short_name_filter_add(const struct bt_scan_short_name *short_nam
 		}
 	}
 
+	err = trie_insert(&bt_scan.filter_index.short_name,
+			  (const uint8_t *)short_name->name, name_len, counter,
+			  short_name->min_len);
+	if (err) {
+		return err;
+	}
+
 	/* Add name to the filter. */
+	memset(short_name_filter->name[counter].target_name, 0,
+	       sizeof(short_name_filter->name[counter].target_name));
 	short_name_filter->name[counter].min_len = short_name->min_len;
 	memcpy(short_name_filter->name[counter].target_name,
 	       short_name->name,
@@ -759,12 +1210,14 @@ static int scan_short_name_filter_add(const struct bt_scan_short_name *short_nam
 	return 0;
 }
 
-static bool find_uuid(const uint8_t *data,
-		      uint8_t data_len,
-		      uint8_t uuid_type,
-		      const struct bt_scan_uuid *target_uuid)
+/* Finds the UUID filters of the advertised UUIDs. */
+static bool find_uuids(const uint8_t *data,
+		       uint8_t data_len,
+		       uint8_t uuid_type,
+		       uint32_t *found)
 {
 	uint8_t uuid_len;
+	uint8_t idx;
 
 	switch (uuid_type) {
 	case BT_UUID_TYPE_16:
@@ -783,19 +1236,14 @@ static bool find_uuid(const uint8_t *data,
 		return false;
 	}
 
-	for (size_t i = 0; i < data_len; i += uuid_len) {
-		struct bt_uuid_128 uuid;
-
-		if (!bt_uuid_create(&uuid.uuid, &data[i], uuid_len)) {
-			return false;
-		}
-
-		if (bt_uuid_cmp(&uuid.uuid, target_uuid->uuid) == 0) {
-			return true;
+	for (size_t i = 0; i + uuid_len <= data_len; i += uuid_len) {
+		idx = uuid_index_find(&data[i], uuid_len);
+		if (idx) {
+			found[(idx - 1) / 32] |= BIT((idx - 1) % 32);
 		}
 	}
 
-	return false;
+	return true;
 }
 
 static bool adv_uuid_compare(const struct bt_data *data, uint8_t uuid_type,
@@ -807,11 +1255,18 @@ static bool adv_uuid_compare(const struct bt_data *data, uint8_t uuid_type,
 	const uint8_t counter = bt_scan.scan_filters.uuid.cnt;
 	uint8_t data_len = data->data_len;
 	uint8_t uuid_match_cnt = 0;
+	uint32_t found[DIV_ROUND_UP(CONFIG_BT_SCAN_UUID_CNT, 32)];
+
+	memset(found, 0, sizeof(found));
+
+	if (!find_uuids(data->data, data_len, uuid_type, found)) {
+		return false;
+	}
 
+	/* The matched filters are reported in the order they were added. */
 	for (size_t i = 0; i < counter; i++) {
 
-		if (find_uuid(data->data, data_len, uuid_type,
-			      &uuid_filter->uuid[i])) {
+		if (found[i / 32] & BIT(i % 32)) {
 			control->filter_status.uuid.uuid[uuid_match_cnt] =
 				uuid_filter->uuid[i].uuid;
 
@@ -883,6 +1338,8 @@ static int scan_uuid_filter_add(struct bt_uuid *uuid)
 	}
 
 	/* Add UUID to the filter. */
+	uuid_index_add(uuid, counter);
+
 	switch (uuid->type) {
 	case BT_UUID_TYPE_16:
 		uuid_16 = BT_UUID_16(uuid);
@@ -1029,25 +1486,23 @@ static bool adv_manufacturer_data_compare(const struct bt_data *data,
 {
 	const struct bt_scan_manufacturer_data_filter *md_filter =
 		&bt_scan.scan_filters.manufacturer_data;
-	uint8_t counter = bt_scan.scan_filters.manufacturer_data.cnt;
+	uint8_t idx;
 
-	/* Compare the name found with the name filter. */
-	for (size_t i = 0; i < counter; i++) {
-		if (adv_manufacturer_data_cmp(data->data,
-				data->data_len,
-				md_filter->manufacturer_data[i].data,
-				md_filter->manufacturer_data[i].data_len)) {
-
-			control->filter_status.manufacturer_data.data =
-				md_filter->manufacturer_data[i].data;
-			control->filter_status.manufacturer_data.len =
-				md_filter->manufacturer_data[i].data_len;
-
-			return true;
-		}
+	/* Find the first manufacturer data filter that the data found
+	 * starts with.
+	 */
+	idx = trie_prefix_find(&bt_scan.filter_index.manufacturer_data,
+			       data->data, data->data_len);
+	if (!idx) {
+		return false;
 	}
 
-	return false;
+	control->filter_status.manufacturer_data.data =
+		md_filter->manufacturer_data[idx - 1].data;
+	control->filter_status.manufacturer_data.len =
+		md_filter->manufacturer_data[idx - 1].data_len;
+
+	return true;
 }
 static inline bool is_manufacturer_data_filter_enabled(void)
 {
@@ -1074,6 +1529,7 @@ static int scan_manufacturer_data_filter_add(const struct bt_scan_manufacturer_d
 	struct bt_scan_manufacturer_data_filter *md_filter =
 		&bt_scan.scan_filters.manufacturer_data;
 	uint8_t counter = bt_scan.scan_filters.manufacturer_data.cnt;
+	int err;
 
 	/* If no memory for filter. */
 	if (counter >= CONFIG_BT_SCAN_MANUFACTURER_DATA_CNT) {
@@ -1097,6 +1553,16 @@ static int scan_manufacturer_data_filter_add(const struct bt_scan_manufacturer_d
 		}
 	}
 
+	/* Manufacturer data filters match the data that starts with them,
+	 * whatever its length.
+	 */
+	err = trie_insert(&bt_scan.filter_index.manufacturer_data,
+			  manufacturer_data->data, manufacturer_data->data_len,
+			  counter, SIZE_MAX);
+	if (err) {
+		return err;
+	}
+
 	/* Add manufacturer data to filter. */
 	memcpy(md_filter->manufacturer_data[counter].data,
 			manufacturer_data->data, manufacturer_data->data_len);
@@ -1151,6 +1617,41 @@ static void scan_default_conn_param_set(void)
 	bt_scan.conn_param = *conn_param;
 }
 
+/* Updates the filter types checked in the advertising reports. */
+static void filter_index_mode_update(void)
+{
+	struct bt_scan_filter_index *index = &bt_scan.filter_index;
+	const struct {
+		bool enabled;
+		uint8_t mode;
+	} types[] = {
+		{is_addr_filter_enabled(), BT_SCAN_ADDR_FILTER},
+		{is_name_filter_enabled(), BT_SCAN_NAME_FILTER},
+		{is_short_name_filter_enabled(), BT_SCAN_SHORT_NAME_FILTER},
+		{is_uuid_filter_enabled(), BT_SCAN_UUID_FILTER},
+		{is_appearance_filter_enabled(), BT_SCAN_APPEARANCE_FILTER},
+		{is_manufacturer_data_filter_enabled(),
+		 BT_SCAN_MANUFACTURER_DATA_FILTER},
+	};
+
+	k_mutex_lock(&scan_mutex, K_FOREVER);
+
+	index->filter_cnt = 0;
+	index->adv_data_mode = 0;
+
+	for (size_t i = 0; i < ARRAY_SIZE(types); i++) {
+		if (types[i].enabled) {
+			index->filter_cnt++;
+			index->adv_data_mode |= types[i].mode;
+		}
+	}
+
+	/* The address is not part of the advertising data. */
+	index->adv_data_mode &= ~BT_SCAN_ADDR_FILTER;
+
+	k_mutex_unlock(&scan_mutex);
+}
+
 int bt_scan_filter_add(enum bt_scan_filter_type type,
 		       const void *data)
 {
@@ -1204,6 +1705,10 @@ int bt_scan_filter_add(enum bt_scan_filter_type type,
 		break;
 	}
 
+	if (!err) {
+		filter_index_mode_update();
+	}
+
 	k_mutex_unlock(&scan_mutex);
 
 	return err;
@@ -1237,6 +1742,9 @@ void bt_scan_filter_remove_all(void)
 		&bt_scan.scan_filters.manufacturer_data;
 	manufacturer_data_filter->cnt = 0;
 
+	filter_index_reset();
+	filter_index_mode_update();
+
 	k_mutex_unlock(&scan_mutex);
 }
 
@@ -1249,6 +1757,8 @@ void bt_scan_filter_disable(void)
 	bt_scan.scan_filters.uuid.enabled = false;
 	bt_scan.scan_filters.appearance.enabled = false;
 	bt_scan.scan_filters.manufacturer_data.enabled = false;
+
+	filter_index_mode_update();
 }
 
 int bt_scan_filter_enable(uint8_t mode, bool match_all)
@@ -1291,6 +1801,8 @@ int bt_scan_filter_enable(uint8_t mode, bool match_all)
 	/* Select the filter mode. */
 	filters->all_mode = match_all;
 
+	filter_index_mode_update();
+
 	return 0;
 }
 
@@ -1331,6 +1843,12 @@ void bt_scan_init(const struct bt_scan_init_param *init)
 
 	/* Disable all scanning filters. */
 	memset(&bt_scan.scan_filters, 0, sizeof(bt_scan.scan_filters));
+	filter_index_reset();
+	filter_index_mode_update();
+
+#if CONFIG_BT_SCAN_DEDUP
+	memset(&bt_scan.dedup, 0, sizeof(bt_scan.dedup));
+#endif /* CONFIG_BT_SCAN_DEDUP */
 
 	/* If the pointer to the initialization structure exist,
 	 * use it to scan the configuration.
@@ -1369,35 +1887,6 @@ void bt_scan_update_init_conn_params(struct bt_le_conn_param *new_conn_param)
 	bt_scan.conn_param = *new_conn_param;
 }
 
-static void check_enabled_filters(struct bt_scan_control *control)
-{
-	control->filter_cnt = 0;
-
-	if (is_addr_filter_enabled()) {
-		control->filter_cnt++;
-	}
-
-	if (is_name_filter_enabled()) {
-		control->filter_cnt++;
-	}
-
-	if (is_short_name_filter_enabled()) {
-		control->filter_cnt++;
-	}
-
-	if (is_uuid_filter_enabled()) {
-		control->filter_cnt++;
-	}
-
-	if (is_appearance_filter_enabled()) {
-		control->filter_cnt++;
-	}
-
-	if (is_manufacturer_data_filter_enabled()) {
-		control->filter_cnt++;
-	}
-}
-
 static bool adv_data_found(struct bt_data *data, void *user_data)
 {
 	struct bt_scan_control *scan_control =
@@ -1448,6 +1937,126 @@ static bool adv_data_found(struct bt_data *data, void *user_data)
 	return true;
 }
 
+#if CONFIG_BT_SCAN_DEDUP
+static void dedup_entry_init(struct dedup_entry *entry,
+			     const bt_addr_le_t *addr, uint32_t hash)
+{
+	memset(entry, 0, sizeof(*entry));
+	bt_addr_le_copy(&entry->addr, addr);
+	entry->hash = hash;
+}
+
+#if CONFIG_BT_SCAN_DEDUP_RSSI
+static void dedup_rssi_add(struct dedup_entry *entry, int8_t rssi)
+{
+	struct bt_scan_rssi_stats *stats = &entry->rssi;
+
+	if (!entry->rssi_cnt || (rssi < stats->min)) {
+		stats->min = rssi;
+	}
+
+	if (!entry->rssi_cnt || (rssi > stats->max)) {
+		stats->max = rssi;
+	}
+
+	if (entry->rssi_cnt < UINT32_MAX) {
+		entry->rssi_sum += rssi;
+		entry->rssi_cnt++;
+	}
+}
+
+/* Gives the RSSI of the deduplicated reports and starts a new period. */
+static bool dedup_rssi_take(struct dedup_entry *entry,
+			    struct bt_scan_rssi_stats *rssi_stats)
+{
+	if (!entry->rssi_cnt) {
+		return false;
+	}
+
+	*rssi_stats = entry->rssi;
+	rssi_stats->count = MIN(entry->rssi_cnt, UINT16_MAX);
+	rssi_stats->avg = entry->rssi_sum / entry->rssi_cnt;
+
+	memset(&entry->rssi, 0, sizeof(entry->rssi));
+	entry->rssi_sum = 0;
+	entry->rssi_cnt = 0;
+
+	return true;
+}
+#endif /* CONFIG_BT_SCAN_DEDUP_RSSI */
+
+/* Returns true if the report repeats a recent report of the device and
+ * must not generate any event. Otherwise, gives the RSSI of the reports
+ * that were deduplicated since the previous event, if any.
+ */
+static bool dedup_check(const struct bt_le_scan_recv_info *info,
+			const struct net_buf_simple *ad,
+			struct bt_scan_rssi_stats *rssi_stats,
+			bool *rssi_valid)
+{
+	struct dedup_cache *cache = &bt_scan.dedup;
+	struct dedup_entry *entry = NULL;
+	struct dedup_entry *oldest = &cache->entry[0];
+	uint32_t now = k_uptime_get_32();
+	uint32_t hash;
+
+	/* Scan responses and advertising data of a device are cached apart,
+	 * they would replace each other otherwise.
+	 */
+	hash = filter_hash(ad->data, ad->len) ^
+	       (((uint32_t)info->adv_type << 16) | info->adv_props);
+
+	cache->seen++;
+
+	for (size_t i = 0; i < cache->count; i++) {
+		if ((cache->entry[i].hash == hash) &&
+		    !bt_addr_le_cmp(&cache->entry[i].addr, info->addr)) {
+			entry = &cache->entry[i];
+			break;
+		}
+
+		if ((cache->seen - cache->entry[i].seen) >
+		    (cache->seen - oldest->seen)) {
+			oldest = &cache->entry[i];
+		}
+	}
+
+	if (entry) {
+		entry->seen = cache->seen;
+
+		if ((CONFIG_BT_SCAN_DEDUP_TTL_MS == 0) ||
+		    ((now - entry->notified) < CONFIG_BT_SCAN_DEDUP_TTL_MS)) {
+			cache->stats.hits++;
+#if CONFIG_BT_SCAN_DEDUP_RSSI
+			dedup_rssi_add(entry, info->rssi);
+#endif /* CONFIG_BT_SCAN_DEDUP_RSSI */
+
+			return true;
+		}
+
+#if CONFIG_BT_SCAN_DEDUP_RSSI
+		*rssi_valid = dedup_rssi_take(entry, rssi_stats);
+#endif /* CONFIG_BT_SCAN_DEDUP_RSSI */
+	} else {
+		if (cache->count < ARRAY_SIZE(cache->entry)) {
+			entry = &cache->entry[cache->count];
+			cache->count++;
+		} else {
+			entry = oldest;
+			cache->stats.evictions++;
+		}
+
+		dedup_entry_init(entry, info->addr, hash);
+		entry->seen = cache->seen;
+	}
+
+	entry->notified = now;
+	cache->stats.misses++;
+
+	return false;
+}
+#endif /* CONFIG_BT_SCAN_DEDUP */
+
 static void filter_state_check(struct bt_scan_control *control,
 			       const bt_addr_le_t *addr)
 {
@@ -1482,12 +2091,22 @@ static void scan_recv(const struct bt_le_scan_recv_info *info,
 {
 	struct bt_scan_control scan_control;
 	struct net_buf_simple_state state;
+	struct bt_scan_rssi_stats rssi_stats;
+	bool rssi_valid = false;
 
 	memset(&scan_control, 0, sizeof(scan_control));
 
-	scan_control.all_mode = bt_scan.scan_filters.all_mode;
+	k_mutex_lock(&scan_mutex, K_FOREVER);
+
+#if CONFIG_BT_SCAN_DEDUP
+	if (dedup_check(info, ad, &rssi_stats, &rssi_valid)) {
+		k_mutex_unlock(&scan_mutex);
+		return;
+	}
+#endif /* CONFIG_BT_SCAN_DEDUP */
 
-	check_enabled_filters(&scan_control);
+	scan_control.all_mode = bt_scan.scan_filters.all_mode;
+	scan_control.filter_cnt = bt_scan.filter_index.filter_cnt;
 
 	/* Check id device is connectable. */
 	scan_control.connectable =
@@ -1496,17 +2115,26 @@ static void scan_recv(const struct bt_le_scan_recv_info *info,
 	/* Check the address filter. */
 	check_addr(&scan_control, info->addr);
 
-	/* Save advertising buffer state to transfer it
+	/* The advertising data is parsed only if a filter can match it.
+	 * Save advertising buffer state to transfer it
 	 * data to application if futher processing is needed.
 	 */
-	net_buf_simple_save(ad, &state);
-	bt_data_parse(ad, adv_data_found, (void *)&scan_control);
-	net_buf_simple_restore(ad, &state);
+	if (bt_scan.filter_index.adv_data_mode) {
+		net_buf_simple_save(ad, &state);
+		bt_data_parse(ad, adv_data_found, (void *)&scan_control);
+		net_buf_simple_restore(ad, &state);
+	}
+
+	k_mutex_unlock(&scan_mutex);
 
 	scan_control.device_info.recv_info = info;
 	scan_control.device_info.conn_param = &bt_scan.conn_param;
 	scan_control.device_info.adv_data = ad;
 
+	if (rssi_valid) {
+		scan_control.device_info.rssi_stats = &rssi_stats;
+	}
+
 	/* In the multifilter mode, the number of the active filters must equal
 	 * the number of the filters matched to generate the notification.
 	 * If the event handler is not NULL, notify the main application.
@@ -1533,6 +2161,13 @@ int bt_scan_start(enum bt_scan_type scan_type)
 		return -EINVAL;
 	}
 
+#if CONFIG_BT_SCAN_DEDUP
+	/* The first report of each device generates an event again. */
+	k_mutex_lock(&scan_mutex, K_FOREVER);
+	bt_scan.dedup.count = 0;
+	k_mutex_unlock(&scan_mutex);
+#endif /* CONFIG_BT_SCAN_DEDUP */
+
 	/* Start the scanning. */
 	int err = bt_le_scan_start(&bt_scan.scan_param, NULL);
 
@@ -1617,3 +2252,19 @@ void bt_scan_conn_attempts_filter_clear(void)
 	k_mutex_unlock(&scan_mutex);
 }
 #endif /* CONFIG_BT_SCAN_CONN_ATTEMPTS_FILTER */
+
+#if CONFIG_BT_SCAN_DEDUP
+void bt_scan_dedup_stats_get(struct bt_scan_dedup_stats *stats)
+{
+	k_mutex_lock(&scan_mutex, K_FOREVER);
+	*stats = bt_scan.dedup.stats;
+	k_mutex_unlock(&scan_mutex);
+}
+
+void bt_scan_dedup_clear(void)
+{
+	k_mutex_lock(&scan_mutex, K_FOREVER);
+	memset(&bt_scan.dedup, 0, sizeof(bt_scan.dedup));
+	k_mutex_unlock(&scan_mutex);
+}
+#endif /* CONFIG_BT_SCAN_DEDUP */
@@ -4,6 +4,9 @@
  * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
  */
 
+#include <zephyr.h>
+#include <string.h>
+#include <sys/ring_buffer.h>
 #include <bluetooth/conn.h>
 #include <bluetooth/uuid.h>
 #include <bluetooth/gatt.h>
@@ -13,11 +16,24 @@
 
 LOG_MODULE_REGISTER(bt_nus, CONFIG_BT_NUS_LOG_LEVEL);
 
+/* Delay before sending again the notifications that the Bluetooth stack
+ * could not take.
+ */
+#define STREAM_RETRY_DELAY K_MSEC(10)
+
 static struct bt_nus_cb nus_cb;
 
+#if CONFIG_BT_NUS_STREAM
+static void stream_ccc_cfg_changed(void);
+#endif
+
 static void nus_ccc_cfg_changed(const struct bt_gatt_attr *attr,
 				  uint16_t value)
 {
+#if CONFIG_BT_NUS_STREAM
+	stream_ccc_cfg_changed();
+#endif
+
 	if (nus_cb.send_enabled) {
 		LOG_DBG("Notification has been turned %s",
 			value == BT_GATT_CCC_NOTIFY ? "on" : "off");
@@ -68,6 +84,309 @@ BT_GATT_PRIMARY_SERVICE(BT_UUID_NUS_SERVICE),
 			       NULL, on_receive, NULL),
 );
 
+#if CONFIG_BT_NUS_STREAM
+enum {
+	STREAM_RESET,
+};
+
+struct nus_stream {
+	struct bt_conn *conn;
+	struct k_mutex lock;
+	struct ring_buf rb;
+	uint8_t buf[CONFIG_BT_NUS_STREAM_BUF_SIZE];
+	struct k_sem space_sem;
+	struct k_delayed_work tx_work;
+	atomic_t in_flight;
+	ATOMIC_DEFINE(flags, 1);
+	uint32_t tx_start;
+	struct bt_nus_stream_stats stats;
+};
+
+static struct nus_stream streams[CONFIG_BT_MAX_CONN];
+static bool stream_initialized;
+
+/* The notifications are prepared in the system workqueue only. */
+static uint8_t stream_tx_data[CONFIG_BT_L2CAP_TX_MTU - 3];
+
+static struct nus_stream *stream_get(struct bt_conn *conn)
+{
+	return &streams[bt_conn_index(conn)];
+}
+
+static void stream_reset(struct nus_stream *stream)
+{
+	k_mutex_lock(&stream->lock, K_FOREVER);
+	ring_buf_reset(&stream->rb);
+	atomic_set(&stream->in_flight, 0);
+	memset(&stream->stats, 0, sizeof(stream->stats));
+
+	if (stream->conn) {
+		bt_conn_unref(stream->conn);
+		stream->conn = NULL;
+	}
+
+	k_mutex_unlock(&stream->lock);
+
+	/* Wake up the writer, which finds that the peer is gone. */
+	k_sem_give(&stream->space_sem);
+}
+
+static void stream_drop(struct nus_stream *stream)
+{
+	k_mutex_lock(&stream->lock, K_FOREVER);
+	ring_buf_reset(&stream->rb);
+	k_mutex_unlock(&stream->lock);
+
+	k_sem_give(&stream->space_sem);
+}
+
+static void stream_sent(struct bt_conn *conn, void *user_data)
+{
+	struct nus_stream *stream = user_data;
+
+	if (atomic_dec(&stream->in_flight) <= 0) {
+		/* The stream was reset when the peer disconnected. */
+		atomic_set(&stream->in_flight, 0);
+		return;
+	}
+
+	stream->stats.tx_time = k_uptime_get_32() - stream->tx_start;
+	k_delayed_work_submit(&stream->tx_work, K_NO_WAIT);
+}
+
+static int stream_notify(struct nus_stream *stream)
+{
+	struct bt_gatt_notify_params params = {0};
+	uint32_t mtu;
+	uint32_t len = 0;
+	uint8_t *data;
+	int err;
+
+	mtu = MIN(bt_nus_get_mtu(stream->conn), sizeof(stream_tx_data));
+
+	k_mutex_lock(&stream->lock, K_FOREVER);
+
+	/* The data may wrap around the end of the buffer, the second claim
+	 * gives the data from the start of the buffer.
+	 */
+	for (size_t i = 0; (i < 2) && (len < mtu); i++) {
+		uint32_t size = ring_buf_get_claim(&stream->rb, &data,
+						   mtu - len);
+
+		memcpy(&stream_tx_data[len], data, size);
+		len += size;
+	}
+
+	k_mutex_unlock(&stream->lock);
+
+	if (len == 0) {
+		return -ENODATA;
+	}
+
+	params.attr = &nus_svc.attrs[2];
+	params.data = stream_tx_data;
+	params.len = len;
+	params.func = stream_sent;
+	params.user_data = stream;
+
+	if (stream->stats.tx_notif == 0) {
+		stream->tx_start = k_uptime_get_32();
+	}
+
+	atomic_inc(&stream->in_flight);
+
+	err = bt_gatt_notify_cb(stream->conn, &params);
+
+	k_mutex_lock(&stream->lock, K_FOREVER);
+	ring_buf_get_finish(&stream->rb, err ? 0 : len);
+	k_mutex_unlock(&stream->lock);
+
+	if (err) {
+		atomic_dec(&stream->in_flight);
+		return err;
+	}
+
+	stream->stats.tx_bytes += len;
+	stream->stats.tx_notif++;
+
+	k_sem_give(&stream->space_sem);
+
+	return 0;
+}
+
+static void stream_tx_work_handler(struct k_work *work)
+{
+	struct nus_stream *stream = CONTAINER_OF(work, struct nus_stream,
+						 tx_work.work);
+	int err;
+
+	if (atomic_test_and_clear_bit(stream->flags, STREAM_RESET)) {
+		stream_reset(stream);
+		return;
+	}
+
+	if (!stream->conn) {
+		return;
+	}
+
+	if (!bt_gatt_is_subscribed(stream->conn, &nus_svc.attrs[2],
+				   BT_GATT_CCC_NOTIFY)) {
+		LOG_DBG("Notifications disabled, stream data dropped");
+		stream_drop(stream);
+		return;
+	}
+
+	while (atomic_get(&stream->in_flight) < CONFIG_BT_NUS_STREAM_TX_MAX) {
+		err = stream_notify(stream);
+		if (err == -ENODATA) {
+			break;
+		} else if (err == -ENOMEM || err == -ENOBUFS ||
+			   err == -EAGAIN) {
+			/* The buffers of the stack, shared by all connections,
+			 * are used up. Try again when a notification is sent
+			 * or after a delay if none is in flight.
+			 */
+			stream->stats.tx_retries++;
+			if (atomic_get(&stream->in_flight) == 0) {
+				k_delayed_work_submit(&stream->tx_work,
+						      STREAM_RETRY_DELAY);
+			}
+			break;
+		} else if (err) {
+			LOG_WRN("Notification failed (err %d), "
+				"stream data dropped", err);
+			stream_drop(stream);
+			break;
+		}
+	}
+}
+
+static void stream_disconnected(struct bt_conn *conn, uint8_t reason)
+{
+	struct nus_stream *stream = stream_get(conn);
+
+	atomic_set_bit(stream->flags, STREAM_RESET);
+	k_delayed_work_submit(&stream->tx_work, K_NO_WAIT);
+}
+
+static void stream_ccc_cfg_changed(void)
+{
+	/* The data of the peers that disabled the notifications is dropped
+	 * by the work handler.
+	 */
+	for (size_t i = 0; i < ARRAY_SIZE(streams); i++) {
+		struct nus_stream *stream = &streams[i];
+
+		k_mutex_lock(&stream->lock, K_FOREVER);
+		if (stream->conn) {
+			k_delayed_work_submit(&stream->tx_work, K_NO_WAIT);
+		}
+		k_mutex_unlock(&stream->lock);
+	}
+}
+
+static struct bt_conn_cb stream_conn_callbacks = {
+	.disconnected = stream_disconnected,
+};
+
+static void stream_init(void)
+{
+	if (stream_initialized) {
+		return;
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(streams); i++) {
+		struct nus_stream *stream = &streams[i];
+
+		k_mutex_init(&stream->lock);
+		ring_buf_init(&stream->rb, sizeof(stream->buf), stream->buf);
+		k_sem_init(&stream->space_sem, 0, 1);
+		k_delayed_work_init(&stream->tx_work, stream_tx_work_handler);
+	}
+
+	bt_conn_cb_register(&stream_conn_callbacks);
+	stream_initialized = true;
+}
+
+int bt_nus_stream_write(struct bt_conn *conn, const uint8_t *data,
+			size_t len, k_timeout_t timeout)
+{
+	const struct bt_gatt_attr *attr = &nus_svc.attrs[2];
+	struct nus_stream *stream;
+	size_t written = 0;
+	uint64_t end;
+	int64_t remaining;
+	bool full;
+
+	if (!conn || (!data && len)) {
+		return -EINVAL;
+	}
+
+	if (!stream_initialized) {
+		return -EACCES;
+	}
+
+	if (!bt_gatt_is_subscribed(conn, attr, BT_GATT_CCC_NOTIFY)) {
+		return -EINVAL;
+	}
+
+	stream = stream_get(conn);
+
+	/* The reference is released when the stream is reset after the
+	 * peer disconnected.
+	 */
+	k_mutex_lock(&stream->lock, K_FOREVER);
+	if (!stream->conn) {
+		stream->conn = bt_conn_ref(conn);
+	}
+	k_mutex_unlock(&stream->lock);
+
+	/* The timeout applies to the whole write, not to each wait. */
+	end = z_timeout_end_calc(timeout);
+
+	while (true) {
+		k_mutex_lock(&stream->lock, K_FOREVER);
+		written += ring_buf_put(&stream->rb, &data[written],
+					len - written);
+		full = (written < len);
+		if (full) {
+			stream->stats.buf_full++;
+		}
+		k_mutex_unlock(&stream->lock);
+
+		k_delayed_work_submit(&stream->tx_work, K_NO_WAIT);
+
+		if (!full) {
+			break;
+		}
+
+		if (!K_TIMEOUT_EQ(timeout, K_FOREVER)) {
+			remaining = end - k_uptime_ticks();
+			timeout = K_TICKS(MAX(remaining, 0));
+		}
+
+		if (k_sem_take(&stream->space_sem, timeout) ||
+		    !bt_gatt_is_subscribed(conn, attr, BT_GATT_CCC_NOTIFY)) {
+			break;
+		}
+	}
+
+	return written;
+}
+
+int bt_nus_stream_stats_get(struct bt_conn *conn,
+			    struct bt_nus_stream_stats *stats)
+{
+	if (!conn || !stats) {
+		return -EINVAL;
+	}
+
+	*stats = stream_get(conn)->stats;
+
+	return 0;
+}
+#endif /* CONFIG_BT_NUS_STREAM */
+
 int bt_nus_init(struct bt_nus_cb *callbacks)
 {
 	if (callbacks) {
@@ -76,6 +395,10 @@ int bt_nus_init(struct bt_nus_cb *callbacks)
 		nus_cb.send_enabled = callbacks->send_enabled;
 	}
 
+#if CONFIG_BT_NUS_STREAM
+	stream_init();
+#endif
+
 	return 0;
 }
 
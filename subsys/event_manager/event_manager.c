@@ -5,6 +5,7 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 #include <zephyr.h>
 #include <spinlock.h>
 #include <sys/slist.h>
@@ -23,6 +24,15 @@ const struct {} linker_tag __attribute__((__section__("event_manager"))) __used;
 static void event_processor_fn(struct k_work *work);
 
 
+struct lane_ctx {
+	const char *name;
+	sys_slist_t eventq;
+	struct k_work work;
+	struct k_work_q *work_q;
+	struct event_lane_stats stats;
+};
+
+
 #if CONFIG_EVENT_MANAGER_PROFILER_ENABLED
 #define IDS_COUNT CONFIG_EVENT_MANAGER_MAX_EVENT_CNT
 #else
@@ -35,9 +45,33 @@ extern uint32_t event_manager_displayed_events;
 static uint32_t event_manager_displayed_events;
 #endif
 
+#ifdef CONFIG_EVENT_MANAGER_LANES
+static K_THREAD_STACK_DEFINE(lane_high_stack,
+			     CONFIG_EVENT_MANAGER_LANE_HIGH_STACK_SIZE);
+static K_THREAD_STACK_DEFINE(lane_background_stack,
+			     CONFIG_EVENT_MANAGER_LANE_BACKGROUND_STACK_SIZE);
+static struct k_work_q lane_high_work_q;
+static struct k_work_q lane_background_work_q;
+#endif
+
 static uint16_t profiler_event_ids[IDS_COUNT];
-static K_WORK_DEFINE(event_processor, event_processor_fn);
-static sys_slist_t eventq = SYS_SLIST_STATIC_INIT(&eventq);
+static struct lane_ctx lanes[EVENT_LANE_COUNT] = {
+	[EVENT_LANE_HIGH] = {
+		.name = "high",
+		.eventq = SYS_SLIST_STATIC_INIT(&lanes[EVENT_LANE_HIGH].eventq),
+		.work = Z_WORK_INITIALIZER(event_processor_fn),
+	},
+	[EVENT_LANE_NORMAL] = {
+		.name = "normal",
+		.eventq = SYS_SLIST_STATIC_INIT(&lanes[EVENT_LANE_NORMAL].eventq),
+		.work = Z_WORK_INITIALIZER(event_processor_fn),
+	},
+	[EVENT_LANE_BACKGROUND] = {
+		.name = "background",
+		.eventq = SYS_SLIST_STATIC_INIT(&lanes[EVENT_LANE_BACKGROUND].eventq),
+		.work = Z_WORK_INITIALIZER(event_processor_fn),
+	},
+};
 static struct k_spinlock lock;
 
 
@@ -228,19 +262,251 @@ static int trace_event_init(void)
 	return 0;
 }
 
+static bool is_pool_block(const struct event_pool *pool, const void *mem)
+{
+	const struct k_mem_slab *slab = pool->slab;
+	const uint8_t *start = (const uint8_t *)slab->buffer;
+	const uint8_t *end = start + slab->block_size * slab->num_blocks;
+
+	return ((const uint8_t *)mem >= start) && ((const uint8_t *)mem < end);
+}
+
+static void pool_max_used_update(struct event_pool *pool)
+{
+	atomic_val_t used = k_mem_slab_num_used_get(pool->slab);
+	atomic_val_t max_used;
+
+	do {
+		max_used = atomic_get(&pool->max_used);
+		if (used <= max_used) {
+			break;
+		}
+	} while (!atomic_cas(&pool->max_used, max_used, used));
+}
+
+void *_event_manager_alloc(const struct event_type *et, size_t size)
+{
+	struct event_pool *pool = et->pool;
+
+	if (IS_ENABLED(CONFIG_EVENT_MANAGER_EVENT_POOLS) && pool &&
+	    (size <= pool->slab->block_size)) {
+		void *event;
+
+		if (!k_mem_slab_alloc(pool->slab, &event, K_NO_WAIT)) {
+			pool_max_used_update(pool);
+			return event;
+		}
+
+		atomic_inc(&pool->heap_fallback_cnt);
+	}
+
+	return k_malloc(size);
+}
+
+static void event_free(struct event_header *eh)
+{
+	struct event_pool *pool = eh->type_id->pool;
+
+	if (IS_ENABLED(CONFIG_EVENT_MANAGER_EVENT_POOLS) && pool &&
+	    is_pool_block(pool, eh)) {
+		k_mem_slab_free(pool->slab, (void **)&eh);
+	} else {
+		k_free(eh);
+	}
+}
+
+size_t event_manager_pool_used_get(const struct event_type *et)
+{
+	ASSERT_EVENT_ID(et);
+
+	if (!IS_ENABLED(CONFIG_EVENT_MANAGER_EVENT_POOLS) || !et->pool) {
+		return 0;
+	}
+
+	return k_mem_slab_num_used_get(et->pool->slab);
+}
+
+size_t event_manager_pool_max_used_get(const struct event_type *et)
+{
+	ASSERT_EVENT_ID(et);
+
+	if (!IS_ENABLED(CONFIG_EVENT_MANAGER_EVENT_POOLS) || !et->pool) {
+		return 0;
+	}
+
+	return atomic_get(&et->pool->max_used);
+}
+
+static struct lane_ctx *lane_ctx_get(const struct event_type *et)
+{
+	if (!IS_ENABLED(CONFIG_EVENT_MANAGER_LANES)) {
+		return &lanes[EVENT_LANE_NORMAL];
+	}
+
+	__ASSERT_NO_MSG(et->lane < EVENT_LANE_COUNT);
+
+	return &lanes[et->lane];
+}
+
+static bool higher_lane_pending(const struct lane_ctx *lane)
+{
+	if (!IS_ENABLED(CONFIG_EVENT_MANAGER_LANES)) {
+		return false;
+	}
+
+	for (const struct lane_ctx *l = &lanes[0]; l != lane; l++) {
+		if (!sys_slist_is_empty(&l->eventq)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void lane_stats_dispatch(struct lane_ctx *lane,
+				const struct event_header *eh)
+{
+#ifdef CONFIG_EVENT_MANAGER_LANES
+	struct event_lane_stats *stats = &lane->stats;
+	uint32_t latency = k_cycle_get_32() - eh->timestamp;
+
+	atomic_dec(&stats->queue_depth);
+	stats->dispatch_cnt++;
+	stats->latency_total += latency;
+	if (latency > stats->latency_max) {
+		stats->latency_max = latency;
+	}
+#endif
+}
+
+static void lane_stats_submit(struct lane_ctx *lane)
+{
+#ifdef CONFIG_EVENT_MANAGER_LANES
+	/* Called with lock held, the maximum depth is updated atomically. */
+	struct event_lane_stats *stats = &lane->stats;
+	atomic_val_t depth = atomic_inc(&stats->queue_depth) + 1;
+
+	if (depth > stats->queue_depth_max) {
+		stats->queue_depth_max = depth;
+	}
+#endif
+}
+
+static void event_stats_submit(const struct event_type *et)
+{
+	if (!IS_ENABLED(CONFIG_EVENT_MANAGER_STATS)) {
+		return;
+	}
+
+	/* Called with lock held, the maximum is updated atomically. */
+	struct event_type_stats *stats = et->stats;
+	atomic_val_t queued = atomic_inc(&stats->queued) + 1;
+
+	stats->submit_cnt++;
+	if (queued > stats->queued_max) {
+		stats->queued_max = queued;
+	}
+}
+
+static void event_stats_dispatch(const struct event_header *eh)
+{
+#ifdef CONFIG_EVENT_MANAGER_STATS
+	struct event_type_stats *stats = eh->type_id->stats;
+	uint32_t queue_time = k_cycle_get_32() - eh->timestamp;
+
+	atomic_dec(&stats->queued);
+	stats->dispatch_cnt++;
+	stats->queue_time_total += queue_time;
+	if (queue_time > stats->queue_time_max) {
+		stats->queue_time_max = queue_time;
+	}
+#endif
+}
+
+static void subscriber_stats_update(const struct event_subscriber *es,
+				    uint32_t start_time)
+{
+	if (!IS_ENABLED(CONFIG_EVENT_MANAGER_STATS)) {
+		return;
+	}
+
+	struct event_subscriber_stats *stats = es->stats;
+	uint32_t exec_time = k_cycle_get_32() - start_time;
+
+	stats->call_cnt++;
+	stats->exec_time_total += exec_time;
+	if (exec_time > stats->exec_time_max) {
+		stats->exec_time_max = exec_time;
+	}
+}
+
+static void event_dispatch(struct event_header *eh)
+{
+	ASSERT_EVENT_ID(eh->type_id);
+
+	const struct event_type *et = eh->type_id;
+
+	event_stats_dispatch(eh);
+
+	trace_event_execution(eh, true);
+
+	log_event(eh);
+
+	bool consumed = false;
+
+	for (size_t prio = SUBS_PRIO_MIN;
+	     (prio <= SUBS_PRIO_MAX) && !consumed;
+	     prio++) {
+		for (const struct event_subscriber *es =
+				et->subs_start[prio];
+		     (es != et->subs_stop[prio]) && !consumed;
+		     es++) {
+
+			__ASSERT_NO_MSG(es != NULL);
+
+			const struct event_listener *el = es->listener;
+
+			__ASSERT_NO_MSG(el != NULL);
+
+			log_event_progress(et, el);
+
+			uint32_t start_time = IS_ENABLED(CONFIG_EVENT_MANAGER_STATS) ?
+					      k_cycle_get_32() : 0;
+
+			if (es->notification) {
+				consumed = es->notification(eh);
+			} else {
+				__ASSERT_NO_MSG(el->notification != NULL);
+				consumed = el->notification(eh);
+			}
+
+			subscriber_stats_update(es, start_time);
+
+			if (consumed) {
+				log_event_consumed(et);
+			}
+		}
+	}
+
+	trace_event_execution(eh, false);
+
+	event_free(eh);
+}
+
 static void event_processor_fn(struct k_work *work)
 {
+	struct lane_ctx *lane = CONTAINER_OF(work, struct lane_ctx, work);
 	sys_slist_t events = SYS_SLIST_STATIC_INIT(&events);
 
 	/* Make current event list local. */
 	k_spinlock_key_t key = k_spin_lock(&lock);
 
-	if (sys_slist_is_empty(&eventq)) {
+	if (sys_slist_is_empty(&lane->eventq)) {
 		k_spin_unlock(&lock, key);
 		return;
 	}
 
-	sys_slist_merge_slist(&events, &eventq);
+	sys_slist_merge_slist(&events, &lane->eventq);
 
 	k_spin_unlock(&lock, key);
 
@@ -252,45 +518,102 @@ static void event_processor_fn(struct k_work *work)
 						       struct event_header,
 						       node);
 
-		ASSERT_EVENT_ID(eh->type_id);
+		lane_stats_dispatch(lane, eh);
+		event_dispatch(eh);
 
-		const struct event_type *et = eh->type_id;
+		/* Let lanes of higher priority process their events. */
+		if (higher_lane_pending(lane)) {
+			k_yield();
+		}
+	}
+}
 
-		trace_event_execution(eh, true);
+int event_manager_lane_stats_get(enum event_lane lane,
+				 struct event_lane_stats *stats)
+{
+	if (!IS_ENABLED(CONFIG_EVENT_MANAGER_LANES)) {
+		return -ENOTSUP;
+	}
 
-		log_event(eh);
+	if ((lane >= EVENT_LANE_COUNT) || !stats) {
+		return -EINVAL;
+	}
 
-		bool consumed = false;
+	*stats = lanes[lane].stats;
 
-		for (size_t prio = SUBS_PRIO_MIN;
-		     (prio <= SUBS_PRIO_MAX) && !consumed;
-		     prio++) {
-			for (const struct event_subscriber *es =
-					et->subs_start[prio];
-			     (es != et->subs_stop[prio]) && !consumed;
-			     es++) {
+	return 0;
+}
+
+int event_manager_stats_get(const struct event_type *et,
+			    struct event_type_stats *stats)
+{
+	if (!IS_ENABLED(CONFIG_EVENT_MANAGER_STATS)) {
+		return -ENOTSUP;
+	}
 
-				__ASSERT_NO_MSG(es != NULL);
+	if (!et || !stats) {
+		return -EINVAL;
+	}
 
-				const struct event_listener *el = es->listener;
+	ASSERT_EVENT_ID(et);
 
-				__ASSERT_NO_MSG(el != NULL);
-				__ASSERT_NO_MSG(el->notification != NULL);
+	*stats = *et->stats;
 
-				log_event_progress(et, el);
+	return 0;
+}
 
-				consumed = el->notification(eh);
+int event_manager_subscriber_stats_get(const struct event_subscriber *es,
+				       struct event_subscriber_stats *stats)
+{
+	if (!IS_ENABLED(CONFIG_EVENT_MANAGER_STATS)) {
+		return -ENOTSUP;
+	}
+
+	if (!es || !stats) {
+		return -EINVAL;
+	}
+
+	*stats = *es->stats;
+
+	return 0;
+}
+
+void event_manager_stats_reset(void)
+{
+	if (!IS_ENABLED(CONFIG_EVENT_MANAGER_STATS)) {
+		return;
+	}
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	for (const struct event_type *et = __start_event_types;
+	     (et != NULL) && (et != __stop_event_types);
+	     et++) {
+		/* Events waiting in the queue are still counted. */
+		atomic_val_t queued = atomic_get(&et->stats->queued);
+
+		memset(et->stats, 0, sizeof(*et->stats));
+		atomic_set(&et->stats->queued, queued);
+		et->stats->queued_max = queued;
 
-				if (consumed) {
-					log_event_consumed(et);
-				}
+		for (size_t prio = SUBS_PRIO_MIN; prio <= SUBS_PRIO_MAX; prio++) {
+			for (const struct event_subscriber *es =
+					et->subs_start[prio];
+			     es != et->subs_stop[prio];
+			     es++) {
+				memset(es->stats, 0, sizeof(*es->stats));
 			}
 		}
+	}
 
-		trace_event_execution(eh, false);
+	k_spin_unlock(&lock, key);
+}
 
-		k_free(eh);
-	}
+const char *event_manager_lane_name_get(enum event_lane lane)
+{
+	__ASSERT_NO_MSG(lane < EVENT_LANE_COUNT);
+
+	return lanes[lane].name;
 }
 
 void _event_submit(struct event_header *eh)
@@ -300,15 +623,45 @@ void _event_submit(struct event_header *eh)
 
 	trace_event_submission(eh);
 
+	struct lane_ctx *lane = lane_ctx_get(eh->type_id);
+
+#ifdef CONFIG_EVENT_MANAGER_EVENT_TIMESTAMP
+	eh->timestamp = k_cycle_get_32();
+#endif
+
 	k_spinlock_key_t key = k_spin_lock(&lock);
-	sys_slist_append(&eventq, &eh->node);
+	lane_stats_submit(lane);
+	event_stats_submit(eh->type_id);
+	sys_slist_append(&lane->eventq, &eh->node);
 	k_spin_unlock(&lock, key);
 
-	k_work_submit(&event_processor);
+	if (lane->work_q) {
+		k_work_submit_to_queue(lane->work_q, &lane->work);
+	} else {
+		k_work_submit(&lane->work);
+	}
+}
+
+static void lanes_init(void)
+{
+#ifdef CONFIG_EVENT_MANAGER_LANES
+	k_work_q_start(&lane_high_work_q, lane_high_stack,
+		       K_THREAD_STACK_SIZEOF(lane_high_stack),
+		       CONFIG_EVENT_MANAGER_LANE_HIGH_THREAD_PRIO);
+	k_thread_name_set(&lane_high_work_q.thread, "em_lane_high");
+	lanes[EVENT_LANE_HIGH].work_q = &lane_high_work_q;
+
+	k_work_q_start(&lane_background_work_q, lane_background_stack,
+		       K_THREAD_STACK_SIZEOF(lane_background_stack),
+		       CONFIG_EVENT_MANAGER_LANE_BACKGROUND_THREAD_PRIO);
+	k_thread_name_set(&lane_background_work_q.thread, "em_lane_bg");
+	lanes[EVENT_LANE_BACKGROUND].work_q = &lane_background_work_q;
+#endif
 }
 
 int event_manager_init(void)
 {
+	lanes_init();
 	log_event_init();
 
 	return trace_event_init();
@@ -70,11 +70,46 @@ extern "C" {
 	_EVENT_SUBSCRIBERS_EMPTY(ename, _SUBS_PRIO_ID(_SUBS_PRIO_FINAL))
 
 
+/* Statistics of event types and subscribers. */
+#ifdef CONFIG_EVENT_MANAGER_STATS
+#define _EVENT_STATS_DEFINE(type, name)	static type name
+#define _EVENT_STATS_PTR(name)		(&name)
+#else
+#define _EVENT_STATS_DEFINE(type, name)
+#define _EVENT_STATS_PTR(name)		NULL
+#endif /* CONFIG_EVENT_MANAGER_STATS */
+
+#define _EVENT_SUBSCRIBER_STATS_NAME(lname, ename) _CONCAT(_CONCAT(__event_subscriber_stats_, ename), lname)
+
+#define _EVENT_TYPE_STATS_NAME(ename) _CONCAT(__event_type_stats_, ename)
+
+
 /* Subscribe a listener to an event. */
 #define _EVENT_SUBSCRIBE(lname, ename, prio)								\
+	_EVENT_STATS_DEFINE(struct event_subscriber_stats, _EVENT_SUBSCRIBER_STATS_NAME(lname, ename));	\
+	const struct event_subscriber _CONCAT(_CONCAT(__event_subscriber_, ename), lname) __used	\
+	__attribute__((__section__(_EVENT_SUBSCRIBERS_SECTION_NAME(ename, prio)))) = {			\
+		.listener = &_CONCAT(__event_listener_, lname),						\
+		.stats = _EVENT_STATS_PTR(_EVENT_SUBSCRIBER_STATS_NAME(lname, ename)),			\
+	}
+
+
+/* Subscribe a listener to an event with an event type specific handler.
+ * The wrapper function is used to check the handler type. As the event
+ * header is the first field of the event, the wrapper reduces to a jump
+ * to the handler.
+ */
+#define _EVENT_SUBSCRIBE_CB(lname, ename, prio, cb_fn)							\
+	static bool _CONCAT(_CONCAT(__event_handler_, ename), lname)(const struct event_header *eh)	\
+	{												\
+		return cb_fn(CONTAINER_OF(eh, struct ename, header));					\
+	}												\
+	_EVENT_STATS_DEFINE(struct event_subscriber_stats, _EVENT_SUBSCRIBER_STATS_NAME(lname, ename));	\
 	const struct event_subscriber _CONCAT(_CONCAT(__event_subscriber_, ename), lname) __used	\
 	__attribute__((__section__(_EVENT_SUBSCRIBERS_SECTION_NAME(ename, prio)))) = {			\
 		.listener = &_CONCAT(__event_listener_, lname),						\
+		.notification = _CONCAT(_CONCAT(__event_handler_, ename), lname),			\
+		.stats = _EVENT_STATS_PTR(_EVENT_SUBSCRIBER_STATS_NAME(lname, ename)),			\
 	}
 
 
@@ -89,7 +124,8 @@ extern "C" {
 #define _EVENT_ALLOCATOR_FN(ename)					\
 	static inline struct ename *_CONCAT(new_, ename)(void)		\
 	{								\
-		struct ename *event = (struct ename *)k_malloc(sizeof(*event));\
+		struct ename *event = (struct ename *)_event_manager_alloc(	\
+					_EVENT_ID(ename), sizeof(*event));	\
 		BUILD_ASSERT(offsetof(struct ename, header) == 0,	\
 				 "");					\
 		if (unlikely(!event)) {					\
@@ -111,7 +147,8 @@ extern "C" {
 #define _EVENT_ALLOCATOR_DYNDATA_FN(ename)				\
 	static inline struct ename *_CONCAT(new_, ename)(size_t size)	\
 	{								\
-		struct ename *event = (struct ename *)k_malloc(sizeof(*event) + size);\
+		struct ename *event = (struct ename *)_event_manager_alloc(	\
+					_EVENT_ID(ename), sizeof(*event) + size);\
 		BUILD_ASSERT((offsetof(struct ename, dyndata) +		\
 				  sizeof(event->dyndata.size)) ==	\
 				 sizeof(*event), "");			\
@@ -221,8 +258,39 @@ extern "C" {
 	_EVENT_ALLOCATOR_DYNDATA_FN(ename)
 
 
-#define _EVENT_TYPE_DEFINE(ename, init_log_en, log_fn, ev_info_struct)							\
+/* Event memory pools are referenced through weak symbols so that event types
+ * without a pool get NULL as pool pointer.
+ */
+#ifdef CONFIG_EVENT_MANAGER_EVENT_POOLS
+#define _EVENT_POOL_NAME(ename) _CONCAT(__event_pool_, ename)
+
+#define _EVENT_POOL_DECLARE(ename)					\
+	extern struct event_pool _EVENT_POOL_NAME(ename) __weak
+
+#define _EVENT_POOL_PTR(ename) (&_EVENT_POOL_NAME(ename))
+
+#define _EVENT_POOL_DEFINE(ename, count)						\
+	K_MEM_SLAB_DEFINE(_CONCAT(__event_slab_, ename),				\
+			  WB_UP(sizeof(struct ename)),					\
+			  count,							\
+			  WB_UP(__alignof__(struct ename)));				\
+	struct event_pool _EVENT_POOL_NAME(ename) = {					\
+		.slab = &_CONCAT(__event_slab_, ename),					\
+	}
+
+#else
+#define _EVENT_POOL_DECLARE(ename)
+#define _EVENT_POOL_PTR(ename) NULL
+#define _EVENT_POOL_DEFINE(ename, count)						\
+	BUILD_ASSERT(false, "CONFIG_EVENT_MANAGER_EVENT_POOLS is disabled")
+
+#endif /* CONFIG_EVENT_MANAGER_EVENT_POOLS */
+
+
+#define _EVENT_TYPE_DEFINE(ename, ev_lane, init_log_en, log_fn, ev_info_struct)						\
 	_EVENT_SUBSCRIBERS_DEFINE(ename);										\
+	_EVENT_POOL_DECLARE(ename);											\
+	_EVENT_STATS_DEFINE(struct event_type_stats, _EVENT_TYPE_STATS_NAME(ename));					\
 	const struct event_type _CONCAT(__event_type_, ename) __used							\
 	__attribute__((__section__("event_types"))) = {									\
 		.name				= STRINGIFY(ename),							\
@@ -237,8 +305,11 @@ extern "C" {
 			[_SUBS_PRIO_FINAL]	= _EVENT_SUBSCRIBERS_STOP(ename, _SUBS_PRIO_ID(_SUBS_PRIO_FINAL)),	\
 		},													\
 		.init_log_enable		= init_log_en,								\
+		.lane				= ev_lane,								\
 		.log_event			= log_fn,								\
 		.ev_info			= ev_info_struct,							\
+		.pool				= _EVENT_POOL_PTR(ename),						\
+		.stats				= _EVENT_STATS_PTR(_EVENT_TYPE_STATS_NAME(ename)),			\
 	}
 
 
@@ -89,6 +89,117 @@ static int show_subscribers(const struct shell *shell, size_t argc,
 	return 0;
 }
 
+static uint32_t avg_us(uint64_t total, uint32_t cnt)
+{
+	return (cnt > 0) ? k_cyc_to_us_floor32(total / cnt) : 0;
+}
+
+static int show_lanes(const struct shell *shell, size_t argc,
+		      char **argv)
+{
+	if (!IS_ENABLED(CONFIG_EVENT_MANAGER_LANES)) {
+		shell_error(shell, "Event processing lanes are disabled");
+		return -ENOTSUP;
+	}
+
+	shell_fprintf(shell, SHELL_NORMAL, "Event processing lanes:\n");
+
+	for (size_t lane = 0; lane < EVENT_LANE_COUNT; lane++) {
+		struct event_lane_stats stats;
+		int err = event_manager_lane_stats_get(lane, &stats);
+
+		if (err) {
+			shell_error(shell, "Cannot get lane stats (err %d)",
+				    err);
+			return err;
+		}
+
+		shell_fprintf(shell, SHELL_NORMAL,
+			      "|\t[%s] depth:%d max_depth:%d dispatched:%u"
+			      " latency avg:%uus max:%uus\n",
+			      event_manager_lane_name_get(lane),
+			      (int)atomic_get(&stats.queue_depth),
+			      (int)stats.queue_depth_max,
+			      stats.dispatch_cnt,
+			      avg_us(stats.latency_total, stats.dispatch_cnt),
+			      k_cyc_to_us_floor32(stats.latency_max));
+	}
+
+	return 0;
+}
+
+static int show_stats(const struct shell *shell, size_t argc,
+		      char **argv)
+{
+	if (!IS_ENABLED(CONFIG_EVENT_MANAGER_STATS)) {
+		shell_error(shell, "Event statistics are disabled");
+		return -ENOTSUP;
+	}
+
+	shell_fprintf(shell, SHELL_NORMAL, "Event statistics:\n");
+	for (const struct event_type *et = __start_event_types;
+	     (et != NULL) && (et != __stop_event_types);
+	     et++) {
+		struct event_type_stats stats;
+		int err = event_manager_stats_get(et, &stats);
+
+		if (err) {
+			shell_error(shell, "Cannot get stats (err %d)", err);
+			return err;
+		}
+
+		shell_fprintf(shell, SHELL_NORMAL,
+			      "[E:%s] submitted:%u queued:%d max_queued:%d"
+			      " queue time avg:%uus max:%uus\n",
+			      et->name, stats.submit_cnt,
+			      (int)atomic_get(&stats.queued),
+			      (int)stats.queued_max,
+			      avg_us(stats.queue_time_total,
+				     stats.dispatch_cnt),
+			      k_cyc_to_us_floor32(stats.queue_time_max));
+
+		for (size_t prio = SUBS_PRIO_MIN;
+		     prio <= SUBS_PRIO_MAX;
+		     prio++) {
+			for (const struct event_subscriber *es =
+					et->subs_start[prio];
+			     es != et->subs_stop[prio];
+			     es++) {
+				struct event_subscriber_stats es_stats;
+
+				event_manager_subscriber_stats_get(es,
+								   &es_stats);
+
+				shell_fprintf(shell, SHELL_NORMAL,
+					      "|\t[L:%s] calls:%u"
+					      " exec time avg:%uus max:%uus\n",
+					      es->listener->name,
+					      es_stats.call_cnt,
+					      avg_us(es_stats.exec_time_total,
+						     es_stats.call_cnt),
+					      k_cyc_to_us_floor32(
+						es_stats.exec_time_max));
+			}
+		}
+	}
+
+	return 0;
+}
+
+static int reset_stats(const struct shell *shell, size_t argc,
+		       char **argv)
+{
+	if (!IS_ENABLED(CONFIG_EVENT_MANAGER_STATS)) {
+		shell_error(shell, "Event statistics are disabled");
+		return -ENOTSUP;
+	}
+
+	event_manager_stats_reset();
+	shell_fprintf(shell, SHELL_NORMAL, "Event statistics reset\n");
+
+	return 0;
+}
+
 static void set_event_displaying(const struct shell *shell, size_t argc,
 				 char **argv, bool enable)
 {
@@ -168,6 +279,12 @@ SHELL_STATIC_SUBCMD_SET_CREATE(sub_event_manager,
 	SHELL_CMD_ARG(show_subscribers, NULL, "Show subscribers",
 		      show_subscribers, 0, 0),
 	SHELL_CMD_ARG(show_events, NULL, "Show events", show_events, 0, 0),
+	SHELL_CMD_ARG(show_lanes, NULL, "Show event processing lanes",
+		      show_lanes, 0, 0),
+	SHELL_CMD_ARG(show_stats, NULL, "Show event statistics",
+		      show_stats, 0, 0),
+	SHELL_CMD_ARG(reset_stats, NULL, "Reset event statistics",
+		      reset_stats, 0, 0),
 	SHELL_CMD_ARG(disable, NULL, "Disable displaying event with given ID",
 		      disable_event_displaying, 0,
 		      sizeof(event_manager_displayed_events) * 8 - 1),
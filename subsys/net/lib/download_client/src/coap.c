@@ -5,6 +5,7 @@
  */
 
 #include <zephyr.h>
+#include <random/rand32.h>
 #include <net/coap.h>
 #include <net/download_client.h>
 #include <logging/log.h>
@@ -14,56 +15,389 @@ LOG_MODULE_DECLARE(download_client, CONFIG_DOWNLOAD_CLIENT_LOG_LEVEL);
 #define COAP_VER 1
 #define FILENAME_SIZE CONFIG_DOWNLOAD_CLIENT_MAX_FILENAME_SIZE
 
+/* Smallest block size used when adapting to losses (64 bytes) */
+#define SZX_MIN 2
+/* Blocks received without retransmission before doubling the block size */
+#define SZX_INCREASE_AFTER 16
+
+#define SZX_TO_BYTES(szx) (16 << (szx))
+
 int url_parse_file(const char *url, char *file, size_t len);
-int socket_send(const struct download_client *client, size_t len);
+int socket_send(const struct download_client *client, const void *buf,
+		size_t len);
+
+/* Forget about the requests in flight and request again
+ * from the next byte to hand to the application.
+ */
+void coap_window_reset(struct download_client *client)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(client->coap.req); i++) {
+		client->coap.req[i].state = DOWNLOAD_CLIENT_COAP_REQ_FREE;
+	}
+
+	client->coap.requested = client->progress;
+}
 
 int coap_block_init(struct download_client *client, size_t from)
 {
-	coap_block_transfer_init(&client->coap.block_ctx,
-				 CONFIG_DOWNLOAD_CLIENT_COAP_BLOCK_SIZE, 0);
-	client->coap.block_ctx.current = from;
+	client->coap.szx = CONFIG_DOWNLOAD_CLIENT_COAP_BLOCK_SIZE;
+	client->coap.good = 0;
+	memset(&client->coap.stats, 0, sizeof(client->coap.stats));
+
+	coap_window_reset(client);
+
 	return 0;
 }
 
-int coap_block_update(struct download_client *client, struct coap_packet *pkt,
-		      size_t *blk_off)
+static uint32_t ack_timeout_get(void)
+{
+	/* Between ACK_TIMEOUT and ACK_TIMEOUT * ACK_RANDOM_FACTOR (1.5) */
+	return CONFIG_DOWNLOAD_CLIENT_COAP_ACK_TIMEOUT_MS +
+	       sys_rand32_get() %
+	       (CONFIG_DOWNLOAD_CLIENT_COAP_ACK_TIMEOUT_MS / 2 + 1);
+}
+
+static int request_send(struct download_client *client,
+			struct download_client_coap_req *req)
 {
 	int err;
-	bool more;
+	char file[FILENAME_SIZE];
+	struct coap_packet request;
+
+	err = coap_packet_init(
+		&request, client->buf, CONFIG_DOWNLOAD_CLIENT_BUF_SIZE,
+		COAP_VER, COAP_TYPE_CON, sizeof(req->token), req->token,
+		COAP_METHOD_GET, req->id
+	);
+	if (err) {
+		LOG_ERR("Failed to init CoAP message, err %d", err);
+		return err;
+	}
+
+	err = url_parse_file(client->file, file, sizeof(file));
+	if (err) {
+		return err;
+	}
 
-	*blk_off = client->coap.block_ctx.current %
-		   coap_block_size_to_bytes(client->coap.block_ctx.block_size);
-	if (*blk_off) {
-		LOG_DBG("%d bytes of current block already downloaded",
-			*blk_off);
+	err = coap_packet_append_option(&request, COAP_OPTION_URI_PATH,
+					file, strlen(file));
+	if (err) {
+		LOG_ERR("Unable add option to request");
+		return err;
 	}
 
-	err = coap_update_from_block(pkt, &client->coap.block_ctx);
+	err = coap_append_option_int(&request, COAP_OPTION_BLOCK2,
+				     (req->off >> (req->szx + 4)) << 4 |
+				     req->szx);
 	if (err) {
+		LOG_ERR("Unable to add block2 option");
 		return err;
 	}
 
 	if (client->file_size == 0) {
-		LOG_DBG("Total size: %d", client->coap.block_ctx.total_size);
-		client->file_size = client->coap.block_ctx.total_size;
+		/* Ask for the file size */
+		err = coap_append_option_int(&request, COAP_OPTION_SIZE2, 0);
+		if (err) {
+			LOG_ERR("Unable to add size2 option");
+			return err;
+		}
 	}
 
-	more = coap_next_block(pkt, &client->coap.block_ctx);
-	if (!more) {
-		LOG_DBG("Last block received");
+	LOG_DBG("CoAP block at %d (%d bytes), retransmission %d", req->off,
+		SZX_TO_BYTES(req->szx), req->retransmits);
+
+	err = socket_send(client, request.data, request.offset);
+	if (err) {
+		LOG_ERR("Failed to send CoAP request, errno %d", errno);
+		return err;
+	}
+
+	if (IS_ENABLED(CONFIG_DOWNLOAD_CLIENT_LOG_HEADERS)) {
+		LOG_HEXDUMP_DBG(request.data, request.offset, "CoAP request");
+	}
+
+	req->sent = k_uptime_get_32();
+	client->coap.stats.requests++;
+
+	return 0;
+}
+
+/* Send a request for a new exchange, possibly for a block requested before */
+static int request_new(struct download_client *client,
+		       struct download_client_coap_req *req)
+{
+	memcpy(req->token, coap_next_token(), sizeof(req->token));
+	req->id = coap_next_id();
+	req->retransmits = 0;
+	req->timeout = ack_timeout_get();
+	req->state = DOWNLOAD_CLIENT_COAP_REQ_SENT;
+
+	return request_send(client, req);
+}
+
+static size_t window_get(const struct download_client *client)
+{
+	if (client->config.coap_window) {
+		return MIN(client->config.coap_window,
+			   ARRAY_SIZE(client->coap.req));
+	}
+
+	return ARRAY_SIZE(client->coap.req);
+}
+
+static bool requests_in_flight(const struct download_client *client)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(client->coap.req); i++) {
+		if (client->coap.req[i].state !=
+		    DOWNLOAD_CLIENT_COAP_REQ_FREE) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Whether a block before `off` is still awaited */
+static bool gap_before(const struct download_client *client, size_t off)
+{
+	const struct download_client_coap_req *req;
+
+	for (size_t i = 0; i < ARRAY_SIZE(client->coap.req); i++) {
+		req = &client->coap.req[i];
+		if (req->state == DOWNLOAD_CLIENT_COAP_REQ_SENT &&
+		    req->off < off) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Keep the window full. The responses received out of order were
+ * discarded, request those blocks again first, once the blocks
+ * before them have been received.
+ */
+int coap_request_send(struct download_client *client)
+{
+	int err;
+	uint8_t szx;
+	struct download_client_coap_req *req;
+
+	for (size_t i = 0; i < ARRAY_SIZE(client->coap.req); i++) {
+		req = &client->coap.req[i];
+		if (req->state != DOWNLOAD_CLIENT_COAP_REQ_DISCARDED ||
+		    gap_before(client, req->off)) {
+			continue;
+		}
+
+		err = request_new(client, req);
+		if (err) {
+			return err;
+		}
+	}
+
+	for (size_t i = 0; i < window_get(client); i++) {
+		req = &client->coap.req[i];
+		if (req->state != DOWNLOAD_CLIENT_COAP_REQ_FREE) {
+			continue;
+		}
+
+		if (client->file_size == 0 && requests_in_flight(client)) {
+			/* The file size is needed to know when to stop */
+			break;
+		}
+
+		if (client->file_size &&
+		    client->coap.requested >= client->file_size) {
+			break;
+		}
+
+		/* Blocks are aligned to their size, the first one may
+		 * start before the requested offset.
+		 */
+		szx = client->coap.szx;
+		req->off = client->coap.requested & ~(SZX_TO_BYTES(szx) - 1);
+		req->szx = szx;
+
+		err = request_new(client, req);
+		if (err) {
+			return err;
+		}
+
+		client->coap.requested = req->off + SZX_TO_BYTES(szx);
+	}
+
+	return 0;
+}
+
+/* Milliseconds until the next retransmission is due */
+int coap_timeout_get(const struct download_client *client)
+{
+	int timeout = CONFIG_DOWNLOAD_CLIENT_COAP_ACK_TIMEOUT_MS;
+	uint32_t now = k_uptime_get_32();
+	const struct download_client_coap_req *req;
+
+	for (size_t i = 0; i < ARRAY_SIZE(client->coap.req); i++) {
+		req = &client->coap.req[i];
+		if (req->state != DOWNLOAD_CLIENT_COAP_REQ_SENT) {
+			continue;
+		}
+
+		if (now - req->sent >= req->timeout) {
+			return 0;
+		}
+
+		timeout = MIN(timeout, req->timeout - (now - req->sent));
+	}
+
+	return timeout;
+}
+
+static void block_size_decrease(struct download_client *client)
+{
+	client->coap.good = 0;
+
+	if (IS_ENABLED(CONFIG_DOWNLOAD_CLIENT_COAP_ADAPTIVE_BLOCK_SIZE) &&
+	    client->coap.szx > SZX_MIN) {
+		client->coap.szx--;
+		LOG_DBG("Losses, block size %d",
+			SZX_TO_BYTES(client->coap.szx));
+	}
+}
+
+static void block_size_increase(struct download_client *client)
+{
+	uint8_t szx = client->coap.szx;
+
+	if (!IS_ENABLED(CONFIG_DOWNLOAD_CLIENT_COAP_ADAPTIVE_BLOCK_SIZE) ||
+	    szx >= CONFIG_DOWNLOAD_CLIENT_COAP_BLOCK_SIZE) {
+		return;
+	}
+
+	if (client->coap.good < SZX_INCREASE_AFTER) {
+		client->coap.good++;
+		return;
+	}
+
+	/* Wait until the next block to request is aligned to the
+	 * larger size, to not download the same bytes twice.
+	 */
+	if (client->coap.requested & (SZX_TO_BYTES(szx + 1) - 1)) {
+		return;
+	}
+
+	client->coap.good = 0;
+	client->coap.szx++;
+	LOG_DBG("No losses, block size %d", SZX_TO_BYTES(client->coap.szx));
+}
+
+/* Retransmit the requests not answered in time, with exponential backoff.
+ * Returns -ETIMEDOUT once a request has been retransmitted
+ * CONFIG_DOWNLOAD_CLIENT_COAP_MAX_RETRANSMIT times without response.
+ */
+int coap_retransmit(struct download_client *client)
+{
+	int err;
+	bool lost = false;
+	uint32_t now = k_uptime_get_32();
+	struct download_client_coap_req *req;
+
+	for (size_t i = 0; i < ARRAY_SIZE(client->coap.req); i++) {
+		req = &client->coap.req[i];
+		if (req->state != DOWNLOAD_CLIENT_COAP_REQ_SENT ||
+		    now - req->sent < req->timeout) {
+			continue;
+		}
+
+		if (req->retransmits ==
+		    CONFIG_DOWNLOAD_CLIENT_COAP_MAX_RETRANSMIT) {
+			LOG_ERR("No response for block at %d", req->off);
+			return -ETIMEDOUT;
+		}
+
+		req->retransmits++;
+		req->timeout *= 2;
+		client->coap.stats.retransmissions++;
+		lost = true;
+
+		err = request_send(client, req);
+		if (err) {
+			return err;
+		}
+	}
+
+	/* Losses in the same window count as one congestion event */
+	if (lost) {
+		block_size_decrease(client);
 	}
 
 	return 0;
 }
 
+static struct download_client_coap_req *
+request_find(struct download_client *client, const struct coap_packet *pkt)
+{
+	uint8_t tkl;
+	uint8_t token[8];
+	struct download_client_coap_req *req;
+
+	tkl = coap_header_get_token(pkt, token);
+	if (tkl != sizeof(req->token)) {
+		return NULL;
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(client->coap.req); i++) {
+		req = &client->coap.req[i];
+		if (req->state == DOWNLOAD_CLIENT_COAP_REQ_SENT &&
+		    memcmp(req->token, token, tkl) == 0) {
+			return req;
+		}
+	}
+
+	return NULL;
+}
+
+static void rtt_update(struct download_client *client,
+		       const struct download_client_coap_req *req)
+{
+	uint32_t rtt;
+	struct download_client_coap_stats *stats = &client->coap.stats;
+
+	/* The response to a retransmitted request could be for any
+	 * of the transmissions, don't use it (Karn's algorithm).
+	 */
+	if (req->retransmits) {
+		return;
+	}
+
+	rtt = k_uptime_get_32() - req->sent;
+
+	if (stats->rtt_samples == 0 || rtt < stats->rtt_min) {
+		stats->rtt_min = rtt;
+	}
+	stats->rtt_max = MAX(stats->rtt_max, rtt);
+	stats->rtt_total += rtt;
+	stats->rtt_samples++;
+}
+
+/* Returns:
+ *  1 if the datagram has been ignored
+ *  0 if a block has been received
+ * -1 on error
+ */
 int coap_parse(struct download_client *client, size_t len)
 {
 	int err;
-	size_t blk_off;
+	int block2;
+	int size2;
+	size_t off;
+	size_t skip;
+	uint8_t szx;
 	uint8_t response_code;
 	uint16_t payload_len;
 	const uint8_t *payload;
 	struct coap_packet response;
+	struct download_client_coap_req *req;
 
 	err = coap_packet_parse(&response, client->buf, len, NULL, 0);
 	if (err) {
@@ -71,11 +405,17 @@ int coap_parse(struct download_client *client, size_t len)
 		return -1;
 	}
 
-	err = coap_block_update(client, &response, &blk_off);
-	if (err) {
-		return -1;
+	req = request_find(client, &response);
+	if (!req) {
+		/* Late response to a retransmitted request, or
+		 * to a request that has been discarded.
+		 */
+		LOG_DBG("Unexpected response, ignored");
+		return 1;
 	}
 
+	rtt_update(client, req);
+
 	response_code = coap_header_get_code(&response);
 	if (response_code != COAP_RESPONSE_CODE_OK &&
 	    response_code != COAP_RESPONSE_CODE_CONTENT) {
@@ -83,79 +423,91 @@ int coap_parse(struct download_client *client, size_t len)
 		return -1;
 	}
 
+	block2 = coap_get_option_int(&response, COAP_OPTION_BLOCK2);
+	if (block2 < 0) {
+		LOG_ERR("No block2 option in response");
+		return -1;
+	}
+
 	payload = coap_packet_get_payload(&response, &payload_len);
 	if (!payload) {
 		LOG_WRN("No CoAP payload!");
 		return -1;
 	}
 
-	/* TODO: because our buffer is large enough for the whole datagram,
-	 * we don't scrictly need to copy the bytes at the beginning
-	 * of the buffer, we could simply send a fragment pointing to the
-	 * payload directly.
-	 */
-	LOG_DBG("CoAP response: %d, copying %d bytes",
-		coap_header_get_code(&response), payload_len - blk_off);
-	memcpy(client->buf + client->offset, payload + blk_off,
-	       payload_len - blk_off);
-
-	client->offset += payload_len - blk_off;
-	client->progress += payload_len - blk_off;
-
-	return 0;
-}
-
-int coap_request_send(struct download_client *client)
-{
-	int err;
-	char file[FILENAME_SIZE];
-	struct coap_packet request;
+	szx = block2 & 0x7;
+	off = (block2 >> 4) << (szx + 4);
 
-	err = coap_packet_init(
-		&request, client->buf, CONFIG_DOWNLOAD_CLIENT_BUF_SIZE,
-		COAP_VER, COAP_TYPE_CON, 8, coap_next_token(),
-		COAP_METHOD_GET, coap_next_id()
-	);
-	if (err) {
-		LOG_ERR("Failed to init CoAP message, err %d", err);
-		return err;
+	if (client->file_size == 0) {
+		size2 = coap_get_option_int(&response, COAP_OPTION_SIZE2);
+		if (size2 > 0) {
+			LOG_DBG("Total size: %d", size2);
+			client->file_size = size2;
+		}
 	}
 
-	err = url_parse_file(client->file, file, sizeof(file));
-	if (err) {
-		return err;
+	if (!(block2 & 0x8)) {
+		LOG_DBG("Last block received");
+		client->file_size = off + payload_len;
 	}
 
-	err = coap_packet_append_option(&request, COAP_OPTION_URI_PATH,
-					file, strlen(file));
-	if (err) {
-		LOG_ERR("Unable add option to request");
-		return err;
+	if (off > client->progress) {
+		/* An earlier block is missing. The response cannot be
+		 * kept, request this block again once it is needed.
+		 */
+		LOG_DBG("Block at %d out of order, discarded", off);
+		req->state = DOWNLOAD_CLIENT_COAP_REQ_DISCARDED;
+		return 1;
 	}
 
-	err = coap_append_block2_option(&request, &client->coap.block_ctx);
-	if (err) {
-		LOG_ERR("Unable to add block2 option");
-		return err;
+	req->state = DOWNLOAD_CLIENT_COAP_REQ_FREE;
+
+	if (off + payload_len <= client->progress) {
+		LOG_DBG("Duplicate block at %d", off);
+		return 1;
 	}
 
-	err = coap_append_size2_option(&request, &client->coap.block_ctx);
-	if (err) {
-		LOG_ERR("Unable to add size2 option");
-		return err;
+	if (szx != req->szx) {
+		/* The server chose a smaller block size, the other
+		 * requests in flight don't match its blocks anymore.
+		 */
+		LOG_DBG("Server block size is %d", SZX_TO_BYTES(szx));
+		client->coap.szx = szx;
+		coap_window_reset(client);
+		client->coap.requested = off + payload_len;
 	}
 
-	LOG_DBG("CoAP next block: %d", client->coap.block_ctx.current);
+	client->coap.stats.blocks++;
+	block_size_increase(client);
 
-	err = socket_send(client, request.offset);
-	if (err) {
-		LOG_ERR("Failed to send CoAP request, errno %d", errno);
-		return err;
+	/* The whole datagram fits in the buffer, so the fragment
+	 * can point to the payload directly instead of copying it.
+	 * Skip the bytes that were already received, if any.
+	 */
+	skip = client->progress - off;
+	if (skip) {
+		LOG_DBG("%d bytes of current block already downloaded", skip);
 	}
 
-	if (IS_ENABLED(CONFIG_DOWNLOAD_CLIENT_LOG_HEADERS)) {
-		LOG_HEXDUMP_DBG(request.data, request.offset, "CoAP request");
+	LOG_DBG("CoAP response: %d, %d bytes", response_code,
+		payload_len - skip);
+
+	client->coap.payload = payload + skip;
+	client->offset = payload_len - skip;
+	client->progress += payload_len - skip;
+
+	return 0;
+}
+
+int download_client_coap_stats_get(const struct download_client *client,
+				   struct download_client_coap_stats *stats)
+{
+	if (client == NULL || stats == NULL) {
+		return -EINVAL;
 	}
 
+	*stats = client->coap.stats;
+	stats->block_size = SZX_TO_BYTES(client->coap.szx);
+
 	return 0;
 }
@@ -14,6 +14,7 @@
 #include <posix/netdb.h>
 #include <posix/sys/time.h>
 #include <posix/sys/socket.h>
+#include <posix/poll.h>
 #else
 #include <net/socket.h>
 #endif
@@ -34,10 +35,18 @@ int url_parse_host(const char *url, char *host, size_t len);
 
 int http_parse(struct download_client *client, size_t len);
 int http_get_request_send(struct download_client *client);
+char *http_rx_buf_get(struct download_client *client, size_t *size);
+size_t http_pending_restore(struct download_client *client);
+void http_pipeline_reset(struct download_client *client);
+bool http_download_done(const struct download_client *client);
+bool http_range_requests_used(const struct download_client *client);
 
 int coap_block_init(struct download_client *client, size_t from);
 int coap_parse(struct download_client *client, size_t len);
 int coap_request_send(struct download_client *client);
+int coap_timeout_get(const struct download_client *client);
+int coap_retransmit(struct download_client *client);
+void coap_window_reset(struct download_client *client);
 
 static const char *str_family(int family)
 {
@@ -362,13 +371,14 @@ cleanup:
 	return err;
 }
 
-int socket_send(const struct download_client *client, size_t len)
+int socket_send(const struct download_client *client, const void *buf,
+		size_t len)
 {
 	int sent;
 	size_t off = 0;
 
 	while (len) {
-		sent = send(client->fd, client->buf + off, len, 0);
+		sent = send(client->fd, (const char *)buf + off, len, 0);
 		if (sent <= 0) {
 			return -errno;
 		}
@@ -396,22 +406,75 @@ static int request_send(struct download_client *dl)
 	return 0;
 }
 
+static bool proto_is_coap(const struct download_client *dl)
+{
+	return IS_ENABLED(CONFIG_COAP) &&
+	       (dl->proto == IPPROTO_UDP || dl->proto == IPPROTO_DTLS_1_2);
+}
+
+/* Wait until a CoAP response can be received,
+ * retransmitting the requests that are not answered in time.
+ */
+static int coap_response_wait(struct download_client *dl)
+{
+	int rc;
+	struct pollfd fds = {
+		.fd = dl->fd,
+		.events = POLLIN,
+	};
+
+	while (true) {
+		rc = poll(&fds, 1, coap_timeout_get(dl));
+		if (rc > 0) {
+			return 0;
+		}
+
+		if (rc < 0) {
+			LOG_ERR("Error in poll(), errno %d", errno);
+			return -errno;
+		}
+
+		rc = coap_retransmit(dl);
+		if (rc) {
+			return rc;
+		}
+	}
+}
+
 static int fragment_evt_send(const struct download_client *client)
 {
-	__ASSERT(client->offset <= CONFIG_DOWNLOAD_CLIENT_BUF_SIZE,
-		 "Buffer overflow!");
+	const void *buf;
+
+	if (client->proto == IPPROTO_UDP ||
+	    client->proto == IPPROTO_DTLS_1_2) {
+		buf = client->coap.payload;
+	} else {
+		__ASSERT(client->offset <= client->frag_buf_size,
+			 "Buffer overflow!");
+		buf = client->frag_buf;
+	}
 
 	const struct download_client_evt evt = {
 		.id = DOWNLOAD_CLIENT_EVT_FRAGMENT,
 		.fragment = {
-			.buf = client->buf,
+			.buf = buf,
 			.len = client->offset,
+			.offset = client->progress - client->offset,
 		}
 	};
 
 	return client->callback(&evt);
 }
 
+static bool download_done(const struct download_client *dl)
+{
+	if (dl->proto == IPPROTO_TCP || dl->proto == IPPROTO_TLS_1_2) {
+		return http_download_done(dl);
+	}
+
+	return dl->progress == dl->file_size;
+}
+
 static int error_evt_send(const struct download_client *dl, int error)
 {
 	/* Error will be sent as negative. */
@@ -440,6 +503,12 @@ static int reconnect(struct download_client *dl)
 		return err;
 	}
 
+	/* Requests in flight were lost with the connection */
+	http_pipeline_reset(dl);
+	if (proto_is_coap(dl)) {
+		coap_window_reset(dl);
+	}
+
 	return 0;
 }
 
@@ -448,26 +517,63 @@ void download_thread(void *client, void *a, void *b)
 	int rc = 0;
 	int error_cause;
 	size_t len;
+	char *rx_buf;
+	size_t rx_size;
 	struct download_client *const dl = client;
 
 restart_and_suspend:
 	k_thread_suspend(dl->tid);
 
 	while (true) {
-		__ASSERT(dl->offset < sizeof(dl->buf), "Buffer overflow");
+		if (dl->proto == IPPROTO_TCP || dl->proto == IPPROTO_TLS_1_2) {
+			rx_buf = http_rx_buf_get(dl, &rx_size);
+		} else {
+			rx_buf = dl->buf;
+			rx_size = sizeof(dl->buf);
+		}
+
+		__ASSERT(dl->offset <= rx_size, "Buffer overflow");
 
-		if (sizeof(dl->buf) - dl->offset == 0) {
+		if (rx_size - dl->offset == 0) {
 			LOG_ERR("Could not fit HTTP header from server (> %d)",
-				sizeof(dl->buf));
+				rx_size);
 			error_evt_send(dl, E2BIG);
 			break;
 		}
 
+		if (dl->http.pending) {
+			/* The beginning of this response was received
+			 * together with the previous one.
+			 */
+			len = 0;
+			goto parse;
+		}
+
+		if (proto_is_coap(dl)) {
+			rc = coap_response_wait(dl);
+			if (rc) {
+				rc = error_evt_send(dl, rc == -ETIMEDOUT ?
+						    ETIMEDOUT : ECONNRESET);
+				if (rc) {
+					/* Restart and suspend */
+					break;
+				}
+
+				rc = reconnect(dl);
+				if (rc) {
+					error_evt_send(dl, EHOSTDOWN);
+					break;
+				}
+
+				goto send_again;
+			}
+		}
+
 		LOG_DBG("Receiving up to %d bytes at %p...",
-			(sizeof(dl->buf) - dl->offset), (dl->buf + dl->offset));
+			(rx_size - dl->offset), (rx_buf + dl->offset));
 
-		len = recv(dl->fd, dl->buf + dl->offset,
-			   sizeof(dl->buf) - dl->offset, 0);
+		len = recv(dl->fd, rx_buf + dl->offset,
+			   rx_size - dl->offset, 0);
 
 		if ((len == 0) || (len == -1)) {
 			/* We just had an unexpected socket error or closure */
@@ -523,6 +629,7 @@ restart_and_suspend:
 			goto send_again;
 		}
 
+parse:
 		LOG_DBG("Read %d bytes from socket", len);
 
 		if (dl->proto == IPPROTO_TCP || dl->proto == IPPROTO_TLS_1_2) {
@@ -533,6 +640,10 @@ restart_and_suspend:
 			}
 		} else if (IS_ENABLED(CONFIG_COAP)) {
 			rc = coap_parse(client, len);
+			if (rc > 0) {
+				/* Duplicate or out of order, wait for more */
+				continue;
+			}
 		}
 
 		if (rc < 0) {
@@ -561,7 +672,7 @@ restart_and_suspend:
 			break;
 		}
 
-		if (dl->progress == dl->file_size) {
+		if (download_done(dl)) {
 			LOG_INF("Download complete");
 			const struct download_client_evt evt = {
 				.id = DOWNLOAD_CLIENT_EVT_DONE,
@@ -579,9 +690,13 @@ restart_and_suspend:
 
 send_again:
 		dl->offset = 0;
-		/* Request next fragment, if necessary (HTTPS/CoAP) */
+		if (dl->http.pending) {
+			dl->offset = http_pending_restore(dl);
+		}
+
+		/* Request next fragment, if necessary (HTTPS/CoAP/ranges) */
 		if (dl->proto != IPPROTO_TCP || len == 0
-		   || IS_ENABLED(CONFIG_DOWNLOAD_CLIENT_RANGE_REQUESTS)) {
+		   || http_range_requests_used(dl)) {
 			dl->http.has_header = false;
 
 			rc = request_send(dl);
@@ -616,6 +731,9 @@ int download_client_init(struct download_client *const client,
 
 	client->fd = -1;
 	client->callback = callback;
+	client->frag_buf = client->buf;
+	client->frag_buf_size = sizeof(client->buf);
+	client->stripe.stride = 0;
 
 	/* The thread is spawned now, but it will suspend itself;
 	 * it is resumed when the download is started via the API.
@@ -646,7 +764,7 @@ int download_client_connect(struct download_client *client, const char *host,
 		return 0;
 	}
 
-	if (config->frag_size_override > CONFIG_DOWNLOAD_CLIENT_BUF_SIZE) {
+	if (config->frag_size_override > client->frag_buf_size) {
 		LOG_ERR("The configured fragment size is larger than buffer");
 		return -E2BIG;
 	}
@@ -694,6 +812,31 @@ int download_client_disconnect(struct download_client *const client)
 	return 0;
 }
 
+int download_client_buf_set(struct download_client *client, void *buf,
+			    size_t len)
+{
+	if (client == NULL) {
+		return -EINVAL;
+	}
+
+	if (buf == NULL) {
+		client->frag_buf = client->buf;
+		client->frag_buf_size = sizeof(client->buf);
+		return 0;
+	}
+
+	if (len < sizeof(client->buf) ||
+	    len < client->config.frag_size_override) {
+		LOG_ERR("Fragment buffer too small (%d bytes)", len);
+		return -EINVAL;
+	}
+
+	client->frag_buf = buf;
+	client->frag_buf_size = len;
+
+	return 0;
+}
+
 int download_client_start(struct download_client *client, const char *file,
 			  size_t from)
 {
@@ -711,13 +854,10 @@ int download_client_start(struct download_client *client, const char *file,
 	client->file_size = 0;
 	client->progress = from;
 
-	client->offset = 0;
-	client->http.has_header = false;
+	http_pipeline_reset(client);
 
-	if (client->proto == IPPROTO_UDP || client->proto == IPPROTO_DTLS_1_2) {
-		if (IS_ENABLED(CONFIG_COAP)) {
-			coap_block_init(client, from);
-		}
+	if (proto_is_coap(client)) {
+		coap_block_init(client, from);
 	}
 
 	err = request_send(client);
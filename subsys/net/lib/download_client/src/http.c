@@ -33,13 +33,102 @@ LOG_MODULE_DECLARE(download_client, CONFIG_DOWNLOAD_CLIENT_LOG_LEVEL);
 
 int url_parse_host(const char *url, char *host, size_t len);
 int url_parse_file(const char *url, char *file, size_t len);
-int socket_send(const struct download_client *client, size_t len);
+int socket_send(const struct download_client *client, const void *buf,
+		size_t len);
 
-int http_get_request_send(struct download_client *client)
+/* We use range requests only for HTTPS, due to memory limitations.
+ * When using HTTP, we request the whole resource to minimize
+ * network usage (only one request/response are sent).
+ */
+bool http_range_requests_used(const struct download_client *client)
+{
+	return client->proto == IPPROTO_TLS_1_2 ||
+	       IS_ENABLED(CONFIG_DOWNLOAD_CLIENT_RANGE_REQUESTS) ||
+	       client->stripe.stride;
+}
+
+static size_t frag_size_get(const struct download_client *client)
+{
+	if (client->config.frag_size_override) {
+		return client->config.frag_size_override;
+	}
+
+	return CONFIG_DOWNLOAD_CLIENT_HTTP_FRAG_SIZE;
+}
+
+static size_t pipeline_depth_get(const struct download_client *client)
+{
+	if (client->config.pipeline_depth) {
+		return client->config.pipeline_depth;
+	}
+
+	return CONFIG_DOWNLOAD_CLIENT_HTTP_PIPELINE_DEPTH;
+}
+
+/* When downloading interleaved with other clients, only one fragment
+ * out of every (1 + stride / fragment size) is downloaded, starting
+ * from the stripe base. Returns `off`, or the beginning of the next
+ * fragment to download if `off` falls between two of them.
+ */
+static size_t stripe_skip(const struct download_client *client, size_t off)
+{
+	size_t pos;
+	size_t frag = frag_size_get(client);
+
+	if (!client->stripe.stride) {
+		return off;
+	}
+
+	pos = (off - client->stripe.base) % (frag + client->stripe.stride);
+	if (pos < frag) {
+		return off;
+	}
+
+	return off + frag + client->stripe.stride - pos;
+}
+
+/* Offset of the last byte of the range to request from `from` */
+static size_t range_end_get(const struct download_client *client,
+			    size_t from)
+{
+	size_t frag = frag_size_get(client);
+	size_t to = from + frag - 1;
+
+	if (client->stripe.stride) {
+		/* Not past the fragment containing `from` */
+		to -= (from - client->stripe.base) %
+		      (frag + client->stripe.stride);
+	}
+
+	if (client->file_size) {
+		/* Don't request bytes past the end of file */
+		to = MIN(to, client->file_size - 1);
+	}
+
+	return to;
+}
+
+/* Payload length of the response being received.
+ * Responses arrive in the order of the requests, and each request
+ * asks for the fragment following the previous one.
+ */
+static size_t response_len_get(const struct download_client *client)
+{
+	size_t from = client->progress - client->offset;
+
+	return range_end_get(client, from) + 1 - from;
+}
+
+/* Send a request for bytes `from` to `to` of the file,
+ * or from `from` to the end of the file if `to` is zero.
+ */
+static int request_send(struct download_client *client, size_t from,
+			size_t to)
 {
 	int err;
 	int len;
-	size_t off;
+	char *req;
+	size_t size;
 	char host[HOSTNAME_SIZE];
 	char file[FILENAME_SIZE];
 
@@ -56,44 +145,28 @@ int http_get_request_send(struct download_client *client)
 		return err;
 	}
 
-	/* Offset of last byte in range (Content-Range) */
-	if (client->config.frag_size_override) {
-		off = client->progress + client->config.frag_size_override - 1;
-	} else {
-		off = client->progress +
-			CONFIG_DOWNLOAD_CLIENT_HTTP_FRAG_SIZE - 1;
-	}
-
-	if (client->file_size != 0) {
-		/* Don't request bytes past the end of file */
-		off = MIN(off, client->file_size);
-	}
+	/* The buffer may already hold the beginning of the next response */
+	req = client->buf + client->offset;
+	size = sizeof(client->buf) - client->offset;
 
-	/* We use range requests only for HTTPS, due to memory limitations.
-	 * When using HTTP, we request the whole resource to minimize
-	 * network usage (only one request/response are sent).
-	 */
-	if (client->proto == IPPROTO_TLS_1_2
-	   || IS_ENABLED(CONFIG_DOWNLOAD_CLIENT_RANGE_REQUESTS)) {
-		len = snprintf(client->buf,
-			CONFIG_DOWNLOAD_CLIENT_BUF_SIZE,
-			GET_HTTPS_TEMPLATE, file, host, client->progress, off);
+	if (to) {
+		len = snprintf(req, size, GET_HTTPS_TEMPLATE,
+			       file, host, from, to);
 	} else {
-		len = snprintf(client->buf,
-			CONFIG_DOWNLOAD_CLIENT_BUF_SIZE,
-			GET_HTTP_TEMPLATE, file, host, client->progress);
+		len = snprintf(req, size, GET_HTTP_TEMPLATE,
+			       file, host, from);
 	}
 
-	if (len < 0 || len > CONFIG_DOWNLOAD_CLIENT_BUF_SIZE) {
+	if (len < 0 || len >= size) {
 		LOG_ERR("Cannot create GET request, buffer too small");
 		return -ENOMEM;
 	}
 
 	if (IS_ENABLED(CONFIG_DOWNLOAD_CLIENT_LOG_HEADERS)) {
-		LOG_HEXDUMP_DBG(client->buf, len, "HTTP request");
+		LOG_HEXDUMP_DBG(req, len, "HTTP request");
 	}
 
-	err = socket_send(client, len);
+	err = socket_send(client, req, len);
 	if (err) {
 		LOG_ERR("Failed to send HTTP request, errno %d", errno);
 		return err;
@@ -102,6 +175,46 @@ int http_get_request_send(struct download_client *client)
 	return 0;
 }
 
+int http_get_request_send(struct download_client *client)
+{
+	int err;
+	size_t from;
+	size_t to;
+
+	if (!http_range_requests_used(client)) {
+		return request_send(client, client->progress, 0);
+	}
+
+	/* Keep the configured number of range requests in flight.
+	 * Until the first response tells the file size,
+	 * only one request is sent, to not request past the end of file.
+	 */
+	do {
+		from = client->http.requested;
+		if (client->file_size && from >= client->file_size) {
+			break;
+		}
+
+		/* Offset of last byte in range (Content-Range) */
+		to = range_end_get(client, from);
+
+		err = request_send(client, from, to);
+		if (err) {
+			if (err == -ENOMEM && client->http.in_flight) {
+				/* Try again when the buffer is emptier */
+				break;
+			}
+			return err;
+		}
+
+		client->http.requested = stripe_skip(client, to + 1);
+		client->http.in_flight++;
+	} while (client->file_size &&
+		 client->http.in_flight < pipeline_depth_get(client));
+
+	return 0;
+}
+
 /* Returns:
  *  1 while the header is being received
  *  0 if the header has been fully received
@@ -110,6 +223,10 @@ int http_get_request_send(struct download_client *client)
 static int http_header_parse(struct download_client *client, size_t *hdr_len)
 {
 	char *p;
+	char end;
+
+	/* The buffer can hold stale data past the received bytes */
+	client->buf[client->offset] = '\0';
 
 	p = strstr(client->buf, "\r\n\r\n");
 	if (!p) {
@@ -130,6 +247,12 @@ static int http_header_parse(struct download_client *client, size_t *hdr_len)
 		client->buf[i] = tolower(client->buf[i]);
 	}
 
+	/* Restrict the search for header fields to this header,
+	 * the payload or the next response may follow.
+	 */
+	end = client->buf[*hdr_len];
+	client->buf[*hdr_len] = '\0';
+
 	p = strstr(client->buf, "http/1.1 206");
 	if (!p) {
 		p = strstr(client->buf, "http/1.1 404");
@@ -137,8 +260,7 @@ static int http_header_parse(struct download_client *client, size_t *hdr_len)
 			LOG_ERR("Server response was 404: file not found");
 			return -1;
 		}
-		if (client->proto == IPPROTO_TLS_1_2
-		   || IS_ENABLED(CONFIG_DOWNLOAD_CLIENT_RANGE_REQUESTS)) {
+		if (http_range_requests_used(client)) {
 			LOG_ERR("Server did not honor partial content request");
 			return -1;
 		}
@@ -153,8 +275,7 @@ static int http_header_parse(struct download_client *client, size_t *hdr_len)
 	 * and via "Content-Range" in case of HTTPS with range requests.
 	 */
 	if (client->file_size == 0) {
-		if (client->proto == IPPROTO_TLS_1_2
-		   || IS_ENABLED(CONFIG_DOWNLOAD_CLIENT_RANGE_REQUESTS)) {
+		if (http_range_requests_used(client)) {
 			p = strstr(client->buf, "content-range");
 			if (!p) {
 				LOG_ERR("Server did not send "
@@ -194,6 +315,7 @@ static int http_header_parse(struct download_client *client, size_t *hdr_len)
 		client->http.connection_close = true;
 	}
 
+	client->buf[*hdr_len] = end;
 	client->http.has_header = true;
 
 	return 0;
@@ -208,11 +330,15 @@ int http_parse(struct download_client *client, size_t len)
 {
 	int rc;
 	size_t hdr_len;
+	size_t payload;
+	size_t received;
 
 	/* Accumulate buffer offset */
 	client->offset += len;
 
 	if (!client->http.has_header) {
+		client->http.pending = 0;
+
 		rc = http_header_parse(client, &hdr_len);
 		if (rc > 0) {
 			/* Wait for header */
@@ -223,41 +349,106 @@ int http_parse(struct download_client *client, size_t len)
 			return -1;
 		}
 
-		if (client->offset != hdr_len) {
-			/* The buffer contains some payload bytes,
-			 * copy them at the beginning of the buffer
-			 * and update the offset.
-			 */
-			LOG_DBG("Copying %u payload bytes",
-				client->offset - hdr_len);
-			memcpy(client->buf, client->buf + hdr_len,
-			       client->offset - hdr_len);
-
-			client->offset -= hdr_len;
-		} else {
-			/* Reset the offset.
-			 * The payload is received in an empty buffer.
+		/* The buffer may contain some payload bytes and,
+		 * when requests are pipelined, the beginning of
+		 * the next response.
+		 */
+		received = client->offset;
+		client->offset = 0;
+
+		/* Skip the fragments downloaded by other clients */
+		client->progress = stripe_skip(client, client->progress);
+
+		payload = received - hdr_len;
+		if (http_range_requests_used(client)) {
+			payload = MIN(payload, response_len_get(client));
+		}
+
+		if (payload) {
+			/* Copy the payload bytes at the beginning
+			 * of the fragment buffer.
 			 */
-			client->offset = 0;
+			LOG_DBG("Copying %u payload bytes", payload);
+			memmove(client->frag_buf, client->buf + hdr_len,
+				payload);
 		}
+
+		if (received > hdr_len + payload) {
+			/* Keep the rest for the next response */
+			client->http.pending = received - hdr_len - payload;
+			client->http.pending_off = hdr_len + payload;
+		}
+
+		client->offset = payload;
+		len = payload;
 	}
 
-	/* Accumulate overall file progress.
-	 * If the last recv() call read an HTTP header,
-	 * `offset` has been moved at the end of any trailing
-	 * payload bytes by http_header_parse(). In this case,
-	 * `offset` is less than `len` and it represents
-	 * the actual payload bytes.
-	 */
-	client->progress += MIN(client->offset, len);
+	/* Accumulate overall file progress */
+	client->progress += len;
 
 	/* Have we received a whole fragment or the whole file? */
-	if (client->progress != client->file_size &&
-	    client->offset < (client->config.frag_size_override != 0 ?
-			      client->config.frag_size_override :
-			      CONFIG_DOWNLOAD_CLIENT_HTTP_FRAG_SIZE)) {
+	if (http_range_requests_used(client)) {
+		if (client->offset < response_len_get(client)) {
+			return 1;
+		}
+
+		__ASSERT_NO_MSG(client->http.in_flight);
+		client->http.in_flight--;
+	} else if (client->progress != client->file_size &&
+		   client->offset < frag_size_get(client)) {
 		return 1;
 	}
 
 	return 0;
 }
+
+/* The response header is received in the internal buffer,
+ * the payload is received directly in the fragment buffer.
+ */
+char *http_rx_buf_get(struct download_client *client, size_t *size)
+{
+	if (!client->http.has_header) {
+		/* Leave room to terminate the header */
+		*size = sizeof(client->buf) - 1;
+		return client->buf;
+	}
+
+	*size = client->frag_buf_size;
+	if (http_range_requests_used(client)) {
+		/* Don't read into the next response */
+		*size = MIN(*size, response_len_get(client));
+	}
+
+	return client->frag_buf;
+}
+
+/* Whether all the bytes to download have been received */
+bool http_download_done(const struct download_client *client)
+{
+	return stripe_skip(client, client->progress) >= client->file_size;
+}
+
+/* Move the beginning of the next response, received together with
+ * the previous one, at the beginning of the buffer.
+ * Returns the number of bytes moved, which still have to be parsed.
+ */
+size_t http_pending_restore(struct download_client *client)
+{
+	memmove(client->buf, client->buf + client->http.pending_off,
+		client->http.pending);
+	client->http.pending_off = 0;
+
+	return client->http.pending;
+}
+
+/* Forget about the requests in flight on the current connection,
+ * and request again from the last byte handed to the application.
+ */
+void http_pipeline_reset(struct download_client *client)
+{
+	client->http.requested = stripe_skip(client, client->progress);
+	client->http.in_flight = 0;
+	client->http.pending = 0;
+	client->http.has_header = false;
+	client->offset = 0;
+}
@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <net/download_client.h>
+#include <logging/log.h>
+
+LOG_MODULE_DECLARE(download_client, CONFIG_DOWNLOAD_CLIENT_LOG_LEVEL);
+
+/* Events are sent from the thread of the client generating them */
+static struct download_client_parallel_conn *conn_get(void)
+{
+	struct download_client *client =
+		CONTAINER_OF(k_current_get(), struct download_client, thread);
+
+	return CONTAINER_OF(client, struct download_client_parallel_conn,
+			    client);
+}
+
+/* Connection downloading the fragment containing `off` */
+static struct download_client_parallel_conn *
+conn_of(struct download_client_parallel *dl, size_t off)
+{
+	return &dl->conn[((off - dl->from) / dl->frag_size) % dl->count];
+}
+
+static void stop(struct download_client_parallel *dl)
+{
+	dl->stopped = true;
+
+	/* Wake up the connections waiting for their turn */
+	for (size_t i = 0; i < dl->count; i++) {
+		k_sem_give(&dl->conn[i].turn);
+	}
+}
+
+/* Start the other connections once the file size is known,
+ * each from its first fragment.
+ */
+static int conns_start(struct download_client_parallel *dl,
+		       size_t file_size)
+{
+	int err;
+	struct download_client_parallel_conn *conn;
+
+	for (size_t i = 1; i < dl->count; i++) {
+		conn = &dl->conn[i];
+
+		if (conn->client.stripe.base >= file_size) {
+			/* File too small for this connection */
+			conn->done = true;
+			continue;
+		}
+
+		err = download_client_start(&conn->client, dl->file,
+					    conn->client.stripe.base);
+		if (err) {
+			LOG_ERR("Failed to start connection %d, err %d",
+				i, err);
+			return err;
+		}
+	}
+
+	dl->started = true;
+
+	return 0;
+}
+
+/* Called with the lock held */
+static int fragment_deliver(struct download_client_parallel *dl,
+			    struct download_client_parallel_conn *conn,
+			    const struct download_client_evt *evt)
+{
+	int err;
+	const struct download_fragment *frag = &evt->fragment;
+
+	/* Wait until all the bytes before this fragment are delivered */
+	while (dl->ordered && !dl->stopped && frag->offset != dl->next) {
+		k_mutex_unlock(&dl->lock);
+		k_sem_take(&conn->turn, K_FOREVER);
+		k_mutex_lock(&dl->lock, K_FOREVER);
+	}
+
+	if (dl->stopped) {
+		return -ECANCELED;
+	}
+
+	err = dl->callback(evt);
+	if (err) {
+		stop(dl);
+		return err;
+	}
+
+	if (dl->ordered) {
+		dl->next = frag->offset + frag->len;
+		k_sem_give(&conn_of(dl, dl->next)->turn);
+	}
+
+	return 0;
+}
+
+/* Errors after which the client stops, whatever the callback returns */
+static bool error_is_terminal(int error)
+{
+	return error == -EBADMSG || error == -E2BIG || error == -EHOSTDOWN;
+}
+
+static bool all_done(const struct download_client_parallel *dl)
+{
+	for (size_t i = 0; i < dl->count; i++) {
+		if (!dl->conn[i].done) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static int callback(const struct download_client_evt *evt)
+{
+	int err = 0;
+	size_t file_size;
+	struct download_client_parallel_conn *conn = conn_get();
+	struct download_client_parallel *dl = conn->parent;
+
+	k_mutex_lock(&dl->lock, K_FOREVER);
+
+	switch (evt->id) {
+	case DOWNLOAD_CLIENT_EVT_FRAGMENT:
+		if (!dl->started) {
+			(void)download_client_file_size_get(&conn->client,
+							    &file_size);
+			err = conns_start(dl, file_size);
+			if (err) {
+				stop(dl);
+				break;
+			}
+		}
+
+		err = fragment_deliver(dl, conn, evt);
+		break;
+	case DOWNLOAD_CLIENT_EVT_ERROR:
+		if (dl->stopped) {
+			err = -ECANCELED;
+			break;
+		}
+
+		err = dl->callback(evt);
+		if (err || error_is_terminal(evt->error)) {
+			/* This connection does not deliver its fragments
+			 * anymore, so the others would wait for their turn
+			 * forever.
+			 */
+			stop(dl);
+		}
+		break;
+	case DOWNLOAD_CLIENT_EVT_DONE:
+		conn->done = true;
+		if (all_done(dl)) {
+			LOG_INF("Parallel download complete");
+			dl->callback(evt);
+		}
+		break;
+	}
+
+	k_mutex_unlock(&dl->lock);
+
+	return err;
+}
+
+int download_client_parallel_init(struct download_client_parallel *dl,
+				  size_t count, bool ordered,
+				  download_client_callback_t callback_fn)
+{
+	int err;
+
+	if (dl == NULL || callback_fn == NULL || count == 0 ||
+	    count > ARRAY_SIZE(dl->conn)) {
+		return -EINVAL;
+	}
+
+	dl->count = count;
+	dl->ordered = ordered;
+	dl->callback = callback_fn;
+
+	k_mutex_init(&dl->lock);
+
+	for (size_t i = 0; i < count; i++) {
+		dl->conn[i].parent = dl;
+		k_sem_init(&dl->conn[i].turn, 0, 1);
+
+		err = download_client_init(&dl->conn[i].client, callback);
+		if (err) {
+			return err;
+		}
+	}
+
+	return 0;
+}
+
+int download_client_parallel_connect(struct download_client_parallel *dl,
+				     const char *host,
+				     const struct download_client_cfg *config)
+{
+	int err;
+
+	if (dl == NULL || host == NULL || config == NULL) {
+		return -EINVAL;
+	}
+
+	dl->frag_size = config->frag_size_override ?
+			config->frag_size_override :
+			CONFIG_DOWNLOAD_CLIENT_HTTP_FRAG_SIZE;
+
+	for (size_t i = 0; i < dl->count; i++) {
+		err = download_client_connect(&dl->conn[i].client, host,
+					      config);
+		if (err) {
+			LOG_ERR("Failed to connect connection %d, err %d",
+				i, err);
+			return err;
+		}
+
+		if (dl->conn[i].client.proto != IPPROTO_TCP &&
+		    dl->conn[i].client.proto != IPPROTO_TLS_1_2) {
+			LOG_ERR("Parallel download requires HTTP(S)");
+			return -EPROTONOSUPPORT;
+		}
+	}
+
+	return 0;
+}
+
+int download_client_parallel_start(struct download_client_parallel *dl,
+				   const char *file, size_t from)
+{
+	struct download_client *client;
+
+	if (dl == NULL || file == NULL) {
+		return -EINVAL;
+	}
+
+	dl->file = file;
+	dl->from = from;
+	dl->next = from;
+	dl->started = false;
+	dl->stopped = false;
+
+	/* Connection `i` downloads fragments i, i + count, i + 2 * count.. */
+	for (size_t i = 0; i < dl->count; i++) {
+		client = &dl->conn[i].client;
+		client->stripe.base = from + i * dl->frag_size;
+		client->stripe.stride = (dl->count - 1) * dl->frag_size;
+
+		dl->conn[i].done = false;
+		k_sem_reset(&dl->conn[i].turn);
+	}
+
+	/* The other connections are started when the file size is known */
+	return download_client_start(&dl->conn[0].client, file, from);
+}
+
+int download_client_parallel_disconnect(struct download_client_parallel *dl)
+{
+	int err;
+	int ret = 0;
+
+	if (dl == NULL) {
+		return -EINVAL;
+	}
+
+	for (size_t i = 0; i < dl->count; i++) {
+		if (dl->conn[i].client.fd < 0) {
+			continue;
+		}
+
+		err = download_client_disconnect(&dl->conn[i].client);
+		if (err) {
+			ret = err;
+		}
+	}
+
+	return ret;
+}
@@ -11,6 +11,7 @@
 #include <string.h>
 #include <zephyr.h>
 #include <logging/log.h>
+#include <json_writer.h>
 #include "cJSON.h"
 #include "cJSON_os.h"
 
@@ -41,30 +42,6 @@ static int json_add_obj(cJSON *parent, const char *str, cJSON *item)
 	return 0;
 }
 
-static int json_add_str(cJSON *parent, const char *str, const char *item)
-{
-	cJSON *json_str;
-
-	json_str = cJSON_CreateString(item);
-	if (json_str == NULL) {
-		return -ENOMEM;
-	}
-
-	return json_add_obj(parent, str, json_str);
-}
-
-static int json_add_null(cJSON *parent, const char *str)
-{
-	cJSON *json_null;
-
-	json_null = cJSON_CreateNull();
-	if (json_null == NULL) {
-		return -ENOMEM;
-	}
-
-	return json_add_obj(parent, str, json_null);
-}
-
 static cJSON *json_object_decode(cJSON *obj, const char *str)
 {
 	return obj ? cJSON_GetObjectItem(obj, str) : NULL;
@@ -112,6 +89,49 @@ static void nrf_cloud_decode_desired_obj(cJSON *const root_obj,
 	}
 }
 
+/* --- Encoding with the JSON writer --- */
+
+typedef void (*json_write_t)(struct json_writer *writer, const void *ctx);
+
+/* The document is written twice: first to get its length, then into a
+ * buffer of this length, so that no other memory is allocated.
+ */
+static int json_encode(json_write_t write, const void *ctx,
+		       struct nrf_cloud_data *output)
+{
+	struct json_writer writer;
+	char *buffer;
+	int len;
+	int ret;
+
+	json_writer_init(&writer, NULL, 0, NULL, NULL);
+	write(&writer, ctx);
+
+	len = json_writer_finish(&writer);
+	if (len < 0) {
+		return len;
+	}
+
+	buffer = nrf_cloud_malloc(len + 1);
+	if (buffer == NULL) {
+		return -ENOMEM;
+	}
+
+	json_writer_init(&writer, buffer, len + 1, NULL, NULL);
+	write(&writer, ctx);
+
+	ret = json_writer_finish(&writer);
+	if (ret < 0) {
+		nrf_cloud_free(buffer);
+		return ret;
+	}
+
+	output->ptr = buffer;
+	output->len = len;
+
+	return 0;
+}
+
 int nrf_codec_init(void)
 {
 	cJSON_Init();
@@ -161,40 +181,26 @@ int nrf_cloud_encode_shadow_data(const struct nrf_cloud_sensor_data *sensor,
 	return 0;
 }
 
+static void sensor_data_write(struct json_writer *writer, const void *ctx)
+{
+	const struct nrf_cloud_sensor_data *sensor = ctx;
+
+	json_writer_object_start(writer, NULL);
+	json_writer_string(writer, "appId", sensor_type_str[sensor->type]);
+	json_writer_string(writer, "data", sensor->data.ptr);
+	json_writer_string(writer, "messageType", "DATA");
+	json_writer_object_end(writer);
+}
+
 int nrf_cloud_encode_sensor_data(const struct nrf_cloud_sensor_data *sensor,
 				 struct nrf_cloud_data *output)
 {
-	int ret;
-
 	__ASSERT_NO_MSG(sensor != NULL);
 	__ASSERT_NO_MSG(sensor->data.ptr != NULL);
 	__ASSERT_NO_MSG(sensor->data.len != 0);
 	__ASSERT_NO_MSG(output != NULL);
 
-	cJSON *root_obj = cJSON_CreateObject();
-
-	if (root_obj == NULL) {
-		return -ENOMEM;
-	}
-
-	ret = json_add_str(root_obj, "appId", sensor_type_str[sensor->type]);
-	ret += json_add_str(root_obj, "data", sensor->data.ptr);
-	ret += json_add_str(root_obj, "messageType", "DATA");
-
-	if (ret != 0) {
-		cJSON_Delete(root_obj);
-		return -ENOMEM;
-	}
-
-	char *buffer;
-
-	buffer = cJSON_PrintUnformatted(root_obj);
-	cJSON_Delete(root_obj);
-
-	output->ptr = buffer;
-	output->len = strlen(buffer);
-
-	return 0;
+	return json_encode(sensor_data_write, sensor, output);
 }
 
 int nrf_cloud_decode_requested_state(const struct nrf_cloud_data *input,
@@ -338,124 +344,83 @@ int nrf_cloud_encode_config_response(struct nrf_cloud_data const *const input,
 	return 0;
 }
 
-int nrf_cloud_encode_state(uint32_t reported_state, struct nrf_cloud_data *output)
-{
-	int ret;
-
-	__ASSERT_NO_MSG(output != NULL);
-
-	cJSON *root_obj = cJSON_CreateObject();
-	cJSON *state_obj = cJSON_CreateObject();
-	cJSON *reported_obj = cJSON_CreateObject();
-	cJSON *pairing_obj = cJSON_CreateObject();
-	cJSON *connection_obj = cJSON_CreateObject();
+struct state_report {
+	uint32_t reported_state;
+	struct nrf_cloud_data tx_endp;
+	struct nrf_cloud_data rx_endp;
+	struct nrf_cloud_data m_endp;
+};
 
-	if ((root_obj == NULL) || (state_obj == NULL) ||
-	    (reported_obj == NULL) || (pairing_obj == NULL) ||
-	    (connection_obj == NULL)) {
-		cJSON_Delete(root_obj);
-		cJSON_Delete(state_obj);
-		cJSON_Delete(reported_obj);
-		cJSON_Delete(pairing_obj);
-		cJSON_Delete(connection_obj);
+static void state_write(struct json_writer *writer, const void *ctx)
+{
+	const struct state_report *report = ctx;
 
-		return -ENOMEM;
-	}
+	json_writer_object_start(writer, NULL);
+	json_writer_object_start(writer, "state");
+	json_writer_object_start(writer, "reported");
 
-	ret = 0;
+	if (report->reported_state == STATE_UA_PIN_WAIT) {
+		json_writer_null(writer, "stage");
+		json_writer_null(writer, "nrfcloud_mqtt_topic_prefix");
 
-	switch (reported_state) {
-	case STATE_UA_PIN_WAIT: {
-		ret += json_add_str(pairing_obj, "state", DUA_PIN_STR);
-		ret += json_add_null(pairing_obj, "topics");
-		ret += json_add_null(pairing_obj, "config");
-		ret += json_add_null(reported_obj, "stage");
-		ret += json_add_null(reported_obj,
-				     "nrfcloud_mqtt_topic_prefix");
-		ret += json_add_null(connection_obj, "keepalive");
-		break;
-	}
-	case STATE_UA_PIN_COMPLETE: {
-		struct nrf_cloud_data rx_endp;
-		struct nrf_cloud_data tx_endp;
-		struct nrf_cloud_data m_endp;
+		json_writer_object_start(writer, "pairing");
+		json_writer_string(writer, "state", DUA_PIN_STR);
+		json_writer_null(writer, "topics");
+		json_writer_null(writer, "config");
+		json_writer_object_end(writer);
 
-		/* Get the endpoint information. */
-		nct_dc_endpoint_get(&tx_endp, &rx_endp, &m_endp);
-		ret += json_add_str(reported_obj, "nrfcloud_mqtt_topic_prefix",
-				    m_endp.ptr);
+		json_writer_object_start(writer, "connection");
+		json_writer_null(writer, "keepalive");
+		json_writer_object_end(writer);
+	} else {
+		json_writer_string(writer, "nrfcloud_mqtt_topic_prefix",
+				   report->m_endp.ptr);
 
 		/* Clear pairing config and pairingStatus fields. */
-		ret += json_add_str(pairing_obj, "state", PAIRED_STR);
-		ret += json_add_null(pairing_obj, "config");
-		ret += json_add_null(reported_obj, "pairingStatus");
-
-		/* Report keepalive value. */
-		if (cJSON_AddNumberToObject(connection_obj, "keepalive",
-					    CONFIG_MQTT_KEEPALIVE) == NULL) {
-			ret = -ENOMEM;
-		}
+		json_writer_null(writer, "pairingStatus");
 
 		/* Report pairing topics. */
-		cJSON *topics_obj = cJSON_CreateObject();
-
-		if (topics_obj == NULL) {
-			cJSON_Delete(root_obj);
-			cJSON_Delete(state_obj);
-			cJSON_Delete(reported_obj);
-			cJSON_Delete(pairing_obj);
-			cJSON_Delete(connection_obj);
+		json_writer_object_start(writer, "pairing");
+		json_writer_string(writer, "state", PAIRED_STR);
+		json_writer_null(writer, "config");
+		json_writer_object_start(writer, "topics");
+		json_writer_string(writer, "d2c", report->tx_endp.ptr);
+		json_writer_string(writer, "c2d", report->rx_endp.ptr);
+		json_writer_object_end(writer);
+		json_writer_object_end(writer);
 
-			return -ENOMEM;
-		}
-
-		ret += json_add_str(topics_obj, "d2c", tx_endp.ptr);
-		ret += json_add_str(topics_obj, "c2d", rx_endp.ptr);
-		ret += json_add_obj(pairing_obj, "topics", topics_obj);
-
-		if (ret != 0) {
-			cJSON_Delete(topics_obj);
-		}
-		break;
-	}
-	default: {
-		cJSON_Delete(root_obj);
-		cJSON_Delete(state_obj);
-		cJSON_Delete(reported_obj);
-		cJSON_Delete(pairing_obj);
-		cJSON_Delete(connection_obj);
-		return -ENOTSUP;
-	}
+		/* Report keepalive value. */
+		json_writer_object_start(writer, "connection");
+		json_writer_number(writer, "keepalive", CONFIG_MQTT_KEEPALIVE);
+		json_writer_object_end(writer);
 	}
 
-	ret += json_add_obj(reported_obj, "pairing", pairing_obj);
-	ret += json_add_obj(reported_obj, "connection", connection_obj);
-	ret += json_add_obj(state_obj, "reported", reported_obj);
-	ret += json_add_obj(root_obj, "state", state_obj);
-
-	if (ret != 0) {
-		cJSON_Delete(root_obj);
-		cJSON_Delete(state_obj);
-		cJSON_Delete(reported_obj);
-		cJSON_Delete(pairing_obj);
-		cJSON_Delete(connection_obj);
-
-		return -ENOMEM;
-	}
+	json_writer_object_end(writer);
+	json_writer_object_end(writer);
+	json_writer_object_end(writer);
+}
 
-	char *buffer;
+int nrf_cloud_encode_state(uint32_t reported_state, struct nrf_cloud_data *output)
+{
+	struct state_report report = {
+		.reported_state = reported_state,
+	};
 
-	buffer = cJSON_PrintUnformatted(root_obj);
-	cJSON_Delete(root_obj);
+	__ASSERT_NO_MSG(output != NULL);
 
-	if (buffer == NULL) {
-		return -ENOMEM;
+	switch (reported_state) {
+	case STATE_UA_PIN_WAIT:
+		break;
+	case STATE_UA_PIN_COMPLETE:
+		/* Get the endpoint information. */
+		nct_dc_endpoint_get(&report.tx_endp, &report.rx_endp,
+				    &report.m_endp);
+		break;
+	default:
+		return -ENOTSUP;
 	}
 
-	output->ptr = buffer;
-	output->len = strlen(buffer);
-
-	return 0;
+	return json_encode(state_write, &report, output);
 }
 
 /**
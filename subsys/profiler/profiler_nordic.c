@@ -22,9 +22,52 @@ uint32_t profiler_enabled_events = 0xffffffff;
 
 
 static K_SEM_DEFINE(profiler_sem, 0, 1);
+static K_SEM_DEFINE(flush_sem, 0, 1);
 static bool protocol_running;
 static bool sending_events;
 
+/* Events are sent to the host in frames. Every frame starts with a header:
+ * - Frame ID (1 byte, FRAME_ID).
+ * - Length of the frame payload (2 bytes).
+ * - Timestamp of the first event in the frame (4 bytes).
+ * - Number of events dropped since the profiler start (4 bytes).
+ * The payload contains encoded events. Every event is encoded as event type ID
+ * (1 byte), timestamp delta to the previous event in the frame (unsigned
+ * LEB128) and event data.
+ */
+#define FRAME_ID		0xFF
+#define FRAME_LEN_POS		1
+#define FRAME_TIMESTAMP_POS	3
+#define FRAME_DROPPED_POS	7
+#define FRAME_HEADER_SIZE	11
+#define TIMESTAMP_DELTA_MAX_LEN	5
+
+BUILD_ASSERT(CONFIG_MAX_NUMBER_OF_CUSTOM_EVENTS < FRAME_ID);
+BUILD_ASSERT(CONFIG_PROFILER_NORDIC_STAGING_BUFFER_SIZE - FRAME_HEADER_SIZE
+	     <= UINT16_MAX);
+/* The largest event, with the data of a custom event buffer, must fit in an
+ * empty staging buffer.
+ */
+BUILD_ASSERT(CONFIG_PROFILER_NORDIC_STAGING_BUFFER_SIZE >= FRAME_HEADER_SIZE +
+	     sizeof(uint8_t) + TIMESTAMP_DELTA_MAX_LEN +
+	     CONFIG_PROFILER_CUSTOM_EVENT_BUF_LEN - sizeof(uint8_t) -
+	     sizeof(uint32_t));
+
+struct staging_buf {
+	uint8_t data[CONFIG_PROFILER_NORDIC_STAGING_BUFFER_SIZE];
+	size_t len;
+	uint32_t event_cnt;
+	uint32_t last_timestamp;
+};
+
+/* Events are added to the active staging buffer. A full buffer is handed
+ * over to the profiler thread that sends it with a single RTT write.
+ */
+static struct staging_buf staging_bufs[2];
+static struct staging_buf *active_buf = &staging_bufs[0];
+static struct staging_buf *pending_buf;
+static struct profiler_nordic_stats stats;
+
 enum nordic_command {
 	NORDIC_COMMAND_START	= 1,
 	NORDIC_COMMAND_STOP	= 2,
@@ -110,12 +153,91 @@ static void send_system_description(void)
 	}
 }
 
+static void staging_buf_reset(struct staging_buf *sb)
+{
+	sb->len = FRAME_HEADER_SIZE;
+	sb->event_cnt = 0;
+}
+
+static struct staging_buf *staging_buf_swap(void)
+{
+	/* Must be called with interrupts locked. */
+	__ASSERT_NO_MSG(pending_buf == NULL);
+
+	pending_buf = active_buf;
+	active_buf = (active_buf == &staging_bufs[0]) ?
+		     &staging_bufs[1] : &staging_bufs[0];
+	staging_buf_reset(active_buf);
+
+	return pending_buf;
+}
+
+static void staging_buf_send(struct staging_buf *sb)
+{
+	sb->data[0] = FRAME_ID;
+	sys_put_le16(sb->len - FRAME_HEADER_SIZE, &sb->data[FRAME_LEN_POS]);
+	sys_put_le32(stats.dropped_events, &sb->data[FRAME_DROPPED_POS]);
+
+	/* RTT buffer works in skip mode, the frame is written entirely
+	 * or not at all.
+	 */
+	unsigned int written = SEGGER_RTT_Write(
+				CONFIG_PROFILER_NORDIC_RTT_CHANNEL_DATA,
+				sb->data, sb->len);
+
+	int key = irq_lock();
+
+	if (written == sb->len) {
+		stats.sent_events += sb->event_cnt;
+		stats.sent_frames++;
+	} else {
+		stats.dropped_events += sb->event_cnt;
+	}
+	pending_buf = NULL;
+
+	irq_unlock(key);
+}
+
+static void staging_flush(void)
+{
+	/* Send the pending buffer and the events collected in the active
+	 * buffer.
+	 */
+	for (size_t i = 0; i < ARRAY_SIZE(staging_bufs); i++) {
+		int key = irq_lock();
+		struct staging_buf *sb = pending_buf;
+
+		if (!sb && (active_buf->event_cnt > 0)) {
+			sb = staging_buf_swap();
+		}
+
+		irq_unlock(key);
+
+		if (!sb) {
+			break;
+		}
+
+		staging_buf_send(sb);
+	}
+}
+
 static void profiler_nordic_thread_fn(void)
 {
+	int64_t last_command_check = 0;
+
 	while (protocol_running) {
 		uint8_t read_data;
 		enum nordic_command command;
 
+		k_sem_take(&flush_sem,
+			   K_MSEC(CONFIG_PROFILER_NORDIC_FLUSH_PERIOD_MS));
+		staging_flush();
+
+		if ((k_uptime_get() - last_command_check) < 500) {
+			continue;
+		}
+		last_command_check = k_uptime_get();
+
 		if (SEGGER_RTT_Read(
 		     CONFIG_PROFILER_NORDIC_RTT_CHANNEL_COMMANDS,
 		     &read_data, sizeof(read_data))) {
@@ -126,6 +248,7 @@ static void profiler_nordic_thread_fn(void)
 				break;
 			case NORDIC_COMMAND_STOP:
 				sending_events = false;
+				staging_flush();
 				break;
 			case NORDIC_COMMAND_INFO:
 				send_system_description();
@@ -135,8 +258,8 @@ static void profiler_nordic_thread_fn(void)
 				break;
 			}
 		}
-		k_sleep(K_MSEC(500));
 	}
+	staging_flush();
 	k_sem_give(&profiler_sem);
 }
 
@@ -148,6 +271,8 @@ int profiler_init(void)
 	}
 	int ret;
 
+	staging_buf_reset(active_buf);
+
 	ret = SEGGER_RTT_ConfigUpBuffer(
 		CONFIG_PROFILER_NORDIC_RTT_CHANNEL_DATA,
 		"Nordic profiler data",
@@ -185,10 +310,19 @@ void profiler_term(void)
 {
 	sending_events = false;
 	protocol_running = false;
-	k_wakeup(protocol_thread_id);
+	k_sem_give(&flush_sem);
 	k_sem_take(&profiler_sem, K_FOREVER);
 }
 
+void profiler_nordic_stats_get(struct profiler_nordic_stats *out)
+{
+	int key = irq_lock();
+
+	*out = stats;
+
+	irq_unlock(key);
+}
+
 const char *profiler_get_event_descr(size_t profiler_event_id)
 {
 	return descr[profiler_event_id];
@@ -245,7 +379,8 @@ void profiler_log_start(struct log_event_buf *buf)
 	/* Adding one to pointer to make space for event type ID */
 	__ASSERT_NO_MSG(sizeof(uint8_t) <= CONFIG_PROFILER_CUSTOM_EVENT_BUF_LEN);
 	buf->payload = buf->payload_start + sizeof(uint8_t);
-	profiler_log_encode_u32(buf, k_cycle_get_32());
+	/* Space for the timestamp, which is taken when the event is sent. */
+	profiler_log_encode_u32(buf, 0);
 }
 
 void profiler_log_encode_u32(struct log_event_buf *buf, uint32_t data)
@@ -262,21 +397,94 @@ void profiler_log_add_mem_address(struct log_event_buf *buf,
 	profiler_log_encode_u32(buf, (uint32_t)mem_address);
 }
 
+static size_t timestamp_delta_encode(uint32_t delta, uint8_t *out)
+{
+	size_t len = 0;
+
+	do {
+		out[len] = delta & 0x7F;
+		delta >>= 7;
+		if (delta) {
+			out[len] |= 0x80;
+		}
+		len++;
+	} while (delta);
+
+	return len;
+}
+
 void profiler_log_send(struct log_event_buf *buf, uint16_t event_type_id)
 {
 	__ASSERT_NO_MSG(event_type_id <= UCHAR_MAX);
-	if (sending_events) {
-		uint8_t type_id = event_type_id & UCHAR_MAX;
+	if (!sending_events) {
+		return;
+	}
 
-		buf->payload_start[0] = type_id;
-		int key = irq_lock();
+	/* Event data is placed after event type ID and timestamp. */
+	const uint8_t *data = buf->payload_start + sizeof(uint8_t) +
+			      sizeof(uint32_t);
+	size_t data_len = buf->payload - data;
+	uint32_t timestamp;
+	uint8_t delta[TIMESTAMP_DELTA_MAX_LEN];
+	size_t delta_len;
+	bool flush_needed = false;
 
-		uint8_t num_bytes_send = SEGGER_RTT_WriteNoLock(
-				CONFIG_PROFILER_NORDIC_RTT_CHANNEL_DATA,
-				buf->payload_start,
-				buf->payload - buf->payload_start);
-		ARG_UNUSED(num_bytes_send);
-		irq_unlock(key);
-		__ASSERT_NO_MSG(num_bytes_send > 0);
+	int key = irq_lock();
+
+	struct staging_buf *sb = active_buf;
+
+	/* The timestamp is taken when the event is committed, so that the
+	 * events of all contexts are in order and the deltas do not wrap.
+	 */
+	timestamp = k_cycle_get_32();
+
+	if (sb->event_cnt == 0) {
+		sys_put_le32(timestamp, &sb->data[FRAME_TIMESTAMP_POS]);
+		sb->last_timestamp = timestamp;
+	}
+
+	delta_len = timestamp_delta_encode(timestamp - sb->last_timestamp,
+					   delta);
+
+	if (sb->len + sizeof(uint8_t) + delta_len + data_len >
+	    sizeof(sb->data)) {
+		if (pending_buf) {
+			/* Both buffers are in use, the event is lost. */
+			stats.dropped_events++;
+			irq_unlock(key);
+			return;
+		}
+
+		staging_buf_swap();
+		flush_needed = true;
+
+		sb = active_buf;
+		sys_put_le32(timestamp, &sb->data[FRAME_TIMESTAMP_POS]);
+		sb->last_timestamp = timestamp;
+		delta_len = timestamp_delta_encode(0, delta);
+
+		if (sb->len + sizeof(uint8_t) + delta_len + data_len >
+		    sizeof(sb->data)) {
+			/* The event does not fit in an empty buffer. */
+			stats.dropped_events++;
+			irq_unlock(key);
+			k_sem_give(&flush_sem);
+			return;
+		}
+	}
+
+	sb->data[sb->len] = event_type_id & UCHAR_MAX;
+	sb->len += sizeof(uint8_t);
+	memcpy(&sb->data[sb->len], delta, delta_len);
+	sb->len += delta_len;
+	memcpy(&sb->data[sb->len], data, data_len);
+	sb->len += data_len;
+	sb->last_timestamp = timestamp;
+	sb->event_cnt++;
+
+	irq_unlock(key);
+
+	if (flush_needed) {
+		k_sem_give(&flush_sem);
 	}
 }
@@ -0,0 +1,17 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef MOCK_NRF_MODEM_H_
+#define MOCK_NRF_MODEM_H_
+
+/* Types of the Modem library used by the AT command driver */
+
+enum nrf_modem_mode_t {
+	NORMAL_MODE,
+	FULL_DFU_MODE,
+};
+
+#endif /* MOCK_NRF_MODEM_H_ */
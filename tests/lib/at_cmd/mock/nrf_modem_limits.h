@@ -0,0 +1,12 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef MOCK_NRF_MODEM_LIMITS_H_
+#define MOCK_NRF_MODEM_LIMITS_H_
+
+/* The AT command driver does not depend on the limits of the modem */
+
+#endif /* MOCK_NRF_MODEM_LIMITS_H_ */
@@ -0,0 +1,258 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <kernel.h>
+#include <net/socket.h>
+
+#include <modem/at_cmd.h>
+#include <modem/nrf_modem_lib.h>
+
+#define RESPONSE_TIMEOUT K_SECONDS(1)
+
+struct response {
+	char buf[CONFIG_AT_CMD_RESPONSE_MAX_LEN];
+	size_t len;
+};
+
+struct test_req {
+	struct at_cmd_req req;
+	char resp[32];
+	k_tid_t thread;
+	size_t order;
+};
+
+/* Responses of the modem, received by the AT thread */
+K_MSGQ_DEFINE(responses, sizeof(struct response), 8, 4);
+
+static K_SEM_DEFINE(done_sem, 0, 8);
+
+static struct {
+	/* errno of the next write of a command, or zero */
+	int send_err;
+} mock;
+
+static size_t complete_cnt;
+static int nested_err;
+
+int mock_at_socket(int family, int type, int proto)
+{
+	zassert_equal(family, AF_LTE, "Wrong socket family");
+	zassert_equal(proto, NPROTO_AT, "Wrong socket protocol");
+
+	return 1;
+}
+
+/* The modem echoes each command in its response */
+ssize_t mock_at_send(int sock, const void *buf, size_t len, int flags)
+{
+	struct response rsp;
+	int err;
+
+	if (mock.send_err) {
+		errno = mock.send_err;
+		mock.send_err = 0;
+		return -1;
+	}
+
+	rsp.len = snprintf(rsp.buf, sizeof(rsp.buf), "%.*s\r\nOK\r\n",
+			   (int)len, (const char *)buf) + 1;
+
+	err = k_msgq_put(&responses, &rsp, K_NO_WAIT);
+	zassert_equal(err, 0, "Too many responses");
+
+	return len;
+}
+
+ssize_t mock_at_recv(int sock, void *buf, size_t max_len, int flags)
+{
+	struct response rsp;
+
+	k_msgq_get(&responses, &rsp, K_FOREVER);
+	zassert_true(rsp.len <= max_len, "Response too long");
+	memcpy(buf, rsp.buf, rsp.len);
+
+	return rsp.len;
+}
+
+int mock_at_close(int sock)
+{
+	return 0;
+}
+
+void nrf_modem_lib_shutdown_wait(void)
+{
+}
+
+static void req_complete(struct at_cmd_req *req, const char *response)
+{
+	struct test_req *treq = CONTAINER_OF(req, struct test_req, req);
+
+	treq->thread = k_current_get();
+	treq->order = complete_cnt++;
+	k_sem_give(&done_sem);
+}
+
+/* Writes a command from the handler, as the submitting thread may do */
+static void failed_req_complete(struct at_cmd_req *req, const char *response)
+{
+	char buf[32];
+	enum at_cmd_state state;
+
+	req_complete(req, response);
+
+	nested_err = at_cmd_write("AT+NESTED", buf, sizeof(buf), &state);
+	if (nested_err == 0 && strcmp(buf, "AT+NESTED\r\n") != 0) {
+		nested_err = -EBADMSG;
+	}
+}
+
+static void test_req_init(struct test_req *treq, const char *cmd,
+			  at_cmd_req_handler_t callback)
+{
+	memset(treq, 0, sizeof(*treq));
+	treq->req.cmd = cmd;
+	treq->req.resp = treq->resp;
+	treq->req.resp_size = sizeof(treq->resp);
+	treq->req.callback = callback;
+}
+
+static void test_setup(void)
+{
+	memset(&mock, 0, sizeof(mock));
+	k_sem_reset(&done_sem);
+	complete_cnt = 0;
+	nested_err = -EINPROGRESS;
+}
+
+static void test_async(void)
+{
+	static const char *const cmds[] = {"AT+CFUN?", "AT+CGSN", "AT%XICCID"};
+	static struct test_req reqs[ARRAY_SIZE(cmds)];
+	char expected[32];
+	int err;
+
+	for (size_t i = 0; i < ARRAY_SIZE(reqs); i++) {
+		test_req_init(&reqs[i], cmds[i], req_complete);
+
+		err = at_cmd_write_async(&reqs[i].req);
+		zassert_equal(err, 0, "Failed to queue command");
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(reqs); i++) {
+		err = k_sem_take(&done_sem, RESPONSE_TIMEOUT);
+		zassert_equal(err, 0, "Command not completed");
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(reqs); i++) {
+		snprintf(expected, sizeof(expected), "%s\r\n", cmds[i]);
+
+		zassert_equal(reqs[i].req.code, 0, "Wrong result code");
+		zassert_equal(reqs[i].req.state, AT_CMD_OK, "Wrong state");
+		zassert_equal(reqs[i].order, i, "Completed out of order");
+		zassert_equal(strcmp(reqs[i].resp, expected), 0,
+			      "Wrong response");
+		zassert_not_equal(reqs[i].thread, k_current_get(),
+				  "Not completed from the AT thread");
+	}
+}
+
+static void test_async_write_failure(void)
+{
+	static struct test_req failed;
+	int err;
+
+	mock.send_err = EIO;
+	test_req_init(&failed, "AT+CFUN=1", failed_req_complete);
+
+	/* The write fails in the submitting thread, which completes the
+	 * request without any lock held.
+	 */
+	err = at_cmd_write_async(&failed.req);
+	zassert_equal(err, 0, "Failed to queue command");
+
+	err = k_sem_take(&done_sem, RESPONSE_TIMEOUT);
+	zassert_equal(err, 0, "Command not completed");
+
+	zassert_equal(failed.req.code, -EIO, "Wrong result code");
+	zassert_equal(failed.req.state, AT_CMD_ERROR_WRITE, "Wrong state");
+	zassert_equal(failed.thread, k_current_get(),
+		      "Not completed from the submitting thread");
+	zassert_equal(nested_err, 0, "Command from the handler failed");
+}
+
+static void test_async_signal(void)
+{
+	static struct test_req treq;
+	struct k_poll_signal signal;
+	struct k_poll_event event = K_POLL_EVENT_INITIALIZER(
+		K_POLL_TYPE_SIGNAL, K_POLL_MODE_NOTIFY_ONLY, &signal);
+	unsigned int signaled;
+	int result;
+	int err;
+
+	for (size_t i = 0; i < 2; i++) {
+		/* The second write fails */
+		mock.send_err = (i == 1) ? EIO : 0;
+
+		k_poll_signal_init(&signal);
+		event.state = K_POLL_STATE_NOT_READY;
+		test_req_init(&treq, "AT+CEREG?", NULL);
+		treq.req.signal = &signal;
+
+		err = at_cmd_write_async(&treq.req);
+		zassert_equal(err, 0, "Failed to queue command");
+
+		err = k_poll(&event, 1, RESPONSE_TIMEOUT);
+		zassert_equal(err, 0, "Command not completed");
+
+		k_poll_signal_check(&signal, &signaled, &result);
+		zassert_true(signaled, "Signal not raised");
+		zassert_equal(result, (i == 1) ? -EIO : 0, "Wrong result");
+		zassert_equal(treq.req.code, result, "Wrong result code");
+	}
+}
+
+static void test_async_invalid(void)
+{
+	static struct test_req treq;
+	int err;
+
+	err = at_cmd_write_async(NULL);
+	zassert_equal(err, -EINVAL, "NULL request queued");
+
+	test_req_init(&treq, " \r\n", req_complete);
+	err = at_cmd_write_async(&treq.req);
+	zassert_equal(err, -EINVAL, "Blank command queued");
+}
+
+void test_main(void)
+{
+	int err;
+
+	err = at_cmd_init();
+	zassert_equal(err, 0, "Failed to initialize");
+
+	ztest_test_suite(at_cmd_test,
+		ztest_unit_test_setup_teardown(test_async,
+					       test_setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_async_write_failure,
+					       test_setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_async_signal,
+					       test_setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_async_invalid,
+					       test_setup,
+					       unit_test_noop)
+	);
+
+	ztest_run_test_suite(at_cmd_test);
+}
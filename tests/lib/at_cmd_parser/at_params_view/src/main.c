@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <stdio.h>
+#include <string.h>
+#include <kernel.h>
+
+#include <modem/at_cmd_parser.h>
+#include <modem/at_params.h>
+
+#define TEST_PARAMS 32
+#define BENCHMARK_ROUNDS 100
+
+static const char * const responses[] = {
+	"+CEREG: 5,\"0140\",\"0012BEEF\",9,,,\"11100000\",\"11100000\"\r\n",
+	"%NCELLMEAS: 0,\"0199F10A\",\"24201\",\"0C3A\",64,6400,"
+	"50,28,10,2476,0,6400,465,28,17,2476,1,6400,180,28,19,2476\r\n",
+	"+CMT: \"12345678\", 24\r\n"
+	"06917429000171040A91747966543100009160402143708006C8329BFD0601\r\n",
+	"+CNMI: (0,3),(0,1,2,3),(0,2),(0,1),(0,1)\r\n",
+	"+CPSMS: 1,,,\"10101111\",\"01101100\"\r\n",
+};
+
+static struct at_param_list copy_list;
+static struct at_param_list view_list;
+static struct at_param view_params[TEST_PARAMS];
+
+/* Heap use, counted by wrapping the kernel allocator */
+static struct {
+	uint32_t allocs;
+	uint32_t bytes;
+} heap;
+
+void *__real_k_malloc(size_t size);
+void *__real_k_calloc(size_t nmemb, size_t size);
+void __real_k_free(void *ptr);
+
+void *__wrap_k_malloc(size_t size)
+{
+	heap.allocs++;
+	heap.bytes += size;
+
+	return __real_k_malloc(size);
+}
+
+void *__wrap_k_calloc(size_t nmemb, size_t size)
+{
+	heap.allocs++;
+	heap.bytes += nmemb * size;
+
+	return __real_k_calloc(nmemb, size);
+}
+
+void __wrap_k_free(void *ptr)
+{
+	__real_k_free(ptr);
+}
+
+static void lists_compare(const struct at_param_list *expected,
+			  const struct at_param_list *actual)
+{
+	int ret;
+	size_t len;
+	size_t expected_len;
+	int64_t value;
+	int64_t expected_value;
+	const char *str;
+	char expected_str[128];
+	uint32_t array[32];
+	uint32_t expected_array[32];
+
+	zassert_equal(at_params_valid_count_get(expected),
+		      at_params_valid_count_get(actual),
+		      "Parameter count mismatch");
+
+	for (size_t i = 0; i < at_params_valid_count_get(expected); i++) {
+		zassert_equal(at_params_type_get(expected, i),
+			      at_params_type_get(actual, i),
+			      "Type mismatch at %d", i);
+
+		at_params_size_get(expected, i, &expected_len);
+		at_params_size_get(actual, i, &len);
+		zassert_equal(expected_len, len, "Size mismatch at %d", i);
+
+		switch (at_params_type_get(expected, i)) {
+		case AT_PARAM_TYPE_NUM_INT:
+			at_params_int64_get(expected, i, &expected_value);
+			ret = at_params_int64_get(actual, i, &value);
+			zassert_equal(ret, 0, "Failed to get integer");
+			zassert_equal(expected_value, value,
+				      "Integer mismatch at %d", i);
+			break;
+		case AT_PARAM_TYPE_STRING:
+			expected_len = sizeof(expected_str);
+			at_params_string_get(expected, i, expected_str,
+					     &expected_len);
+
+			ret = at_params_string_ptr_get(actual, i, &str, &len);
+			zassert_equal(ret, 0, "Failed to get string");
+			zassert_equal(expected_len, len,
+				      "String length mismatch at %d", i);
+			zassert_equal(memcmp(expected_str, str, len), 0,
+				      "String mismatch at %d", i);
+			break;
+		case AT_PARAM_TYPE_ARRAY:
+			expected_len = sizeof(expected_array);
+			at_params_array_get(expected, i, expected_array,
+					    &expected_len);
+
+			len = sizeof(array);
+			ret = at_params_array_get(actual, i, array, &len);
+			zassert_equal(ret, 0, "Failed to get array");
+			zassert_equal(expected_len, len,
+				      "Array length mismatch at %d", i);
+			zassert_equal(memcmp(expected_array, array, len), 0,
+				      "Array mismatch at %d", i);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+static void test_view_init(void)
+{
+	struct at_param_list list;
+
+	zassert_equal(-EINVAL, at_params_list_view_init(NULL, view_params,
+							TEST_PARAMS),
+		      "Init function initializes with NULL list");
+	zassert_equal(-EINVAL, at_params_list_view_init(&list, NULL,
+							TEST_PARAMS),
+		      "Init function initializes with NULL parameters");
+	zassert_equal(0, at_params_list_view_init(&list, view_params,
+						  TEST_PARAMS),
+		      "Not able to initialize params list");
+
+	zassert_equal(TEST_PARAMS, list.param_count,
+		      "Params count should be the same as TEST_PARAMS");
+	zassert_equal_ptr(view_params, list.params,
+			  "Params are not the provided array");
+
+	zassert_equal(-ENOTSUP, at_params_array_put(&list, 0,
+						    (uint32_t[]){ 1 }, 4),
+		      "Arrays cannot be copied in a view");
+
+	at_params_list_free(&list);
+
+	zassert_equal(0, list.param_count,
+		      "Params list count is not 0 after free");
+}
+
+static void test_view_same_as_copy(void)
+{
+	int ret;
+
+	at_params_list_init(&copy_list, TEST_PARAMS);
+	at_params_list_view_init(&view_list, view_params, TEST_PARAMS);
+
+	for (size_t i = 0; i < ARRAY_SIZE(responses); i++) {
+		ret = at_parser_params_from_str(responses[i], NULL,
+						&copy_list);
+		zassert_equal(ret, 0, "Failed to parse response %d", i);
+
+		ret = at_parser_params_from_str(responses[i], NULL,
+						&view_list);
+		zassert_equal(ret, 0, "Failed to parse response %d", i);
+
+		lists_compare(&copy_list, &view_list);
+	}
+
+	at_params_list_free(&copy_list);
+}
+
+static void test_view_string_refers_to_response(void)
+{
+	int ret;
+	size_t len;
+	const char *str;
+	const char *response = responses[0];
+
+	at_params_list_view_init(&view_list, view_params, TEST_PARAMS);
+
+	ret = at_parser_params_from_str(response, NULL, &view_list);
+	zassert_equal(ret, 0, "Failed to parse response");
+
+	ret = at_params_string_ptr_get(&view_list, 2, &str, &len);
+	zassert_equal(ret, 0, "Failed to get string");
+	zassert_equal_ptr(str, strstr(response, "0140"),
+			  "String does not refer to the response");
+	zassert_equal(len, strlen("0140"), "Wrong string length");
+
+	ret = at_params_string_ptr_get(&view_list, 1, &str, &len);
+	zassert_equal(ret, -EINVAL, "Integer returned as a string");
+}
+
+static void test_view_no_heap(void)
+{
+	int ret;
+
+	at_params_list_view_init(&view_list, view_params, TEST_PARAMS);
+
+	memset(&heap, 0, sizeof(heap));
+
+	for (size_t i = 0; i < ARRAY_SIZE(responses); i++) {
+		ret = at_parser_params_from_str(responses[i], NULL,
+						&view_list);
+		zassert_equal(ret, 0, "Failed to parse response %d", i);
+	}
+
+	at_params_list_free(&view_list);
+
+	zassert_equal(heap.allocs, 0, "Heap used by a view");
+}
+
+static void benchmark(struct at_param_list *list, uint32_t *cycles)
+{
+	int ret;
+	uint32_t start;
+
+	memset(&heap, 0, sizeof(heap));
+	start = k_cycle_get_32();
+
+	for (size_t round = 0; round < BENCHMARK_ROUNDS; round++) {
+		for (size_t i = 0; i < ARRAY_SIZE(responses); i++) {
+			ret = at_parser_params_from_str(responses[i], NULL,
+							list);
+			zassert_equal(ret, 0, "Failed to parse response %d",
+				      i);
+		}
+	}
+
+	*cycles = (k_cycle_get_32() - start) / BENCHMARK_ROUNDS;
+}
+
+static void test_benchmark(void)
+{
+	uint32_t copy_cycles;
+	uint32_t view_cycles;
+	uint32_t copy_allocs;
+	uint32_t copy_bytes;
+
+	at_params_list_init(&copy_list, TEST_PARAMS);
+	benchmark(&copy_list, &copy_cycles);
+	copy_allocs = heap.allocs;
+	copy_bytes = heap.bytes;
+	at_params_list_free(&copy_list);
+
+	at_params_list_view_init(&view_list, view_params, TEST_PARAMS);
+	benchmark(&view_list, &view_cycles);
+
+	printk("Parsing %d responses, per round:\n", ARRAY_SIZE(responses));
+	printk("  copy: %u cycles, %u allocations, %u bytes\n",
+	       copy_cycles, copy_allocs / BENCHMARK_ROUNDS,
+	       copy_bytes / BENCHMARK_ROUNDS);
+	printk("  view: %u cycles, %u allocations, %u bytes\n",
+	       view_cycles, heap.allocs / BENCHMARK_ROUNDS,
+	       heap.bytes / BENCHMARK_ROUNDS);
+
+	zassert_equal(heap.allocs, 0, "Heap used by a view");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(at_params_view,
+			 ztest_unit_test(test_view_init),
+			 ztest_unit_test(test_view_same_as_copy),
+			 ztest_unit_test(test_view_string_refers_to_response),
+			 ztest_unit_test(test_view_no_heap),
+			 ztest_unit_test(test_benchmark)
+			);
+
+	ztest_run_test_suite(at_params_view);
+}
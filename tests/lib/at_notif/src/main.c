@@ -0,0 +1,258 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <stdio.h>
+#include <string.h>
+#include <kernel.h>
+
+#include <modem/at_cmd.h>
+#include <modem/at_notif.h>
+
+#define HANDLERS_MAX CONFIG_AT_NOTIF_PREFIX_HANDLERS_MAX
+#define BENCHMARK_ROUNDS 1000
+
+static at_cmd_handler_t dispatch;
+
+/* Number of notifications received by each context */
+static uint32_t calls[HANDLERS_MAX + 1];
+static uint32_t catch_all_calls;
+
+/* Names of the notifications of the benchmark */
+static char names[HANDLERS_MAX][16];
+
+void at_cmd_set_notification_handler(at_cmd_handler_t handler)
+{
+	dispatch = handler;
+}
+
+static void handler(void *context, const char *response)
+{
+	calls[(uintptr_t)context]++;
+}
+
+static void catch_all_handler(void *context, const char *response)
+{
+	catch_all_calls++;
+}
+
+/* Same as the handlers receiving all notifications do */
+static void strncmp_handler(void *context, const char *response)
+{
+	const char *name = names[(uintptr_t)context];
+
+	if (strncmp(response, name, strlen(name)) == 0) {
+		calls[(uintptr_t)context]++;
+	}
+}
+
+static void calls_reset(void)
+{
+	memset(calls, 0, sizeof(calls));
+	catch_all_calls = 0;
+}
+
+static void test_init(void)
+{
+	zassert_equal(at_notif_init(), 0, "Failed to initialize");
+	zassert_not_null(dispatch, "Dispatcher not registered");
+}
+
+static void test_prefix_dispatch(void)
+{
+	int err;
+
+	calls_reset();
+
+	err = at_notif_register_prefix_handler("+CEREG", (void *)1, handler);
+	zassert_equal(err, 0, "Failed to register handler");
+	err = at_notif_register_prefix_handler("%XMODEMSLEEP", (void *)2,
+					       handler);
+	zassert_equal(err, 0, "Failed to register handler");
+	err = at_notif_register_prefix_handler("+CSCON", (void *)3, handler);
+	zassert_equal(err, 0, "Failed to register handler");
+	err = at_notif_register_handler(NULL, catch_all_handler);
+	zassert_equal(err, 0, "Failed to register handler");
+
+	dispatch("+CEREG: 5,\"0140\",\"0012BEEF\",9,,,\"11100000\"\r\n");
+	dispatch("%XMODEMSLEEP: 1,3600000\r\n");
+	dispatch("%XMODEMSLEEP: 1,0\r\n");
+	dispatch("+CMT: \"12345678\",22\r\n");
+
+	zassert_equal(calls[1], 1, "Wrong number of +CEREG notifications");
+	zassert_equal(calls[2], 2, "Wrong number of %XMODEMSLEEP notifications");
+	zassert_equal(calls[3], 0, "Wrong number of +CSCON notifications");
+	zassert_equal(catch_all_calls, 4, "Catch-all handler missed some");
+
+	at_notif_deregister_prefix_handler("+CEREG", (void *)1, handler);
+	at_notif_deregister_prefix_handler("%XMODEMSLEEP", (void *)2, handler);
+	at_notif_deregister_prefix_handler("+CSCON", (void *)3, handler);
+	at_notif_deregister_handler(NULL, catch_all_handler);
+}
+
+static void test_prefix_whole_name(void)
+{
+	calls_reset();
+
+	at_notif_register_prefix_handler("+CEDRXP", (void *)1, handler);
+	at_notif_register_prefix_handler("+CEDRX", (void *)2, handler);
+
+	dispatch("+CEDRXP: 4,\"1000\",\"0101\",\"0011\"\r\n");
+	dispatch("+CEDRXS: 4,\"1000\"\r\n");
+	dispatch("+CEDR: 1\r\n");
+	dispatch("+CEDRXP");
+
+	zassert_equal(calls[1], 2, "Notification not matched on its name");
+	zassert_equal(calls[2], 0, "Notification matched on part of its name");
+
+	at_notif_deregister_prefix_handler("+CEDRXP", (void *)1, handler);
+	at_notif_deregister_prefix_handler("+CEDRX", (void *)2, handler);
+}
+
+static void test_prefix_several_handlers(void)
+{
+	calls_reset();
+
+	at_notif_register_prefix_handler("+CEREG", (void *)1, handler);
+	at_notif_register_prefix_handler("+CEREG", (void *)2, handler);
+	/* Registered twice, called once */
+	at_notif_register_prefix_handler("+CEREG", (void *)2, handler);
+
+	dispatch("+CEREG: 1\r\n");
+
+	zassert_equal(calls[1], 1, "First handler not called");
+	zassert_equal(calls[2], 1, "Second handler not called once");
+
+	at_notif_deregister_prefix_handler("+CEREG", (void *)1, handler);
+	dispatch("+CEREG: 1\r\n");
+
+	zassert_equal(calls[1], 1, "De-registered handler called");
+	zassert_equal(calls[2], 2, "Remaining handler not called");
+
+	at_notif_deregister_prefix_handler("+CEREG", (void *)2, handler);
+	dispatch("+CEREG: 1\r\n");
+
+	zassert_equal(calls[2], 2, "De-registered handler called");
+}
+
+static void test_prefix_invalid(void)
+{
+	int err;
+
+	err = at_notif_register_prefix_handler(NULL, NULL, handler);
+	zassert_equal(err, -EINVAL, "NULL prefix accepted");
+	err = at_notif_register_prefix_handler("", NULL, handler);
+	zassert_equal(err, -EINVAL, "Empty prefix accepted");
+	err = at_notif_register_prefix_handler("+CEREG: 5", NULL, handler);
+	zassert_equal(err, -EINVAL, "Prefix with a colon accepted");
+	err = at_notif_register_prefix_handler("+CEREG", NULL, NULL);
+	zassert_equal(err, -EINVAL, "NULL handler accepted");
+}
+
+static void test_prefix_table_full(void)
+{
+	int err;
+
+	for (size_t i = 0; i < HANDLERS_MAX; i++) {
+		err = at_notif_register_prefix_handler("+CEREG", (void *)i,
+						       handler);
+		zassert_equal(err, 0, "Failed to register handler %d", i);
+	}
+
+	err = at_notif_register_prefix_handler("+CSCON", NULL, handler);
+	zassert_equal(err, -ENOBUFS, "Handler registered in a full table");
+
+	for (size_t i = 0; i < HANDLERS_MAX; i++) {
+		at_notif_deregister_prefix_handler("+CEREG", (void *)i,
+						   handler);
+	}
+}
+
+/* Time to dispatch a notification to one of `count` handlers, each
+ * registered for a different notification.
+ */
+static uint32_t dispatch_cycles(size_t count, bool prefix)
+{
+	uint32_t start;
+	uint32_t cycles;
+	char notif[32];
+
+	calls_reset();
+
+	for (size_t i = 0; i < count; i++) {
+		if (prefix) {
+			at_notif_register_prefix_handler(names[i], (void *)i,
+							 handler);
+		} else {
+			at_notif_register_handler((void *)i, strncmp_handler);
+		}
+	}
+
+	/* The last registered notification */
+	snprintf(notif, sizeof(notif), "%s: 1,2,3\r\n", names[count - 1]);
+
+	start = k_cycle_get_32();
+	for (size_t i = 0; i < BENCHMARK_ROUNDS; i++) {
+		dispatch(notif);
+	}
+	cycles = (k_cycle_get_32() - start) / BENCHMARK_ROUNDS;
+
+	zassert_equal(calls[count - 1], BENCHMARK_ROUNDS,
+		      "Notification not dispatched");
+	for (size_t i = 0; i < count - 1; i++) {
+		zassert_equal(calls[i], 0, "Notification sent to handler %d",
+			      i);
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		if (prefix) {
+			at_notif_deregister_prefix_handler(names[i], (void *)i,
+							   handler);
+		} else {
+			at_notif_deregister_handler((void *)i,
+						    strncmp_handler);
+		}
+	}
+
+	return cycles;
+}
+
+static void test_dispatch_cost(void)
+{
+	uint32_t prefix_one;
+	uint32_t prefix_all;
+	uint32_t strncmp_one;
+	uint32_t strncmp_all;
+
+	for (size_t i = 0; i < HANDLERS_MAX; i++) {
+		snprintf(names[i], sizeof(names[i]), "%%XNOTIF%02d", (int)i);
+	}
+
+	prefix_one = dispatch_cycles(1, true);
+	prefix_all = dispatch_cycles(HANDLERS_MAX, true);
+	strncmp_one = dispatch_cycles(1, false);
+	strncmp_all = dispatch_cycles(HANDLERS_MAX, false);
+
+	printk("Cycles to dispatch a notification, with 1 and %d handlers:\n",
+	       HANDLERS_MAX);
+	printk("  prefix table: %u, %u\n", prefix_one, prefix_all);
+	printk("  all handlers: %u, %u\n", strncmp_one, strncmp_all);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(at_notif,
+			 ztest_unit_test(test_init),
+			 ztest_unit_test(test_prefix_dispatch),
+			 ztest_unit_test(test_prefix_whole_name),
+			 ztest_unit_test(test_prefix_several_handlers),
+			 ztest_unit_test(test_prefix_invalid),
+			 ztest_unit_test(test_prefix_table_full),
+			 ztest_unit_test(test_dispatch_cost)
+			);
+
+	ztest_run_test_suite(at_notif);
+}
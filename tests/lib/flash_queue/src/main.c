@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <zephyr.h>
+#include <stdio.h>
+#include <string.h>
+#include <flash_queue.h>
+
+#define TYPE_GENERIC	1
+#define TYPE_BATCH	2
+
+#define ENTRY_LEN	200
+
+static struct flash_queue queue;
+
+static uint8_t data[ENTRY_LEN];
+static uint8_t buf[ENTRY_LEN];
+
+/* Fills the data of an entry with a pattern given by its number. */
+static void data_fill(uint32_t n)
+{
+	for (size_t i = 0; i < sizeof(data); i++) {
+		data[i] = n + i;
+	}
+}
+
+static void entry_push(uint32_t n)
+{
+	int ret;
+
+	data_fill(n);
+
+	ret = flash_queue_push(&queue, TYPE_BATCH, data, sizeof(data));
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+}
+
+/* Reads the next entry and checks that it was pushed by entry_push(n). */
+static void entry_check(uint32_t n)
+{
+	int ret;
+	struct flash_queue_entry entry;
+
+	ret = flash_queue_read(&queue, &entry, buf, sizeof(buf));
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+	zassert_equal(entry.type, TYPE_BATCH, "Wrong type");
+	zassert_equal(entry.len, sizeof(data), "Wrong length");
+
+	data_fill(n);
+	zassert_mem_equal(buf, data, sizeof(data), "Wrong data");
+}
+
+/* Number of entries that would fit in the flash area without overhead. */
+static size_t capacity_get(void)
+{
+	return (queue.fcb.f_sector_cnt * queue.sectors[0].fs_size) / ENTRY_LEN;
+}
+
+static void test_push_read_ack(void)
+{
+	int ret;
+	struct flash_queue_entry entry;
+	const char first[] = "{\"appV\":\"v1.0.0\"}";
+	const char second[] = "odd";
+
+	ret = flash_queue_push(&queue, TYPE_GENERIC, first, strlen(first));
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+
+	ret = flash_queue_push(&queue, TYPE_BATCH, second, strlen(second));
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+
+	zassert_equal(flash_queue_count(&queue), 2, "Wrong number of entries");
+
+	ret = flash_queue_peek(&queue, &entry);
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+	zassert_equal(entry.type, TYPE_GENERIC, "Wrong type");
+	zassert_equal(entry.len, strlen(first), "Wrong length");
+
+	ret = flash_queue_read(&queue, &entry, buf, sizeof(buf));
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+	zassert_equal(entry.type, TYPE_GENERIC, "Wrong type");
+	zassert_equal(entry.len, strlen(first), "Wrong length");
+	zassert_mem_equal(buf, first, strlen(first), "Wrong data");
+
+	ret = flash_queue_read(&queue, &entry, buf, sizeof(buf));
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+	zassert_equal(entry.type, TYPE_BATCH, "Wrong type");
+	zassert_equal(entry.len, strlen(second), "Wrong length");
+	zassert_mem_equal(buf, second, strlen(second), "Wrong data");
+
+	ret = flash_queue_read(&queue, &entry, buf, sizeof(buf));
+	zassert_equal(-ENODATA, ret, "Return value %d is wrong", ret);
+
+	/* Read entries are queued until they are acknowledged. */
+	zassert_equal(flash_queue_count(&queue), 2, "Wrong number of entries");
+
+	ret = flash_queue_ack(&queue, entry.seq);
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+	zassert_equal(flash_queue_count(&queue), 0, "Wrong number of entries");
+}
+
+static void test_reboot(void)
+{
+	int ret;
+	struct flash_queue_entry entry;
+
+	for (uint32_t n = 0; n < 5; n++) {
+		entry_push(n);
+	}
+
+	entry_check(0);
+	entry_check(1);
+
+	ret = flash_queue_peek(&queue, &entry);
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+
+	/* Only the first entry is acknowledged. */
+	ret = flash_queue_ack(&queue, entry.seq - 2);
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+
+	ret = flash_queue_init(&queue, FLASH_QUEUE_AREA_ID);
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+	zassert_equal(flash_queue_count(&queue), 4, "Wrong number of entries");
+
+	/* The entry that was read but not acknowledged is read again. */
+	for (uint32_t n = 1; n < 5; n++) {
+		entry_check(n);
+	}
+
+	/* Sequence numbers go on from the entries stored before the reboot. */
+	entry_push(5);
+
+	ret = flash_queue_peek(&queue, &entry);
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+	zassert_equal(entry.seq, 6, "Wrong sequence number %d", entry.seq);
+
+	ret = flash_queue_ack(&queue, 4);
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+
+	ret = flash_queue_init(&queue, FLASH_QUEUE_AREA_ID);
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+	zassert_equal(flash_queue_count(&queue), 2, "Wrong number of entries");
+
+	entry_check(4);
+	entry_check(5);
+}
+
+static void test_power_failure(void)
+{
+	int ret;
+	struct fcb_entry loc;
+
+	entry_push(0);
+
+	/* Entry appended without its CRC, as if the power failed while it was
+	 * being written.
+	 */
+	ret = fcb_append(&queue.fcb, ENTRY_LEN, &loc);
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+
+	ret = flash_queue_init(&queue, FLASH_QUEUE_AREA_ID);
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+	zassert_equal(flash_queue_count(&queue), 1, "Wrong number of entries");
+
+	entry_push(1);
+
+	entry_check(0);
+	entry_check(1);
+	zassert_equal(flash_queue_count(&queue), 2, "Wrong number of entries");
+}
+
+static void test_invalid(void)
+{
+	int ret;
+	struct flash_queue_entry entry;
+	static uint8_t large[4096];
+
+	ret = flash_queue_push(&queue, TYPE_BATCH, large, sizeof(large));
+	zassert_equal(-EFBIG, ret, "Return value %d is wrong", ret);
+
+	ret = flash_queue_peek(&queue, &entry);
+	zassert_equal(-ENODATA, ret, "Return value %d is wrong", ret);
+
+	entry_push(0);
+
+	/* Not read yet. */
+	ret = flash_queue_ack(&queue, 1);
+	zassert_equal(-EINVAL, ret, "Return value %d is wrong", ret);
+
+	/* The entry stays to be read. */
+	ret = flash_queue_read(&queue, &entry, buf, ENTRY_LEN - 1);
+	zassert_equal(-ENOMEM, ret, "Return value %d is wrong", ret);
+
+	entry_check(0);
+}
+
+static void test_full(void)
+{
+	int ret;
+	uint32_t n;
+	size_t count;
+	size_t capacity = capacity_get();
+
+	/* Acknowledged entries make room without dropping anything, the
+	 * sectors are used in turn.
+	 */
+	for (n = 0; n < 3 * capacity; n++) {
+		entry_push(n);
+		entry_check(n);
+
+		ret = flash_queue_ack(&queue, n + 1);
+		zassert_equal(0, ret, "Return value %d is wrong", ret);
+	}
+
+	zassert_equal(flash_queue_dropped(&queue), 0, "Entries dropped");
+	zassert_equal(flash_queue_count(&queue), 0, "Wrong number of entries");
+
+	/* Without acknowledgments, the oldest entries are dropped. */
+	for (size_t i = 0; i < 2 * capacity; i++) {
+		entry_push(n + i);
+	}
+
+	zassert_true(flash_queue_dropped(&queue) > 0, "No entries dropped");
+	zassert_equal(flash_queue_count(&queue) + flash_queue_dropped(&queue),
+		      2 * capacity, "Wrong number of entries");
+
+	/* The entries that are left are the newest ones. */
+	for (size_t i = flash_queue_dropped(&queue); i < 2 * capacity; i++) {
+		entry_check(n + i);
+	}
+
+	count = flash_queue_count(&queue);
+
+	ret = flash_queue_init(&queue, FLASH_QUEUE_AREA_ID);
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+	zassert_equal(flash_queue_count(&queue), count, "Wrong number of entries");
+	zassert_equal(flash_queue_dropped(&queue), 0, "Wrong number of dropped entries");
+}
+
+static void test_setup(void)
+{
+	int ret;
+
+	ret = flash_queue_init(&queue, FLASH_QUEUE_AREA_ID);
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+
+	ret = flash_queue_clear(&queue);
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+
+	ret = flash_queue_init(&queue, FLASH_QUEUE_AREA_ID);
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(flash_queue_test,
+		ztest_unit_test_setup_teardown(test_push_read_ack,
+					       test_setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_reboot,
+					       test_setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_power_failure,
+					       test_setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_invalid,
+					       test_setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_full,
+					       test_setup,
+					       unit_test_noop)
+	);
+
+	ztest_run_test_suite(flash_queue_test);
+}
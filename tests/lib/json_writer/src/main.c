@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <zephyr.h>
+#include <string.h>
+#include <math.h>
+#include <json_writer.h>
+
+static struct json_writer writer;
+static char buf[256];
+
+/* Output of the flush handler. */
+static char chunked[256];
+static size_t chunked_len;
+static size_t flush_count;
+static int flush_err;
+
+static int flush_handler(const char *data, size_t len, void *user_data)
+{
+	if (user_data != &chunked) {
+		return -EFAULT;
+	}
+
+	if (flush_err) {
+		return flush_err;
+	}
+
+	memcpy(&chunked[chunked_len], data, len);
+	chunked_len += len;
+	flush_count++;
+
+	return 0;
+}
+
+/* Writes a document with all types of values. */
+static void document_write(struct json_writer *w)
+{
+	json_writer_object_start(w, NULL);
+	json_writer_string(w, "str", "value");
+	json_writer_number(w, "int", 42);
+	json_writer_number(w, "neg", -1.5);
+	json_writer_bool(w, "t", true);
+	json_writer_bool(w, "f", false);
+	json_writer_null(w, "null");
+	json_writer_array_start(w, "arr");
+	json_writer_number(w, NULL, 1);
+	json_writer_object_start(w, NULL);
+	json_writer_object_end(w);
+	json_writer_array_start(w, NULL);
+	json_writer_array_end(w);
+	json_writer_string(w, NULL, "");
+	json_writer_array_end(w);
+	json_writer_object_end(w);
+}
+
+#define DOCUMENT "{\"str\":\"value\",\"int\":42,\"neg\":-1.5,\"t\":true,\"f\":false," \
+		 "\"null\":null,\"arr\":[1,{},[],\"\"]}"
+
+static void test_write_document(void)
+{
+	int ret;
+
+	json_writer_init(&writer, buf, sizeof(buf), NULL, NULL);
+	document_write(&writer);
+
+	ret = json_writer_finish(&writer);
+	zassert_equal(strlen(DOCUMENT), ret, "Return value %d is wrong", ret);
+	zassert_equal(0, strcmp(DOCUMENT, buf), "Output is wrong: %s", buf);
+}
+
+static void test_write_chunked(void)
+{
+	int ret;
+	char small[7];
+
+	chunked_len = 0;
+	flush_count = 0;
+	flush_err = 0;
+
+	json_writer_init(&writer, small, sizeof(small), flush_handler, &chunked);
+	document_write(&writer);
+
+	ret = json_writer_finish(&writer);
+	zassert_equal(strlen(DOCUMENT), ret, "Return value %d is wrong", ret);
+	zassert_equal(strlen(DOCUMENT), chunked_len, "Output length is wrong");
+	zassert_equal(0, memcmp(DOCUMENT, chunked, chunked_len), "Output is wrong");
+	zassert_equal(DIV_ROUND_UP(strlen(DOCUMENT), sizeof(small)), flush_count,
+		      "Flush count is wrong");
+
+	/* Errors of the flush handler are returned. */
+	flush_err = -EIO;
+
+	json_writer_init(&writer, small, sizeof(small), flush_handler, &chunked);
+	document_write(&writer);
+
+	ret = json_writer_finish(&writer);
+	zassert_equal(-EIO, ret, "Return value %d is wrong", ret);
+}
+
+static void test_measure(void)
+{
+	int ret;
+
+	json_writer_init(&writer, NULL, 0, NULL, NULL);
+	zassert_true(json_writer_is_measuring(&writer), "Writer is not measuring");
+
+	document_write(&writer);
+
+	ret = json_writer_finish(&writer);
+	zassert_equal(strlen(DOCUMENT), ret, "Return value %d is wrong", ret);
+}
+
+static void test_buffer_too_small(void)
+{
+	int ret;
+
+	/* The output fits exactly with the NUL terminator. */
+	json_writer_init(&writer, buf, sizeof(DOCUMENT), NULL, NULL);
+	document_write(&writer);
+
+	ret = json_writer_finish(&writer);
+	zassert_equal(strlen(DOCUMENT), ret, "Return value %d is wrong", ret);
+
+	json_writer_init(&writer, buf, sizeof(DOCUMENT) - 1, NULL, NULL);
+	document_write(&writer);
+
+	ret = json_writer_error(&writer);
+	zassert_equal(-ENOMEM, ret, "Return value %d is wrong", ret);
+
+	ret = json_writer_finish(&writer);
+	zassert_equal(-ENOMEM, ret, "Return value %d is wrong", ret);
+}
+
+static void test_numbers(void)
+{
+	int ret;
+
+	json_writer_init(&writer, buf, sizeof(buf), NULL, NULL);
+	json_writer_array_start(&writer, NULL);
+	json_writer_number(&writer, NULL, 0);
+	json_writer_number(&writer, NULL, 0.1);
+	json_writer_number(&writer, NULL, 1.0 / 3);
+	json_writer_number(&writer, NULL, 1563968747123);
+	json_writer_number(&writer, NULL, 1e300);
+	json_writer_number(&writer, NULL, (float)0.1);
+	json_writer_number(&writer, NULL, NAN);
+	json_writer_number(&writer, NULL, INFINITY);
+	json_writer_array_end(&writer);
+
+	ret = json_writer_finish(&writer);
+	zassert_true(ret > 0, "Return value %d is wrong", ret);
+	zassert_equal(0, strcmp("[0,0.1,0.33333333333333331,1563968747123,1e+300,"
+				"0.10000000149011612,null,null]", buf),
+		      "Output is wrong: %s", buf);
+}
+
+static void test_string_escaping(void)
+{
+	int ret;
+
+	json_writer_init(&writer, buf, sizeof(buf), NULL, NULL);
+	json_writer_object_start(&writer, NULL);
+	json_writer_string(&writer, "k\"", "\"\\/\b\f\n\r\t\x01\x1f \xc3\xa6");
+	json_writer_object_end(&writer);
+
+	ret = json_writer_finish(&writer);
+	zassert_true(ret > 0, "Return value %d is wrong", ret);
+	zassert_equal(0, strcmp("{\"k\\\"\":\"\\\"\\\\/\\b\\f\\n\\r\\t\\u0001\\u001f \xc3\xa6\"}",
+				buf),
+		      "Output is wrong: %s", buf);
+}
+
+static void test_invalid_use(void)
+{
+	int ret;
+
+	/* Key inside an array. */
+	json_writer_init(&writer, buf, sizeof(buf), NULL, NULL);
+	json_writer_array_start(&writer, NULL);
+	ret = json_writer_number(&writer, "key", 1);
+	zassert_equal(-EINVAL, ret, "Return value %d is wrong", ret);
+
+	/* Errors are sticky. */
+	ret = json_writer_array_end(&writer);
+	zassert_equal(-EINVAL, ret, "Return value %d is wrong", ret);
+
+	/* Missing key inside an object. */
+	json_writer_init(&writer, buf, sizeof(buf), NULL, NULL);
+	json_writer_object_start(&writer, NULL);
+	ret = json_writer_number(&writer, NULL, 1);
+	zassert_equal(-EINVAL, ret, "Return value %d is wrong", ret);
+
+	/* Key for the top-level value. */
+	json_writer_init(&writer, buf, sizeof(buf), NULL, NULL);
+	ret = json_writer_object_start(&writer, "key");
+	zassert_equal(-EINVAL, ret, "Return value %d is wrong", ret);
+
+	/* Second top-level value. */
+	json_writer_init(&writer, buf, sizeof(buf), NULL, NULL);
+	json_writer_null(&writer, NULL);
+	ret = json_writer_null(&writer, NULL);
+	zassert_equal(-EINVAL, ret, "Return value %d is wrong", ret);
+
+	/* Mismatched end. */
+	json_writer_init(&writer, buf, sizeof(buf), NULL, NULL);
+	json_writer_object_start(&writer, NULL);
+	ret = json_writer_array_end(&writer);
+	zassert_equal(-EINVAL, ret, "Return value %d is wrong", ret);
+
+	/* End without start. */
+	json_writer_init(&writer, buf, sizeof(buf), NULL, NULL);
+	ret = json_writer_object_end(&writer);
+	zassert_equal(-EINVAL, ret, "Return value %d is wrong", ret);
+
+	/* Open container when finishing. */
+	json_writer_init(&writer, buf, sizeof(buf), NULL, NULL);
+	json_writer_array_start(&writer, NULL);
+	ret = json_writer_finish(&writer);
+	zassert_equal(-EINVAL, ret, "Return value %d is wrong", ret);
+}
+
+static void test_depth_max(void)
+{
+	int ret;
+
+	json_writer_init(&writer, buf, sizeof(buf), NULL, NULL);
+
+	for (int i = 0; i < CONFIG_JSON_WRITER_DEPTH_MAX; i++) {
+		ret = json_writer_array_start(&writer, NULL);
+		zassert_equal(0, ret, "Return value %d is wrong", ret);
+	}
+
+	ret = json_writer_array_start(&writer, NULL);
+	zassert_equal(-E2BIG, ret, "Return value %d is wrong", ret);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(json_writer,
+		ztest_unit_test(test_write_document),
+		ztest_unit_test(test_write_chunked),
+		ztest_unit_test(test_measure),
+		ztest_unit_test(test_buffer_too_small),
+		ztest_unit_test(test_numbers),
+		ztest_unit_test(test_string_escaping),
+		ztest_unit_test(test_invalid_use),
+		ztest_unit_test(test_depth_max)
+	);
+
+	ztest_run_test_suite(json_writer);
+}
@@ -9,8 +9,49 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <modem/at_cmd_parser.h>
+#include <modem/at_params.h>
+
 #include "lte_lc_helpers.h"
 
+#define BENCHMARK_ROUNDS 100
+
+/* NCELLMEAS notification with the largest number of neighbor cells */
+static const char ncellmeas_max[] =
+	"%NCELLMEAS: 0,\"021D140C\",\"24201\",\"0821\",65535,5300,449,50,15,10891,"
+	"5300,100,40,-5,0,5301,101,41,-4,-100,5302,102,42,-3,-200,"
+	"5303,103,43,-2,-300,5304,104,44,-1,-400,5305,105,45,0,-500,"
+	"5306,106,46,1,-600,5307,107,47,2,-700,5308,108,48,3,-800,"
+	"5309,109,49,4,-900,5310,110,50,5,-1000,5311,111,51,6,-1100,"
+	"5312,112,52,7,-1200,5313,113,53,8,-1300,5314,114,54,9,-1400,"
+	"5315,115,55,10,-1500,5316,116,56,11,-1600\r\n";
+
+/* Heap allocations, counted by wrapping the kernel allocator */
+static uint32_t heap_allocs;
+
+void *__real_k_malloc(size_t size);
+void *__real_k_calloc(size_t nmemb, size_t size);
+void __real_k_free(void *ptr);
+
+void *__wrap_k_malloc(size_t size)
+{
+	heap_allocs++;
+
+	return __real_k_malloc(size);
+}
+
+void *__wrap_k_calloc(size_t nmemb, size_t size)
+{
+	heap_allocs++;
+
+	return __real_k_calloc(nmemb, size);
+}
+
+void __wrap_k_free(void *ptr)
+{
+	__real_k_free(ptr);
+}
+
 static void test_parse_edrx(void)
 {
 	int err;
@@ -382,7 +423,7 @@ static void test_parse_ncellmeas(void)
 		.neighbor_cells = ncells,
 	};
 
-	err = parse_ncellmeas(resp1, &cells);
+	err = parse_ncellmeas(resp1, &cells, ARRAY_SIZE(ncells));
 	zassert_equal(err, 0, "parse_ncellmeas failed, error: %d", err);
 	zassert_equal(cells.current_cell.mcc, 242, "Wrong MCC");
 	zassert_equal(cells.current_cell.mnc, 1, "Wrong MNC");
@@ -404,28 +445,230 @@ static void test_parse_ncellmeas(void)
 	zassert_equal(cells.neighbor_cells[1].rsrq, 27, "Wrong RSRQ");
 	zassert_equal(cells.neighbor_cells[1].time_diff, 24, "Wrong time difference");
 
-	err = parse_ncellmeas(resp2, &cells);
+	err = parse_ncellmeas(resp2, &cells, ARRAY_SIZE(ncells));
 	zassert_equal(err, 1, "parse_ncellmeas was expected to return 1, but returned %d", err);
 
-	err = parse_ncellmeas(resp3, &cells);
+	err = parse_ncellmeas(resp3, &cells, ARRAY_SIZE(ncells));
 	zassert_equal(err, 0, "parse_ncellmeas was expected to return 0, but returned %d", err);
+	zassert_equal(cells.ncells_count, 0, "Wrong neighbor cell count");
+}
+
+static void test_parse_ncellmeas_array_full(void)
+{
+	int err;
+	struct lte_lc_ncell ncells[4];
+	struct lte_lc_cells_info cells = {
+		.neighbor_cells = ncells,
+	};
+
+	err = parse_ncellmeas(ncellmeas_max, &cells, ARRAY_SIZE(ncells));
+	zassert_equal(err, -E2BIG, "parse_ncellmeas was expected to return -E2BIG");
+	zassert_equal(cells.ncells_count, ARRAY_SIZE(ncells), "Wrong neighbor cell count");
+	zassert_equal(cells.current_cell.id, 35460108, "Wrong cell ID");
+
+	for (size_t i = 0; i < ARRAY_SIZE(ncells); i++) {
+		zassert_equal(ncells[i].earfcn, 5300 + i, "Wrong EARFCN");
+		zassert_equal(ncells[i].phys_cell_id, 100 + i, "Wrong physical cell ID");
+		zassert_equal(ncells[i].rsrp, 40 + i, "Wrong RSRP");
+		zassert_equal(ncells[i].rsrq, -5 + (int)i, "Wrong RSRQ");
+		zassert_equal(ncells[i].time_diff, -100 * (int)i, "Wrong time difference");
+	}
+}
+
+static int ncell_count(const struct lte_lc_ncell *ncell, void *context)
+{
+	size_t *count = context;
+
+	zassert_equal(ncell->earfcn, 5300 + *count, "Cells out of order");
+
+	(*count)++;
+
+	return 0;
+}
+
+static int ncell_stop(const struct lte_lc_ncell *ncell, void *context)
+{
+	size_t *count = context;
+
+	return ++(*count) == 3 ? -ECANCELED : 0;
+}
+
+static void test_parse_ncellmeas_stream(void)
+{
+	int err;
+	size_t count = 0;
+	struct lte_lc_cell cell;
+
+	err = parse_ncellmeas_stream(ncellmeas_max, &cell, ncell_count, &count);
+	zassert_equal(err, 0, "parse_ncellmeas_stream failed, error: %d", err);
+	zassert_equal(count, 17, "Wrong neighbor cell count");
+	zassert_equal(cell.mcc, 242, "Wrong MCC");
+	zassert_equal(cell.mnc, 1, "Wrong MNC");
+	zassert_equal(cell.measurement_time, 10891, "Wrong measurement time");
+
+	count = 0;
+	err = parse_ncellmeas_stream(ncellmeas_max, &cell, ncell_stop, &count);
+	zassert_equal(err, -ECANCELED, "Error of the handler not returned");
+	zassert_equal(count, 3, "Parsing did not stop");
+
+	err = parse_ncellmeas_stream("+CEREG: 1", &cell, ncell_count, &count);
+	zassert_true(err < 0, "Wrong notification parsed");
+}
+
+/* Parse truncated and corrupted responses, to check that the parser never
+ * reads or writes out of bounds.
+ */
+static void test_parse_ncellmeas_fuzz(void)
+{
+	int err;
+	char resp[sizeof(ncellmeas_max)];
+	struct lte_lc_ncell ncells[17];
+	struct lte_lc_cells_info cells = {
+		.neighbor_cells = ncells,
+	};
+	uint32_t seed = 1;
+	static const char alphabet[] = "0123456789ABF,\" -\r\n";
+
+	for (size_t len = 0; len < sizeof(ncellmeas_max); len++) {
+		memcpy(resp, ncellmeas_max, len);
+		resp[len] = '\0';
+
+		err = parse_ncellmeas(resp, &cells, ARRAY_SIZE(ncells));
+		zassert_true(err <= 1, "Unexpected return value %d", err);
+		zassert_true(cells.ncells_count <= ARRAY_SIZE(ncells), "Too many cells");
+	}
+
+	for (size_t round = 0; round < 2000; round++) {
+		memcpy(resp, ncellmeas_max, sizeof(resp));
+
+		for (size_t i = 0; i < 4; i++) {
+			seed = seed * 1103515245 + 12345;
+			resp[(seed >> 8) % (sizeof(resp) - 1)] =
+				alphabet[(seed >> 20) % (sizeof(alphabet) - 1)];
+		}
+
+		err = parse_ncellmeas(resp, &cells, ARRAY_SIZE(ncells));
+		zassert_true(err <= 1, "Unexpected return value %d", err);
+		zassert_true(cells.ncells_count <= ARRAY_SIZE(ncells), "Too many cells");
+	}
+}
+
+/* Count the neighbor cells of a response from its commas, as the NCELLMEAS
+ * parser used to. Only used as the baseline of the benchmark.
+ */
+static uint32_t neighborcell_count_get(const char *at_response)
+{
+	uint32_t comma_count = 0;
+	uint32_t ncell_elements;
+
+	if (at_response == NULL) {
+		return 0;
+	}
+
+	for (const char *c = at_response; *c != '\0'; c++) {
+		comma_count += (*c == ',');
+	}
+
+	if (comma_count < AT_NCELLMEAS_PRE_NCELLS_PARAMS_COUNT) {
+		return 0;
+	}
+
+	/* Add one, as there's no comma after the last element. */
+	ncell_elements = comma_count - (AT_NCELLMEAS_PRE_NCELLS_PARAMS_COUNT - 1) + 1;
+
+	return ncell_elements / AT_NCELLMEAS_N_PARAMS_COUNT;
+}
+
+/* Parse the same response with an AT parameter list, as the NCELLMEAS parser
+ * used to.
+ */
+static int ncellmeas_params_parse(const char *resp, struct lte_lc_cells_info *cells)
+{
+	int err;
+	int tmp;
+	struct at_param_list list;
+	size_t count = 3;
+
+	for (const char *c = resp; *c != '\0'; c++) {
+		count += (*c == ',');
+	}
+
+	err = at_params_list_init(&list, count);
+	if (err) {
+		return err;
+	}
+
+	err = at_parser_params_from_str(resp, NULL, &list);
+	if (err) {
+		goto exit;
+	}
+
+	cells->ncells_count = neighborcell_count_get(resp);
+
+	for (size_t i = 0; i < cells->ncells_count; i++) {
+		size_t idx = AT_NCELLMEAS_PRE_NCELLS_PARAMS_COUNT + i * AT_NCELLMEAS_N_PARAMS_COUNT;
+
+		at_params_int_get(&list, idx + AT_NCELLMEAS_N_EARFCN_INDEX, &tmp);
+		cells->neighbor_cells[i].earfcn = tmp;
+		at_params_int_get(&list, idx + AT_NCELLMEAS_N_PHYS_CELL_ID_INDEX, &tmp);
+		cells->neighbor_cells[i].phys_cell_id = tmp;
+		at_params_int_get(&list, idx + AT_NCELLMEAS_N_RSRP_INDEX, &tmp);
+		cells->neighbor_cells[i].rsrp = tmp;
+		at_params_int_get(&list, idx + AT_NCELLMEAS_N_RSRQ_INDEX, &tmp);
+		cells->neighbor_cells[i].rsrq = tmp;
+		at_params_int_get(&list, idx + AT_NCELLMEAS_N_TIME_DIFF_INDEX,
+				  &cells->neighbor_cells[i].time_diff);
+	}
+
+exit:
+	at_params_list_free(&list);
+
+	return err;
 }
 
-static void test_neighborcell_count_get(void)
+static void test_parse_ncellmeas_benchmark(void)
 {
-	char *resp1 = "%NCELLMEAS: 1,2,3,4,5,6,7,8,9,10,1,2,3,4,5,1,2,3,4,5,1,2,3,4,5,1,2,3,4,5,"
-		      "1,2,3,4,5,1,2,3,4,5,1,2,3,4,5,1,2,3,4,5,1,2,3,4,5,1,2,3,4,5,1,2,3,4,5,"
-		      "1,2,3,4,5,1,2,3,4,5,1,2,3,4,5,1,2,3,4,5,1,2,3,4,5,1,2,3,4,5";
-	char *resp2 = "%NCELLMEAS: 1,2,3,4,5,6,7,8,9,10,1,2,3,4,5,1,2,3,4,5,1,2,3,4,5,1,2,3,4";
-	char *resp3 = "%NCELLMEAS: 1,2,3,4,5,6,7,8,9,10";
-	char *resp4 = "%NCELLMEAS: ";
-	char *resp5 = " ";
-
-	zassert_equal(17, neighborcell_count_get(resp1), "Wrong neighbor cell count");
-	zassert_equal(3, neighborcell_count_get(resp2), "Wrong neighbor cell count");
-	zassert_equal(0, neighborcell_count_get(resp3), "Wrong neighbor cell count");
-	zassert_equal(0, neighborcell_count_get(resp4), "Wrong neighbor cell count");
-	zassert_equal(0, neighborcell_count_get(resp5), "Wrong neighbor cell count");
+	int err;
+	uint32_t start;
+	uint32_t stream_cycles;
+	uint32_t params_cycles;
+	uint32_t stream_allocs;
+	uint32_t params_allocs;
+	struct lte_lc_ncell ncells[17];
+	struct lte_lc_cells_info cells = {
+		.neighbor_cells = ncells,
+	};
+
+	heap_allocs = 0;
+	start = k_cycle_get_32();
+
+	for (size_t i = 0; i < BENCHMARK_ROUNDS; i++) {
+		err = parse_ncellmeas(ncellmeas_max, &cells, ARRAY_SIZE(ncells));
+		zassert_equal(err, 0, "parse_ncellmeas failed, error: %d", err);
+	}
+
+	stream_cycles = (k_cycle_get_32() - start) / BENCHMARK_ROUNDS;
+	stream_allocs = heap_allocs;
+
+	heap_allocs = 0;
+	start = k_cycle_get_32();
+
+	for (size_t i = 0; i < BENCHMARK_ROUNDS; i++) {
+		err = ncellmeas_params_parse(ncellmeas_max, &cells);
+		zassert_equal(err, 0, "Parsing with parameter list failed, error: %d", err);
+	}
+
+	params_cycles = (k_cycle_get_32() - start) / BENCHMARK_ROUNDS;
+	params_allocs = heap_allocs;
+
+	/* The cycle counts are only reported, they depend on the platform */
+	printk("Parsing NCELLMEAS with 17 neighbor cells:\n");
+	printk("  stream: %u cycles, %u allocations\n", stream_cycles,
+	       stream_allocs / BENCHMARK_ROUNDS);
+	printk("  parameter list: %u cycles, %u allocations\n", params_cycles,
+	       params_allocs / BENCHMARK_ROUNDS);
+
+	zassert_equal(stream_allocs, 0, "Heap used by the NCELLMEAS parser");
 }
 
 void test_main(void)
@@ -438,7 +681,10 @@ void test_main(void)
 		ztest_unit_test(test_parse_rrc_mode),
 		ztest_unit_test(test_response_is_valid),
 		ztest_unit_test(test_parse_ncellmeas),
-		ztest_unit_test(test_neighborcell_count_get),
+		ztest_unit_test(test_parse_ncellmeas_array_full),
+		ztest_unit_test(test_parse_ncellmeas_stream),
+		ztest_unit_test(test_parse_ncellmeas_fuzz),
+		ztest_unit_test(test_parse_ncellmeas_benchmark),
 		ztest_unit_test(test_parse_coneval)
 	);
 
@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <modem/at_cmd.h>
+#include <modem/at_notif.h>
+#include <modem/modem_info.h>
+
+#define FIELD(field) MODEM_INFO_SNAPSHOT_FIELD(field)
+
+/* Responses of the modem to the snapshot commands, NULL for an error */
+static struct {
+	const char *cmd;
+	const char *response;
+	size_t sent;
+} responses[] = {
+	{ "AT%XCBAND", "%XCBAND: 20\r\n" },
+	{ "AT+CEMODE?", "+CEMODE: 2\r\n" },
+	{ "AT+COPS?", "+COPS: 0,2,\"24201\",7\r\n" },
+	{ "AT+CEREG?", NULL },
+	{ "AT+CGDCONT?", "+CGDCONT: 0,\"IPV4V6\",\"telenor.smart\","
+			 "\"10.1.2.3 1111:2222:3333:4444:5555:6666:7777:8888\","
+			 "0,0\r\n"
+			 "+CGDCONT: 1,\"IP\",\"other\",\"10.9.9.9\",0,0\r\n" },
+	{ "AT%XSYSTEMMODE?", "%XSYSTEMMODE: 1,0,1,0\r\n" },
+	{ "AT%XSIM?", "%XSIM: 1\r\n" },
+	{ "AT%XVBAT", "%XVBAT: 3600\r\n" },
+	{ "AT+CCLK?", "+CCLK: \"21/04/20,10:15:30+04\"\r\n" },
+	{ "AT%XCBAND=?", "%XCBAND: (1,2,3,4,12,13,20,66)\r\n" },
+	{ "AT+CGMR", "mfw_nrf9160_1.2.3\r\n" },
+	{ "AT+CRSM=176,12258,0,0,10",
+	  "+CRSM: 144,0,\"981380009170437997F5\"\r\n" },
+	{ "AT+CIMI", "244123456789012\r\n" },
+	{ "AT+CGSN", "352656100123456\r\n" },
+};
+
+/* Commands reading the fields that do not change */
+static const char *const static_cmds[] = {
+	"AT%XCBAND=?", "AT+CGMR", "AT+CRSM=176,12258,0,0,10", "AT+CIMI",
+	"AT+CGSN",
+};
+
+static char cereg_response[64];
+
+static void response_set(const char *cmd, const char *response)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(responses); i++) {
+		if (strcmp(responses[i].cmd, cmd) == 0) {
+			responses[i].response = response;
+		}
+	}
+}
+
+static void cell_set(uint32_t cell_id)
+{
+	snprintf(cereg_response, sizeof(cereg_response),
+		 "+CEREG: 2,1,\"0140\",\"%08X\",7\r\n", cell_id);
+	response_set("AT+CEREG?", cereg_response);
+}
+
+static size_t sent_count(const char *cmd)
+{
+	size_t sent = 0;
+
+	for (size_t i = 0; i < ARRAY_SIZE(responses); i++) {
+		if (cmd == NULL || strcmp(responses[i].cmd, cmd) == 0) {
+			sent += responses[i].sent;
+		}
+	}
+
+	return sent;
+}
+
+/* Commands are completed right away, from the calling thread */
+int at_cmd_write_async(struct at_cmd_req *req)
+{
+	const char *response = NULL;
+	bool found = false;
+
+	for (size_t i = 0; i < ARRAY_SIZE(responses); i++) {
+		if (strcmp(responses[i].cmd, req->cmd) == 0) {
+			responses[i].sent++;
+			response = responses[i].response;
+			found = true;
+			break;
+		}
+	}
+
+	zassert_true(found, "Unexpected command");
+
+	req->state = response ? AT_CMD_OK : AT_CMD_ERROR;
+	req->code = response ? 0 : -ENOEXEC;
+	req->callback(req, response);
+
+	return 0;
+}
+
+int at_cmd_write(const char *const cmd, char *buf, size_t buf_len,
+		 enum at_cmd_state *state)
+{
+	return -ENOTSUP;
+}
+
+int at_notif_register_prefix_handler(const char *prefix, void *context,
+				     at_notif_handler_t handler)
+{
+	return -ENOTSUP;
+}
+
+static void responses_reset(void)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(responses); i++) {
+		responses[i].sent = 0;
+	}
+
+	cell_set(0x12BEEF);
+}
+
+static void test_snapshot_invalid(void)
+{
+	int err;
+
+	err = modem_info_snapshot_get(NULL, MODEM_INFO_SNAPSHOT_ALL);
+	zassert_equal(err, -EINVAL, "NULL snapshot accepted");
+	zassert_equal(sent_count(NULL), 0, "Command sent");
+}
+
+static void test_snapshot_parse(void)
+{
+	static const uint8_t bands[] = {
+		0x1E, 0x30, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04,
+	};
+	struct modem_info_snapshot snapshot = {0};
+	int err;
+
+	err = modem_info_snapshot_get(&snapshot, MODEM_INFO_SNAPSHOT_ALL);
+	zassert_equal(err, 0, "Snapshot failed");
+	zassert_equal(snapshot.present, MODEM_INFO_SNAPSHOT_ALL,
+		      "Fields missing");
+	zassert_equal(snapshot.changed, MODEM_INFO_SNAPSHOT_ALL,
+		      "Fields not flagged as changed");
+
+	/* Each command is sent once */
+	zassert_equal(sent_count(NULL), ARRAY_SIZE(responses),
+		      "Wrong number of commands");
+	zassert_equal(sent_count("AT+CEREG?"), 1, "Command sent twice");
+	zassert_equal(sent_count("AT+CGDCONT?"), 1, "Command sent twice");
+
+	zassert_equal(snapshot.current_band, 20, "Wrong band");
+	zassert_equal(snapshot.ue_mode, 2, "Wrong mode");
+	zassert_equal(strcmp(snapshot.mccmnc, "24201"), 0, "Wrong operator");
+	zassert_equal(snapshot.area_code, 0x0140, "Wrong area code");
+	zassert_equal(snapshot.cell_id, 0x12BEEF, "Wrong cell ID");
+	zassert_equal(strcmp(snapshot.ip_address, "10.1.2.3"), 0,
+		      "Wrong IP address");
+	zassert_equal(strcmp(snapshot.apn, "telenor.smart"), 0, "Wrong APN");
+	zassert_equal(snapshot.system_mode,
+		      MODEM_INFO_SNAPSHOT_SYSTEM_MODE_LTEM |
+		      MODEM_INFO_SNAPSHOT_SYSTEM_MODE_GPS,
+		      "Wrong system mode");
+	zassert_equal(snapshot.uicc, 1, "Wrong UICC state");
+	zassert_equal(snapshot.battery, 3600, "Wrong battery voltage");
+	zassert_equal(strcmp(snapshot.date_time, "21/04/20,10:15:30+04"), 0,
+		      "Wrong date and time");
+	zassert_mem_equal(snapshot.sup_bands, bands, sizeof(bands),
+			  "Wrong supported bands");
+	zassert_equal(strcmp(snapshot.modem_fw, "mfw_nrf9160_1.2.3"), 0,
+		      "Wrong firmware version");
+	zassert_equal(strcmp(snapshot.iccid, "8931080019073497795"), 0,
+		      "Wrong ICCID");
+	zassert_equal(strcmp(snapshot.imsi, "244123456789012"), 0,
+		      "Wrong IMSI");
+	zassert_equal(strcmp(snapshot.imei, "352656100123456"), 0,
+		      "Wrong IMEI");
+}
+
+static void test_snapshot_changed(void)
+{
+	struct modem_info_snapshot snapshot = {0};
+	int err;
+
+	err = modem_info_snapshot_get(&snapshot, MODEM_INFO_SNAPSHOT_ALL);
+	zassert_equal(err, 0, "Snapshot failed");
+
+	/* The static fields were read by the previous snapshot */
+	zassert_equal(sent_count(NULL),
+		      ARRAY_SIZE(responses) - ARRAY_SIZE(static_cmds),
+		      "Wrong number of commands");
+
+	for (size_t i = 0; i < ARRAY_SIZE(static_cmds); i++) {
+		zassert_equal(sent_count(static_cmds[i]), 0,
+			      "Static field read again");
+	}
+
+	cell_set(0x12BEF0);
+
+	err = modem_info_snapshot_get(&snapshot, MODEM_INFO_SNAPSHOT_ALL);
+	zassert_equal(err, 0, "Snapshot failed");
+	zassert_equal(snapshot.changed, FIELD(CELLID),
+		      "Wrong fields flagged as changed");
+	zassert_equal(snapshot.cell_id, 0x12BEF0, "Wrong cell ID");
+}
+
+static void test_snapshot_failure(void)
+{
+	struct modem_info_snapshot snapshot = {0};
+	int err;
+
+	response_set("AT+CEREG?", NULL);
+
+	err = modem_info_snapshot_get(&snapshot,
+				      FIELD(CELLID) | FIELD(BATTERY));
+	zassert_equal(err, -EAGAIN, "Failure not reported");
+	zassert_equal(snapshot.present, FIELD(BATTERY),
+		      "Fields not read reported as present");
+	zassert_equal(snapshot.battery, 3600, "Wrong battery voltage");
+
+	/* The cell ID is missing from the response */
+	response_set("AT+CEREG?", "+CEREG: 2,1,\"0140\"\r\n");
+
+	err = modem_info_snapshot_get(&snapshot,
+				      FIELD(CELLID) | FIELD(AREA_CODE));
+	zassert_equal(err, -EAGAIN, "Failure not reported");
+	zassert_equal(snapshot.present, FIELD(BATTERY) | FIELD(AREA_CODE),
+		      "Fields not read reported as present");
+	zassert_equal(snapshot.area_code, 0x0140, "Wrong area code");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(modem_info_test,
+		ztest_unit_test_setup_teardown(test_snapshot_invalid,
+					       responses_reset,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_snapshot_parse,
+					       responses_reset,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_snapshot_changed,
+					       responses_reset,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_snapshot_failure,
+					       responses_reset,
+					       unit_test_noop)
+	);
+
+	ztest_run_test_suite(modem_info_test);
+}
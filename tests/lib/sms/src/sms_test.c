@@ -745,6 +745,10 @@ void test_recv_len8_number20(void)
 /** Receive concatenated SMS with 291 characters that are split into 2 messages. */
 void test_recv_concat_len291_msgs2(void)
 {
+	if (IS_ENABLED(CONFIG_SMS_REASSEMBLY)) {
+		TEST_IGNORE_MESSAGE("Parts are reassembled into one message");
+	}
+
 	sms_reg_helper();
 
 	strcpy(test_sms_header.originating_address.address_str, "1234567890");
@@ -795,6 +799,10 @@ void test_recv_concat_len291_msgs2(void)
  */
 void test_recv_concat_len755_msgs5(void)
 {
+	if (IS_ENABLED(CONFIG_SMS_REASSEMBLY)) {
+		TEST_IGNORE_MESSAGE("Parts are reassembled into one message");
+	}
+
 	sms_reg_helper();
 
 	strcpy(test_sms_header.originating_address.address_str, "1234567890");
@@ -931,6 +939,10 @@ void test_recv_special_characters(void)
  */
 void test_recv_concat_escape_character_last(void)
 {
+	if (IS_ENABLED(CONFIG_SMS_REASSEMBLY)) {
+		TEST_IGNORE_MESSAGE("Parts are reassembled into one message");
+	}
+
 	sms_reg_helper();
 
 	strcpy(test_sms_header.originating_address.address_str, "1234567890");
@@ -1068,6 +1080,310 @@ void test_recv_port_addr(void)
 	sms_unreg_helper();
 }
 
+/**
+ * Tests:
+ * - UCS2 text decoded into UTF-8
+ * - Character outside of the Basic Multilingual Plane as UTF-16 surrogate pair
+ */
+void test_recv_ucs2(void)
+{
+	sms_reg_helper();
+
+	strcpy(test_sms_header.originating_address.address_str, "1234567890");
+	test_sms_header.originating_address.length = 10;
+	test_sms_header.originating_address.type = 0x91;
+	/* "Moi", grinning face, a and o with diaeresis, euro sign */
+	test_sms_data.payload_len = 17;
+	strcpy(test_sms_data.payload, "Moi \xF0\x9F\x98\x80 \xC3\xA4\xC3\xB6 \xE2\x82\xAC");
+	test_sms_header.time.year = 21;
+	test_sms_header.time.month = 3;
+	test_sms_header.time.day = 1;
+	test_sms_header.time.hour = 12;
+	test_sms_header.time.minute = 0;
+	test_sms_header.time.second = 0;
+
+	__wrap_at_cmd_write_ExpectAndReturn("AT+CNMA=1", NULL, 0, NULL, 0);
+	sms_callback_called_expected = true;
+	sms_at_handler(NULL, "+CMT: \"+1234567890\",40\r\n"
+		"0791534874894310040A91214365870900081230102100000016004D006F00690020D83DDE00002000E400F6002020AC\r\n");
+
+	sms_unreg_helper();
+}
+
+/**
+ * Test UCS2 message with 142 octets of user data, which would not fit into the payload buffer
+ * once decoded into UTF-8.
+ */
+void test_recv_fail_ucs2_len142(void)
+{
+	sms_reg_helper();
+
+	sms_callback_called_expected = false;
+	sms_at_handler(NULL, "+CMT: \"+1234567890\",40\r\n"
+		"0791534874894310040A9121436587090008123010210000008E20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC20AC\r\n");
+
+	sms_unreg_helper();
+}
+
+/********* SMS REASSEMBLY TESTS ***********************/
+
+#if defined(CONFIG_SMS_REASSEMBLY)
+/* Tests with pool exhaustion assume these values from overlay-reassembly.conf */
+BUILD_ASSERT(CONFIG_SMS_REASSEMBLY_MSGS_MAX == 4, "4 messages reassembled at once expected");
+BUILD_ASSERT(CONFIG_SMS_REASSEMBLY_PARTS_MAX >= 5, "5 parts per message expected");
+#define REASSEMBLY_TIMEOUT K_SECONDS(CONFIG_SMS_REASSEMBLY_TIMEOUT)
+#else
+#define REASSEMBLY_TIMEOUT K_NO_WAIT
+#endif
+
+/**
+ * Set the expected message reassembled from parts sent on 2021-03-01 12:00,
+ * with the given second in the timestamp of the first part.
+ */
+static void helper_reassembled_set(const char *address, uint16_t ref_number,
+				   uint8_t total_msgs, uint8_t second, const char *payload)
+{
+	helper_sms_data_clear();
+
+	strcpy(test_sms_header.originating_address.address_str, address);
+	test_sms_header.originating_address.length = strlen(address);
+	test_sms_header.originating_address.type = 0x91;
+	test_sms_header.time.year = 21;
+	test_sms_header.time.month = 3;
+	test_sms_header.time.day = 1;
+	test_sms_header.time.hour = 12;
+	test_sms_header.time.minute = 0;
+	test_sms_header.time.second = second;
+
+	test_sms_header.concatenated.present = true;
+	test_sms_header.concatenated.ref_number = ref_number;
+	test_sms_header.concatenated.total_msgs = total_msgs;
+	test_sms_header.concatenated.seq_number = 0;
+
+	strcpy(test_sms_data.payload, payload);
+	test_sms_data.payload_len = strlen(payload);
+}
+
+/** Receive a part that does not complete its message, or a duplicate part. */
+static void helper_recv_part_buffered(const char *at_notif)
+{
+	__wrap_at_cmd_write_ExpectAndReturn("AT+CNMA=1", NULL, 0, NULL, 0);
+	sms_callback_called_expected = false;
+	sms_callback_called_occurred = false;
+	sms_at_handler(NULL, at_notif);
+	TEST_ASSERT_EQUAL(false, sms_callback_called_occurred);
+}
+
+/** Receive the last missing part of the message set with helper_reassembled_set(). */
+static void helper_recv_part_completing(const char *at_notif)
+{
+	__wrap_at_cmd_write_ExpectAndReturn("AT+CNMA=1", NULL, 0, NULL, 0);
+	sms_callback_called_expected = true;
+	sms_callback_called_occurred = false;
+	sms_at_handler(NULL, at_notif);
+	TEST_ASSERT_EQUAL(true, sms_callback_called_occurred);
+}
+
+/**
+ * Receive the parts of the 5 message long concatenated SMS of
+ * test_recv_concat_len755_msgs5 out of order and with duplicates.
+ */
+void test_recv_reassembly_len755_msgs5_out_of_order(void)
+{
+	const char *part1 = "+CMT: \"1234567890\",159\r\n"
+		"0791534874894310440A912143658709000012202280655080A0050003800501C2E231B96C3EA3D3EA35BBED7EC3E3F239BD6EBFE3F37A50583C2697CD67745ABD66B7DD6F785C3EA7D7ED777C5E0F0A8BC7E4B2F98C4EABD7ECB6FB0D8FCBE7F4BAFD8ECFEB4161F1985C369FD169F59ADD76BFE171F99C5EB7DFF1793D282C1E93CBE6333AAD5EB3DBEE373C2E9FD3EBF63B3EAF0785C56372D97C46A7D56B76DBFD86C7E5\r\n";
+	const char *part2 = "+CMT: \"1234567890\",159\r\n"
+		"0791534874894370440A912143658709000012202280656080A0050003800502E6F4BAFD8ECFEB4161F1985C369FD169F59ADD76BFE171F99C5EB7DFF1793D282C1E93CBE6333AAD5EB3DBEE373C2E9FD3EBF63B3EAF0785C56372D97C46A7D56B76DBFD86C7E5737ADD7EC7E7F5A0B0784C2E9BCFE8B47ACD6EBBDFF0B87C4EAFDBEFF8BC1E14168FC965F3199D56AFD96DF71B1E97CFE975FB1D9FD783C2E231B96C3EA3D3\r\n";
+	const char *part3 = "+CMT: \"1234567890\",159\r\n"
+		"0791534874894310440A912143658709000012202280656080A0050003800503D46B76DBFD86C7E5737ADD7EC7E7F5A0B0784C2E9BCFE8B47ACD6EBBDFF0B87C4EAFDBEFF8BC1E14168FC965F3199D56AFD96DF71B1E97CFE975FB1D9FD783C2E231B96C3EA3D3EA35BBED7EC3E3F239BD6EBFE3F37A50583C2697CD67745ABD66B7DD6F785C3EA7D7ED777C5E0F0A8BC7E4B2F98C4EABD7ECB6FB0D8FCBE7F4BAFD8ECFEB41\r\n";
+	const char *part4 = "+CMT: \"1234567890\",159\r\n"
+		"0791534874894370440A912143658709000012202280656080A0050003800504C2E231B96C3EA3D3EA35BBED7EC3E3F239BD6EBFE3F37A50583C2697CD67745ABD66B7DD6F785C3EA7D7ED777C5E0F0A8BC7E4B2F98C4EABD7ECB6FB0D8FCBE7F4BAFD8ECFEB4161F1985C369FD169F59ADD76BFE171F99C5EB7DFF1793D282C1E93CBE6333AAD5EB3DBEE373C2E9FD3EBF63B3EAF0785C56372D97C46A7D56B76DBFD86C7E5\r\n";
+	const char *part5 = "+CMT: \"1234567890\"151\r\n"
+		"0791534874894310440A91214365870900001220228065608096050003800505E6F4BAFD8ECFEB4161F1985C369FD169F59ADD76BFE171F99C5EB7DFF1793D282C1E93CBE6333AAD5EB3DBEE373C2E9FD3EBF63B3EAF0785C56372D97C46A7D56B76DBFD86C7E5737ADD7EC7E7F5A0B0784C2E9BCFE8B47ACD6EBBDFF0B87C4EAFDBEFF8BC1E14168FC965F3199D56AFD96DF71B1E97CFE975FB1D9FD703\r\n";
+
+	if (!IS_ENABLED(CONFIG_SMS_REASSEMBLY)) {
+		TEST_IGNORE_MESSAGE("Reassembly disabled");
+	}
+
+	sms_reg_helper();
+
+	helper_recv_part_buffered(part4);
+	helper_recv_part_buffered(part1);
+	helper_recv_part_buffered(part4);
+	helper_recv_part_buffered(part2);
+	helper_recv_part_buffered(part5);
+	helper_recv_part_buffered(part1);
+
+	helper_sms_data_clear();
+	strcpy(test_sms_header.originating_address.address_str, "1234567890");
+	test_sms_header.originating_address.length = 10;
+	test_sms_header.originating_address.type = 0x91;
+	/* Header of the first part, not of the part received first */
+	test_sms_header.time.year = 21;
+	test_sms_header.time.month = 2;
+	test_sms_header.time.day = 22;
+	test_sms_header.time.hour = 8;
+	test_sms_header.time.minute = 56;
+	test_sms_header.time.second = 5;
+	test_sms_header.concatenated.present = true;
+	test_sms_header.concatenated.total_msgs = 5;
+	test_sms_header.concatenated.ref_number = 128;
+	test_sms_header.concatenated.seq_number = 0;
+
+	for (int i = 0; i < 27; i++) {
+		strcat(test_sms_data.payload, "abcdefghijklmnopqrstuvwxyz ");
+	}
+	strcat(test_sms_data.payload, "abcdefghijklmnopqrstuvwxyz");
+	test_sms_data.payload_len = 755;
+
+	helper_recv_part_completing(part3);
+
+	sms_unreg_helper();
+}
+
+/**
+ * Receive the parts of 4 concatenated messages interleaved and out of order:
+ * - 2 messages with the same reference number from different senders
+ * - 1 message in UCS2, decoded into UTF-8
+ */
+void test_recv_reassembly_interleaved(void)
+{
+	/* Message 1 from 1234567890, reference number 1 */
+	const char *msg1_part1 = "+CMT: \"+1234567890\",52\r\n"
+		"0791534874894310440A91214365870900001230102100110026050003010301A061391DF47697416F33888E2E83CC69F99C0E6A97E7F3F0B9EC0201\r\n";
+	const char *msg1_part2 = "+CMT: \"+1234567890\",52\r\n"
+		"0791534874894310440A91214365870900001230102100210026050003010302A061391D44BFBF416F33888E2E83CC69F99C0E6A97E7F3F0B9EC0201\r\n";
+	const char *msg1_part3 = "+CMT: \"+1234567890\",53\r\n"
+		"0791534874894310440A91214365870900001230102100310027050003010303A061391D4447CBCB65D0DB0CA2A3CB20735A3EA783DAE5F93C7C2EBB00\r\n";
+	/* Message 2 from 987654321, reference number 1 */
+	const char *msg2_part1 = "+CMT: \"+987654321\",45\r\n"
+		"079153487489431044099189674523F10000123010210012001E050003010201A6E17619242F9BCBF2B27B5C06B9EB6D7159CE0201\r\n";
+	const char *msg2_part2 = "+CMT: \"+987654321\",38\r\n"
+		"079153487489431044099189674523F100001230102100220016050003010202C2EE371D5D9683E66537B92C7701\r\n";
+	/* Message 3 from 1234567890, reference number 2, UCS2 */
+	const char *msg3_part1 = "+CMT: \"+1234567890\",52\r\n"
+		"0791534874894310440A9121436587090008123010210013002205000302020100480079007600E400E40020007000E40069007600E400E4002C0020\r\n";
+	const char *msg3_part2 = "+CMT: \"+1234567890\",46\r\n"
+		"0791534874894310440A9121436587090008123010210023001C050003020202006E00E4006B0065006D00690069006E0021002020AC\r\n";
+	/* Message 4 from 1234567890, reference number 3 */
+	const char *msg4_part1 = "+CMT: \"+1234567890\",31\r\n"
+		"0791534874894310440A9121436587090000123010210014000E0500030303018CEFBA9C8E0601\r\n";
+	const char *msg4_part2 = "+CMT: \"+1234567890\",32\r\n"
+		"0791534874894310440A9121436587090000123010210024000F050003030302DAE5F93C7C2E8300\r\n";
+	const char *msg4_part3 = "+CMT: \"+1234567890\",38\r\n"
+		"0791534874894310440A91214365870900001230102100340016050003030303D26E101D2D2F9741F0B09C3E7701\r\n";
+
+	if (!IS_ENABLED(CONFIG_SMS_REASSEMBLY)) {
+		TEST_IGNORE_MESSAGE("Reassembly disabled");
+	}
+
+	sms_reg_helper();
+
+	helper_recv_part_buffered(msg1_part2);
+	helper_recv_part_buffered(msg2_part1);
+	helper_recv_part_buffered(msg3_part2);
+	helper_recv_part_buffered(msg1_part1);
+	helper_recv_part_buffered(msg4_part3);
+	helper_recv_part_buffered(msg2_part1);
+
+	helper_reassembled_set("1234567890", 2, 2, 31, "Hyv\xC3\xA4\xC3\xA4 p\xC3\xA4iv\xC3\xA4\xC3\xA4, n\xC3\xA4kemiin! \xE2\x82\xAC");
+	helper_recv_part_completing(msg3_part1);
+
+	helper_recv_part_buffered(msg4_part1);
+
+	helper_reassembled_set("987654321", 1, 2, 21,
+			       "Same reference number, another sender.");
+	helper_recv_part_completing(msg2_part2);
+
+	helper_reassembled_set("1234567890", 1, 3, 11,
+			       "Part one of the first message. "
+			       "Part two of the first message. "
+			       "Part three of the first message.");
+	helper_recv_part_completing(msg1_part3);
+
+	helper_reassembled_set("1234567890", 3, 3, 41, "Fourth message in three parts.");
+	helper_recv_part_completing(msg4_part2);
+
+	/* Parts of completed messages start new messages */
+	helper_recv_part_buffered(msg3_part1);
+
+	sms_unreg_helper();
+}
+
+/** Drop the oldest message being reassembled when a part of yet another one is received. */
+void test_recv_reassembly_too_many_msgs(void)
+{
+	const char *msg_part1[] = {
+		"+CMT: \"+1234567890\",42\r\n"
+			"0791534874894310440A9121436587090000123010210010001B0500030A02019AE5F93C7C2E83623016081E96D341311708\r\n",
+		"+CMT: \"+1234567890\",42\r\n"
+			"0791534874894310440A9121436587090000123010210010001B0500030B02019AE5F93C7C2E83623116081E96D341311708\r\n",
+		"+CMT: \"+1234567890\",42\r\n"
+			"0791534874894310440A9121436587090000123010210010001B0500030C02019AE5F93C7C2E83623216081E96D341311708\r\n",
+		"+CMT: \"+1234567890\",42\r\n"
+			"0791534874894310440A9121436587090000123010210010001B0500030D02019AE5F93C7C2E83623316081E96D341311708\r\n",
+		"+CMT: \"+1234567890\",42\r\n"
+			"0791534874894310440A9121436587090000123010210010001B0500030E02019AE5F93C7C2E83623416081E96D341311708\r\n",
+	};
+	const char *msg10_part2 = "+CMT: \"+1234567890\",42\r\n"
+		"0791534874894310440A9121436587090000123010210020001B0500030A02029AE5F93C7C2E83623016081E96D341321708\r\n";
+	const char *msg11_part2 = "+CMT: \"+1234567890\",42\r\n"
+		"0791534874894310440A9121436587090000123010210020001B0500030B02029AE5F93C7C2E83623116081E96D341321708\r\n";
+	const char *msg14_part2 = "+CMT: \"+1234567890\",42\r\n"
+		"0791534874894310440A9121436587090000123010210020001B0500030E02029AE5F93C7C2E83623416081E96D341321708\r\n";
+
+	if (!IS_ENABLED(CONFIG_SMS_REASSEMBLY)) {
+		TEST_IGNORE_MESSAGE("Reassembly disabled");
+	}
+
+	sms_reg_helper();
+
+	for (size_t i = 0; i < ARRAY_SIZE(msg_part1); i++) {
+		helper_recv_part_buffered(msg_part1[i]);
+	}
+
+	helper_reassembled_set("1234567890", 14, 2, 1,
+			       "Message 14, part 1. Message 14, part 2. ");
+	helper_recv_part_completing(msg14_part2);
+
+	/* Message 10 was dropped for message 14 */
+	helper_recv_part_buffered(msg10_part2);
+
+	helper_reassembled_set("1234567890", 11, 2, 1,
+			       "Message 11, part 1. Message 11, part 2. ");
+	helper_recv_part_completing(msg11_part2);
+
+	sms_unreg_helper();
+}
+
+/** Drop the parts of a message that is not complete in time. */
+void test_recv_reassembly_timeout(void)
+{
+	const char *part1 = "+CMT: \"+987654321\",35\r\n"
+		"079153487489431044099189674523F10000123010210010001305000307020198617A19040FCBE9A0980B\r\n";
+	const char *part2 = "+CMT: \"+987654321\",35\r\n"
+		"079153487489431044099189674523F10000123010210020001305000307020298617A19040FCBE920990B\r\n";
+
+	if (!IS_ENABLED(CONFIG_SMS_REASSEMBLY)) {
+		TEST_IGNORE_MESSAGE("Reassembly disabled");
+	}
+
+	sms_reg_helper();
+
+	helper_recv_part_buffered(part1);
+
+	k_sleep(REASSEMBLY_TIMEOUT);
+
+	/* Part 1 has timed out, so part 2 starts a new message */
+	helper_recv_part_buffered(part2);
+	helper_recv_part_buffered(part2);
+
+	helper_reassembled_set("987654321", 7, 2, 1, "Late part 1.Late part 2.");
+	helper_recv_part_completing(part1);
+
+	sms_unreg_helper();
+}
+
 /********* SMS RECV FAIL TESTS ******************/
 
 /** Test AT command unknown for SMS library. */
@@ -1171,12 +1487,38 @@ void test_recv_cmt_erroneous(void)
 	sms_unreg_helper();
 }
 
-/** DCS not supported (UCS2): 0x08 */
-void test_recv_fail_invalid_dcs_ucs2(void)
+/**
+ * Tests:
+ * - UCS2 with port addressing
+ * - User-Data-Length longer than the data, which ends with an odd byte
+ */
+void test_recv_ucs2_port_addr(void)
 {
 	sms_reg_helper();
 
-	sms_callback_called_expected = false;
+	strcpy(test_sms_header.originating_address.address_str, "12345678");
+	test_sms_header.originating_address.length = 8;
+	test_sms_header.originating_address.type = 0x81;
+	/* U+0102, U+0304, U+0506 and U+0708 in UTF-8 */
+	test_sms_data.payload_len = 8;
+	strcpy(test_sms_data.payload, "\xC4\x82\xCC\x84\xD4\x86\xDC\x88");
+	test_sms_header.time.year = 21;
+	test_sms_header.time.month = 1;
+	test_sms_header.time.day = 30;
+	test_sms_header.time.hour = 12;
+	test_sms_header.time.minute = 34;
+	test_sms_header.time.second = 56;
+
+	test_sms_header.app_port.present = true;
+	test_sms_header.app_port.dest_port = 2948;
+
+	test_sms_header.concatenated.present = true;
+	test_sms_header.concatenated.total_msgs = 1;
+	test_sms_header.concatenated.ref_number = 124;
+	test_sms_header.concatenated.seq_number = 1;
+
+	__wrap_at_cmd_write_ExpectAndReturn("AT+CNMA=1", NULL, 0, NULL, 0);
+	sms_callback_called_expected = true;
 	sms_at_handler(NULL, "+CMT: \"+1234567890\",22\r\n"
 		"004408812143658700081210032143652b1c0b05040b84000000037c0101010203040506070809\r\n");
 
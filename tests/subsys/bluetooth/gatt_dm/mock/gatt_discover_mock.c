@@ -5,21 +5,29 @@
  */
 #include <stdbool.h>
 #include <inttypes.h>
+#include <string.h>
+#include <bluetooth/bluetooth.h>
 #include <bluetooth/gatt.h>
 #include <bluetooth/uuid.h>
+#include <bluetooth/conn.h>
 #include <kernel.h>
 #include <ztest.h>
 #include <sys/util.h>
 
 
 /* Settings of the discover mock */
-static struct bt_discover_mock {
+static struct {
 	const struct bt_gatt_attr *attr;
 	size_t len;
+	size_t cnt;
+} discover_mock_data;
+
+/* Simulated discovery, one for each discovery parameters in use */
+static struct bt_discover_mock {
 	struct bt_conn *conn;
 	struct bt_gatt_discover_params *params;
 	struct k_delayed_work work;
-} discover_mock_data;
+} discover_mock[CONFIG_BT_GATT_DM_MAX_INSTANCES];
 
 
 void bt_gatt_discover_mock_setup(const struct bt_gatt_attr *attr, size_t len)
@@ -28,6 +36,24 @@ void bt_gatt_discover_mock_setup(const struct bt_gatt_attr *attr, size_t len)
 	discover_mock_data.len  = len;
 }
 
+size_t bt_gatt_discover_mock_cnt_get(void)
+{
+	return discover_mock_data.cnt;
+}
+
+static struct bt_discover_mock *discover_mock_get(
+	struct bt_gatt_discover_params *params)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(discover_mock); i++) {
+		if (!discover_mock[i].params ||
+		    (discover_mock[i].params == params)) {
+			return &discover_mock[i];
+		}
+	}
+
+	return NULL;
+}
+
 static bool bt_gatt_primary_check(const struct bt_gatt_attr *attr_cur,
 				  const struct bt_uuid *uuid)
 {
@@ -122,11 +148,123 @@ static void bt_gatt_discover_work(struct k_work *work)
 int bt_gatt_discover(struct bt_conn *conn,
 		     struct bt_gatt_discover_params *params)
 {
+	struct bt_discover_mock *mock_data = discover_mock_get(params);
+
+	printk("Running %s mock\n", __func__);
+	zassert_not_null(mock_data, "Too many discovery parameters in use");
+
+	mock_data->conn = conn;
+	mock_data->params = params;
+	discover_mock_data.cnt++;
+
+	k_delayed_work_init(&(mock_data->work), bt_gatt_discover_work);
+	k_delayed_work_submit(&(mock_data->work), K_MSEC(5));
+	return 0;
+}
+
+#if CONFIG_BT_GATT_DM_CACHE
+
+/* Settings of the bonded peer and Database Hash mocks */
+static struct {
+	struct bt_conn *conn;
+	bt_addr_le_t addr;
+	const uint8_t *db_hash;
+} bond_mock_data;
+
+/* Simulated read of the Database Hash, one for each read parameters */
+static struct bt_read_mock {
+	struct bt_conn *conn;
+	struct bt_gatt_read_params *params;
+	struct k_delayed_work work;
+} read_mock[CONFIG_BT_GATT_DM_MAX_INSTANCES];
+
+
+void bt_gatt_discover_mock_bond_setup(struct bt_conn *conn,
+				      const bt_addr_le_t *addr)
+{
+	bond_mock_data.conn = conn;
+	bt_addr_le_copy(&bond_mock_data.addr, addr);
+}
+
+void bt_gatt_discover_mock_db_hash_setup(const uint8_t *hash)
+{
+	bond_mock_data.db_hash = hash;
+}
+
+static struct bt_read_mock *read_mock_get(struct bt_gatt_read_params *params)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(read_mock); i++) {
+		if (!read_mock[i].params || (read_mock[i].params == params)) {
+			return &read_mock[i];
+		}
+	}
+
+	return NULL;
+}
+
+static void bt_gatt_read_work(struct k_work *work)
+{
+	struct bt_read_mock *mock_data =
+		CONTAINER_OF(work, struct bt_read_mock, work);
+	struct bt_gatt_read_params *params = mock_data->params;
+
+	zassert_equal(0, params->handle_count, "Only read by UUID is mocked");
+	zassert_true(!bt_uuid_cmp(BT_UUID_GATT_DB_HASH, params->by_uuid.uuid),
+		     "Unexpected UUID read");
+
+	if (!bond_mock_data.db_hash) {
+		(void)params->func(mock_data->conn,
+				   BT_ATT_ERR_ATTRIBUTE_NOT_FOUND,
+				   params, NULL, 0);
+		return;
+	}
+
+	if (params->func(mock_data->conn, 0, params,
+			 bond_mock_data.db_hash, 16) == BT_GATT_ITER_CONTINUE) {
+		/* Send NULL to mark processing end */
+		(void)params->func(mock_data->conn, 0, params, NULL, 0);
+	}
+}
+
+/* Mocked version of the bt_gatt_read */
+/* Call the bt_gatt_discover_mock_db_hash_setup function first */
+int bt_gatt_read(struct bt_conn *conn, struct bt_gatt_read_params *params)
+{
+	struct bt_read_mock *mock_data = read_mock_get(params);
+
 	printk("Running %s mock\n", __func__);
-	discover_mock_data.conn = conn;
-	discover_mock_data.params = params;
+	zassert_not_null(mock_data, "Too many read parameters in use");
+
+	mock_data->conn = conn;
+	mock_data->params = params;
 
-	k_delayed_work_init(&(discover_mock_data.work), bt_gatt_discover_work);
-	k_delayed_work_submit(&(discover_mock_data.work), K_MSEC(5));
+	k_delayed_work_init(&(mock_data->work), bt_gatt_read_work);
+	k_delayed_work_submit(&(mock_data->work), K_MSEC(5));
 	return 0;
 }
+
+/* Mocked version of the bt_conn_get_info */
+/* Only the connection set with bt_gatt_discover_mock_bond_setup has
+ * a known peer address
+ */
+int bt_conn_get_info(const struct bt_conn *conn, struct bt_conn_info *info)
+{
+	static const bt_addr_le_t unknown_addr;
+
+	memset(info, 0, sizeof(*info));
+	info->type = BT_CONN_TYPE_LE;
+	info->id = BT_ID_DEFAULT;
+	info->le.dst = (conn == bond_mock_data.conn) ?
+		       &bond_mock_data.addr : &unknown_addr;
+
+	return 0;
+}
+
+/* Mocked version of the bt_addr_le_is_bonded */
+bool bt_addr_le_is_bonded(uint8_t id, const bt_addr_le_t *addr)
+{
+	return bond_mock_data.conn &&
+	       !bt_addr_le_cmp(addr, &bond_mock_data.addr);
+}
+
+#endif /* CONFIG_BT_GATT_DM_CACHE */
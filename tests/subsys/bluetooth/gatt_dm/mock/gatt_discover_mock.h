@@ -9,6 +9,7 @@
 
 #include <bluetooth/uuid.h>
 #include <bluetooth/gatt.h>
+#include <bluetooth/conn.h>
 
 
 /**
@@ -90,5 +91,36 @@
  */
 void bt_gatt_discover_mock_setup(const struct bt_gatt_attr *attr, size_t len);
 
+/**
+ * @brief Get the number of discoveries
+ *
+ * @return The number of times @ref bt_gatt_discover was called.
+ */
+size_t bt_gatt_discover_mock_cnt_get(void);
+
+#if CONFIG_BT_GATT_DM_CACHE
+/**
+ * @brief Bonded peer mock setup
+ *
+ * This function setups the mock for @ref bt_conn_get_info and
+ * @ref bt_addr_le_is_bonded functions.
+ *
+ * @param conn The connection with the bonded peer
+ * @param addr The address of the bonded peer
+ */
+void bt_gatt_discover_mock_bond_setup(struct bt_conn *conn,
+				      const bt_addr_le_t *addr);
+
+/**
+ * @brief Database Hash mock setup
+ *
+ * This function setups the mock for @ref bt_gatt_read function.
+ *
+ * @param hash The Database Hash of the peer, 16 bytes long,
+ *             or NULL if the peer has no Database Hash characteristic.
+ */
+void bt_gatt_discover_mock_db_hash_setup(const uint8_t *hash);
+#endif
+
 /** @} */
 #endif /* #define BT_GATT_DISCOVERY_MOCK_H_ */
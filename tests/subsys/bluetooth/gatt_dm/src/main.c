@@ -6,16 +6,19 @@
 #include <ztest.h>
 #include <kernel.h>
 #include <stddef.h>
+#include <string.h>
 #include <sys/util.h>
 #include <bluetooth/uuid.h>
 #include <bluetooth/gatt_dm.h>
+#include <settings/settings.h>
 #include "../mock/gatt_discover_mock.h"
 
 /* Timeout for the discovery in ms */
 #define SERVICE_DISCOVERY_TIMEOUT 2000
 
 static char dummy_conn;
-K_SEM_DEFINE(discovery_finished, 0, 1);
+static char dummy_conn_2;
+K_SEM_DEFINE(discovery_finished, 0, CONFIG_BT_GATT_DM_MAX_INSTANCES);
 
 
 const struct bt_gatt_attr discover_sim[] = {
@@ -79,12 +82,13 @@ void test_setup(void)
 	bt_gatt_discover_mock_setup(discover_sim, ARRAY_SIZE(discover_sim));
 }
 
-struct bt_gatt_dm *run_dm(const struct bt_uuid *svc_uuid)
+struct bt_gatt_dm *run_dm_conn(struct bt_conn *conn,
+			       const struct bt_uuid *svc_uuid)
 {
 	struct bt_gatt_dm *dm;
 	int err;
 
-	err = bt_gatt_dm_start((struct bt_conn *)&dummy_conn,
+	err = bt_gatt_dm_start(conn,
 				   svc_uuid,
 				   &test_hids_cb,
 				   &dm);
@@ -96,6 +100,11 @@ struct bt_gatt_dm *run_dm(const struct bt_uuid *svc_uuid)
 	return dm;
 }
 
+struct bt_gatt_dm *run_dm(const struct bt_uuid *svc_uuid)
+{
+	return run_dm_conn((struct bt_conn *)&dummy_conn, svc_uuid);
+}
+
 struct bt_gatt_dm *run_dm_next(struct bt_gatt_dm *dm)
 {
 	int err;
@@ -376,6 +385,298 @@ void test_gatt_generic_serv(void)
 	/* No cleanup here - cleanup is done in run_dm_next */
 }
 
+/* Discoveries of two peers running at the same time */
+void test_gatt_concurrent(void)
+{
+	int err;
+	struct bt_gatt_dm *dm_hids = NULL;
+	struct bt_gatt_dm *dm_dis = NULL;
+	struct bt_gatt_dm *dm_none;
+	const struct bt_gatt_dm_attr *attr_serv;
+	const struct bt_gatt_service_val *serv_val;
+	struct bt_gatt_dm_stats stats;
+
+	err = bt_gatt_dm_start((struct bt_conn *)&dummy_conn,
+			       BT_UUID_HIDS,
+			       &test_hids_cb,
+			       &dm_hids);
+	zassert_false(err, "bt_gatt_dm_start finished with error: %d", err);
+
+	err = bt_gatt_dm_start((struct bt_conn *)&dummy_conn_2,
+			       BT_UUID_DIS,
+			       &test_hids_cb,
+			       &dm_dis);
+	zassert_false(err, "bt_gatt_dm_start finished with error: %d", err);
+
+	/* Both instances configured in prj.conf are in use */
+	err = bt_gatt_dm_start((struct bt_conn *)&dummy_conn,
+			       BT_UUID_BAS,
+			       &test_hids_cb,
+			       &dm_none);
+	zassert_equal(-EALREADY, err, "Unexpected error: %d", err);
+
+	for (int i = 0; i < 2; ++i) {
+		err = k_sem_take(&discovery_finished,
+				 K_MSEC(SERVICE_DISCOVERY_TIMEOUT));
+		zassert_equal(0, err, "It seems that no callback function was called: %d", err);
+	}
+
+	zassert_not_null(dm_hids, "Device Manager pointer not set");
+	zassert_not_null(dm_dis, "Device Manager pointer not set");
+	zassert_not_equal(dm_hids, dm_dis, "Instance used twice");
+
+	zassert_equal_ptr(&dummy_conn, bt_gatt_dm_conn_get(dm_hids), "Invalid connection");
+	attr_serv = bt_gatt_dm_service_get(dm_hids);
+	serv_val  = bt_gatt_dm_attr_service_val(attr_serv);
+	zassert_true(!bt_uuid_cmp(BT_UUID_HIDS, serv_val->uuid), "Invalid service detected");
+	zassert_equal(11,
+		      bt_gatt_dm_attr_cnt(dm_hids),
+		      "Unexpected number of attributes detected: %d",
+		      bt_gatt_dm_attr_cnt(dm_hids));
+
+	zassert_equal_ptr(&dummy_conn_2, bt_gatt_dm_conn_get(dm_dis), "Invalid connection");
+	attr_serv = bt_gatt_dm_service_get(dm_dis);
+	serv_val  = bt_gatt_dm_attr_service_val(attr_serv);
+	zassert_true(!bt_uuid_cmp(BT_UUID_DIS, serv_val->uuid), "Invalid service detected");
+	zassert_equal(5,
+		      bt_gatt_dm_attr_cnt(dm_dis),
+		      "Unexpected number of attributes detected: %d",
+		      bt_gatt_dm_attr_cnt(dm_dis));
+
+	bt_gatt_dm_stats_get(dm_hids, &stats);
+	zassert_equal(11, stats.attr_cnt, "Attribute count: %d", stats.attr_cnt);
+	zassert_true(stats.chunk_cnt > 0, "No data chunks in use");
+	zassert_true(stats.data_len > 0, "No data in use");
+	zassert_equal(0, stats.nomem_cnt, "Allocation failures: %d", stats.nomem_cnt);
+
+	/* ------------------------------------------------------ */
+	/* Clean up */
+	bt_gatt_dm_data_release(dm_hids);
+	bt_gatt_dm_data_release(dm_dis);
+
+	bt_gatt_dm_stats_get(dm_hids, &stats);
+	zassert_equal(0, stats.attr_cnt, "Attribute count after clearing: %d", stats.attr_cnt);
+	zassert_equal(0, stats.chunk_cnt, "Chunk count after clearing: %d", stats.chunk_cnt);
+	zassert_equal(0, stats.data_len, "Data length after clearing: %d", stats.data_len);
+	zassert_true(stats.attr_max >= 11, "Attribute count maximum: %d", stats.attr_max);
+}
+
+#if CONFIG_BT_GATT_DM_CACHE
+
+static char bonded_conn;
+
+static const bt_addr_le_t bonded_addr = {
+	.type = BT_ADDR_LE_RANDOM,
+	.a.val = {0x01, 0x02, 0x03, 0x04, 0x05, 0xc6}
+};
+
+/* Settings key of the cached HIDS of the bonded peer */
+#define HIDS_CACHE_KEY "bt/dm/c605040302011/1218"
+
+static const uint8_t db_hash[16] = {
+	0x5a, 0x1c, 0x0e, 0x32, 0x8b, 0x74, 0x11, 0xd0,
+	0x9e, 0x27, 0x63, 0xa5, 0x40, 0xfb, 0x18, 0x86
+};
+
+static const uint8_t db_hash_changed[16] = {
+	0x5a, 0x1c, 0x0e, 0x32, 0x8b, 0x74, 0x11, 0xd0,
+	0x9e, 0x27, 0x63, 0xa5, 0x40, 0xfb, 0x18, 0x87
+};
+
+/* Runs the HIDS discovery with the bonded peer and checks if the
+ * service was discovered or loaded from the cache
+ */
+static void run_dm_hids_bonded(bool discovered)
+{
+	struct bt_gatt_dm *dm;
+	const struct bt_gatt_dm_attr *attr;
+	const struct bt_gatt_service_val *serv_val;
+	const struct bt_gatt_chrc *chrc;
+	size_t discover_cnt = bt_gatt_discover_mock_cnt_get();
+
+	dm = run_dm_conn((struct bt_conn *)&bonded_conn, BT_UUID_HIDS);
+	zassert_not_null(dm, "Device Manager pointer not set");
+	zassert_equal(discovered,
+		      discover_cnt != bt_gatt_discover_mock_cnt_get(),
+		      "Unexpected discovery");
+
+	zassert_equal(11,
+		      bt_gatt_dm_attr_cnt(dm),
+		      "Unexpected number of attributes detected: %d",
+		      bt_gatt_dm_attr_cnt(dm));
+
+	serv_val = bt_gatt_dm_attr_service_val(bt_gatt_dm_service_get(dm));
+	zassert_not_null(serv_val, "Invalid service attribute");
+	zassert_true(!bt_uuid_cmp(BT_UUID_HIDS, serv_val->uuid), "Invalid service detected");
+	zassert_equal(11, serv_val->end_handle, "Invalid end handle");
+
+	attr = NULL;
+	for (int i = 2; i <= 11; ++i) {
+		attr = bt_gatt_dm_attr_next(dm, attr);
+		zassert_not_null(attr, "Attr handle: %d", i);
+		zassert_equal(i, attr->handle, "Attr handle: %d", i);
+	}
+
+	attr = bt_gatt_dm_char_by_uuid(dm, BT_UUID_HIDS_REPORT);
+	zassert_not_null(attr, "Characteristic not found");
+	zassert_equal(6, attr->handle, "Invalid characteristic handle");
+	chrc = bt_gatt_dm_attr_chrc_val(attr);
+	zassert_equal(BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY,
+		      chrc->properties,
+		      "Invalid characteristic properties");
+
+	attr = bt_gatt_dm_desc_by_uuid(dm, attr, BT_UUID_GATT_CCC);
+	zassert_not_null(attr, "Descriptor not found");
+	zassert_equal(8, attr->handle, "Invalid descriptor handle");
+
+	bt_gatt_dm_data_release(dm);
+}
+
+void test_gatt_cache(void)
+{
+	run_dm_hids_bonded(true);
+	run_dm_hids_bonded(false);
+	run_dm_hids_bonded(false);
+}
+
+void test_gatt_cache_other_service(void)
+{
+	struct bt_gatt_dm *dm;
+	size_t discover_cnt;
+
+	run_dm_hids_bonded(true);
+
+	discover_cnt = bt_gatt_discover_mock_cnt_get();
+	dm = run_dm_conn((struct bt_conn *)&bonded_conn, BT_UUID_DIS);
+	zassert_not_null(dm, "Device Manager pointer not set");
+	zassert_not_equal(discover_cnt, bt_gatt_discover_mock_cnt_get(),
+			  "Service not discovered");
+	zassert_equal(5,
+		      bt_gatt_dm_attr_cnt(dm),
+		      "Unexpected number of attributes detected: %d",
+		      bt_gatt_dm_attr_cnt(dm));
+	bt_gatt_dm_data_release(dm);
+
+	run_dm_hids_bonded(false);
+}
+
+void test_gatt_cache_continue(void)
+{
+	struct bt_gatt_dm *dm;
+	size_t discover_cnt;
+
+	run_dm_hids_bonded(true);
+
+	discover_cnt = bt_gatt_discover_mock_cnt_get();
+	dm = run_dm_conn((struct bt_conn *)&bonded_conn, BT_UUID_HIDS);
+	zassert_not_null(dm, "Device Manager pointer not set");
+	zassert_equal(discover_cnt, bt_gatt_discover_mock_cnt_get(),
+		      "Service not loaded from the cache");
+
+	/* The discovery continues after the cached service */
+	dm = run_dm_next(dm);
+	zassert_not_null(dm, "Device Manager pointer not set");
+	zassert_equal(5,
+		      bt_gatt_dm_attr_cnt(dm),
+		      "Unexpected number of attributes detected: %d",
+		      bt_gatt_dm_attr_cnt(dm));
+	zassert_true(!bt_uuid_cmp(BT_UUID_DIS,
+				  bt_gatt_dm_attr_service_val(
+					bt_gatt_dm_service_get(dm))->uuid),
+		     "Invalid service detected");
+	bt_gatt_dm_data_release(dm);
+}
+
+void test_gatt_cache_db_changed(void)
+{
+	run_dm_hids_bonded(true);
+
+	bt_gatt_discover_mock_db_hash_setup(db_hash_changed);
+	run_dm_hids_bonded(true);
+	run_dm_hids_bonded(false);
+}
+
+void test_gatt_cache_no_db_hash(void)
+{
+	bt_gatt_discover_mock_db_hash_setup(NULL);
+	run_dm_hids_bonded(true);
+	run_dm_hids_bonded(true);
+}
+
+void test_gatt_cache_not_bonded(void)
+{
+	struct bt_gatt_dm *dm;
+	size_t discover_cnt;
+
+	run_dm_hids_bonded(true);
+
+	/* The peer of dummy_conn is not bonded */
+	for (int i = 0; i < 2; ++i) {
+		discover_cnt = bt_gatt_discover_mock_cnt_get();
+		dm = run_dm(BT_UUID_HIDS);
+		zassert_not_null(dm, "Device Manager pointer not set");
+		zassert_not_equal(discover_cnt, bt_gatt_discover_mock_cnt_get(),
+				  "Service not discovered");
+		bt_gatt_dm_data_release(dm);
+	}
+}
+
+void test_gatt_cache_clear(void)
+{
+	int err;
+
+	run_dm_hids_bonded(true);
+	run_dm_hids_bonded(false);
+
+	err = bt_gatt_dm_cache_clear(&bonded_addr);
+	zassert_equal(0, err, "Cache clear failed: %d", err);
+
+	run_dm_hids_bonded(true);
+	run_dm_hids_bonded(false);
+}
+
+void test_gatt_cache_invalid(void)
+{
+	int err;
+	uint8_t entry[1 + sizeof(db_hash) + 12];
+	/* The HIDS declaration followed by a truncated attribute */
+	static const uint8_t attrs[] = {
+		0x01, 0x00, 0x00, 0x02, 0x00, 0x28, 0x02, 0x12, 0x18, 0x0b, 0x00,
+		0x02
+	};
+
+	BUILD_ASSERT(sizeof(entry) == 1 + sizeof(db_hash) + sizeof(attrs));
+
+	entry[0] = 1;
+	memcpy(&entry[1], db_hash, sizeof(db_hash));
+	memcpy(&entry[1 + sizeof(db_hash)], attrs, sizeof(attrs));
+
+	err = settings_save_one(HIDS_CACHE_KEY, entry, sizeof(entry));
+	zassert_equal(0, err, "Settings save failed: %d", err);
+
+	run_dm_hids_bonded(true);
+	run_dm_hids_bonded(false);
+}
+
+void test_cache_setup(void)
+{
+	int err;
+
+	test_setup();
+
+	err = settings_subsys_init();
+	zassert_equal(0, err, "Settings init failed: %d", err);
+
+	err = bt_gatt_dm_cache_clear(&bonded_addr);
+	zassert_equal(0, err, "Cache clear failed: %d", err);
+
+	bt_gatt_discover_mock_bond_setup((struct bt_conn *)&bonded_conn,
+					 &bonded_addr);
+	bt_gatt_discover_mock_db_hash_setup(db_hash);
+}
+
+#endif /* CONFIG_BT_GATT_DM_CACHE */
+
 void test_main(void)
 {
 	ztest_test_suite(
@@ -387,8 +688,25 @@ void test_main(void)
 		ztest_unit_test_setup_teardown(test_gatt_HIDS_attr_by_handle, test_setup, unit_test_noop),
 		ztest_unit_test_setup_teardown(test_gatt_HIDS_next_chrc_access, test_setup, unit_test_noop),
 		ztest_unit_test_setup_teardown(test_gatt_HIDS_chrc_by_uuid, test_setup, unit_test_noop),
-		ztest_unit_test_setup_teardown(test_gatt_generic_serv, test_setup, unit_test_noop)
+		ztest_unit_test_setup_teardown(test_gatt_generic_serv, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_gatt_concurrent, test_setup, unit_test_noop)
 	);
 
 	ztest_run_test_suite(test_gatt);
+
+#if CONFIG_BT_GATT_DM_CACHE
+	ztest_test_suite(
+		test_gatt_dm_cache,
+		ztest_unit_test_setup_teardown(test_gatt_cache, test_cache_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_gatt_cache_other_service, test_cache_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_gatt_cache_continue, test_cache_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_gatt_cache_db_changed, test_cache_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_gatt_cache_no_db_hash, test_cache_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_gatt_cache_not_bonded, test_cache_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_gatt_cache_clear, test_cache_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_gatt_cache_invalid, test_cache_setup, unit_test_noop)
+	);
+
+	ztest_run_test_suite(test_gatt_dm_cache);
+#endif
 }
@@ -0,0 +1,535 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <zephyr.h>
+#include <string.h>
+#include <sys/util.h>
+#include <bluetooth/hci.h>
+#include <bluetooth/conn.h>
+#include <bluetooth/gatt.h>
+#include <bluetooth/services/nus.h>
+
+/* Size of the data written by a UART at a time in the benchmark. */
+#define BENCHMARK_CHUNK_LEN	20
+#define BENCHMARK_LEN		(64 * 1024)
+
+#define MTU_MIN			23
+#define MTU_MAX			(CONFIG_BT_L2CAP_TX_MTU)
+#define RX_BUF_SIZE		(4 * CONFIG_BT_NUS_STREAM_BUF_SIZE)
+#define NOTIF_LEN_MAX		32
+
+struct notif {
+	struct bt_conn *conn;
+	bt_gatt_complete_func_t func;
+	void *user_data;
+};
+
+static char dummy_conn;
+static struct bt_conn *conn = (struct bt_conn *)&dummy_conn;
+static struct bt_conn_cb *conn_cb;
+/* References to the connection, kept across the tests */
+static int conn_refs;
+
+static struct {
+	uint16_t mtu;
+	bool subscribed;
+	bool auto_complete;
+	size_t err_cnt;
+	int err;
+	struct notif pending[CONFIG_BT_NUS_STREAM_TX_MAX];
+	size_t pending_cnt;
+	size_t pending_max;
+	uint16_t notif_len[NOTIF_LEN_MAX];
+	size_t notif_cnt;
+	uint8_t rx[RX_BUF_SIZE];
+	size_t rx_len;
+	bool rx_counted_only;
+} mock;
+
+static uint8_t tx_data[RX_BUF_SIZE];
+
+void __wrap_bt_conn_cb_register(struct bt_conn_cb *cb)
+{
+	conn_cb = cb;
+}
+
+uint8_t __wrap_bt_conn_index(struct bt_conn *c)
+{
+	return 0;
+}
+
+struct bt_conn *__wrap_bt_conn_ref(struct bt_conn *c)
+{
+	zassert_equal_ptr(c, conn, "Reference to wrong connection");
+	conn_refs++;
+
+	return c;
+}
+
+void __wrap_bt_conn_unref(struct bt_conn *c)
+{
+	zassert_equal_ptr(c, conn, "Reference to wrong connection");
+	zassert_true(conn_refs > 0, "Connection not referenced");
+	conn_refs--;
+}
+
+uint16_t __wrap_bt_gatt_get_mtu(struct bt_conn *c)
+{
+	return mock.mtu;
+}
+
+bool __wrap_bt_gatt_is_subscribed(struct bt_conn *c,
+				  const struct bt_gatt_attr *attr,
+				  uint16_t ccc_value)
+{
+	return mock.subscribed;
+}
+
+int __wrap_bt_gatt_notify_cb(struct bt_conn *c,
+			     struct bt_gatt_notify_params *params)
+{
+	zassert_equal_ptr(c, conn, "Notification to wrong connection");
+	zassert_true(params->len <= mock.mtu - 3,
+		     "Notification longer than ATT MTU");
+	zassert_not_null(params->func, "No sent callback");
+
+	if (mock.err_cnt) {
+		mock.err_cnt--;
+		return mock.err;
+	}
+
+	if (mock.notif_cnt < ARRAY_SIZE(mock.notif_len)) {
+		mock.notif_len[mock.notif_cnt] = params->len;
+	}
+	mock.notif_cnt++;
+
+	if (!mock.rx_counted_only) {
+		zassert_true(mock.rx_len + params->len <= sizeof(mock.rx),
+			     "Too much data notified");
+		memcpy(&mock.rx[mock.rx_len], params->data, params->len);
+	}
+	mock.rx_len += params->len;
+
+	if (mock.auto_complete) {
+		params->func(c, params->user_data);
+		return 0;
+	}
+
+	zassert_true(mock.pending_cnt < ARRAY_SIZE(mock.pending),
+		     "Too many notifications in flight");
+
+	mock.pending[mock.pending_cnt].conn = c;
+	mock.pending[mock.pending_cnt].func = params->func;
+	mock.pending[mock.pending_cnt].user_data = params->user_data;
+	mock.pending_cnt++;
+	mock.pending_max = MAX(mock.pending_max, mock.pending_cnt);
+
+	return 0;
+}
+
+/* Lets the system workqueue send the stream data. */
+static void stream_flush(void)
+{
+	k_sleep(K_MSEC(20));
+}
+
+/* Completes the notifications in flight, as the Bluetooth stack does when
+ * they are sent.
+ */
+static void pending_complete(void)
+{
+	size_t cnt = mock.pending_cnt;
+
+	mock.pending_cnt = 0;
+
+	for (size_t i = 0; i < cnt; i++) {
+		mock.pending[i].func(mock.pending[i].conn,
+				     mock.pending[i].user_data);
+	}
+}
+
+static void notif_complete(void)
+{
+	pending_complete();
+	stream_flush();
+}
+
+/* The notifications are completed periodically from the system workqueue,
+ * which also sends them.
+ */
+static void complete_work_handler(struct k_work *work)
+{
+	pending_complete();
+}
+
+static K_WORK_DEFINE(complete_work, complete_work_handler);
+
+static void complete_timer_handler(struct k_timer *timer)
+{
+	k_work_submit(&complete_work);
+}
+
+static K_TIMER_DEFINE(complete_timer, complete_timer_handler, NULL);
+
+static void rx_check(size_t len)
+{
+	zassert_equal(mock.rx_len, len, "Wrong amount of data notified");
+	zassert_mem_equal(mock.rx, tx_data, len, "Wrong data notified");
+}
+
+static void stats_check(size_t bytes, size_t notif)
+{
+	struct bt_nus_stream_stats stats;
+	int err;
+
+	err = bt_nus_stream_stats_get(conn, &stats);
+	zassert_equal(err, 0, "Failed to get stream statistics");
+	zassert_equal(stats.tx_bytes, bytes, "Wrong number of bytes");
+	zassert_equal(stats.tx_notif, notif,
+		      "Wrong number of notifications");
+}
+
+static void test_not_subscribed(void)
+{
+	int ret;
+
+	mock.subscribed = false;
+
+	ret = bt_nus_stream_write(conn, tx_data, 10, K_NO_WAIT);
+	zassert_equal(ret, -EINVAL, "Data written without subscription");
+
+	ret = bt_nus_stream_write(NULL, tx_data, 10, K_NO_WAIT);
+	zassert_equal(ret, -EINVAL, "Data written without connection");
+
+	stream_flush();
+	zassert_equal(mock.notif_cnt, 0, "Data notified");
+}
+
+static void test_packing(void)
+{
+	const size_t len = 100;
+	int ret;
+
+	mock.mtu = MTU_MIN;
+
+	ret = bt_nus_stream_write(conn, tx_data, len, K_NO_WAIT);
+	zassert_equal(ret, len, "Data not written");
+
+	stream_flush();
+	zassert_equal(mock.notif_cnt, CONFIG_BT_NUS_STREAM_TX_MAX,
+		      "Wrong number of notifications in flight");
+
+	while (mock.pending_cnt) {
+		notif_complete();
+	}
+
+	zassert_equal(mock.pending_max, CONFIG_BT_NUS_STREAM_TX_MAX,
+		      "Wrong number of notifications in flight");
+	zassert_equal(mock.notif_cnt, len / (MTU_MIN - 3),
+		      "Data not packed in notifications");
+	for (size_t i = 0; i < mock.notif_cnt; i++) {
+		zassert_equal(mock.notif_len[i], MTU_MIN - 3,
+			      "Notification not filled");
+	}
+
+	rx_check(len);
+	stats_check(len, len / (MTU_MIN - 3));
+}
+
+static void test_wrap(void)
+{
+	const size_t len = CONFIG_BT_NUS_STREAM_BUF_SIZE / 2 + 8;
+	int ret;
+
+	mock.mtu = MTU_MAX;
+	mock.auto_complete = true;
+
+	/* The second write wraps around the end of the stream buffer. */
+	for (size_t i = 0; i < 2; i++) {
+		ret = bt_nus_stream_write(conn, &tx_data[i * len], len,
+					  K_NO_WAIT);
+		zassert_equal(ret, len, "Data not written");
+		stream_flush();
+	}
+
+	rx_check(2 * len);
+	for (size_t i = 0; i < mock.notif_cnt; i++) {
+		zassert_true((mock.notif_len[i] == MTU_MAX - 3) ||
+			     (mock.notif_len[i] == len % (MTU_MAX - 3)),
+			     "Notification not filled");
+	}
+}
+
+static void test_backpressure(void)
+{
+	const size_t len = 2 * CONFIG_BT_NUS_STREAM_BUF_SIZE;
+	struct bt_nus_stream_stats stats;
+	size_t written;
+	int ret;
+
+	mock.mtu = MTU_MIN;
+
+	ret = bt_nus_stream_write(conn, tx_data, len, K_NO_WAIT);
+	zassert_true(ret > CONFIG_BT_NUS_STREAM_BUF_SIZE / 2,
+		     "Data not written");
+	zassert_true(ret < len, "Stream buffer not full");
+	written = ret;
+
+	/* No notification is sent, so no space is freed. */
+	stream_flush();
+	ret = bt_nus_stream_write(conn, &tx_data[written], len - written,
+				  K_MSEC(50));
+	zassert_true(ret < len - written, "Stream buffer not full");
+	written += ret;
+
+	bt_nus_stream_stats_get(conn, &stats);
+	zassert_true(stats.buf_full >= 2, "Full stream buffer not counted");
+
+	/* The producer waits for the data to be sent. */
+	mock.auto_complete = true;
+	notif_complete();
+
+	ret = bt_nus_stream_write(conn, &tx_data[written], len - written,
+				  K_FOREVER);
+	zassert_equal(ret, len - written, "Data not written");
+	stream_flush();
+
+	rx_check(len);
+	zassert_true(mock.pending_max <= CONFIG_BT_NUS_STREAM_TX_MAX,
+		     "Too many notifications in flight");
+}
+
+static void test_timeout(void)
+{
+	const size_t len = 2 * CONFIG_BT_NUS_STREAM_BUF_SIZE;
+	int64_t start;
+	int64_t elapsed;
+	int ret;
+
+	mock.mtu = MTU_MIN;
+
+	ret = bt_nus_stream_write(conn, tx_data, CONFIG_BT_NUS_STREAM_BUF_SIZE,
+				  K_NO_WAIT);
+	zassert_equal(ret, CONFIG_BT_NUS_STREAM_BUF_SIZE, "Data not written");
+	stream_flush();
+
+	/* Space is freed regularly, but too slowly for all the data to be
+	 * written before the timeout.
+	 */
+	k_timer_start(&complete_timer, K_MSEC(5), K_MSEC(5));
+
+	start = k_uptime_get();
+	ret = bt_nus_stream_write(conn, tx_data, len, K_MSEC(50));
+	elapsed = k_uptime_get() - start;
+
+	k_timer_stop(&complete_timer);
+	stream_flush();
+
+	zassert_true(ret > 0, "Freed space not used");
+	zassert_true(ret < len, "Stream buffer not full");
+	zassert_true(elapsed < 100, "Timeout restarted by each wait");
+}
+
+static void test_retry(void)
+{
+	static const int errors[] = {-ENOMEM, -ENOBUFS, -EAGAIN};
+	const size_t len = 40;
+	struct bt_nus_stream_stats stats;
+	int ret;
+
+	mock.mtu = MTU_MAX;
+	mock.auto_complete = true;
+
+	for (size_t i = 0; i < ARRAY_SIZE(errors); i++) {
+		mock.err = errors[i];
+		mock.err_cnt = 2;
+
+		ret = bt_nus_stream_write(conn, &tx_data[i * len], len,
+					  K_NO_WAIT);
+		zassert_equal(ret, len, "Data not written");
+
+		k_sleep(K_MSEC(100));
+		zassert_equal(mock.rx_len, (i + 1) * len,
+			      "Data not sent after error %d", errors[i]);
+	}
+
+	rx_check(ARRAY_SIZE(errors) * len);
+	bt_nus_stream_stats_get(conn, &stats);
+	zassert_equal(stats.tx_retries, 2 * ARRAY_SIZE(errors),
+		      "Retries not counted");
+	zassert_equal(stats.tx_notif, ARRAY_SIZE(errors),
+		      "Wrong number of notifications");
+}
+
+static void test_unsubscribed(void)
+{
+	int ret;
+
+	mock.mtu = MTU_MIN;
+
+	ret = bt_nus_stream_write(conn, tx_data, 100, K_NO_WAIT);
+	zassert_equal(ret, 100, "Data not written");
+	stream_flush();
+
+	/* The data that is not sent is dropped. */
+	mock.subscribed = false;
+	notif_complete();
+	zassert_equal(mock.notif_cnt, CONFIG_BT_NUS_STREAM_TX_MAX,
+		      "Data notified without subscription");
+
+	mock.subscribed = true;
+	mock.auto_complete = true;
+
+	ret = bt_nus_stream_write(conn, tx_data, 10, K_NO_WAIT);
+	zassert_equal(ret, 10, "Data not written");
+	stream_flush();
+
+	zassert_equal(mock.notif_cnt, CONFIG_BT_NUS_STREAM_TX_MAX + 1,
+		      "Data not notified");
+	zassert_equal(mock.notif_len[CONFIG_BT_NUS_STREAM_TX_MAX], 10,
+		      "Dropped data notified");
+}
+
+static void test_disconnect(void)
+{
+	struct bt_nus_stream_stats stats;
+	int ret;
+
+	mock.mtu = MTU_MIN;
+
+	ret = bt_nus_stream_write(conn, tx_data, 100, K_NO_WAIT);
+	zassert_equal(ret, 100, "Data not written");
+	stream_flush();
+	zassert_equal(conn_refs, 1, "Connection not referenced");
+
+	conn_cb->disconnected(conn, BT_HCI_ERR_REMOTE_USER_TERM_CONN);
+	stream_flush();
+	zassert_equal(conn_refs, 0, "Connection reference not released");
+
+	bt_nus_stream_stats_get(conn, &stats);
+	zassert_equal(stats.tx_bytes, 0, "Statistics not cleared");
+	zassert_equal(stats.tx_notif, 0, "Statistics not cleared");
+
+	/* The notifications in flight complete after the disconnection. */
+	notif_complete();
+	zassert_equal(mock.notif_cnt, CONFIG_BT_NUS_STREAM_TX_MAX,
+		      "Data notified after disconnection");
+
+	/* The stream is empty on the next connection. */
+	memset(&mock.rx, 0, sizeof(mock.rx));
+	mock.rx_len = 0;
+	mock.notif_cnt = 0;
+	mock.pending_max = 0;
+
+	ret = bt_nus_stream_write(conn, tx_data, 100, K_NO_WAIT);
+	zassert_equal(ret, 100, "Data not written");
+	stream_flush();
+
+	while (mock.pending_cnt) {
+		notif_complete();
+	}
+
+	rx_check(100);
+	zassert_equal(mock.pending_max, CONFIG_BT_NUS_STREAM_TX_MAX,
+		      "Wrong number of notifications in flight");
+	stats_check(100, 5);
+}
+
+static void test_benchmark(void)
+{
+	struct bt_nus_stream_stats stats;
+	uint32_t start;
+	uint32_t cycles;
+	int ret;
+
+	mock.mtu = MTU_MAX;
+	mock.auto_complete = true;
+	mock.rx_counted_only = true;
+
+	start = k_cycle_get_32();
+
+	for (size_t i = 0; i < BENCHMARK_LEN; i += BENCHMARK_CHUNK_LEN) {
+		size_t offset = i % (sizeof(tx_data) - BENCHMARK_CHUNK_LEN);
+
+		ret = bt_nus_stream_write(conn, &tx_data[offset],
+					  BENCHMARK_CHUNK_LEN, K_FOREVER);
+		zassert_equal(ret, BENCHMARK_CHUNK_LEN, "Data not written");
+	}
+
+	stream_flush();
+	cycles = k_cycle_get_32() - start;
+
+	bt_nus_stream_stats_get(conn, &stats);
+	zassert_equal(stats.tx_bytes, mock.rx_len, "Wrong number of bytes");
+	zassert_true(stats.tx_bytes >= BENCHMARK_LEN, "Data not sent");
+
+	/* The data is not sent in notifications of the UART chunk size. */
+	zassert_true(stats.tx_bytes / stats.tx_notif > (MTU_MAX - 3) / 2,
+		     "Data not packed in notifications");
+
+	TC_PRINT("%u bytes in %u notifications instead of %u\n",
+		 stats.tx_bytes, stats.tx_notif,
+		 stats.tx_bytes / BENCHMARK_CHUNK_LEN);
+	TC_PRINT("%u cycles per kB\n",
+		 (uint32_t)((uint64_t)cycles * 1024 / stats.tx_bytes));
+}
+
+/* Resets the stream, as on a new connection. */
+static void test_setup(void)
+{
+	int err;
+
+	err = bt_nus_init(NULL);
+	zassert_equal(err, 0, "Failed to initialize NUS");
+	zassert_not_null(conn_cb, "Connection callbacks not registered");
+
+	memset(&mock, 0, sizeof(mock));
+	conn_cb->disconnected(conn, BT_HCI_ERR_REMOTE_USER_TERM_CONN);
+	stream_flush();
+
+	mock.mtu = MTU_MIN;
+	mock.subscribed = true;
+}
+
+void test_main(void)
+{
+	for (size_t i = 0; i < sizeof(tx_data); i++) {
+		tx_data[i] = i % 251;
+	}
+
+	ztest_test_suite(bt_nus_stream_test,
+		ztest_unit_test_setup_teardown(test_not_subscribed,
+					       test_setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_packing,
+					       test_setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_wrap,
+					       test_setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_backpressure,
+					       test_setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_timeout,
+					       test_setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_retry,
+					       test_setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_unsubscribed,
+					       test_setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_disconnect,
+					       test_setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_benchmark,
+					       test_setup,
+					       unit_test_noop)
+	);
+
+	ztest_run_test_suite(bt_nus_stream_test);
+}
@@ -0,0 +1,561 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <zephyr.h>
+#include <string.h>
+#include <sys/util.h>
+#include <sys/byteorder.h>
+#include <bluetooth/bluetooth.h>
+#include <bluetooth/uuid.h>
+#include <bluetooth/scan.h>
+
+/* Number of advertisers in the benchmark, a quarter of them match a filter. */
+#define BENCHMARK_DEVICE_CNT	64
+#define BENCHMARK_ROUNDS	100
+
+#define AD_MAX_LEN		31
+
+struct adv_report {
+	bt_addr_le_t addr;
+	uint8_t adv_type;
+	int8_t rssi;
+	uint8_t data[AD_MAX_LEN];
+	uint8_t len;
+};
+
+static struct bt_le_scan_cb *scan_cb;
+
+static struct bt_scan_filter_match last_match;
+static size_t match_cnt;
+static size_t no_match_cnt;
+
+static struct bt_scan_rssi_stats last_rssi_stats;
+static bool last_rssi_valid;
+
+/* The scanning module registers its callback in bt_scan_init(). */
+void __wrap_bt_le_scan_cb_register(struct bt_le_scan_cb *cb)
+{
+	scan_cb = cb;
+}
+
+static void scan_filter_match(struct bt_scan_device_info *device_info,
+			      struct bt_scan_filter_match *filter_match,
+			      bool connectable)
+{
+	last_match = *filter_match;
+	match_cnt++;
+}
+
+static void scan_filter_no_match(struct bt_scan_device_info *device_info,
+				 bool connectable)
+{
+	last_rssi_valid = (device_info->rssi_stats != NULL);
+	if (last_rssi_valid) {
+		last_rssi_stats = *device_info->rssi_stats;
+	}
+
+	no_match_cnt++;
+}
+
+BT_SCAN_CB_INIT(scan_cb_data, scan_filter_match, scan_filter_no_match,
+		NULL, NULL);
+
+static void addr_set(bt_addr_le_t *addr, uint8_t n)
+{
+	addr->type = BT_ADDR_LE_RANDOM;
+	memset(addr->a.val, 0xc0, sizeof(addr->a.val));
+	addr->a.val[0] = n;
+}
+
+static void report_ad_add(struct adv_report *report, uint8_t type,
+			  const void *data, uint8_t len)
+{
+	zassert_true(report->len + len + 2 <= sizeof(report->data),
+		     "Advertising data too long");
+
+	report->data[report->len++] = len + 1;
+	report->data[report->len++] = type;
+	memcpy(&report->data[report->len], data, len);
+	report->len += len;
+}
+
+static void report_send(const struct adv_report *report)
+{
+	struct net_buf_simple ad;
+	struct bt_le_scan_recv_info info = {
+		.addr = &report->addr,
+		.adv_type = report->adv_type,
+		.rssi = report->rssi,
+		.adv_props = BT_GAP_ADV_PROP_CONNECTABLE,
+	};
+
+	net_buf_simple_init_with_data(&ad, (void *)report->data, report->len);
+
+	scan_cb->recv(&info, &ad);
+}
+
+/* Sends a report and returns true if it matched the filters. */
+static bool report_match(const struct adv_report *report)
+{
+	size_t cnt = match_cnt;
+
+	memset(&last_match, 0, sizeof(last_match));
+	report_send(report);
+
+	return match_cnt != cnt;
+}
+
+/* Sends a report and returns true if it generated an event. */
+static bool report_notified(const struct adv_report *report)
+{
+	size_t cnt = match_cnt + no_match_cnt;
+
+	report_send(report);
+
+	return (match_cnt + no_match_cnt) != cnt;
+}
+
+static void filter_add(enum bt_scan_filter_type type, const void *data)
+{
+	int err;
+
+	err = bt_scan_filter_add(type, data);
+	zassert_equal(0, err, "Return value %d is wrong", err);
+}
+
+static void filter_enable(uint8_t mode, bool match_all)
+{
+	int err;
+
+	err = bt_scan_filter_enable(mode, match_all);
+	zassert_equal(0, err, "Return value %d is wrong", err);
+}
+
+static void test_name(void)
+{
+	struct adv_report report = {0};
+	struct bt_scan_short_name short_name = {
+		.name = "Nordic_Blinky",
+		.min_len = 6,
+	};
+
+	filter_add(BT_SCAN_FILTER_TYPE_NAME, "Nordic_HRM");
+	filter_add(BT_SCAN_FILTER_TYPE_NAME, "Nordic_UART");
+	filter_add(BT_SCAN_FILTER_TYPE_SHORT_NAME, &short_name);
+	filter_enable(BT_SCAN_NAME_FILTER | BT_SCAN_SHORT_NAME_FILTER, false);
+
+	report_ad_add(&report, BT_DATA_NAME_COMPLETE, "Nordic_UART", 11);
+	zassert_true(report_match(&report), "Name not matched");
+	zassert_true(last_match.name.match, "Name not matched");
+	zassert_equal(strcmp(last_match.name.name, "Nordic_UART"), 0,
+		      "Wrong name matched");
+
+	memset(&report, 0, sizeof(report));
+	report_ad_add(&report, BT_DATA_NAME_COMPLETE, "Nordic_LBS", 10);
+	zassert_false(report_match(&report), "Name matched");
+
+	memset(&report, 0, sizeof(report));
+	report_ad_add(&report, BT_DATA_NAME_SHORTENED, "Nordic_B", 8);
+	zassert_true(report_match(&report), "Short name not matched");
+	zassert_true(last_match.short_name.match, "Short name not matched");
+
+	/* Shorter than the minimum length of the filter. */
+	memset(&report, 0, sizeof(report));
+	report_ad_add(&report, BT_DATA_NAME_SHORTENED, "Nord", 4);
+	zassert_false(report_match(&report), "Short name matched");
+}
+
+static void test_addr(void)
+{
+	struct adv_report report = {0};
+	bt_addr_le_t addr;
+
+	for (uint8_t n = 0; n < CONFIG_BT_SCAN_ADDRESS_CNT; n++) {
+		addr_set(&addr, 2 * n);
+		filter_add(BT_SCAN_FILTER_TYPE_ADDR, &addr);
+	}
+
+	filter_enable(BT_SCAN_ADDR_FILTER, false);
+
+	addr_set(&report.addr, 6);
+	zassert_true(report_match(&report), "Address not matched");
+	zassert_true(last_match.addr.match, "Address not matched");
+	zassert_equal(bt_addr_le_cmp(last_match.addr.addr, &report.addr), 0,
+		      "Wrong address matched");
+
+	addr_set(&report.addr, 7);
+	zassert_false(report_match(&report), "Address matched");
+
+	/* Same address of another type. */
+	addr_set(&report.addr, 6);
+	report.addr.type = BT_ADDR_LE_PUBLIC;
+	zassert_false(report_match(&report), "Address matched");
+
+	addr_set(&addr, 1);
+	zassert_equal(bt_scan_filter_add(BT_SCAN_FILTER_TYPE_ADDR, &addr),
+		      -ENOMEM, "Filter added");
+}
+
+static void test_uuid(void)
+{
+	struct adv_report report = {0};
+	/* Heart Rate Service in 128-bit form, little endian. */
+	const uint8_t hrs_128[] = {
+		0xfb, 0x34, 0x9b, 0x5f, 0x80, 0x00, 0x00, 0x80,
+		0x00, 0x10, 0x00, 0x00, 0x0d, 0x18, 0x00, 0x00
+	};
+	const uint8_t bas_dis[] = {0x0f, 0x18, 0x0a, 0x18};
+	const uint8_t hrs_bas[] = {0x0d, 0x18, 0x0f, 0x18};
+
+	filter_add(BT_SCAN_FILTER_TYPE_UUID, BT_UUID_HRS);
+	filter_add(BT_SCAN_FILTER_TYPE_UUID, BT_UUID_BAS);
+	filter_enable(BT_SCAN_UUID_FILTER, false);
+
+	report_ad_add(&report, BT_DATA_UUID128_ALL, hrs_128, sizeof(hrs_128));
+	zassert_true(report_match(&report), "UUID not matched");
+	zassert_equal(last_match.uuid.count, 1, "Wrong UUID count");
+	zassert_equal(bt_uuid_cmp(last_match.uuid.uuid[0], BT_UUID_HRS), 0,
+		      "Wrong UUID matched");
+
+	/* Both UUIDs must be found with all the filters. */
+	filter_enable(BT_SCAN_UUID_FILTER, true);
+	zassert_false(report_match(&report), "UUID matched");
+
+	memset(&report, 0, sizeof(report));
+	report_ad_add(&report, BT_DATA_UUID16_SOME, bas_dis, sizeof(bas_dis));
+	zassert_false(report_match(&report), "UUID matched");
+
+	/* The UUIDs must be found in the same field. */
+	memset(&report, 0, sizeof(report));
+	report_ad_add(&report, BT_DATA_UUID16_ALL, &hrs_bas[0], 2);
+	report_ad_add(&report, BT_DATA_UUID16_SOME, &hrs_bas[2], 2);
+	zassert_false(report_match(&report), "UUIDs of two fields matched");
+
+	memset(&report, 0, sizeof(report));
+	report_ad_add(&report, BT_DATA_UUID16_ALL, hrs_bas, sizeof(hrs_bas));
+	zassert_true(report_match(&report), "UUIDs not matched");
+	zassert_equal(last_match.uuid.count, 2, "Wrong UUID count");
+}
+
+static void test_manufacturer_data(void)
+{
+	struct adv_report report = {0};
+	uint8_t company[] = {0x59, 0x00};
+	uint8_t beacon[] = {0x59, 0x00, 0x02, 0x15};
+	const uint8_t data[] = {0x59, 0x00, 0x02, 0x15, 0x01, 0x02};
+	struct bt_scan_manufacturer_data filter = {
+		.data = beacon,
+		.data_len = sizeof(beacon),
+	};
+
+	filter_add(BT_SCAN_FILTER_TYPE_MANUFACTURER_DATA, &filter);
+	filter.data = company;
+	filter.data_len = sizeof(company);
+	filter_add(BT_SCAN_FILTER_TYPE_MANUFACTURER_DATA, &filter);
+	filter_enable(BT_SCAN_MANUFACTURER_DATA_FILTER, false);
+
+	/* The first filter that the data starts with is matched. */
+	report_ad_add(&report, BT_DATA_MANUFACTURER_DATA, data, sizeof(data));
+	zassert_true(report_match(&report), "Data not matched");
+	zassert_equal(last_match.manufacturer_data.len, sizeof(beacon),
+		      "Wrong data matched");
+
+	memset(&report, 0, sizeof(report));
+	report_ad_add(&report, BT_DATA_MANUFACTURER_DATA, data, 3);
+	zassert_true(report_match(&report), "Data not matched");
+	zassert_equal(last_match.manufacturer_data.len, sizeof(company),
+		      "Wrong data matched");
+
+	memset(&report, 0, sizeof(report));
+	report_ad_add(&report, BT_DATA_MANUFACTURER_DATA, data, 1);
+	zassert_false(report_match(&report), "Data matched");
+}
+
+static void test_remove_all(void)
+{
+	struct adv_report report = {0};
+
+	filter_add(BT_SCAN_FILTER_TYPE_NAME, "Nordic_HRM_long_name");
+	bt_scan_filter_remove_all();
+	filter_add(BT_SCAN_FILTER_TYPE_NAME, "Nordic");
+	filter_enable(BT_SCAN_NAME_FILTER, false);
+
+	/* Nothing is left of the removed filter. */
+	report_ad_add(&report, BT_DATA_NAME_COMPLETE, "Nordic_HRM", 10);
+	zassert_false(report_match(&report), "Removed name matched");
+
+	memset(&report, 0, sizeof(report));
+	report_ad_add(&report, BT_DATA_NAME_COMPLETE, "Nordic", 6);
+	zassert_true(report_match(&report), "Name not matched");
+}
+
+static void test_multifilter(void)
+{
+	struct adv_report report = {0};
+	uint16_t appearance = 0x03c1;
+	uint8_t appearance_data[sizeof(appearance)];
+
+	addr_set(&report.addr, 1);
+	filter_add(BT_SCAN_FILTER_TYPE_ADDR, &report.addr);
+	filter_add(BT_SCAN_FILTER_TYPE_NAME, "Nordic_HIDS");
+	filter_add(BT_SCAN_FILTER_TYPE_APPEARANCE, &appearance);
+	filter_enable(BT_SCAN_ADDR_FILTER | BT_SCAN_NAME_FILTER |
+		      BT_SCAN_APPEARANCE_FILTER, true);
+
+	report_ad_add(&report, BT_DATA_NAME_COMPLETE, "Nordic_HIDS", 11);
+	zassert_false(report_match(&report), "Matched without appearance");
+
+	/* The scanning module reads the appearance in big endian. */
+	sys_put_be16(appearance, appearance_data);
+	report_ad_add(&report, BT_DATA_GAP_APPEARANCE, appearance_data,
+		      sizeof(appearance_data));
+	zassert_true(report_match(&report), "Filters not matched");
+	zassert_true(last_match.addr.match && last_match.name.match &&
+		     last_match.appearance.match, "Filters not matched");
+
+	filter_enable(BT_SCAN_ADDR_FILTER | BT_SCAN_NAME_FILTER, true);
+	addr_set(&report.addr, 2);
+	zassert_false(report_match(&report), "Address matched");
+}
+
+/* Advertising reports of a crowded environment, where most of the devices
+ * do not match the filters.
+ */
+static void test_benchmark(void)
+{
+	static struct adv_report reports[BENCHMARK_DEVICE_CNT];
+	static char names[CONFIG_BT_SCAN_NAME_CNT][sizeof("Sensor_00")];
+	const uint8_t flags = BT_LE_AD_GENERAL | BT_LE_AD_NO_BREDR;
+	const uint8_t company[] = {0x4c, 0x00, 0x02, 0x15};
+	uint32_t start;
+	uint32_t cycles;
+	size_t cnt;
+
+	for (size_t i = 0; i < CONFIG_BT_SCAN_NAME_CNT; i++) {
+		snprintk(names[i], sizeof(names[i]), "Sensor_%02u",
+			 (unsigned int)(8 * i));
+		filter_add(BT_SCAN_FILTER_TYPE_NAME, names[i]);
+	}
+
+	for (size_t i = 0; i < CONFIG_BT_SCAN_ADDRESS_CNT; i++) {
+		bt_addr_le_t addr;
+
+		addr_set(&addr, 8 * i + 1);
+		filter_add(BT_SCAN_FILTER_TYPE_ADDR, &addr);
+	}
+
+	filter_add(BT_SCAN_FILTER_TYPE_UUID, BT_UUID_HRS);
+	filter_add(BT_SCAN_FILTER_TYPE_UUID, BT_UUID_CSC);
+	filter_enable(BT_SCAN_NAME_FILTER | BT_SCAN_ADDR_FILTER |
+		      BT_SCAN_UUID_FILTER, false);
+
+	for (size_t i = 0; i < ARRAY_SIZE(reports); i++) {
+		struct adv_report *report = &reports[i];
+		char name[sizeof("Sensor_00")];
+		uint16_t uuid = sys_cpu_to_le16(0x1800 + i);
+
+		memset(report, 0, sizeof(*report));
+		addr_set(&report->addr, i);
+		snprintk(name, sizeof(name), "Sensor_%02u", (unsigned int)i);
+
+		report_ad_add(report, BT_DATA_FLAGS, &flags, sizeof(flags));
+		report_ad_add(report, BT_DATA_NAME_COMPLETE, name,
+			      strlen(name));
+		report_ad_add(report, BT_DATA_UUID16_ALL, &uuid, sizeof(uuid));
+		report_ad_add(report, BT_DATA_MANUFACTURER_DATA, company,
+			      sizeof(company));
+	}
+
+	cnt = match_cnt;
+	start = k_cycle_get_32();
+
+	for (size_t round = 0; round < BENCHMARK_ROUNDS; round++) {
+		for (size_t i = 0; i < ARRAY_SIZE(reports); i++) {
+			report_send(&reports[i]);
+		}
+	}
+
+	cycles = k_cycle_get_32() - start;
+
+	/* Names and addresses of one in eight devices each, and the HRS and
+	 * CSC UUIDs.
+	 */
+#if defined(CONFIG_BT_SCAN_DEDUP)
+	/* The repeated reports are deduplicated until their time to live
+	 * expires.
+	 */
+	zassert_true(match_cnt - cnt >= 2 * BENCHMARK_DEVICE_CNT / 8 + 2,
+		     "Wrong number of matches");
+	zassert_true(match_cnt - cnt <
+		     BENCHMARK_ROUNDS * (2 * BENCHMARK_DEVICE_CNT / 8 + 2),
+		     "Reports not deduplicated");
+#else
+	zassert_equal(match_cnt - cnt,
+		      BENCHMARK_ROUNDS * (2 * BENCHMARK_DEVICE_CNT / 8 + 2),
+		      "Wrong number of matches");
+#endif /* defined(CONFIG_BT_SCAN_DEDUP) */
+
+	TC_PRINT("%u cycles per advertising report\n",
+		 cycles / (BENCHMARK_ROUNDS * BENCHMARK_DEVICE_CNT));
+}
+
+#if defined(CONFIG_BT_SCAN_DEDUP)
+static void dedup_stats_check(uint32_t hits, uint32_t misses,
+			      uint32_t evictions)
+{
+	struct bt_scan_dedup_stats stats;
+
+	bt_scan_dedup_stats_get(&stats);
+	zassert_equal(stats.hits, hits, "Wrong hits %u", stats.hits);
+	zassert_equal(stats.misses, misses, "Wrong misses %u", stats.misses);
+	zassert_equal(stats.evictions, evictions, "Wrong evictions %u",
+		      stats.evictions);
+}
+
+static void test_dedup(void)
+{
+	struct adv_report report = {0};
+	const uint8_t flags = BT_LE_AD_GENERAL | BT_LE_AD_NO_BREDR;
+
+	addr_set(&report.addr, 1);
+	report_ad_add(&report, BT_DATA_FLAGS, &flags, sizeof(flags));
+	report_ad_add(&report, BT_DATA_NAME_COMPLETE, "Nordic", 6);
+
+	zassert_true(report_notified(&report), "Report deduplicated");
+	zassert_false(report_notified(&report), "Report not deduplicated");
+	zassert_false(report_notified(&report), "Report not deduplicated");
+
+	/* Same report of another device. */
+	addr_set(&report.addr, 2);
+	zassert_true(report_notified(&report), "Report deduplicated");
+
+	/* Scan response of the device. */
+	report.adv_type = BT_GAP_ADV_TYPE_SCAN_RSP;
+	zassert_true(report_notified(&report), "Report deduplicated");
+
+	/* Advertising data that changed. */
+	report.adv_type = BT_GAP_ADV_TYPE_ADV_IND;
+	report.data[report.len - 1] = 'C';
+	zassert_true(report_notified(&report), "Report deduplicated");
+
+	dedup_stats_check(2, 4, 0);
+
+	/* Clearing the cache also resets the statistics. */
+	bt_scan_dedup_clear();
+	zassert_true(report_notified(&report), "Report deduplicated");
+	dedup_stats_check(0, 1, 0);
+}
+
+static void test_dedup_ttl(void)
+{
+	struct adv_report report = {0};
+	const int8_t rssi[] = {-40, -60, -53};
+
+	addr_set(&report.addr, 1);
+	report_ad_add(&report, BT_DATA_NAME_COMPLETE, "Nordic", 6);
+
+	report.rssi = -50;
+	zassert_true(report_notified(&report), "Report deduplicated");
+	zassert_false(last_rssi_valid, "RSSI of no report");
+
+	for (size_t i = 0; i < ARRAY_SIZE(rssi); i++) {
+		report.rssi = rssi[i];
+		zassert_false(report_notified(&report),
+			      "Report not deduplicated");
+	}
+
+	k_sleep(K_MSEC(CONFIG_BT_SCAN_DEDUP_TTL_MS));
+
+	report.rssi = -45;
+	zassert_true(report_notified(&report), "Report deduplicated");
+
+#if defined(CONFIG_BT_SCAN_DEDUP_RSSI)
+	zassert_true(last_rssi_valid, "No RSSI of the deduplicated reports");
+	zassert_equal(last_rssi_stats.count, ARRAY_SIZE(rssi), "Wrong count");
+	zassert_equal(last_rssi_stats.min, -60, "Wrong minimum");
+	zassert_equal(last_rssi_stats.max, -40, "Wrong maximum");
+	zassert_equal(last_rssi_stats.avg, -51, "Wrong average");
+#endif /* defined(CONFIG_BT_SCAN_DEDUP_RSSI) */
+
+	zassert_false(report_notified(&report), "Report not deduplicated");
+	dedup_stats_check(ARRAY_SIZE(rssi) + 1, 2, 0);
+}
+
+static void test_dedup_eviction(void)
+{
+	struct adv_report report = {0};
+
+	report_ad_add(&report, BT_DATA_NAME_COMPLETE, "Nordic", 6);
+
+	for (uint8_t n = 0; n <= CONFIG_BT_SCAN_DEDUP_CACHE_SIZE; n++) {
+		addr_set(&report.addr, n);
+		zassert_true(report_notified(&report), "Report deduplicated");
+	}
+
+	/* The least recently seen device was replaced. */
+	addr_set(&report.addr, CONFIG_BT_SCAN_DEDUP_CACHE_SIZE);
+	zassert_false(report_notified(&report), "Report not deduplicated");
+	addr_set(&report.addr, 0);
+	zassert_true(report_notified(&report), "Report deduplicated");
+
+	dedup_stats_check(1, CONFIG_BT_SCAN_DEDUP_CACHE_SIZE + 2, 2);
+}
+#endif /* defined(CONFIG_BT_SCAN_DEDUP) */
+
+/* Removes and disables all the filters. */
+static void test_setup(void)
+{
+	bt_scan_init(NULL);
+	zassert_not_null(scan_cb, "Scanning callback not registered");
+}
+
+void test_main(void)
+{
+	bt_scan_cb_register(&scan_cb_data);
+
+	ztest_test_suite(bt_scan_test,
+		ztest_unit_test_setup_teardown(test_name,
+					       test_setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_addr,
+					       test_setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_uuid,
+					       test_setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_manufacturer_data,
+					       test_setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_remove_all,
+					       test_setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_multifilter,
+					       test_setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_benchmark,
+					       test_setup,
+					       unit_test_noop)
+	);
+
+	ztest_run_test_suite(bt_scan_test);
+
+#if defined(CONFIG_BT_SCAN_DEDUP)
+	ztest_test_suite(bt_scan_dedup_test,
+		ztest_unit_test_setup_teardown(test_dedup,
+					       test_setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_dedup_ttl,
+					       test_setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_dedup_eviction,
+					       test_setup,
+					       unit_test_noop)
+	);
+
+	ztest_run_test_suite(bt_scan_dedup_test);
+#endif /* defined(CONFIG_BT_SCAN_DEDUP) */
+}
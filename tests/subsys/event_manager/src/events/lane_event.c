@@ -0,0 +1,20 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include "lane_event.h"
+
+
+EVENT_TYPE_LANE_DEFINE(lane_high_event,
+		       EVENT_LANE_HIGH,
+		       true,
+		       NULL,
+		       NULL);
+
+EVENT_TYPE_LANE_DEFINE(lane_bg_event,
+		       EVENT_LANE_BACKGROUND,
+		       true,
+		       NULL,
+		       NULL);
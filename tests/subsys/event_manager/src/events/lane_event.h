@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _LANE_EVENT_H_
+#define _LANE_EVENT_H_
+
+/**
+ * @brief Lane Events
+ * @defgroup lane_event Lane Events
+ * @{
+ */
+
+#include "event_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Event processed in the high priority lane. */
+struct lane_high_event {
+	struct event_header header;
+
+	int val;
+};
+
+EVENT_TYPE_DECLARE(lane_high_event);
+
+/* Event processed in the background lane. */
+struct lane_bg_event {
+	struct event_header header;
+
+	int val;
+};
+
+EVENT_TYPE_DECLARE(lane_bg_event);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* _LANE_EVENT_H_ */
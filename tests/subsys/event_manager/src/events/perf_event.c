@@ -0,0 +1,18 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include "perf_event.h"
+
+
+EVENT_TYPE_DEFINE(perf_event,
+		  false,
+		  NULL,
+		  NULL);
+
+EVENT_TYPE_DEFINE(perf_cb_event,
+		  false,
+		  NULL,
+		  NULL);
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _PERF_EVENT_H_
+#define _PERF_EVENT_H_
+
+/**
+ * @brief Performance Events
+ * @defgroup perf_event Performance Events
+ * @{
+ */
+
+#include "event_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Event dispatched to listeners with generic event handlers. */
+struct perf_event {
+	struct event_header header;
+
+	uint32_t val;
+};
+
+EVENT_TYPE_DECLARE(perf_event);
+
+/* Event dispatched to listeners with event type specific handlers. */
+struct perf_cb_event {
+	struct event_header header;
+
+	uint32_t val;
+};
+
+EVENT_TYPE_DECLARE(perf_cb_event);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* _PERF_EVENT_H_ */
@@ -0,0 +1,15 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include "pool_event.h"
+
+
+EVENT_POOL_DEFINE(pool_event, POOL_EVENT_POOL_SIZE);
+
+EVENT_TYPE_DEFINE(pool_event,
+		  true,
+		  NULL,
+		  NULL);
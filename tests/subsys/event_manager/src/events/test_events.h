@@ -27,6 +27,10 @@ enum test_id {
 	TEST_SUBSCRIBER_ORDER,
 	TEST_OOM_RESET,
 	TEST_MULTICONTEXT,
+	TEST_EVENT_POOL,
+	TEST_DISPATCH_PERF,
+	TEST_LANES,
+	TEST_STATS,
 
 	TEST_CNT
 };
@@ -19,3 +19,16 @@
 
 /* TEST_EVENT_ORDER */
 #define TEST_EVENT_ORDER_CNT 20
+
+
+/* TEST_DISPATCH_PERF */
+#define TEST_DISPATCH_PERF_EVENT_CNT 50
+
+
+/* TEST_LANES */
+#define TEST_LANES_EVENT_CNT 10
+
+
+/* TEST_STATS */
+#define TEST_STATS_EVENT_CNT 5
+#define TEST_STATS_HANDLER_TIME_US 100
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <ztest.h>
+
+#include <test_events.h>
+#include <lane_event.h>
+
+#include "test_config.h"
+
+#define MODULE test_lanes
+
+static int high_cnt;
+static int bg_cnt;
+
+
+static void send_lane_events(void)
+{
+	high_cnt = 0;
+	bg_cnt = 0;
+
+	/* Background events are submitted first, but high priority lane
+	 * must process its events before the background lane.
+	 */
+	for (size_t i = 0; i < TEST_LANES_EVENT_CNT; i++) {
+		struct lane_bg_event *event = new_lane_bg_event();
+
+		event->val = i;
+		EVENT_SUBMIT(event);
+	}
+
+	for (size_t i = 0; i < TEST_LANES_EVENT_CNT; i++) {
+		struct lane_high_event *event = new_lane_high_event();
+
+		event->val = i;
+		EVENT_SUBMIT(event);
+	}
+}
+
+static void check_lane_stats(enum event_lane lane)
+{
+	struct event_lane_stats stats;
+	int err = event_manager_lane_stats_get(lane, &stats);
+
+	zassert_equal(err, 0, "Cannot get lane stats");
+	zassert_true(stats.dispatch_cnt >= TEST_LANES_EVENT_CNT,
+		     "Invalid number of dispatched events");
+	zassert_true(stats.queue_depth_max >= TEST_LANES_EVENT_CNT,
+		     "Invalid maximum queue depth");
+}
+
+static bool handle_lane_high_event(const struct lane_high_event *event)
+{
+	zassert_equal(event->val, high_cnt, "Wrong event order");
+	zassert_equal(bg_cnt, 0, "Background lane processed first");
+	high_cnt++;
+
+	return false;
+}
+
+static bool handle_lane_bg_event(const struct lane_bg_event *event)
+{
+	zassert_equal(event->val, bg_cnt, "Wrong event order");
+	zassert_equal(high_cnt, TEST_LANES_EVENT_CNT,
+		      "High priority lane not processed");
+	bg_cnt++;
+
+	if (bg_cnt == TEST_LANES_EVENT_CNT) {
+		check_lane_stats(EVENT_LANE_HIGH);
+
+		struct test_end_event *te = new_test_end_event();
+
+		te->test_id = TEST_LANES;
+		EVENT_SUBMIT(te);
+	}
+
+	return false;
+}
+
+static bool event_handler(const struct event_header *eh)
+{
+	if (is_test_start_event(eh)) {
+		struct test_start_event *st = cast_test_start_event(eh);
+
+		if (st->test_id == TEST_LANES) {
+			send_lane_events();
+		}
+
+		return false;
+	}
+
+	zassert_true(false, "Event unhandled");
+
+	return false;
+}
+
+EVENT_LISTENER(MODULE, event_handler);
+EVENT_SUBSCRIBE(MODULE, test_start_event);
+EVENT_SUBSCRIBE_CB(MODULE, lane_high_event, handle_lane_high_event);
+EVENT_SUBSCRIBE_CB(MODULE, lane_bg_event, handle_lane_bg_event);
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <ztest.h>
+
+#include <test_events.h>
+#include <data_event.h>
+#include <order_event.h>
+#include <multicontext_event.h>
+#include <perf_event.h>
+
+#include "test_config.h"
+
+#define MODULE test_perf
+
+static uint32_t start_cycles;
+static uint32_t generic_cycles;
+static uint32_t received_cnt;
+static volatile uint32_t handled_cnt;
+
+
+static uint32_t events_per_sec(uint32_t cycles)
+{
+	uint64_t cycles_per_sec = sys_clock_hw_cycles_per_sec();
+
+	return (TEST_DISPATCH_PERF_EVENT_CNT * cycles_per_sec) /
+	       MAX(cycles, 1);
+}
+
+static void send_perf_events(bool typed)
+{
+	received_cnt = 0;
+	start_cycles = k_cycle_get_32();
+
+	for (size_t i = 0; i < TEST_DISPATCH_PERF_EVENT_CNT; i++) {
+		if (typed) {
+			struct perf_cb_event *event = new_perf_cb_event();
+
+			event->val = i;
+			EVENT_SUBMIT(event);
+		} else {
+			struct perf_event *event = new_perf_event();
+
+			event->val = i;
+			EVENT_SUBMIT(event);
+		}
+	}
+}
+
+/* Generic event handler emulating a module that checks several event types
+ * before it finds the one it is interested in.
+ */
+static bool generic_handler(const struct event_header *eh)
+{
+	if (is_test_start_event(eh)) {
+		return false;
+	}
+
+	if (is_test_end_event(eh)) {
+		return false;
+	}
+
+	if (is_order_event(eh)) {
+		return false;
+	}
+
+	if (is_data_event(eh)) {
+		return false;
+	}
+
+	if (is_multicontext_event(eh)) {
+		return false;
+	}
+
+	if (is_perf_event(eh)) {
+		handled_cnt += cast_perf_event(eh)->val;
+		return false;
+	}
+
+	zassert_true(false, "Event unhandled");
+
+	return false;
+}
+
+static bool typed_handler(const struct perf_cb_event *event)
+{
+	handled_cnt += event->val;
+
+	return false;
+}
+
+#define PERF_LISTENERS_DEFINE(idx)						\
+	EVENT_LISTENER(_CONCAT(perf_generic, idx), generic_handler);		\
+	EVENT_SUBSCRIBE(_CONCAT(perf_generic, idx), perf_event);		\
+	EVENT_LISTENER(_CONCAT(perf_typed, idx), NULL);				\
+	EVENT_SUBSCRIBE_CB(_CONCAT(perf_typed, idx), perf_cb_event,		\
+			   typed_handler)
+
+PERF_LISTENERS_DEFINE(0);
+PERF_LISTENERS_DEFINE(1);
+PERF_LISTENERS_DEFINE(2);
+PERF_LISTENERS_DEFINE(3);
+PERF_LISTENERS_DEFINE(4);
+PERF_LISTENERS_DEFINE(5);
+PERF_LISTENERS_DEFINE(6);
+PERF_LISTENERS_DEFINE(7);
+
+
+static bool handle_perf_event(const struct perf_event *event)
+{
+	received_cnt++;
+
+	if (received_cnt == TEST_DISPATCH_PERF_EVENT_CNT) {
+		generic_cycles = k_cycle_get_32() - start_cycles;
+		send_perf_events(true);
+	}
+
+	return false;
+}
+
+static bool handle_perf_cb_event(const struct perf_cb_event *event)
+{
+	received_cnt++;
+
+	if (received_cnt == TEST_DISPATCH_PERF_EVENT_CNT) {
+		uint32_t typed_cycles = k_cycle_get_32() - start_cycles;
+
+		printk("Dispatch performance (events/s):"
+		       " generic handlers: %u, typed handlers: %u\n",
+		       events_per_sec(generic_cycles),
+		       events_per_sec(typed_cycles));
+
+		struct test_end_event *te = new_test_end_event();
+
+		te->test_id = TEST_DISPATCH_PERF;
+		EVENT_SUBMIT(te);
+	}
+
+	return false;
+}
+
+static bool event_handler(const struct event_header *eh)
+{
+	if (is_test_start_event(eh)) {
+		struct test_start_event *st = cast_test_start_event(eh);
+
+		if (st->test_id == TEST_DISPATCH_PERF) {
+			send_perf_events(false);
+		}
+
+		return false;
+	}
+
+	zassert_true(false, "Event unhandled");
+
+	return false;
+}
+
+EVENT_LISTENER(MODULE, event_handler);
+EVENT_SUBSCRIBE(MODULE, test_start_event);
+EVENT_SUBSCRIBE_FINAL_CB(MODULE, perf_event, handle_perf_event);
+EVENT_SUBSCRIBE_FINAL_CB(MODULE, perf_cb_event, handle_perf_cb_event);
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <ztest.h>
+
+#include <test_events.h>
+#include <pool_event.h>
+
+#define MODULE test_pool
+
+static struct pool_event *event_tab[POOL_EVENT_POOL_SIZE];
+static const struct event_type *et;
+static int received_cnt;
+
+static void send_pool_events(void)
+{
+	received_cnt = 0;
+
+	for (size_t i = 0; i < ARRAY_SIZE(event_tab); i++) {
+		event_tab[i] = new_pool_event();
+		event_tab[i]->val = i;
+		et = event_tab[i]->header.type_id;
+	}
+
+	zassert_not_null(et->pool, "Event type has no memory pool");
+	zassert_equal(event_manager_pool_used_get(et), POOL_EVENT_POOL_SIZE,
+		      "Events not allocated from the pool");
+	zassert_equal(event_manager_pool_max_used_get(et),
+		      POOL_EVENT_POOL_SIZE, "Invalid pool high-water mark");
+	zassert_equal(atomic_get(&et->pool->heap_fallback_cnt), 0,
+		      "Event allocated from the heap");
+
+	for (size_t i = 0; i < ARRAY_SIZE(event_tab); i++) {
+		EVENT_SUBMIT(event_tab[i]);
+	}
+}
+
+static bool event_handler(const struct event_header *eh)
+{
+	if (is_test_start_event(eh)) {
+		struct test_start_event *st = cast_test_start_event(eh);
+
+		if (st->test_id == TEST_EVENT_POOL) {
+			send_pool_events();
+		}
+
+		return false;
+	}
+
+	if (is_test_end_event(eh)) {
+		struct test_end_event *te = cast_test_end_event(eh);
+
+		if (te->test_id == TEST_EVENT_POOL) {
+			/* All pool events were processed before this event. */
+			zassert_equal(event_manager_pool_used_get(et), 0,
+				      "Events not returned to the pool");
+		}
+
+		return false;
+	}
+
+	if (is_pool_event(eh)) {
+		struct pool_event *ev = cast_pool_event(eh);
+
+		zassert_equal(ev, event_tab[received_cnt],
+			      "Event was copied during dispatch");
+		zassert_equal(ev->val, received_cnt, "Wrong event order");
+		received_cnt++;
+
+		if (received_cnt == POOL_EVENT_POOL_SIZE) {
+			struct test_end_event *te = new_test_end_event();
+
+			te->test_id = TEST_EVENT_POOL;
+			EVENT_SUBMIT(te);
+		}
+
+		return false;
+	}
+
+	zassert_true(false, "Event unhandled");
+
+	return false;
+}
+
+EVENT_LISTENER(MODULE, event_handler);
+EVENT_SUBSCRIBE(MODULE, test_start_event);
+EVENT_SUBSCRIBE(MODULE, pool_event);
+EVENT_SUBSCRIBE_EARLY(MODULE, test_end_event);
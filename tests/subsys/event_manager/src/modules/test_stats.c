@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <ztest.h>
+
+#include <test_events.h>
+#include <stats_event.h>
+
+#include "test_config.h"
+
+#define MODULE test_stats
+
+
+static void send_stats_events(void)
+{
+	event_manager_stats_reset();
+
+	for (size_t i = 0; i < TEST_STATS_EVENT_CNT; i++) {
+		struct stats_event *event = new_stats_event();
+
+		event->val = i;
+		EVENT_SUBMIT(event);
+	}
+}
+
+static void check_stats(const struct event_type *et)
+{
+	struct event_type_stats stats;
+	struct event_subscriber_stats es_stats;
+	const struct event_subscriber *es = et->subs_start[_SUBS_PRIO_NORMAL];
+	int err;
+
+	err = event_manager_stats_get(et, &stats);
+	zassert_equal(err, 0, "Cannot get event stats");
+	zassert_equal(stats.submit_cnt, TEST_STATS_EVENT_CNT,
+		      "Invalid number of submitted events");
+	zassert_equal(stats.dispatch_cnt, TEST_STATS_EVENT_CNT,
+		      "Invalid number of dispatched events");
+	zassert_equal(stats.queued_max, TEST_STATS_EVENT_CNT,
+		      "Invalid queue high-water mark");
+	zassert_equal(atomic_get(&stats.queued), 0,
+		      "Invalid number of queued events");
+	zassert_true(stats.queue_time_max >=
+		     k_us_to_cyc_floor32(TEST_STATS_HANDLER_TIME_US),
+		     "Invalid queue time");
+
+	zassert_equal(et->subs_stop[_SUBS_PRIO_NORMAL] - es, 1,
+		      "Invalid number of subscribers");
+	err = event_manager_subscriber_stats_get(es, &es_stats);
+	zassert_equal(err, 0, "Cannot get subscriber stats");
+
+	/* Execution of the current handler is not counted yet. */
+	zassert_equal(es_stats.call_cnt, TEST_STATS_EVENT_CNT - 1,
+		      "Invalid number of notifications");
+	zassert_true(es_stats.exec_time_max >=
+		     k_us_to_cyc_floor32(TEST_STATS_HANDLER_TIME_US),
+		     "Invalid execution time");
+}
+
+static bool handle_stats_event(const struct stats_event *event)
+{
+	k_busy_wait(TEST_STATS_HANDLER_TIME_US);
+
+	if (event->val == (TEST_STATS_EVENT_CNT - 1)) {
+		check_stats(event->header.type_id);
+
+		struct test_end_event *te = new_test_end_event();
+
+		te->test_id = TEST_STATS;
+		EVENT_SUBMIT(te);
+	}
+
+	return false;
+}
+
+static bool event_handler(const struct event_header *eh)
+{
+	if (is_test_start_event(eh)) {
+		struct test_start_event *st = cast_test_start_event(eh);
+
+		if (st->test_id == TEST_STATS) {
+			send_stats_events();
+		}
+
+		return false;
+	}
+
+	zassert_true(false, "Event unhandled");
+
+	return false;
+}
+
+EVENT_LISTENER(MODULE, event_handler);
+EVENT_SUBSCRIBE(MODULE, test_start_event);
+EVENT_SUBSCRIBE_CB(MODULE, stats_event, handle_stats_event);
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef MOCK_NET_SOCKET_H_
+#define MOCK_NET_SOCKET_H_
+
+/* Sockets connected to the stand-in servers, implemented by the test */
+
+#include <sys/types.h>
+#include <sys/_timeval.h>
+#include <stddef.h>
+#include <errno.h>
+#include <net/net_ip.h>
+
+#ifndef AF_LTE
+#define AF_LTE		102
+#endif
+#ifndef SOCK_MGMT
+#define SOCK_MGMT	4
+#endif
+#ifndef NPROTO_PDN
+#define NPROTO_PDN	514
+#endif
+
+#define AI_PDNSERV	0x1000
+
+#define SOL_SOCKET	1
+#define SO_RCVTIMEO	20
+#define SO_BINDTODEVICE	25
+#define IFNAMSIZ	16
+
+#define SOL_TLS			282
+#define TLS_SEC_TAG_LIST	1
+#define TLS_HOSTNAME		2
+#define TLS_PEER_VERIFY		5
+
+#define POLLIN		1
+
+struct pollfd {
+	int fd;
+	short events;
+	short revents;
+};
+
+struct addrinfo {
+	struct addrinfo *ai_next;
+	int ai_flags;
+	int ai_family;
+	int ai_socktype;
+	int ai_protocol;
+	socklen_t ai_addrlen;
+	struct sockaddr *ai_addr;
+	char *ai_canonname;
+};
+
+#define socket		mock_socket
+#define connect		mock_connect
+#define send		mock_send
+#define recv		mock_recv
+#define close		mock_close
+#define setsockopt	mock_setsockopt
+#define getaddrinfo	mock_getaddrinfo
+#define freeaddrinfo	mock_freeaddrinfo
+#define poll		mock_poll
+
+int mock_socket(int family, int type, int proto);
+int mock_connect(int sock, const struct sockaddr *addr, socklen_t addrlen);
+ssize_t mock_send(int sock, const void *buf, size_t len, int flags);
+ssize_t mock_recv(int sock, void *buf, size_t max_len, int flags);
+int mock_close(int sock);
+int mock_setsockopt(int sock, int level, int optname, const void *optval,
+		    socklen_t optlen);
+int mock_getaddrinfo(const char *host, const char *service,
+		     const struct addrinfo *hints, struct addrinfo **res);
+void mock_freeaddrinfo(struct addrinfo *ai);
+int mock_poll(struct pollfd *fds, int nfds, int timeout);
+
+#endif /* MOCK_NET_SOCKET_H_ */
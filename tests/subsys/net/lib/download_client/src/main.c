@@ -0,0 +1,334 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <ztest.h>
+#include <net/download_client.h>
+
+#include "server.h"
+
+#define FILE_SIZE (32 * 1024)
+#define LARGE_FRAG_SIZE 8192
+#define THROUGHPUT_ROUNDS 20
+/* Round trip time of the simulated link, in milliseconds */
+#define RTT_MS 200
+#define PIPELINE_DEPTH 4
+#define SEC_TAG 42
+#define DOWNLOAD_TIMEOUT K_SECONDS(10)
+
+void test_coap_window(void);
+void test_coap_resume(void);
+void test_coap_loss(void);
+void test_coap_server_block_size(void);
+void test_coap_timeout(void);
+void test_parallel_ordered(void);
+void test_parallel_as_received(void);
+void test_parallel_terminal_error(void);
+void test_parallel_http(void);
+
+static struct download_client client;
+static struct download_client_cfg config;
+static char *frag_buf;
+static size_t frag_buf_size;
+static size_t from;
+static char app_buf[LARGE_FRAG_SIZE];
+static char sink[LARGE_FRAG_SIZE];
+
+static void (*on_fragment)(const char *buf, size_t len, size_t off);
+static int result;
+
+static K_SEM_DEFINE(done_sem, 0, 1);
+
+static int callback(const struct download_client_evt *evt)
+{
+	switch (evt->id) {
+	case DOWNLOAD_CLIENT_EVT_FRAGMENT:
+		on_fragment(evt->fragment.buf, evt->fragment.len,
+			    evt->fragment.offset);
+		break;
+	case DOWNLOAD_CLIENT_EVT_ERROR:
+		/* Stop, the server does not break the connections */
+		result = evt->error;
+		k_sem_give(&done_sem);
+		return -1;
+	case DOWNLOAD_CLIENT_EVT_DONE:
+		result = 0;
+		k_sem_give(&done_sem);
+		break;
+	}
+
+	return 0;
+}
+
+static void client_setup(char *buf, size_t buf_size, size_t frag_size)
+{
+	server_reset(FILE_SIZE);
+
+	memset(&config, 0, sizeof(config));
+	config.sec_tag = SEC_TAG;
+	config.frag_size_override = frag_size;
+
+	frag_buf = buf;
+	frag_buf_size = buf_size;
+	from = 0;
+
+	client.stripe.base = 0;
+	client.stripe.stride = 0;
+}
+
+/* Runs the download in the download thread, from `from`,
+ * which delivers each fragment to `fragment_cb`.
+ */
+static void download(void (*fragment_cb)(const char *, size_t, size_t))
+{
+	int err;
+
+	on_fragment = fragment_cb;
+	result = -EINPROGRESS;
+	k_sem_reset(&done_sem);
+
+	/* The fragment size is checked against the buffer when connecting */
+	err = download_client_buf_set(&client, frag_buf, frag_buf_size);
+	zassert_equal(err, 0, "Failed to set the fragment buffer");
+
+	err = download_client_connect(&client, "https://stand.in", &config);
+	zassert_equal(err, 0, "Failed to connect");
+
+	err = download_client_start(&client, "file.bin", from);
+	zassert_equal(err, 0, "Failed to start");
+
+	err = k_sem_take(&done_sem, DOWNLOAD_TIMEOUT);
+	zassert_equal(err, 0, "Download did not end");
+	zassert_equal(result, 0, "Download failed");
+
+	/* Let the thread suspend itself before the next download */
+	k_sleep(K_MSEC(10));
+
+	err = download_client_disconnect(&client);
+	zassert_equal(err, 0, "Failed to disconnect");
+}
+
+static size_t verified;
+
+static void fragment_verify(const char *buf, size_t len, size_t off)
+{
+	zassert_true(buf == client.frag_buf, "Fragment not in fragment buffer");
+	zassert_true(len <= client.frag_buf_size, "Fragment too large");
+
+	for (size_t i = 0; i < len; i++) {
+		zassert_equal((uint8_t)buf[i], server_file_byte(off + i),
+			      "Fragment content mismatch at %d", off + i);
+	}
+
+	verified += len;
+}
+
+static void fragment_copy(const char *buf, size_t len, size_t off)
+{
+	/* What an application does with the internal buffer */
+	memcpy(sink, buf, len);
+}
+
+static void fragment_use(const char *buf, size_t len, size_t off)
+{
+	/* The fragment is already where the application wants it */
+}
+
+static void test_internal_buffer(void)
+{
+	verified = 0;
+	client_setup(NULL, 0, 0);
+
+	download(fragment_verify);
+
+	zassert_equal(verified, FILE_SIZE, "File not downloaded");
+	zassert_equal(client.file_size, FILE_SIZE, "Wrong file size");
+	zassert_equal(server.requests,
+		      FILE_SIZE / CONFIG_DOWNLOAD_CLIENT_HTTP_FRAG_SIZE,
+		      "Unexpected number of requests");
+}
+
+static void test_app_buffer(void)
+{
+	verified = 0;
+	client_setup(app_buf, sizeof(app_buf), LARGE_FRAG_SIZE);
+
+	download(fragment_verify);
+
+	zassert_equal(verified, FILE_SIZE, "File not downloaded");
+	zassert_equal(server.requests, FILE_SIZE / LARGE_FRAG_SIZE,
+		      "Unexpected number of requests");
+}
+
+static uint32_t link_time_measure(size_t frag_size, uint8_t depth)
+{
+	verified = 0;
+	client_setup(NULL, 0, frag_size);
+	config.pipeline_depth = depth;
+	server.rtt = RTT_MS;
+
+	download(fragment_verify);
+
+	zassert_equal(verified, FILE_SIZE, "File not downloaded");
+	zassert_true(server.max_in_flight <= depth, "Pipeline too deep");
+
+	return server.now;
+}
+
+static void test_pipeline(void)
+{
+	uint32_t sequential;
+	uint32_t pipelined;
+
+	sequential = link_time_measure(0, 1);
+	zassert_equal(server.max_in_flight, 1, "Requests were pipelined");
+
+	pipelined = link_time_measure(0, PIPELINE_DEPTH);
+	zassert_equal(server.max_in_flight, PIPELINE_DEPTH,
+		      "Pipeline not filled");
+
+	printk("Time to download %d bytes with %d ms RTT:\n",
+	       FILE_SIZE, RTT_MS);
+	printk("  sequential requests: %u ms\n", sequential);
+	printk("  %d requests in flight: %u ms\n", PIPELINE_DEPTH, pipelined);
+
+	zassert_true(pipelined < sequential / 2,
+		     "Pipelining does not hide the round trip time");
+}
+
+static void test_pipeline_small_fragments(void)
+{
+	/* Several responses fit in one recv() */
+	link_time_measure(256, PIPELINE_DEPTH);
+	zassert_equal(server.requests, FILE_SIZE / 256,
+		      "Unexpected number of requests");
+}
+
+static void test_pipeline_connection_close(void)
+{
+	verified = 0;
+	client_setup(NULL, 0, 0);
+	config.pipeline_depth = PIPELINE_DEPTH;
+	server.rtt = RTT_MS;
+	server.close_after = 3;
+
+	download(fragment_verify);
+
+	/* Requests in flight when the connection was closed are sent again */
+	zassert_equal(verified, FILE_SIZE, "File not downloaded");
+	zassert_equal(server.connections, 2, "Client did not reconnect");
+	zassert_true(server.requests > FILE_SIZE /
+				       CONFIG_DOWNLOAD_CLIENT_HTTP_FRAG_SIZE,
+		     "Lost requests were not sent again");
+}
+
+static void stripe_verify(const char *buf, size_t len, size_t off)
+{
+	size_t period = CONFIG_DOWNLOAD_CLIENT_HTTP_FRAG_SIZE +
+			client.stripe.stride;
+
+	zassert_true((off - client.stripe.base) % period +
+		     len <= CONFIG_DOWNLOAD_CLIENT_HTTP_FRAG_SIZE,
+		     "Fragment at %d is not in this client's stripes", off);
+
+	fragment_verify(buf, len, off);
+}
+
+static void test_stripes(void)
+{
+	const size_t count = 3;
+	const size_t base = 100;
+	const size_t frag_size = CONFIG_DOWNLOAD_CLIENT_HTTP_FRAG_SIZE;
+
+	/* Run the clients of a parallel download one after the other */
+	verified = 0;
+	for (size_t i = 0; i < count; i++) {
+		client_setup(NULL, 0, 0);
+		config.pipeline_depth = PIPELINE_DEPTH;
+		client.stripe.base = base + i * frag_size;
+		client.stripe.stride = (count - 1) * frag_size;
+		from = client.stripe.base;
+
+		download(stripe_verify);
+	}
+
+	zassert_equal(verified, FILE_SIZE - base,
+		      "Fragments missing or downloaded twice");
+}
+
+static uint32_t throughput_measure(char *buf, size_t buf_size,
+				   size_t frag_size,
+				   void (*fragment_cb)(const char *, size_t,
+						       size_t))
+{
+	uint32_t start;
+	uint32_t cycles = 0;
+
+	for (size_t i = 0; i < THROUGHPUT_ROUNDS; i++) {
+		client_setup(buf, buf_size, frag_size);
+
+		start = k_cycle_get_32();
+		download(fragment_cb);
+		cycles += k_cycle_get_32() - start;
+	}
+
+	return cycles / THROUGHPUT_ROUNDS;
+}
+
+static void test_throughput(void)
+{
+	uint32_t copy;
+	uint32_t zero_copy;
+	uint32_t zero_copy_large;
+
+	copy = throughput_measure(NULL, 0, 0, fragment_copy);
+	zero_copy = throughput_measure(app_buf, CONFIG_DOWNLOAD_CLIENT_BUF_SIZE,
+				       0, fragment_use);
+	zero_copy_large = throughput_measure(app_buf, sizeof(app_buf),
+					     LARGE_FRAG_SIZE, fragment_use);
+
+	printk("Cycles to download %d bytes:\n", FILE_SIZE);
+	printk("  internal buffer, %d B fragments: %u\n",
+	       CONFIG_DOWNLOAD_CLIENT_HTTP_FRAG_SIZE, copy);
+	printk("  application buffer, %d B fragments: %u\n",
+	       CONFIG_DOWNLOAD_CLIENT_HTTP_FRAG_SIZE, zero_copy);
+	printk("  application buffer, %d B fragments: %u\n",
+	       LARGE_FRAG_SIZE, zero_copy_large);
+}
+
+void test_main(void)
+{
+	int err;
+
+	err = download_client_init(&client, callback);
+	zassert_equal(err, 0, "Failed to initialize");
+
+	/* Let the thread suspend itself, the first download resumes it */
+	k_sleep(K_MSEC(10));
+
+	ztest_test_suite(download_client_test,
+			 ztest_unit_test(test_internal_buffer),
+			 ztest_unit_test(test_app_buffer),
+			 ztest_unit_test(test_pipeline),
+			 ztest_unit_test(test_pipeline_small_fragments),
+			 ztest_unit_test(test_pipeline_connection_close),
+			 ztest_unit_test(test_stripes),
+			 ztest_unit_test(test_coap_window),
+			 ztest_unit_test(test_coap_resume),
+			 ztest_unit_test(test_coap_loss),
+			 ztest_unit_test(test_coap_server_block_size),
+			 ztest_unit_test(test_coap_timeout),
+			 ztest_unit_test(test_parallel_ordered),
+			 ztest_unit_test(test_parallel_as_received),
+			 ztest_unit_test(test_parallel_terminal_error),
+			 ztest_unit_test(test_parallel_http),
+			 ztest_unit_test(test_throughput)
+			 );
+	ztest_run_test_suite(download_client_test);
+}
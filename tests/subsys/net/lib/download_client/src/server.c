@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <ztest.h>
+#include <net/socket.h>
+
+#include "server.h"
+
+/* Largest amount of data returned by a single recv() */
+#define SEGMENT_SIZE 708
+/* Bytes per millisecond of the simulated link */
+#define LINK_RATE 50
+#define SOCKETS_MAX 8
+
+struct response {
+	char hdr[128];
+	size_t hdr_len;
+	size_t hdr_off;
+	size_t off;
+	size_t len;
+	/* Time at which the response reaches the client */
+	uint32_t time;
+};
+
+/* Responses in flight on each connection */
+static struct {
+	bool used;
+	int type;
+	struct response queue[8];
+	size_t head;
+	size_t count;
+} sockets[SOCKETS_MAX];
+
+struct server server;
+
+void server_reset(size_t file_size)
+{
+	memset(&server, 0, sizeof(server));
+	server.file_size = file_size;
+}
+
+uint8_t server_file_byte(size_t off)
+{
+	return (uint8_t)(off * 31 + (off >> 8));
+}
+
+static void response_queue(int sock, unsigned int from, unsigned int to)
+{
+	struct response *rsp;
+	bool fail = server.fail && from == server.fail_from;
+
+	zassert_true(sockets[sock].count < ARRAY_SIZE(sockets[sock].queue),
+		     "Too many requests in flight");
+
+	rsp = &sockets[sock].queue[(sockets[sock].head +
+				    sockets[sock].count) %
+				   ARRAY_SIZE(sockets[sock].queue)];
+	sockets[sock].count++;
+	server.max_in_flight = MAX(server.max_in_flight,
+				   sockets[sock].count);
+
+	if (fail) {
+		rsp->hdr_len = snprintf(rsp->hdr, sizeof(rsp->hdr),
+			"HTTP/1.1 500 Internal Server Error\r\n"
+			"Content-Length: 0\r\n"
+			"\r\n");
+		rsp->len = 0;
+	} else {
+		rsp->hdr_len = snprintf(rsp->hdr, sizeof(rsp->hdr),
+			"HTTP/1.1 206 Partial Content\r\n"
+			"Content-Range: bytes %u-%u/%u\r\n"
+			"Content-Length: %u\r\n"
+			"%s"
+			"\r\n",
+			from, to, (unsigned int)server.file_size,
+			to - from + 1,
+			server.requests == server.close_after ?
+				"Connection: close\r\n" : "");
+		rsp->len = to - from + 1;
+	}
+
+	rsp->hdr_off = 0;
+	rsp->off = from;
+	rsp->time = server.now + server.rtt;
+}
+
+static void request_parse(int sock, const char *req, size_t len)
+{
+	char *end;
+	unsigned int from;
+	unsigned int to;
+	const char *range;
+
+	zassert_equal(req[len], '\0', "Bad request length");
+
+	range = strstr(req, "Range: bytes=");
+	zassert_not_null(range, "No range in request");
+
+	from = strtoul(range + strlen("Range: bytes="), &end, 10);
+	zassert_equal(*end, '-', "Malformed range");
+
+	to = server.file_size - 1;
+	if (end[1] >= '0' && end[1] <= '9') {
+		to = strtoul(end + 1, NULL, 10);
+		zassert_true(to < server.file_size, "Range past end of file");
+	}
+
+	server.requests++;
+	if (server.close_after && server.requests > server.close_after) {
+		/* Lost, the server closes the connection before */
+		return;
+	}
+
+	response_queue(sock, from, to);
+}
+
+int mock_socket(int family, int type, int proto)
+{
+	zassert_equal(family, AF_INET, "Wrong socket family");
+
+	for (int sock = 0; sock < SOCKETS_MAX; sock++) {
+		if (!sockets[sock].used) {
+			memset(&sockets[sock], 0, sizeof(sockets[sock]));
+			sockets[sock].used = true;
+			sockets[sock].type = type;
+			return sock;
+		}
+	}
+
+	errno = ENFILE;
+	return -1;
+}
+
+int mock_connect(int sock, const struct sockaddr *addr, socklen_t addrlen)
+{
+	zassert_true(sockets[sock].used, "Socket not open");
+
+	/* Handshake */
+	server.connections++;
+	server.now += server.rtt;
+
+	return 0;
+}
+
+ssize_t mock_send(int sock, const void *buf, size_t len, int flags)
+{
+	zassert_true(sockets[sock].used, "Socket not open");
+
+	if (sockets[sock].type == SOCK_DGRAM) {
+		return coap_server_send(buf, len) ? -1 : len;
+	}
+
+	request_parse(sock, buf, len);
+
+	return len;
+}
+
+/* Returns the data that has reached the client, waiting for it if needed */
+ssize_t mock_recv(int sock, void *buf, size_t max_len, int flags)
+{
+	size_t n;
+	size_t copied = 0;
+	struct response *rsp;
+
+	zassert_true(sockets[sock].used, "Socket not open");
+	zassert_true(sockets[sock].count > 0, "recv() would block forever");
+
+	max_len = MIN(max_len, SEGMENT_SIZE);
+	rsp = &sockets[sock].queue[sockets[sock].head];
+	server.now = MAX(server.now, rsp->time);
+
+	while (copied < max_len && sockets[sock].count) {
+		rsp = &sockets[sock].queue[sockets[sock].head];
+		if (rsp->time > server.now) {
+			break;
+		}
+
+		n = MIN(max_len - copied, rsp->hdr_len - rsp->hdr_off);
+		memcpy((char *)buf + copied, rsp->hdr + rsp->hdr_off, n);
+		rsp->hdr_off += n;
+		copied += n;
+
+		n = MIN(max_len - copied, rsp->len);
+		for (size_t i = 0; i < n; i++) {
+			((uint8_t *)buf)[copied + i] =
+				server_file_byte(rsp->off + i);
+		}
+		rsp->off += n;
+		rsp->len -= n;
+		copied += n;
+
+		if (rsp->hdr_off == rsp->hdr_len && rsp->len == 0) {
+			sockets[sock].head = (sockets[sock].head + 1) %
+				ARRAY_SIZE(sockets[sock].queue);
+			sockets[sock].count--;
+		}
+	}
+
+	server.now += DIV_ROUND_UP(copied, LINK_RATE);
+
+	return copied;
+}
+
+int mock_close(int sock)
+{
+	zassert_true(sockets[sock].used, "Socket not open");
+
+	sockets[sock].used = false;
+	server.close_after = 0;
+
+	return 0;
+}
+
+int mock_setsockopt(int sock, int level, int optname, const void *optval,
+		    socklen_t optlen)
+{
+	zassert_true(sockets[sock].used, "Socket not open");
+
+	return 0;
+}
+
+int mock_getaddrinfo(const char *host, const char *service,
+		     const struct addrinfo *hints, struct addrinfo **res)
+{
+	static struct sockaddr addr;
+	static struct addrinfo ai;
+
+	zassert_equal(strcmp(host, "stand.in"), 0, "Unknown host");
+
+	addr.sa_family = AF_INET;
+	ai.ai_family = AF_INET;
+	ai.ai_addr = &addr;
+	ai.ai_addrlen = sizeof(struct sockaddr_in);
+	*res = &ai;
+
+	return 0;
+}
+
+void mock_freeaddrinfo(struct addrinfo *ai)
+{
+}
+
+int mock_poll(struct pollfd *fds, int nfds, int timeout)
+{
+	/* CoAP is tested without the download thread */
+	errno = ENOTSUP;
+	return -1;
+}
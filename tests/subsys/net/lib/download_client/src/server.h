@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef SERVER_H_
+#define SERVER_H_
+
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Stand-in for an HTTP server, reached through the sockets of
+ * mock/net/socket.h. It answers range requests for a file of
+ * `file_size` bytes over a simulated link with a round trip time of
+ * `rtt` milliseconds. Datagrams are handed to the CoAP server.
+ */
+struct server {
+	size_t file_size;
+	uint32_t rtt;
+	/* Close the connection after this many responses, if not zero */
+	size_t close_after;
+	/* Answer the request starting at this offset with an error */
+	size_t fail_from;
+	bool fail;
+	/* Counted over all the connections */
+	size_t connections;
+	size_t requests;
+	size_t max_in_flight;
+	/* Simulated time, in milliseconds */
+	uint32_t now;
+};
+
+extern struct server server;
+
+/* Resets the server and its statistics, for a file of `file_size` bytes */
+void server_reset(size_t file_size);
+
+/* Byte of the file at offset `off` */
+uint8_t server_file_byte(size_t off);
+
+/* Receives a CoAP request, implemented by the CoAP tests */
+int coap_server_send(const void *buf, size_t len);
+
+#endif /* SERVER_H_ */
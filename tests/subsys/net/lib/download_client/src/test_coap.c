@@ -0,0 +1,349 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+#include <string.h>
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <ztest.h>
+#include <net/coap.h>
+#include <net/socket.h>
+#include <net/download_client.h>
+
+#define COAP_FILE_SIZE (16 * 1024)
+/* Simulated link, in milliseconds */
+#define COAP_RTT_MS 100
+#define COAP_WINDOW 4
+#define COAP_LOSS_PERCENT 10
+
+int coap_block_init(struct download_client *client, size_t from);
+int coap_parse(struct download_client *client, size_t len);
+int coap_request_send(struct download_client *client);
+int coap_timeout_get(const struct download_client *client);
+int coap_retransmit(struct download_client *client);
+
+static struct download_client client;
+/* The requests reach the server through this socket */
+static int sock = -1;
+
+struct datagram {
+	uint8_t data[CONFIG_DOWNLOAD_CLIENT_BUF_SIZE];
+	uint16_t len;
+	/* Time at which the datagram reaches the client */
+	uint32_t time;
+};
+
+/* Stand-in for a CoAP server, answering Block2 requests over a simulated
+ * link with a round trip time of COAP_RTT_MS milliseconds, which loses
+ * `loss` percent of the datagrams in each direction.
+ */
+static struct {
+	struct datagram queue[2 * CONFIG_DOWNLOAD_CLIENT_COAP_WINDOW];
+	size_t head;
+	size_t count;
+	size_t requests;
+	uint32_t seed;
+	uint8_t loss;
+	/* Largest block size exponent the server uses */
+	uint8_t szx_max;
+} server;
+
+static uint8_t file_byte(size_t off)
+{
+	return (uint8_t)(off * 31 + (off >> 8));
+}
+
+static bool lost(void)
+{
+	/* Deterministic, so that failures can be reproduced */
+	server.seed = server.seed * 1103515245 + 12345;
+
+	return (server.seed >> 16) % 100 < server.loss;
+}
+
+int coap_server_send(const void *buf, size_t len)
+{
+	int err;
+	int block2;
+	uint8_t szx;
+	uint8_t tkl;
+	uint8_t token[8];
+	size_t off;
+	size_t payload_len;
+	uint8_t payload[512];
+	struct coap_packet request;
+	struct coap_packet response;
+	struct datagram *dgram;
+
+	server.requests++;
+	if (lost()) {
+		return 0;
+	}
+
+	err = coap_packet_parse(&request, (uint8_t *)buf, len, NULL, 0);
+	zassert_equal(err, 0, "Malformed request");
+
+	block2 = coap_get_option_int(&request, COAP_OPTION_BLOCK2);
+	zassert_true(block2 >= 0, "No block2 option in request");
+
+	/* The server may answer with smaller blocks */
+	szx = MIN(block2 & 0x7, server.szx_max);
+	off = (block2 >> 4) << ((block2 & 0x7) + 4);
+	zassert_true(off < COAP_FILE_SIZE, "Block past end of file");
+
+	payload_len = MIN(16 << szx, COAP_FILE_SIZE - off);
+	for (size_t i = 0; i < payload_len; i++) {
+		payload[i] = file_byte(off + i);
+	}
+
+	if (lost()) {
+		return 0;
+	}
+
+	zassert_true(server.count < ARRAY_SIZE(server.queue),
+		     "Too many datagrams in flight");
+
+	dgram = &server.queue[(server.head + server.count) %
+			      ARRAY_SIZE(server.queue)];
+	server.count++;
+
+	tkl = coap_header_get_token(&request, token);
+	err = coap_packet_init(&response, dgram->data, sizeof(dgram->data),
+			       1, COAP_TYPE_ACK, tkl, token,
+			       COAP_RESPONSE_CODE_CONTENT,
+			       coap_header_get_id(&request));
+	zassert_equal(err, 0, "Failed to build response");
+
+	err = coap_append_option_int(&response, COAP_OPTION_BLOCK2,
+			(off >> (szx + 4)) << 4 |
+			(off + payload_len < COAP_FILE_SIZE) << 3 | szx);
+	zassert_equal(err, 0, "Failed to add block2 option");
+
+	if (coap_get_option_int(&request, COAP_OPTION_SIZE2) >= 0) {
+		err = coap_append_option_int(&response, COAP_OPTION_SIZE2,
+					     COAP_FILE_SIZE);
+		zassert_equal(err, 0, "Failed to add size2 option");
+	}
+
+	err = coap_packet_append_payload_marker(&response);
+	zassert_equal(err, 0, "Failed to add payload marker");
+
+	err = coap_packet_append_payload(&response, payload, payload_len);
+	zassert_equal(err, 0, "Failed to add payload");
+
+	dgram->len = response.offset;
+	dgram->time = k_uptime_get_32() + COAP_RTT_MS;
+
+	return 0;
+}
+
+/* Waits up to `timeout` milliseconds for a datagram, like poll() and
+ * recv() do in the download thread. Returns zero on timeout.
+ */
+static size_t server_recv(void *buf, int timeout)
+{
+	uint32_t now = k_uptime_get_32();
+	struct datagram *dgram = &server.queue[server.head];
+
+	if (server.count == 0 || dgram->time - now > timeout) {
+		k_sleep(K_MSEC(timeout));
+		return 0;
+	}
+
+	k_sleep(K_MSEC(dgram->time - now));
+
+	memcpy(buf, dgram->data, dgram->len);
+	server.head = (server.head + 1) % ARRAY_SIZE(server.queue);
+	server.count--;
+
+	return dgram->len;
+}
+
+static void client_setup(uint8_t window, uint8_t loss)
+{
+	memset(&client, 0, sizeof(client));
+	memset(&server, 0, sizeof(server));
+
+	if (sock < 0) {
+		sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+		zassert_true(sock >= 0, "Failed to open socket");
+	}
+
+	client.fd = sock;
+	client.host = "coap://stand.in";
+	client.file = "file.bin";
+	client.proto = IPPROTO_UDP;
+	client.config.sec_tag = -1;
+	client.config.coap_window = window;
+
+	server.seed = 1;
+	server.loss = loss;
+	server.szx_max = CONFIG_DOWNLOAD_CLIENT_COAP_BLOCK_SIZE;
+}
+
+/* Runs the download like the download thread does, verifying that the
+ * blocks are delivered in order. Returns the time it took.
+ */
+static uint32_t download(size_t from)
+{
+	int err;
+	size_t len;
+	size_t next = from;
+	uint32_t start = k_uptime_get_32();
+
+	client.progress = from;
+	coap_block_init(&client, from);
+
+	err = coap_request_send(&client);
+	zassert_equal(err, 0, "Failed to send request");
+
+	while (true) {
+		len = server_recv(client.buf, coap_timeout_get(&client));
+		if (len == 0) {
+			err = coap_retransmit(&client);
+			zassert_equal(err, 0, "Failed to retransmit");
+			continue;
+		}
+
+		err = coap_parse(&client, len);
+		if (err > 0) {
+			continue;
+		}
+		zassert_equal(err, 0, "Failed to parse response");
+
+		/* Same as download_fragment.offset */
+		zassert_equal(client.progress - client.offset, next,
+			      "Block out of order");
+
+		for (size_t i = 0; i < client.offset; i++) {
+			zassert_equal(client.coap.payload[i],
+				      file_byte(next + i),
+				      "Block content mismatch at %d",
+				      next + i);
+		}
+
+		next += client.offset;
+		if (client.progress == client.file_size) {
+			break;
+		}
+
+		err = coap_request_send(&client);
+		zassert_equal(err, 0, "Failed to send request");
+	}
+
+	zassert_equal(next, COAP_FILE_SIZE, "File not downloaded");
+	zassert_equal(client.file_size, COAP_FILE_SIZE, "Wrong file size");
+
+	return k_uptime_get_32() - start;
+}
+
+static void stats_print(void)
+{
+	struct download_client_coap_stats stats;
+
+	download_client_coap_stats_get(&client, &stats);
+
+	printk("  %u blocks, %u requests, %u retransmissions\n",
+	       stats.blocks, stats.requests, stats.retransmissions);
+	printk("  RTT min/avg/max %u/%u/%u ms, block size %u\n",
+	       stats.rtt_min, stats.rtt_total / MAX(stats.rtt_samples, 1),
+	       stats.rtt_max, stats.block_size);
+}
+
+void test_coap_window(void)
+{
+	uint32_t sequential;
+	uint32_t windowed;
+	struct download_client_coap_stats stats;
+
+	client_setup(1, 0);
+	sequential = download(0);
+
+	client_setup(COAP_WINDOW, 0);
+	windowed = download(0);
+
+	download_client_coap_stats_get(&client, &stats);
+	zassert_equal(stats.retransmissions, 0, "Retransmissions without loss");
+	zassert_equal(stats.blocks, stats.requests, "Blocks requested twice");
+	zassert_true(stats.rtt_min >= COAP_RTT_MS, "RTT not measured");
+
+	printk("Time to download %d bytes with %d ms RTT:\n",
+	       COAP_FILE_SIZE, COAP_RTT_MS);
+	printk("  one block at a time: %u ms\n", sequential);
+	printk("  %d blocks in flight: %u ms\n", COAP_WINDOW, windowed);
+
+	zassert_true(windowed < sequential / 2,
+		     "Window does not hide the round trip time");
+}
+
+void test_coap_resume(void)
+{
+	struct download_client_coap_stats stats;
+
+	/* The first block starts before the requested offset */
+	client_setup(COAP_WINDOW, 0);
+	download(1000);
+
+	download_client_coap_stats_get(&client, &stats);
+	zassert_equal(stats.blocks,
+		      DIV_ROUND_UP(COAP_FILE_SIZE - 1000 / stats.block_size *
+				   stats.block_size, stats.block_size),
+		      "Unexpected number of blocks");
+}
+
+void test_coap_loss(void)
+{
+	struct download_client_coap_stats stats;
+
+	client_setup(COAP_WINDOW, COAP_LOSS_PERCENT);
+	download(0);
+
+	download_client_coap_stats_get(&client, &stats);
+	zassert_true(stats.retransmissions > 0, "Nothing was lost");
+
+	printk("Download with %d%% loss in each direction:\n",
+	       COAP_LOSS_PERCENT);
+	stats_print();
+}
+
+void test_coap_server_block_size(void)
+{
+	struct download_client_coap_stats stats;
+
+	client_setup(COAP_WINDOW, 0);
+	server.szx_max = CONFIG_DOWNLOAD_CLIENT_COAP_BLOCK_SIZE - 1;
+
+	download(0);
+
+	download_client_coap_stats_get(&client, &stats);
+	zassert_equal(stats.block_size,
+		      16 << (CONFIG_DOWNLOAD_CLIENT_COAP_BLOCK_SIZE - 1),
+		      "Server block size not adopted");
+}
+
+void test_coap_timeout(void)
+{
+	int err;
+	struct download_client_coap_stats stats;
+
+	client_setup(COAP_WINDOW, 100);
+	coap_block_init(&client, 0);
+
+	err = coap_request_send(&client);
+	zassert_equal(err, 0, "Failed to send request");
+
+	do {
+		zassert_equal(server_recv(client.buf,
+					  coap_timeout_get(&client)), 0,
+			      "Response through a dead link");
+		err = coap_retransmit(&client);
+	} while (err == 0);
+
+	zassert_equal(err, -ETIMEDOUT, "Unexpected error %d", err);
+
+	download_client_coap_stats_get(&client, &stats);
+	zassert_equal(stats.retransmissions,
+		      CONFIG_DOWNLOAD_CLIENT_COAP_MAX_RETRANSMIT,
+		      "Unexpected number of retransmissions");
+}
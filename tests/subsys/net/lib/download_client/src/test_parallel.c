@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+#include <string.h>
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <ztest.h>
+#include <net/download_client.h>
+
+#include "server.h"
+
+#define PARALLEL_FILE_SIZE	(10 * 1024 + 100)
+#define PARALLEL_FRAG_SIZE	512
+#define PARALLEL_CONNS		3
+#define PARALLEL_SEC_TAG	42
+#define PARALLEL_TIMEOUT	K_SECONDS(10)
+
+/* The parallel download is tested against the stand-in server,
+ * each connection running the download thread of its client.
+ */
+static struct {
+	uint8_t file[PARALLEL_FILE_SIZE];
+	bool received[PARALLEL_FILE_SIZE];
+	size_t next;
+	size_t delivered;
+	size_t out_of_order;
+	bool ordered;
+	int error;
+	size_t done_cnt;
+} app;
+
+static K_SEM_DEFINE(done_sem, 0, 1);
+
+static struct download_client_parallel parallel_dl[4];
+
+static int app_callback(const struct download_client_evt *evt)
+{
+	const struct download_fragment *frag = &evt->fragment;
+
+	switch (evt->id) {
+	case DOWNLOAD_CLIENT_EVT_FRAGMENT:
+		zassert_true(frag->offset + frag->len <= PARALLEL_FILE_SIZE,
+			     "Fragment past end of file");
+
+		if (app.ordered) {
+			zassert_equal(frag->offset, app.next,
+				      "Fragment out of order");
+		} else if (frag->offset != app.next) {
+			app.out_of_order++;
+		}
+		app.next = frag->offset + frag->len;
+
+		for (size_t i = 0; i < frag->len; i++) {
+			zassert_false(app.received[frag->offset + i],
+				      "Byte received twice");
+			app.received[frag->offset + i] = true;
+		}
+
+		memcpy(&app.file[frag->offset], frag->buf, frag->len);
+		app.delivered += frag->len;
+		break;
+	case DOWNLOAD_CLIENT_EVT_ERROR:
+		app.error = evt->error;
+		/* Ask for a reconnection, the client may still stop */
+		k_sem_give(&done_sem);
+		break;
+	case DOWNLOAD_CLIENT_EVT_DONE:
+		app.done_cnt++;
+		k_sem_give(&done_sem);
+		break;
+	}
+
+	return 0;
+}
+
+static void parallel_init(struct download_client_parallel *dl, bool ordered)
+{
+	int err;
+
+	err = download_client_parallel_init(dl, PARALLEL_CONNS, ordered,
+					    app_callback);
+	zassert_equal(err, 0, "Failed to initialize");
+
+	/* Let the threads suspend themselves, the download resumes them */
+	k_sleep(K_MSEC(10));
+}
+
+static void parallel_download(struct download_client_parallel *dl,
+			      const char *host, int sec_tag, bool ordered)
+{
+	const struct download_client_cfg config = {
+		.frag_size_override = PARALLEL_FRAG_SIZE,
+		.sec_tag = sec_tag,
+	};
+	int err;
+
+	memset(&app, 0, sizeof(app));
+	app.ordered = ordered;
+	k_sem_reset(&done_sem);
+
+	err = download_client_parallel_connect(dl, host, &config);
+	zassert_equal(err, 0, "Failed to connect");
+
+	err = download_client_parallel_start(dl, "file", 0);
+	zassert_equal(err, 0, "Failed to start");
+
+	err = k_sem_take(&done_sem, PARALLEL_TIMEOUT);
+	zassert_equal(err, 0, "Download did not end");
+
+	/* Let the threads suspend themselves before the next download */
+	k_sleep(K_MSEC(10));
+
+	err = download_client_parallel_disconnect(dl);
+	zassert_equal(err, 0, "Failed to disconnect");
+}
+
+static void file_verify(void)
+{
+	zassert_equal(app.error, 0, "Download failed");
+	zassert_equal(app.done_cnt, 1, "Wrong number of done events");
+	zassert_equal(app.delivered, PARALLEL_FILE_SIZE, "File incomplete");
+
+	for (size_t i = 0; i < PARALLEL_FILE_SIZE; i++) {
+		zassert_equal(app.file[i], server_file_byte(i), "Wrong data");
+	}
+}
+
+void test_parallel_ordered(void)
+{
+	server_reset(PARALLEL_FILE_SIZE);
+	parallel_init(&parallel_dl[0], true);
+
+	parallel_download(&parallel_dl[0], "https://stand.in",
+			  PARALLEL_SEC_TAG, true);
+	file_verify();
+	zassert_equal(server.connections, PARALLEL_CONNS,
+		      "Wrong number of connections");
+}
+
+void test_parallel_as_received(void)
+{
+	server_reset(PARALLEL_FILE_SIZE);
+	parallel_init(&parallel_dl[1], false);
+
+	parallel_download(&parallel_dl[1], "https://stand.in",
+			  PARALLEL_SEC_TAG, false);
+	file_verify();
+	zassert_not_equal(app.out_of_order, 0,
+			  "Fragments not received out of order");
+}
+
+void test_parallel_terminal_error(void)
+{
+	/* The second fragment of the first connection is answered
+	 * with an error, which the client can't parse.
+	 */
+	server_reset(PARALLEL_FILE_SIZE);
+	server.fail = true;
+	server.fail_from = PARALLEL_CONNS * PARALLEL_FRAG_SIZE;
+	parallel_init(&parallel_dl[2], true);
+
+	parallel_download(&parallel_dl[2], "https://stand.in",
+			  PARALLEL_SEC_TAG, true);
+
+	zassert_equal(app.error, -EBADMSG, "Error not reported");
+	zassert_equal(app.done_cnt, 0, "Download done after error");
+	zassert_true(app.delivered <= PARALLEL_CONNS * PARALLEL_FRAG_SIZE,
+		     "Fragments delivered after error");
+
+	/* No connection is left waiting for its turn,
+	 * so the download can be started again.
+	 */
+	server_reset(PARALLEL_FILE_SIZE);
+
+	parallel_download(&parallel_dl[2], "https://stand.in",
+			  PARALLEL_SEC_TAG, true);
+	file_verify();
+}
+
+void test_parallel_http(void)
+{
+	/* Without range requests enabled, each connection still has
+	 * to request its next fragment over plain HTTP.
+	 */
+	server_reset(PARALLEL_FILE_SIZE);
+	parallel_init(&parallel_dl[3], true);
+
+	parallel_download(&parallel_dl[3], "http://stand.in", -1, true);
+	file_verify();
+	zassert_equal(server.requests,
+		      DIV_ROUND_UP(PARALLEL_FILE_SIZE, PARALLEL_FRAG_SIZE),
+		      "Unexpected number of requests");
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <profiler.h>
+
+/* Every event takes 10 bytes in a frame: type ID, timestamp delta and two
+ * data fields. The events must fit in the RTT buffer.
+ */
+#define TEST_EVENT_CNT		1000
+#define TEST_BURST_SIZE		20
+#define TEST_FLUSH_WAIT_MS	(2 * CONFIG_PROFILER_NORDIC_FLUSH_PERIOD_MS)
+
+static uint16_t test_event_id;
+
+
+static void test_init(void)
+{
+	static const char *labels[] = {"val1", "val2"};
+	static const enum profiler_arg types[] = {PROFILER_ARG_U32,
+						  PROFILER_ARG_U32};
+
+	zassert_equal(profiler_init(), 0, "Cannot initialize profiler");
+
+	test_event_id = profiler_register_event_type("test_event", labels,
+						     types, ARRAY_SIZE(types));
+}
+
+static void test_throughput(void)
+{
+	struct profiler_nordic_stats stats;
+	uint32_t cycles = 0;
+
+	for (size_t i = 0; i < TEST_EVENT_CNT; i++) {
+		struct log_event_buf buf;
+		uint32_t start = k_cycle_get_32();
+
+		profiler_log_start(&buf);
+		profiler_log_encode_u32(&buf, i);
+		profiler_log_encode_u32(&buf, start);
+		profiler_log_send(&buf, test_event_id);
+
+		cycles += k_cycle_get_32() - start;
+
+		/* Let the profiler thread send the staged events. */
+		if ((i % TEST_BURST_SIZE) == (TEST_BURST_SIZE - 1)) {
+			k_sleep(K_MSEC(1));
+		}
+	}
+
+	k_sleep(K_MSEC(TEST_FLUSH_WAIT_MS));
+	profiler_nordic_stats_get(&stats);
+
+	printk("Profiler throughput: %u events/s, %u events in %u frames\n",
+	       (uint32_t)((uint64_t)TEST_EVENT_CNT *
+			  sys_clock_hw_cycles_per_sec() / MAX(cycles, 1)),
+	       stats.sent_events, stats.sent_frames);
+
+	zassert_equal(stats.dropped_events, 0, "Events dropped");
+	zassert_equal(stats.sent_events, TEST_EVENT_CNT, "Events not sent");
+	zassert_true(stats.sent_frames < stats.sent_events,
+		     "Events not batched");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(profiler_tests,
+			 ztest_unit_test(test_init),
+			 ztest_unit_test(test_throughput)
+			 );
+
+	ztest_run_test_suite(profiler_tests);
+}